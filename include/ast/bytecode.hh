@@ -0,0 +1,271 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ast/decl.hh>
+#include <utils/literals.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @brief the instruction set of the stack vm
+        /// @note operands follow the opcode inline, 16 bits each (jump targets: 32 bits)
+        enum class Op : uint8_t
+        {
+            Const,          ///< [k] push constants[k]
+            Nil,            ///< push nil
+            True,           ///< push true
+            False,          ///< push false
+            Pop,            ///< drop the top
+            Dup,            ///< push the top again
+
+            GetLocal,       ///< [slot] push a frame slot
+            SetLocal,       ///< [slot] pop into a frame slot
+            GetBoxed,       ///< [depth, slot] push a slot of a heap scope
+            SetBoxed,       ///< [depth, slot] pop into a slot of a heap scope
+            GetUpvalue,     ///< [slot] push a captured cell
+            SetUpvalue,     ///< [slot] pop into a captured cell
+            GetGlobal,      ///< [idx] push a global
+            SetGlobal,      ///< [idx] pop into a global
+            DefineFunc,     ///< [idx] pop a function into a global (once, outside the REPL)
+
+            Add,            ///< [op] the binary operators, ints inline, the rest as Eval does
+            Sub,            ///< [op]
+            Mul,            ///< [op]
+            Div,            ///< [op]
+            Less,           ///< [op]
+            LessEqual,      ///< [op]
+            Greater,        ///< [op]
+            GreaterEqual,   ///< [op]
+            Equal,          ///< [op]
+            NotEqual,       ///< [op]
+            Negate,         ///< [op]
+            Not,            ///< [op]
+
+            Jump,           ///< [target]
+            JumpIfFalse,    ///< [target] pop, jump if falsy
+            JumpIfTrue,     ///< [target] pop, jump if truthy
+            JumpIfNotNil,   ///< [target] jump keeping the top if it isn't nil, else pop it
+
+            PushScope,      ///< [slots] open a heap scope for a block's captured locals
+            PopScope,       ///< close it
+            Closure,        ///< [proto] push a function bound to its captured cells
+            Call,           ///< [site] call the site's callee with the arguments on the stack
+            Return,         ///< pop the result, back to the caller
+            ReturnNil,      ///< back to the caller with nil
+
+            Print,          ///< pop & print
+            Result,         ///< pop a top level declaration's value (see Eval::evaluate)
+            Halt            ///< end of the script
+        };
+
+        /// @brief the instruction set of the register vm: three addresses over the
+        ///        call's register window (frame slots first, then temporaries)
+        /// @note R: register, K: constant, the rest are slots, indices or jump targets
+        enum class RegOp : uint8_t
+        {
+            Move,           ///< R[a] = R[b]
+            LoadK,          ///< R[a] = K[b]
+            LoadNil,        ///< R[a] = nil
+            LoadBool,       ///< R[a] = b != 0
+
+            GetBoxed,       ///< R[a] = scope(depth b)[c]
+            SetBoxed,       ///< scope(depth b)[c] = R[a]
+            GetUpvalue,     ///< R[a] = cells[b]
+            SetUpvalue,     ///< cells[b] = R[a]
+            GetGlobal,      ///< R[a] = globals[b]
+            SetGlobal,      ///< globals[b] = R[a]
+            DefineFunc,     ///< globals[b] = R[a] (once, outside the REPL), K[c] its name
+
+            Add, Sub, Mul, Div,                         ///< R[a] = R[b] op R[c]
+            Less, LessEqual, Greater, GreaterEqual,     ///< R[a] = R[b] op R[c]
+            Equal, NotEqual,                            ///< R[a] = R[b] op R[c]
+            AddK, SubK, MulK, DivK,                     ///< R[a] = R[b] op K[c]
+            LessK, LessEqualK, GreaterK, GreaterEqualK, ///< R[a] = R[b] op K[c]
+            EqualK, NotEqualK,                          ///< R[a] = R[b] op K[c]
+            Negate,         ///< R[a] = -R[b]
+            Not,            ///< R[a] = !R[b]
+
+            Jump,           ///< to a
+            JumpIfFalse,    ///< to a if R[b] is falsy
+            JumpIfTrue,     ///< to a if R[b] is truthy
+            JumpIfNotNil,   ///< to a if R[b] isn't nil
+
+            PushScope,      ///< open a heap scope of a slots
+            PopScope,       ///< close it
+            Closure,        ///< R[a] = protos[b] bound to its captured cells
+            Call,           ///< R[a] = sites[b] called with the arguments in R[c]...
+            Return,         ///< back to the caller with R[a]
+            ReturnNil,      ///< back to the caller with nil
+
+            Print,          ///< print R[a]
+            Result,         ///< R[a] is a top level declaration's value
+            Halt            ///< end of the script
+        };
+
+        /// @brief a register vm instruction
+        struct Instr
+        {
+            RegOp op;
+            uint16_t a = 0, b = 0, c = 0;
+        };
+
+        struct Closure;
+        struct Proto;
+        struct Thunk;
+        struct Native;
+
+        /// @brief a vm value, ints & bools unboxed
+        /// @note anything else (strings, doubles, ...) stays a token and goes through the
+        ///       evaluator's generic semantics, so both engines agree on every result
+        struct Value
+        {
+            enum class Type : uint8_t { Nil, Bool, Int, Func, Boxed };
+
+            Type type = Type::Nil;
+            union {
+                bool b;
+                int32_t i = 0;
+            };
+            /// @note the token (Boxed) or the closure (Func)
+            std::shared_ptr<void> ref = nullptr;
+
+            Value() = default;
+            static inline Value boolean(bool b) { Value v; v.type = Type::Bool; v.b = b; return v; }
+            static inline Value integer(int32_t i) { Value v; v.type = Type::Int; v.i = i; return v; }
+            static inline Value boxed(Token tok) { Value v; v.type = Type::Boxed; v.ref = std::make_shared<Token>(std::move(tok)); return v; }
+            static inline Value func(std::shared_ptr<Closure> fn) { Value v; v.type = Type::Func; v.ref = std::move(fn); return v; }
+
+            /// @brief the value of a token Eval produced, & the token Eval would have
+            static Value from(Token tok);
+            Token to(int line) const;
+
+            inline bool nil() const { return type == Type::Nil || (type == Type::Boxed && token().type == TokenType::NIL); }
+            inline bool truthy() const { return type == Type::Bool ? b : type != Type::Boxed || rift::truthy(token()); }
+            inline const Token& token() const { return *static_cast<const Token*>(ref.get()); }
+            inline Closure& closure() const { return *static_cast<Closure*>(ref.get()); }
+        };
+
+        /// @brief a heap scope: the captured locals of a block or of a function's params
+        struct Scope
+        {
+            Scope(std::shared_ptr<Scope> enclosing, size_t size) : enclosing(std::move(enclosing)), slots(size) {}
+
+            inline Value& at(int depth, int slot) {
+                Scope *curr = this;
+                while (depth-- > 0) curr = curr->enclosing.get();
+                return curr->slots[slot];
+            }
+
+            std::shared_ptr<Scope> enclosing;
+            std::vector<Value> slots;
+        };
+
+        /// @brief a captured variable, shared by the closures capturing it & its scope
+        struct Cell
+        {
+            std::shared_ptr<Scope> scope;
+            int slot;
+
+            inline Value& get() const { return scope->slots[slot]; }
+        };
+
+        /// @brief a call site
+        struct Site
+        {
+            Token name;
+            Storage storage = Storage::Global;
+            int depth = -1, slot = -1;
+            /// @note number of arguments pushed, the i-th goes to the callee's i-th param
+            size_t args = 0;
+        };
+
+        /// @brief a compiled function (or the script)
+        struct Proto
+        {
+            Token name;
+            std::vector<uint8_t> code = {};
+            /// @note literals & declaration names, operator tokens (lines, generic semantics),
+            ///       call sites & the functions declared inside
+            std::vector<Value> constants = {};
+            std::vector<Token> ops = {};
+            std::vector<Site> sites = {};
+            std::vector<std::shared_ptr<Proto>> protos = {};
+
+            /// @note frame slots the code uses & where each param goes (see Resolver)
+            int frame = 0, boxes = 0;
+            std::vector<Storage> params = {};
+            std::vector<DeclFunc<Token>::Func::Capture> captures = {};
+
+            /// @note register vm: its code, the source line of each instruction
+            ///       & the size of a call's register window
+            std::vector<Instr> instrs = {};
+            std::vector<int> lines = {};
+            int registers = 0;
+
+            /// @note thunk engine: the body's thunk
+            std::shared_ptr<Thunk> body = nullptr;
+
+            /// @note jit: the machine code, how hot the proto ran until it had some
+            ///       & whether it stays interpreted
+            mutable std::shared_ptr<Native> native = nullptr;
+            mutable unsigned heat = 0;
+            mutable bool cold = false;
+
+            /// @note lazily parsed functions compile on their first call
+            DeclFunc<Token>::Func* lazy = nullptr;
+        };
+
+        /// @brief a function value
+        struct Closure
+        {
+            std::shared_ptr<Proto> proto;
+            std::vector<Cell> cells;
+        };
+
+        /// @brief the vm's global table, names to indices fixed at compile time
+        class Globals
+        {
+            public:
+                static Globals& getInstance() {
+                    static Globals instance;
+                    return instance;
+                }
+
+                /// @brief index of a global, allocated (as nil) on first sight
+                size_t index(const str_t& name) {
+                    auto it = symbols.find(name);
+                    if (it != symbols.end()) return it->second;
+                    symbols.emplace(name, values.size());
+                    values.emplace_back();
+                    return values.size() - 1;
+                }
+
+                void clear() {
+                    symbols.clear();
+                    values.clear();
+                }
+
+                std::vector<Value> values = {};
+            private:
+                std::unordered_map<str_t, size_t> symbols = {};
+        };
+    }
+}
@@ -0,0 +1,202 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @brief tags for the nodes in the binary ast format
+        enum class Node : uint8_t
+        {
+            Null,
+
+            // expressions
+            Assign,
+            Binary,
+            Grouping,
+            Literal,
+            Unary,
+            Call,
+            Ternary,
+            VarExpr,
+
+            // statements
+            StmtExpr,
+            StmtPrint,
+            StmtIf,
+            StmtReturn,
+            Block,
+            For,
+
+            // declarations
+            DeclStmt,
+            DeclVar,
+            DeclFunc,
+            DeclClass
+        };
+
+        /// @class Serializer
+        /// @brief Flattens a parsed and resolved program into the binary ast format
+        /// @details Layout (integers in native byte order)
+        ///          - header: magic "RFTC", format version, key, checksum (FNV-1a of the rest), #symbols
+        ///          - symbols: every lexeme once (u32 length + bytes)
+        ///          - nodes: pre-order stream of tagged nodes, tokens refer to symbols
+        ///                   by index and variables carry their resolved depth
+        class Serializer : public ExprVisitor<Token>, StmtVisitor<void>,
+                                  DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                Serializer() = default;
+                ~Serializer() = default;
+
+                /// @brief serializes the program under the given cache key
+                std::vector<char> serialize(const std::unique_ptr<Program<Tokens>>& prgm, uint64_t key);
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                template <typename T>
+                void put(T val) const;
+                void tag(Node node) const;
+                void symbol(const string& str) const;
+                void token(const Token& tok) const;
+                void expr(const Expr<Token>* expr) const;
+                void stmt(const Stmt<void>* stmt) const;
+                void decl(const Decl<Token>* decl) const;
+                void arm(const StmtIf<void>::Stmt* arm) const;
+
+                mutable std::vector<char> nodes;
+                mutable std::vector<string> symbols;
+                mutable std::unordered_map<string, uint32_t> interned;
+        };
+
+        /// @class Deserializer
+        /// @brief Rebuilds a program from a (mapped) binary ast buffer
+        /// @note nothing read is trusted: counts are bounded by the bytes left & every resolved
+        ///       slot is checked against the frame, scopes & cells it will run in
+        class Deserializer
+        {
+            public:
+                Deserializer(const char* data, size_t size): data(data), size(size), pos(0) {};
+                ~Deserializer() = default;
+
+                /// @brief rebuilds the program, fails if the buffer was not written for key
+                std::unique_ptr<Program<Tokens>> deserialize(uint64_t key);
+
+            private:
+                template <typename T>
+                T get();
+                Node tag();
+                Token token();
+                Storage storage();
+                std::unique_ptr<Expr<Token>> expr();
+                std::unique_ptr<Stmt<void>> stmt();
+                std::unique_ptr<Block<void>> block();
+                std::unique_ptr<Decl<Token>> decl();
+                StmtIf<void>::Stmt* arm();
+                /// @brief a count of nodes or bytes, each taking a byte at least
+                uint32_t count();
+                /// @brief a frame or scope size, each of its slots is declared by a node
+                int32_t extent();
+                /// @brief checks a resolved variable against where it runs
+                void local(Storage storage, int32_t depth, int32_t slot) const;
+
+                const char* data;
+                size_t size, pos;
+                std::vector<string> symbols;
+
+                /// @note what the nodes being read may index: their function's frame (-1 at the
+                ///       top level, sized by its blocks & loop pre-headers instead) & cells
+                struct Frame {
+                    int32_t size, cells;
+                    /// @note slots of each heap scope, innermost last
+                    std::vector<int32_t> scopes = {};
+                    /// @note frame slots made room for by the enclosing blocks & pre-headers
+                    std::vector<int32_t> bounds = {};
+                };
+                std::vector<Frame> frames;
+        };
+
+        /// @class Cache
+        /// @brief On-disk cache of parsed programs, keyed by a hash of source & compiler version
+        class Cache
+        {
+            public:
+                Cache(const string& dir, const string& version): dir(dir), version(version) {};
+                ~Cache() = default;
+
+                /// @brief maps the cached program for source (nullptr on a miss)
+                std::unique_ptr<Program<Tokens>> load(const string& source) const;
+                /// @brief writes the program for source into the cache
+                void store(const string& source, const std::unique_ptr<Program<Tokens>>& prgm) const;
+
+                /// @brief $RIFT_CACHE_DIR, $XDG_CACHE_HOME/rift or ~/.cache/rift
+                static string defaultDir();
+                /// @brief the version a program is cached under: the compiler's & everything shaping the tree
+                /// @note lazy trees keep unparsed (so unoptimized) bodies, eager runs must not load them
+                static string pipeline(const string& compiler, unsigned level, unsigned inlineSize, unsigned ctfeSteps, bool lazy);
+
+            private:
+                uint64_t key(const string& source) const;
+                string path(uint64_t key) const;
+
+                string dir;
+                string version;
+        };
+
+        /// @class CacheException
+        /// @brief Raised on malformed or stale cache entries
+        class CacheException : public std::exception
+        {
+            public:
+                CacheException(const string &message): message(message) {};
+                const char *what() const noexcept override { return message.c_str(); }
+            private:
+                string message;
+        };
+    }
+}
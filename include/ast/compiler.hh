@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#pragma once
+
+#include <ast/bytecode.hh>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Compiler
+        /// @brief Compiles a resolved program into bytecode for the vm
+        /// @details locals keep the slots the Resolver gave them (frame, heap scope or
+        ///          captured cell), globals get a fixed index in the vm's table and
+        ///          literals go to the constant pool
+        class Compiler : public ExprVisitor<Token>, StmtVisitor<void>, 
+                                DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                Compiler() = default;
+                ~Compiler() = default;
+
+                /// @return the script's code, nullptr if it uses something only Eval runs (classes)
+                std::shared_ptr<Proto> compile(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @brief compiles a function's body into its proto
+                /// @return false if the body uses something only Eval runs
+                bool compile(const DeclFunc<Token>::Func& func, Proto& proto) const;
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                void emit(Op op) const;
+                void emit(Op op, size_t a) const;
+                void emit(Op op, size_t a, size_t b) const;
+                /// @return where the jump's target goes (see patch)
+                size_t jump(Op op) const;
+                /// @brief points a jump at the next instruction
+                void patch(size_t at) const;
+                /// @brief a jump back to target
+                void loop(size_t target) const;
+
+                size_t constant(Value value) const;
+                size_t op(const Token& tok) const;
+
+                /// @brief reads / writes (popping) a resolved variable
+                void load(Storage storage, int depth, int slot, const str_t& name) const;
+                void store(Storage storage, int depth, int slot, const str_t& name) const;
+                /// @brief an assignment whose value is unused
+                void assign(const Assign<Token>& expr) const;
+                /// @brief the body of an if/elif/else branch
+                void branch(const Stmt<void>* stmt, const Block<void>* blk) const;
+
+                /// @note the function (or script) being emitted
+                mutable Proto* proto = nullptr;
+                /// @note the declaration visited is a top level one, its value is a result
+                mutable bool result = false;
+                /// @note false once something only Eval runs shows up
+                mutable bool supported = true;
+        };
+    }
+}
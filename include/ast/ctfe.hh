@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Ctfe
+        /// @brief Compile time evaluation of calls to pure functions
+        /// @details a top level function is pure if its body only touches its own frame,
+        ///          prints nothing, declares no functions and only calls pure functions.
+        ///          Such a call on constant arguments runs on a small interpreter over the
+        ///          tree, bounded by a step budget. A call running out of steps, recursing
+        ///          too deep or that would fail at runtime is left to the runtime
+        class Ctfe : public ExprVisitor<Token>, StmtVisitor<void>, 
+                            DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                /// @param budget steps (nodes visited) a single call may take
+                Ctfe(unsigned budget = 10000): budget(budget) {};
+                ~Ctfe() = default;
+
+                /// @brief finds the pure functions of the program
+                void analyze(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @brief the top level function is bound from here on
+                void declare(const string& name) const;
+                /// @brief the call runs a pure function that is bound by now
+                bool callable(const Call<Token>& call) const;
+
+                /// @param args the constant value of each argument, in order
+                /// @return the value the call returns, IGNORE if it is left to the runtime
+                Token evaluate(const Call<Token>& call, const std::vector<Token>& args) const;
+
+                /// @brief calls evaluated so far
+                unsigned evaluated() const { return count; }
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief thrown to abandon an evaluation (out of steps, a runtime error)
+                struct Abandon {};
+
+                /// @brief runs func on its arguments (by param)
+                Token call(const DeclFunc<Token>::Func& func, std::vector<Token>&& args) const;
+                /// @brief a frame slot of the running call
+                Token& local(int slot) const;
+                /// @brief counts a step, abandons the evaluation past the budget
+                void step() const;
+
+                unsigned budget;
+                /// @note pure top level functions by name & the ones bound so far
+                mutable std::unordered_map<string, const DeclFunc<Token>::Func*> funcs = {};
+                mutable std::unordered_set<string> declared = {};
+
+                /// @note frames of the running calls, the value returned by the innermost
+                mutable std::vector<std::vector<Token>> frames = {};
+                mutable Token returned = {};
+                mutable bool returning = false;
+                mutable unsigned steps = 0, count = 0;
+        };
+    }
+}
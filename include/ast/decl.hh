@@ -72,26 +72,63 @@ namespace rift
                 DeclVar(const Token &identifier, std::unique_ptr<Expr<Token>> expr): identifier(identifier), expr(std::move(expr)) {};
                 T accept(const DeclVisitor<T> &visitor) const override { return visitor.visit_decl_var(*this); }
 
-                const Token& identifier;
+                Token identifier;
                 std::unique_ptr<Expr<Token>> expr;
+                /// @note frame or box slot in the enclosing scope (-1: global)
+                mutable Storage storage = Storage::Global;
+                mutable int slot = -1;
         };
 
         template <typename T>
         class DeclFunc : public Decl<T>
         {
             public:
-                typedef struct {
+                struct Func {
                     Token name;
                     Tokens params;
-                    Environment closure;
                     std::unique_ptr<Block<void>> blk;
-                } Func;
+
+                    /// @note resolver: storage of each param, boxed params & frame size
+                    std::vector<Storage> storage = {};
+                    int boxes = 0, frame = 0;
+
+                    /// @brief where a captured variable is, seen from the declaration
+                    struct Capture {
+                        /// @note boxed local of the enclosing function (depth, slot),
+                        ///       else its own upvalue at slot
+                        bool local;
+                        int depth, slot;
+                        bool operator==(const Capture&) const = default;
+                    };
+                    /// @note resolver: variables of enclosing functions the body uses
+                    std::vector<Capture> captures = {};
+
+                    /// @note lazy parsing: tokens [begin, end) of the body (after the '{')
+                    ///       kept until the first call parses them into blk
+                    std::shared_ptr<Tokens> src = nullptr;
+                    unsigned begin = 0, end = 0;
+
+                    /// @brief has a body, parsed or not
+                    inline bool defined() const { return blk != nullptr || src != nullptr; }
+                };
+
+                /// @brief a function value of the tree walker: the declaration & the cells of
+                ///        the variables it captured when the declaration ran
+                /// @note shares the declaration, it outlives its program (an earlier REPL line)
+                struct Closure {
+                    std::shared_ptr<Func> func;
+                    /// @note nullptr: captures nothing
+                    std::shared_ptr<std::vector<Upvalue>> upvalues;
+                };
 
                 DeclFunc(): func(nullptr) {};
                 DeclFunc(std::unique_ptr<Func> func): func(std::move(func)) {};
                 ~DeclFunc() = default;
 
-                std::unique_ptr<Func> func;
+                std::shared_ptr<Func> func;
+                /// @note frame or box slot in the enclosing scope (-1: global)
+                mutable Storage storage = Storage::Global;
+                mutable int slot = -1;
 
                 T accept(const DeclVisitor<T> &visitor) const override { return visitor.visit_decl_func(*this); };
         };
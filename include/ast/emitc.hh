@@ -0,0 +1,75 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <sstream>
+#include <ast/ssa.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class CEmitter
+        /// @brief Compiles a resolved program ahead of time, to C
+        /// @details every function goes through the ssa optimizer, then each ssa value
+        ///          becomes a C local, each block a label & phis copies on the edges
+        ///          into their block. Values are tagged (nil, bool, int, string or
+        ///          function), ints typed by Infer skip the tag checks, the rest goes
+        ///          through the runtime library (header & source below)
+        class CEmitter
+        {
+            public:
+                CEmitter() = default;
+                ~CEmitter() = default;
+
+                /// @return the C source, empty if the program uses something the runtime lacks (see error)
+                string emit(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @brief writes the C source to path, the runtime next to it & builds exe
+                ///        of both with the system's C compiler ($CC, cc by default)
+                /// @return false if any step failed (see error)
+                bool build(const std::unique_ptr<Program<Tokens>>& prgm, const string& path, const string& exe) const;
+
+                /// @brief why the last emit or build failed
+                const string& error() const { return failure; }
+
+                /// @note the runtime library: values, strings, scopes, closures, calls & printing
+                static const char* const header;
+                static const char* const source;
+
+            private:
+                void function(std::ostream& out, const ssa::Function& fn, size_t index) const;
+                void instruction(std::ostream& out, const ssa::Inst& inst) const;
+                /// @brief the phi copies of the succ'th edge out of blk
+                string edge(const ssa::Block& blk, size_t succ) const;
+
+                string value(const ssa::Inst* inst) const;
+                string constant(const Token& tok) const;
+                /// @brief where a loaded or stored variable lives
+                string variable(const ssa::Inst& inst) const;
+                static string quote(const string& text);
+
+                mutable string failure = "";
+                /// @note the functions emitted (the script first) & the C function of each declaration
+                mutable std::vector<std::unique_ptr<ssa::Function>> fns = {};
+                mutable std::unordered_map<const DeclFunc<Token>::Func*, size_t> index = {};
+                /// @note globals & string constants, by number
+                mutable std::unordered_map<str_t, int> globals = {};
+                mutable std::vector<string> strings = {};
+                /// @note numbering of the values of the function being emitted
+                mutable std::unordered_map<const ssa::Inst*, unsigned> ids = {};
+                mutable bool script = false;
+        };
+    }
+}
@@ -16,10 +16,14 @@
 // #include "../../external/abseil/absl/container/flat_hash_map.h"
 // #include <absl/container/flat_hash_map.h>
 #include <scanner/tokens.hh>
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include <error/error.hh>
+#include <ast/hamt.hh>
 
 using Token = rift::scanner::Token;
 using str_t = std::string;
@@ -38,70 +42,193 @@ namespace rift
                     static Environment parser_instance;
                     return parser ? parser_instance : eval_instance;
                 }
-                /// @brief add a child to the current environment (recursive-checks)
-                void addChild() {
-                    Environment* curr = this;
-                    while(curr->child) {
-                        curr = curr->child;
-                    }
-                    curr->child = new Environment();
+                /// @brief open a block scope on top of the scope stack
+                /// @note O(1), a closed scope keeps its table allocated for the next one
+                void pushScope() {
+                    if (open == scopes.size()) scopes.emplace_back();
+                    scopes[open++].base = values.size();
                 }
-                /// @brief remove the child from the current environment
-                void removeChild() {
-                    Environment* curr = this;
-                    Environment prev;
-                    while(curr->child != nullptr) {
-                        prev = curr;
-                        curr = curr->child;
-                    }
-                    // want it to trap for debug info if we ever hit this case
-                    prev.child = nullptr;
+                /// @brief close the innermost block scope, dropping its names & values
+                void popScope() {
+                    if (open == 0) rift::error::runTimeError("Closed a scope that was never opened");
+                    auto& scope = scopes[--open];
+                    values.resize(scope.base);
+                    fixed.resize(scope.base);
+                    scope.symbols.clear();
                 }
 
                 /// @brief clear all enviroments
                 /// @note usefull for switching from compile-time to runtime
                 void clear(bool parser) {
-                    Environment* curr = this;
-                    while(curr->child != nullptr) {
-                        Environment *tmp = curr->child;
-                        curr->child = curr->child->child;
-                        delete tmp;
-                    }
-                    getInstance(parser).values.clear();
-                    getInstance(parser).const_keys.clear();
+                    while (open > 0) popScope();
+                    getInstance(parser).symbols.clear();
+                    getInstance(parser).globals.clear();
+                    getInstance(parser).dense.clear();
+                    getInstance(parser).dirty.clear();
+                    getInstance(parser).version++;
                 }
 
-                Environment() : child(nullptr) {}
-                Environment(Environment *child) : child(child) {}
+                Environment() = default;
+                /// @brief a local scope, its variables live in slots resolved by the Resolver
+                Environment(std::shared_ptr<Environment> enclosing, size_t size) : enclosing(enclosing), slots(size) {}
                 ~Environment() = default;
 
+                /// @note the global table is persistent, copies share its trie until either is
+                ///       written (O(1), the copy reads & writes the trie, not a dense table)
                 Environment(const Environment& other) {
+                    other.flush();
+                    enclosing = other.enclosing;
+                    slots = other.slots;
+                    version = other.version;
+                    symbols = other.symbols;
+                    globals = other.globals;
+                    scopes = other.scopes;
+                    open = other.open;
                     values = other.values;
-                    const_keys = other.const_keys;
-                    child = other.child;
+                    fixed = other.fixed;
                 }
+                Environment& operator=(const Environment& other) = delete;
 
+                /// @brief the state of the global table, O(1) (plus the globals written since the last one)
+                Environment snapshot() const { return *this; }
+                /// @brief back to a snapshot, O(1) (plus the globals added or dropped since)
+                /// @note indices may now name other globals, the sites caching one look again;
+                ///       dense entries go stale & are read back from the trie on first use
+                void restore(const Environment& snapshot) {
+                    snapshot.flush();
+                    symbols = snapshot.symbols;
+                    globals = snapshot.globals;
+                    scopes = snapshot.scopes;
+                    open = snapshot.open;
+                    values = snapshot.values;
+                    fixed = snapshot.fixed;
+                    dirty.clear();
+                    generation++;
+                    dense.resize(symbols.size());
+                    version = std::max(version, snapshot.version) + 1;
+                }
+
+                /// @return the binding of name, a nil token if there is none
                 template <typename T>
-                T getEnv(const str_t& name) const;
+                const T& getEnv(const str_t& name) const;
 
                 template <typename T>
                 void setEnv(const str_t& name, T value, bool is_const);
 
-                Environment* at(int dist) {
+                /// @brief slot of the local scope depth levels out
+                inline Token& at(int depth, int slot) {
                     Environment *curr = this;
-                    for (int i=0; i<dist; i++) {
-                        if (curr == nullptr) rift::error::runTimeError("went past boundary");
-                        curr = curr->child;
+                    while (depth-- > 0) curr = curr->enclosing.get();
+                    return curr->slots[slot];
+                }
+
+                /// @brief index of a global in the table, allocated (as nil) on first sight
+                /// @note indices are stable until the table is cleared or restored
+                size_t index(const str_t& name) {
+                    if (auto idx = symbols.find(name)) return *idx;
+                    size_t idx = symbols.size();
+                    symbols.set(name, idx);
+                    Global global = {Token(rift::scanner::TokenType::NIL, "nil", "nil", -1), false};
+                    if (dense.size() == idx) {
+                        dense.push_back({std::move(global), generation, true});
+                        dirty.push_back(idx);
+                    } else {
+                        globals.set(idx, std::move(global));
+                    }
+                    return idx;
+                }
+
+                /// @brief read a global through its index
+                inline const Token& get(size_t idx) const {
+                    if (idx >= dense.size()) return globals.find(idx)->value;
+                    if (dense[idx].generation != generation) refill(idx);
+                    return dense[idx].global.value;
+                }
+
+                /// @brief write a global through its index
+                void assign(size_t idx, Token value, bool is_const) {
+                    if (idx < dense.size() && dense[idx].generation != generation) refill(idx);
+                    const auto& global = idx < dense.size() ? dense[idx].global : *globals.find(idx);
+                    if (global.is_const)
+                        error::report(0, "Environment", "Cannot reassign a constant variable", global.value, std::exception());
+                    // call sites cache their callee, any function moving in or out invalidates them
+                    if (global.value.type == rift::scanner::TokenType::FUN || value.type == rift::scanner::TokenType::FUN)
+                        version++;
+                    if (idx >= dense.size()) {
+                        globals.set(idx, {std::move(value), is_const});
+                        return;
+                    }
+                    auto& entry = dense[idx];
+                    entry.global = {std::move(value), is_const};
+                    if (!entry.dirty) {
+                        entry.dirty = true;
+                        dirty.push_back(idx);
                     }
-                    return curr;
                 }
 
                 void printState();
-                Environment *child;
+
+                /// @note local scopes
+                std::shared_ptr<Environment> enclosing = nullptr;
+                std::vector<rift::scanner::Token> slots = {};
+
+                /// @note global table, sites cache an index & callee while the version matches
+                unsigned version = 1;
             protected:
-                // absl::flat_hash_map<str_t, rift::scanner::Token> values;
-                std::unordered_map<str_t, rift::scanner::Token> values = {};
-                std::unordered_set<str_t> const_keys = {};
+                struct Global {
+                    Token value;
+                    bool is_const;
+                };
+                /// @note names to indices & indices (hashed as themselves, so dense) to values
+                Hamt<str_t, size_t> symbols = {};
+                mutable Hamt<size_t, Global> globals = {};
+
+                /// @note globals are read & written in a dense table (what sites cache an index
+                ///       into), the trie only catches up with the entries written (dirty) once a
+                ///       snapshot is taken. Entries of an older generation predate a restore
+                struct Entry {
+                    Global global;
+                    unsigned generation = 0;
+                    bool dirty = false;
+                };
+                mutable std::vector<Entry> dense = {};
+                mutable std::vector<size_t> dirty = {};
+                unsigned generation = 1;
+
+                /// @brief reads a stale dense entry back from the trie
+                void refill(size_t idx) const {
+                    dense[idx] = {*globals.find(idx), generation, false};
+                }
+                /// @brief writes the dirty dense entries to the trie
+                void flush() const {
+                    for (size_t idx : dirty) {
+                        if (idx >= dense.size() || !dense[idx].dirty) continue;
+                        globals.set(idx, dense[idx].global);
+                        dense[idx].dirty = false;
+                    }
+                    dirty.clear();
+                }
+
+                /// @note block scopes (parser), innermost last: names index one contiguous
+                ///       value stack, a scope owns the values from its base up
+                struct Scope {
+                    std::unordered_map<str_t, size_t> symbols = {};
+                    size_t base = 0;
+                };
+                std::vector<Scope> scopes = {};
+                size_t open = 0;
+                std::vector<Token> values = {};
+                std::vector<bool> fixed = {};
+        };
+
+        /// @brief a captured variable: its slot in the heap scope declaring it
+        /// @note shared by every closure capturing the variable & the scope itself
+        struct Upvalue
+        {
+            std::shared_ptr<Environment> scope;
+            int slot;
+
+            inline Token& get() const { return scope->slots[slot]; }
         };
     }
 }
\ No newline at end of file
@@ -30,6 +30,23 @@ namespace rift
 {
     namespace ast
     {
+        /// @brief how a statement completed
+        enum class Signal : uint8_t
+        {
+            Normal,  ///< on to the next statement
+            Return,  ///< unwind to the call, with a value
+            Break,   ///< unwind out of the innermost loop
+            Continue ///< unwind to the innermost loop's increment
+        };
+
+        /// @brief the completion record of the statement run last
+        struct Completion
+        {
+            Signal signal = Signal::Normal;
+            /// @note what a return carries
+            Token value = {};
+        };
+
         class Eval : public ExprVisitor<Token>, StmtVisitor<void>, 
                             DeclVisitor<Token>, ProgramVisitor<Tokens>
         {
@@ -67,11 +84,27 @@ namespace rift
                 /// @brief Evaluates the given *expr/stmt/decl*
                 std::vector<string> evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive);
 
-                /// @note Resolver API
-                static Token lookup(Expr<Token>* expr, std::string key);
-                void resolve(Expr<Token>* expr, int depth);
+                /// @brief the value of a literal, the one every engine starts from
+                static Token literal(const Literal<Token>& expr);
+                /// @brief the untyped semantics of a binary operator on two values
+                /// @note shared with the vm, which only takes its own fast paths for ints & bools
+                static Token binary(const Token& op, const Token& left, const Token& right);
+                /// @brief the semantics of a unary operator on a value
+                static Token unary(const Token& op, const Token& right);
+                /// @brief a value the way evaluate reports it
+                static string show(const Token& tok);
+                /// @brief a value the way print writes it
+                static string text(const Token& tok);
 
             private:
+                /// @brief value of an operand, variables are read in place (tmp holds anything else)
+                const Token& operand(const Expr<Token>& expr, Token& tmp) const;
+                /// @brief an assignment whose value is unused, moved into the variable
+                void store(const Assign<Token>& expr) const;
+
+                /// @note blocks & loops unwind while it isn't normal, calls consume returns
+                mutable Completion completion = {};
+
                 const std::unique_ptr<ProgramVisitor<Tokens>> visitor;
         };
 
@@ -88,16 +121,5 @@ namespace rift
             private:
                 std::string message;
         };
-
-        class StmtReturnException: public std::exception
-        {
-            public:
-                StmtReturnException(Token tok): tok(tok) {};
-                ~StmtReturnException() = default;
-                Token tok;
-                const char* what() const noexcept override {
-                    return "Statement Return Exception";
-                }
-        };
     }
 }
\ No newline at end of file
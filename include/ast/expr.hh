@@ -44,6 +44,34 @@ namespace rift
             VarExpr
         )
 
+        /// @brief where a resolved name lives at runtime
+        enum class Storage : uint8_t
+        {
+            Global, ///< indexed global table
+            Frame,  ///< flat stack frame of the enclosing function
+            Boxed,  ///< heap scope shared with the closures capturing it
+            Upvalue ///< local of an enclosing function, through the closure's cells
+        };
+
+        /// @brief statically inferred type of a value
+        enum class Kind : uint8_t
+        {
+            Unknown, ///< only known at runtime
+            Int,
+            Double,
+            String,
+            Bool
+        };
+
+        /// @brief what a node rewrote itself to after watching its operands (quickening)
+        enum class Quick : uint8_t
+        {
+            Unseen,  ///< still recording the operand types it runs on
+            Int,     ///< only saw ints: int arithmetic behind a type guard
+            String,  ///< only concatenated strings: concatenation behind a type guard
+            Generic  ///< saw mixed types or a guard failed: the untyped semantics for good
+        };
+
         /// @class Visitor
         /// @brief Visitor pattern for expressions
         template <typename T>
@@ -100,11 +128,18 @@ namespace rift
         class Call : public Expr<T>
         {
             public:
-                using Exprs = std::unordered_map<std::string, std::unique_ptr<Expr<T>>>;
+                /// @note positional, the callee's i-th parameter gets args[i]
+                using Exprs = std::vector<std::unique_ptr<Expr<T>>>;
                 Call(Token name, Exprs&& args): name(name), args(std::move(args)) {};
 
                 Token name; // expr -> Literal::Identifier
                 Exprs args;
+                /// @note resolved storage of the callee, boxed scopes to hop & its slot
+                mutable Storage storage = Storage::Global;
+                mutable int depth = -1, slot = -1;
+                /// @note inline cache of a global callee (valid while version matches the global table)
+                mutable unsigned version = 0;
+                mutable void* callee = nullptr;
 
                 inline T accept(const ExprVisitor<T>& visitor) const override { return visitor.visit_call(*this); }
         };
@@ -128,6 +163,12 @@ namespace rift
                 Assign(Token name, std::unique_ptr<Expr<T>> value): name(name), value(std::move(value)) {};
                 Token name;
                 std::unique_ptr<Expr<T>> value;
+                /// @note resolved storage, boxed scopes to hop & slot
+                mutable Storage storage = Storage::Global;
+                mutable int depth = -1, slot = -1;
+                /// @note inline cache of the global index (valid while version matches the global table)
+                mutable int global = -1;
+                mutable unsigned version = 0;
 
                 virtual inline T accept(const ExprVisitor<T>& visitor) const override { return visitor.visit_assign(*this); }
         };
@@ -145,6 +186,13 @@ namespace rift
                 Token op;
                 std::unique_ptr<Expr<T>> left;
                 std::unique_ptr<Expr<T>> right;
+                /// @note type inference: what both operands are known to be (Unknown: checked at runtime)
+                mutable Kind operands = Kind::Unknown;
+                /// @note type feedback: the operand types of the runs so far (Unknown: mixed),
+                ///       specialized to once they held for a few runs
+                mutable Kind seen = Kind::Unknown;
+                mutable uint8_t runs = 0;
+                mutable Quick quick = Quick::Unseen;
 
                 inline T accept(const ExprVisitor<T>& visitor) const override { return visitor.visit_binary(*this); }
         };
@@ -183,6 +231,12 @@ namespace rift
             public:
                 VarExpr(Token value): value(value) {};
                 Token value;
+                /// @note resolved storage, boxed scopes to hop & slot
+                mutable Storage storage = Storage::Global;
+                mutable int depth = -1, slot = -1;
+                /// @note inline cache of the global index (valid while version matches the global table)
+                mutable int global = -1;
+                mutable unsigned version = 0;
 
                 inline T accept(const ExprVisitor<T> &visitor) const override {return visitor.visit_var_expr(*this);}
         };
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <ast/ctfe.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Fold
+        /// @brief Constant folding & propagation over a resolved program
+        /// @details folds constant subexpressions into literals, propagates the
+        ///          values of `mut!` constants into their uses and simplifies
+        ///          `??`, `&&`, `||` & ternaries with a constant left/condition.
+        ///          With a step budget, calls to pure functions on constant arguments
+        ///          are evaluated too (see Ctfe)
+        class Fold : public ExprVisitor<Token>, StmtVisitor<void>, 
+                            DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                /// @param steps budget of each call evaluated at compile time (0: none are)
+                Fold(unsigned steps = 0): steps(steps), ctfe(steps) {};
+                ~Fold() = default;
+
+                /// @brief folds the program in place
+                /// @return the number of nodes eliminated
+                unsigned run(const std::unique_ptr<Program<Tokens>>& prgm) const;
+
+                /// @brief nodes eliminated & constant uses propagated so far
+                unsigned eliminated() const { return removed; }
+                unsigned propagated() const { return uses; }
+                /// @brief calls evaluated at compile time so far
+                unsigned evaluated() const { return ctfe.evaluated(); }
+
+                /// @brief the evaluator computes op on these constants without a runtime error
+                static bool foldable(const Token& op, const Token& left, const Token& right);
+                static bool foldable(const Token& op, const Token& right);
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief folds the expression owned by ptr, replacing it when it simplifies
+                Token fold(const std::unique_ptr<Expr<Token>>& ptr) const;
+                /// @brief the value is known at compile time
+                static bool constant(const Token& tok);
+                /// @brief number of nodes in an expression tree
+                static unsigned size(const Expr<Token>* expr);
+
+                /// @note set by a visit whose node should be replaced by (one of its children)
+                mutable std::unique_ptr<Expr<Token>> replacement = nullptr;
+                /// @note lexical scopes of the names visible so far, constants carry their value
+                mutable std::vector<std::unordered_map<string, Token>> scopes = {};
+                /// @note names some assignment writes & whether a top level body is not parsed yet
+                mutable std::unordered_set<string> assigned = {};
+                mutable bool unparsed = false;
+                mutable unsigned removed = 0, uses = 0;
+                unsigned steps;
+                Ctfe ctfe;
+        };
+    }
+}
@@ -0,0 +1,170 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Hamt
+        /// @brief Persistent hash array mapped trie (map from K to V)
+        /// @details 32-way nodes indexed by 5 bits of the hash at a time, only the
+        ///          children present are stored (bitmap + compressed vector). Copies
+        ///          share every node, so copying is O(1) and a write copies the
+        ///          O(log32 n) nodes on its path that another copy still uses, the
+        ///          ones it owns alone are written in place
+        template <typename K, typename V, typename Hash = std::hash<K>>
+        class Hamt
+        {
+            public:
+                Hamt() = default;
+                ~Hamt() = default;
+
+                /// @return the value of key (nullptr: absent)
+                const V* find(const K& key) const
+                {
+                    if (root == nullptr) return nullptr;
+                    size_t hash = Hash{}(key);
+                    const Node* node = root.get();
+                    for (unsigned shift = 0;; shift += bits) {
+                        unsigned idx = index(hash, shift);
+                        if (!(node->bitmap & (1u << idx))) return nullptr;
+
+                        const Slot& slot = node->slots[position(node->bitmap, idx)];
+                        if (slot.node != nullptr) {
+                            node = slot.node.get();
+                            continue;
+                        }
+                        if (slot.leaf->hash != hash) return nullptr;
+                        for (const auto& entry : slot.leaf->entries)
+                            if (entry.first == key) return &entry.second;
+                        return nullptr;
+                    }
+                }
+
+                inline bool contains(const K& key) const { return find(key) != nullptr; }
+
+                /// @brief binds key to value
+                /// @return whether key is new
+                bool set(const K& key, V value)
+                {
+                    bool added = insert(root, 0, Hash{}(key), key, std::move(value));
+                    if (added) count++;
+                    return added;
+                }
+
+                /// @brief calls fn(key, value) for every entry, in no particular order
+                template <typename F>
+                void each(F&& fn) const
+                {
+                    if (root != nullptr) walk(*root, fn);
+                }
+
+                inline size_t size() const { return count; }
+                inline bool empty() const { return count == 0; }
+                inline void clear() { root = nullptr; count = 0; }
+
+            private:
+                /// @brief the entries of one hash (more than one on a full collision)
+                struct Leaf {
+                    size_t hash;
+                    std::vector<std::pair<K, V>> entries;
+                };
+                struct Node;
+                /// @note either a subtrie or a leaf
+                struct Slot {
+                    std::shared_ptr<Node> node = nullptr;
+                    std::shared_ptr<Leaf> leaf = nullptr;
+                };
+                struct Node {
+                    uint32_t bitmap = 0;
+                    std::vector<Slot> slots = {};
+                };
+
+                static constexpr unsigned bits = 5;
+
+                static inline unsigned index(size_t hash, unsigned shift) { return (hash >> shift) & 31; }
+                /// @brief position of child idx in the compressed slots
+                static inline unsigned position(uint32_t bitmap, unsigned idx) { return std::popcount(bitmap & ((1u << idx) - 1)); }
+
+                /// @brief makes node writable, copying it if another trie shares it
+                template <typename T>
+                static inline void own(std::shared_ptr<T>& node)
+                {
+                    if (node == nullptr) node = std::make_shared<T>();
+                    else if (node.use_count() > 1) node = std::make_shared<T>(*node);
+                }
+
+                static bool insert(std::shared_ptr<Node>& node, unsigned shift, size_t hash, const K& key, V&& value)
+                {
+                    own(node);
+                    unsigned idx = index(hash, shift);
+                    unsigned pos = position(node->bitmap, idx);
+
+                    if (!(node->bitmap & (1u << idx))) {
+                        node->slots.insert(node->slots.begin() + pos, Slot{nullptr, std::make_shared<Leaf>(Leaf{hash, {{key, std::move(value)}}})});
+                        node->bitmap |= 1u << idx;
+                        return true;
+                    }
+
+                    Slot& slot = node->slots[pos];
+                    if (slot.node != nullptr)
+                        return insert(slot.node, shift + bits, hash, key, std::move(value));
+
+                    if (slot.leaf->hash == hash) {
+                        own(slot.leaf);
+                        for (auto& entry : slot.leaf->entries) {
+                            if (entry.first == key) {
+                                entry.second = std::move(value);
+                                return false;
+                            }
+                        }
+                        slot.leaf->entries.emplace_back(key, std::move(value));
+                        return true;
+                    }
+
+                    // two hashes share this prefix, the leaf moves a level down
+                    auto child = std::make_shared<Node>();
+                    child->bitmap = 1u << index(slot.leaf->hash, shift + bits);
+                    child->slots.push_back(Slot{nullptr, std::move(slot.leaf)});
+                    slot = Slot{std::move(child), nullptr};
+                    return insert(slot.node, shift + bits, hash, key, std::move(value));
+                }
+
+                template <typename F>
+                static void walk(const Node& node, F& fn)
+                {
+                    for (const auto& slot : node.slots) {
+                        if (slot.node != nullptr) {
+                            walk(*slot.node, fn);
+                            continue;
+                        }
+                        for (const auto& entry : slot.leaf->entries)
+                            fn(entry.first, entry.second);
+                    }
+                }
+
+                std::shared_ptr<Node> root = nullptr;
+                size_t count = 0;
+        };
+    }
+}
@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Hoist
+        /// @brief Loop invariant code motion over a resolved (type inferred) program
+        /// @details moves the expressions of a `for` loop that only read values the
+        ///          loop never writes (the resolver's write sets) to the pre-header of
+        ///          the outermost loop they are invariant in, the loop then reads them
+        ///          from a frame slot. The pre-header runs before the first test of
+        ///          the condition, even when the body never does, so only expressions
+        ///          that cannot fail (typed binaries, no division) are moved, except
+        ///          for the ones the first test evaluates anyway. Calls never move
+        class Hoist : public ExprVisitor<Token>, StmtVisitor<void>, 
+                             DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                Hoist() = default;
+                ~Hoist() = default;
+
+                /// @brief hoists the program's loop invariants in place
+                /// @return the number of expressions hoisted
+                unsigned run(const std::unique_ptr<Program<Tokens>>& prgm) const;
+
+                /// @brief expressions hoisted so far
+                unsigned hoisted() const { return moved; }
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief moves expr to a pre-header if it is invariant, else looks inside it
+                void hoist(const std::unique_ptr<Expr<Token>>& expr) const;
+                /// @return expr only reads what loop never writes (and cannot fail if speculative)
+                static bool invariant(const Expr<Token>* expr, const For<void>& loop, bool speculative);
+                /// @return frame slots the locals of stmt need (top level)
+                static int frame(const Stmt<void>* stmt);
+                /// @brief moves a function body's invariants (its own frame & loops)
+                void function(DeclFunc<Token>::Func& func) const;
+
+                /// @note enclosing loops of the current function, outermost first
+                mutable std::vector<For<void>*> loops = {};
+                /// @note first frame slot no local of the current function uses
+                mutable int high = 0;
+                /// @note the expression is evaluated by the first test of the innermost condition
+                mutable bool must = false;
+                mutable unsigned moved = 0;
+        };
+    }
+}
@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <unordered_map>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Infer
+        /// @brief Flow sensitive type inference over a resolved (folded) program
+        /// @details tags the binary operations whose operands are statically known to
+        ///          be ints, doubles or strings, the evaluator runs those without
+        ///          checking the operand types. Frame locals & globals are tracked
+        ///          along the control flow (merged at joins, iterated to a fixpoint
+        ///          over loops), a call forgets what is known about the globals and
+        ///          captured (boxed) locals, parameters & call results are unknown
+        class Infer : public ExprVisitor<Token>, StmtVisitor<void>, 
+                             DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                Infer() = default;
+                ~Infer() = default;
+
+                /// @brief tags the program in place
+                /// @return the number of operations specialized
+                unsigned run(const std::unique_ptr<Program<Tokens>>& prgm) const;
+
+                /// @brief operations specialized so far
+                unsigned specialized() const { return tagged; }
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief what is known at a point of the program (absent: Unknown)
+                struct Types {
+                    std::unordered_map<int, Kind> frame = {};
+                    std::unordered_map<string, Kind> globals = {};
+
+                    bool operator==(const Types& other) const = default;
+                };
+
+                /// @return the kind of expr (after visiting it)
+                Kind kind(const std::unique_ptr<Expr<Token>>& expr) const;
+                /// @brief records the kind of a resolved variable
+                void bind(Storage storage, int slot, const string& name, Kind kind) const;
+                /// @brief analyses a function body on its own
+                void function(const DeclFunc<Token>::Func& func) const;
+                /// @return what holds after either a or b
+                static Types merge(const Types& a, const Types& b);
+
+                mutable Types types = {};
+                /// @note kind of the expression visited last
+                mutable Kind last = Kind::Unknown;
+                mutable unsigned tagged = 0;
+        };
+    }
+}
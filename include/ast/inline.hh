@@ -0,0 +1,110 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Inline
+        /// @brief Inlines calls to small, non-recursive, single-return top level functions
+        /// @details a call to `func f(a) { return <expr>; }` becomes a copy of <expr> with
+        ///          the arguments in place of the parameters, so no frame is pushed and
+        ///          no callee looked up. Arguments are only substituted where that cannot
+        ///          change what the program does: literals & variable reads anywhere,
+        ///          other pure expressions at the single unconditional use of their
+        ///          parameter, locals of the caller's frame once the body makes calls
+        class Inline : public ExprVisitor<Token>, StmtVisitor<void>, 
+                              DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                /// @param limit largest body (in nodes) inlined
+                /// @param depth how deep calls inside inlined bodies are inlined in turn
+                Inline(unsigned limit = 16, unsigned depth = 3): limit(limit), depth(depth) {};
+                ~Inline() = default;
+
+                /// @brief inlines the program's calls in place
+                /// @return the number of calls inlined
+                unsigned run(const std::unique_ptr<Program<Tokens>>& prgm) const;
+
+                /// @brief calls inlined so far
+                unsigned inlined() const { return count; }
+
+                /// @return global names something other than their function declaration writes
+                static std::unordered_set<string> written(const std::unique_ptr<Program<Tokens>>& prgm);
+                /// @return every name an assignment writes (locals included)
+                static std::unordered_set<string> assigned(const std::unique_ptr<Program<Tokens>>& prgm);
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief how a body uses its parameters
+                struct Uses {
+                    std::vector<unsigned> reads = {};
+                    /// @note some read of the parameter may not run (short circuit, ternary)
+                    std::vector<bool> conditional = {};
+                    bool calls = false;
+                };
+
+                /// @brief inlines the calls in expr (and expr itself if it is one)
+                void expand(const std::unique_ptr<Expr<Token>>& expr) const;
+                /// @return the inlined body for call (nullptr: not inlined)
+                std::unique_ptr<Expr<Token>> substitute(const Call<Token>& call) const;
+
+                /// @return uses of the parameters, false if the body cannot be inlined
+                static bool scan(const Expr<Token>* expr, const string& self, Uses& uses, bool conditional);
+                /// @return a copy of expr, params[i] in place of the reads of frame slot i
+                static std::unique_ptr<Expr<Token>> clone(const Expr<Token>* expr, const std::vector<const Expr<Token>*>& params);
+                static unsigned size(const Expr<Token>* expr);
+
+                unsigned limit, depth;
+                /// @note single-return top level functions by name, bodies being inlined
+                mutable std::unordered_map<string, const DeclFunc<Token>::Func*> funcs = {};
+                mutable std::vector<string> active = {};
+                /// @note top level functions declared ahead of what is visited
+                mutable std::unordered_set<string> declared = {};
+                mutable unsigned count = 0;
+        };
+    }
+}
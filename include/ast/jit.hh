@@ -0,0 +1,152 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <ast/bytecode.hh>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+    #define RIFT_JIT 1
+#endif
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Assembler
+        /// @brief Just the x86-64 the jit emits: 32 bit integer ops on the low eight
+        ///        registers, byte & dword memory operands off a base register, jumps to labels
+        class Assembler
+        {
+            public:
+                enum Reg : uint8_t { rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi };
+                /// @note the condition codes, as jcc & setcc encode them
+                enum Cond : uint8_t { O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G };
+                struct Mem { Reg base; int32_t disp; };
+                using Label = size_t;
+
+                Assembler() = default;
+                ~Assembler() = default;
+
+                void mov(Reg dst, int32_t imm);
+                void mov(Reg dst, Reg src);
+                void mov(Reg dst, Mem src);
+                void mov(Mem dst, Reg src);
+                void mov8(Mem dst, uint8_t imm);
+                /// @note src: al, cl, dl or bl
+                void mov8(Mem dst, Reg src);
+                void mov32(Mem dst, int32_t imm);
+                void movzx8(Reg dst, Mem src);
+                void movzx8(Reg dst, Reg src);
+
+                void add(Reg dst, Mem src);
+                void add(Reg dst, int32_t imm);
+                void sub(Reg dst, Mem src);
+                void sub(Reg dst, int32_t imm);
+                void imul(Reg dst, Mem src);
+                void imul(Reg dst, int32_t imm);
+                void cmp(Reg left, Mem right);
+                void cmp(Reg left, int32_t imm);
+                void cmp8(Mem left, uint8_t imm);
+                void cmp8(Reg left, uint8_t imm);
+                void neg(Reg dst);
+                void cdq();
+                void idiv(Reg divisor);
+                void setcc(Cond cond, Reg dst);
+
+                Label label();
+                void bind(Label label);
+                void jmp(Label label);
+                void jcc(Cond cond, Label label);
+                void ret();
+
+                /// @return the code, every jump resolved
+                const std::vector<uint8_t>& finish();
+
+            private:
+                void byte(uint8_t b);
+                void dword(int32_t d);
+                /// @brief a ModRM addressing [base + disp32]
+                void mem(uint8_t reg, Mem m);
+                /// @brief a ModRM addressing a register
+                void direct(uint8_t reg, Reg rm);
+                void rel32(Label label);
+
+                std::vector<uint8_t> code = {};
+                std::vector<int64_t> bound = {};
+                /// @note where each jump's rel32 is & its label
+                std::vector<std::pair<size_t, Label>> fixups = {};
+        };
+
+        /// @brief a proto's machine code, in pages of its own (writable, then executable)
+        /// @details register windows are read & written in place, so leaving the code
+        ///          at any instruction leaves the interpreter everything to go on with
+        struct Native
+        {
+            /// @return the instruction the interpreter resumes at (| DEOPT if a guard failed)
+            using Entry = uint32_t (*)(Value* regs, uint32_t pc);
+            static constexpr uint32_t DEOPT = 1u << 31;
+
+            Native(void* pages, size_t mapped, size_t size) : pages(pages), mapped(mapped), size(size) {}
+            ~Native();
+            Native(const Native&) = delete;
+            Native& operator=(const Native&) = delete;
+
+            inline uint32_t run(Value* regs, uint32_t pc) const { return reinterpret_cast<Entry>(pages)(regs, pc); }
+
+            void* pages;
+            size_t mapped, size;
+            /// @note instructions the code can be entered at (the start & loop headers)
+            std::vector<bool> entries = {};
+            /// @note guards failed so far
+            unsigned deopts = 0;
+        };
+
+        /// @class Jit
+        /// @brief A baseline jit for the register vm: hot protos (calls & loop iterations
+        ///        past HOT) are translated instruction by instruction to x86-64
+        /// @details ints are unboxed in their registers' values, every instruction checks
+        ///          the types it assumes & leaves to the interpreter when they don't hold.
+        ///          What it doesn't translate (calls, globals, scopes, printing, ...) leaves
+        ///          to the interpreter too, which comes back in at the next loop header
+        class Jit
+        {
+            public:
+                /// @note calls & backward jumps before a proto compiles, guards failing
+                ///       before its code is dropped (the proto stays interpreted)
+                static constexpr unsigned HOT = 100, DEOPTS = 64;
+
+                struct Stats {
+                    string name;
+                    size_t bytes = 0, instrs = 0, translated = 0;
+                    double ms = 0;
+                };
+
+                Jit() = default;
+                ~Jit() = default;
+
+                /// @return the proto's code, nullptr if too little of it translates (or no jit here)
+                std::shared_ptr<Native> compile(const Proto& proto);
+
+                const std::vector<Stats>& stats() const { return compiled; }
+
+            private:
+                std::vector<Stats> compiled = {};
+        };
+    }
+}
@@ -38,14 +38,22 @@ namespace rift
         class Parser : public Reader<Token>
         {
             public:
-                Parser(std::shared_ptr<std::vector<Token>> &tokens) : Reader<Token>(tokens), tokens(tokens)  {};
+                Parser(std::shared_ptr<std::vector<Token>> &tokens, bool lazy = false) : Reader<Token>(tokens), tokens(tokens), lazy(lazy)  {};
                 ~Parser() = default;
 
                 /// @brief Parses the tokens and returns an expression
                 std::unique_ptr<Program<Tokens>> parse();
+
+                /// @brief Parses the body of a lazily parsed function
+                /// @return false if there was nothing left to parse
+                static bool materialize(DeclFunc<Token>::Func& func);
             protected:
                 std::shared_ptr<std::vector<Token>> tokens;
                 std::exception exception;
+                /// @brief only brace-match the bodies of top level functions
+                bool lazy;
+                /// @brief block nesting depth
+                unsigned depth = 0;
 
             private:
                 #pragma mark - Grammar Evaluators
@@ -112,7 +120,7 @@ namespace rift
                 /// @example 1, 2, 3
                 Tokens params();
                 /// @example 1+1, "str", a
-                Call<Token>::Exprs args(Tokens params);
+                Call<Token>::Exprs args();
                 /// @note program
                 std::unique_ptr<Program<Tokens>> program();
                 
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <functional>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Verifier
+        /// @brief Counts the nodes of a program & checks what the passes rely on
+        /// @details every required child is there and every resolved variable has a
+        ///          usable slot (inside its function's frame for frame locals)
+        class Verifier : public ExprVisitor<Token>, StmtVisitor<void>, 
+                                DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                Verifier() = default;
+                ~Verifier() = default;
+
+                /// @return the number of nodes in the program
+                unsigned count(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @return what is broken in the program (empty: nothing)
+                string verify(const std::unique_ptr<Program<Tokens>>& prgm) const;
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief visits a required child
+                template <typename Node>
+                void visit(const std::unique_ptr<Node>& node, const string& what) const;
+                /// @brief checks a resolved variable reference
+                void slot(Storage storage, int depth, int slot, const Token& name) const;
+                void function(const DeclFunc<Token>::Func& func) const;
+                void check(bool ok, const string& what) const;
+
+                mutable unsigned nodes = 0;
+                mutable string broken = "";
+                /// @note frame size of the function being visited (-1: top level)
+                mutable int frame = -1;
+                /// @note variables the function being visited captures
+                mutable int captures = 0;
+        };
+
+        /// @class PassManager
+        /// @brief Runs a sequence of AST to AST passes over a resolved program
+        /// @details between passes the tree is verified (debug builds only), each
+        ///          pass is timed & when profiling the node count before and after
+        ///          it is recorded too
+        class PassManager
+        {
+            public:
+                /// @return a summary of what the pass did
+                using Run = std::function<string(const std::unique_ptr<Program<Tokens>>&)>;
+
+                struct Stats {
+                    string name, report;
+                    double ms = 0;
+                    unsigned before = 0, after = 0;
+                };
+
+                PassManager(bool profile = false): profile(profile) {};
+                ~PassManager() = default;
+
+                /// @brief the pipeline of an optimization level
+                /// @param level 0 (nothing), 1 (fold, prune), 2 (inline, fold & evaluate pure calls, prune, infer, hoist)
+                /// @param interactive the program may be extended later (a prompt)
+                /// @param inlineSize largest function inlined, in nodes (0: no inlining)
+                /// @param ctfeSteps budget of each call to a pure function evaluated while folding (0: none are)
+                static PassManager pipeline(unsigned level, bool interactive, unsigned inlineSize = 16, bool profile = false, unsigned ctfeSteps = 10000);
+
+                /// @brief appends a pass to the sequence
+                void add(const string& name, Run run);
+                /// @brief runs every pass in order over prgm
+                void run(const std::unique_ptr<Program<Tokens>>& prgm);
+
+                /// @brief names of the passes, in order
+                std::vector<string> passes() const;
+                /// @brief one entry per pass run so far
+                const std::vector<Stats>& stats() const { return ran; }
+
+            private:
+                /// @brief aborts if a pass left the tree malformed (debug builds)
+                static void verify(const std::unique_ptr<Program<Tokens>>& prgm, const string& after);
+
+                bool profile;
+                std::vector<std::pair<string, Run>> sequence = {};
+                std::vector<Stats> ran = {};
+        };
+    }
+}
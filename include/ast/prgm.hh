@@ -45,6 +45,19 @@ namespace rift
                 Program(vec_t&& decls): decls(std::move(decls)) {}
                 virtual ~Program() = default;
                 friend class Eval;
+                friend class Serializer;
+                friend class Resolver;
+                friend class Fold;
+                friend class Prune;
+                friend class Infer;
+                friend class Hoist;
+                friend class Inline;
+                friend class Ctfe;
+                friend class Verifier;
+                friend class Compiler;
+                friend class RegisterCompiler;
+                friend class ThunkCompiler;
+                friend class SSABuilder;
 
                 T accept(const ProgramVisitor<T> &visitor) { return visitor.visit_program(*this); }
 
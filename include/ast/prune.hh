@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Prune
+        /// @brief Dead-branch & unreachable code elimination over a resolved (folded) program
+        /// @details drops if/elif/else arms whose literal condition never holds (and
+        ///          every arm after one that always does), statements after a return,
+        ///          loop bodies that never run and top level functions the entry
+        ///          program never references
+        class Prune : public ExprVisitor<Token>, StmtVisitor<void>, 
+                             DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                Prune() = default;
+                ~Prune() = default;
+
+                /// @brief prunes the program in place
+                /// @param functions also drop unreferenced top level functions
+                ///        (not for the REPL, later lines may still call them)
+                void run(const std::unique_ptr<Program<Tokens>>& prgm, bool functions) const;
+
+                /// @brief statements/arms & top level functions removed so far
+                unsigned statements() const { return stmts; }
+                unsigned functions() const { return funcs; }
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief prunes a list of declarations, cutting it after a return
+                void prune(std::vector<std::unique_ptr<Decl<Token>>>& decls) const;
+                /// @return what is left of stmt (nullptr: nothing)
+                std::unique_ptr<Stmt<void>> simplify(std::unique_ptr<Stmt<void>> stmt) const;
+                /// @return what is left of an if statement (nullptr: nothing)
+                std::unique_ptr<Stmt<void>> branch(std::unique_ptr<Stmt<void>> stmt, StmtIf<void>* ifs) const;
+                /// @brief prunes the body of an if arm
+                void body(StmtIf<void>::Stmt* arm) const;
+
+                /// @brief marks a global name as referenced
+                void ref(const string& name) const;
+                /// @brief references made from a function's body
+                void scan(const DeclFunc<Token>::Func& func) const;
+
+                /// @note global names referenced, in the order they were found
+                mutable std::unordered_set<string> refs = {};
+                mutable std::vector<string> found = {};
+                mutable unsigned stmts = 0, funcs = 0;
+        };
+    }
+}
@@ -0,0 +1,146 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#pragma once
+
+#include <ast/bytecode.hh>
+#include <ast/eval.hh>
+#include <ast/jit.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class RegisterCompiler
+        /// @brief Lowers a resolved program into three address code for the register vm
+        /// @details frame locals are registers themselves (an operand reads them in
+        ///          place), temporaries come right after the frame and constants are
+        ///          operands of their own (`x = x + 1` is a single AddK)
+        class RegisterCompiler : public ExprVisitor<Token>, StmtVisitor<void>, 
+                                        DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                RegisterCompiler() = default;
+                ~RegisterCompiler() = default;
+
+                /// @return the script's code, nullptr if it uses something only Eval runs (classes)
+                std::shared_ptr<Proto> compile(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @brief compiles a function's body into its proto
+                /// @return false if the body uses something only Eval runs
+                bool compile(const DeclFunc<Token>::Func& func, Proto& proto) const;
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @return the instruction's index
+                size_t emit(RegOp op, size_t a = 0, size_t b = 0, size_t c = 0, int line = 0) const;
+                /// @brief points the jump at the next instruction
+                void patch(size_t at) const;
+                size_t constant(Value value) const;
+
+                /// @brief a fresh temporary (numbered apart from the frame until relocate)
+                int temp() const;
+                /// @brief temporaries move behind the frame, whose size is only known at the end
+                void relocate(Proto& target) const;
+
+                /// @brief evaluates expr into the register dst
+                void into(const Expr<Token>& expr, int dst) const;
+                /// @return a register holding expr's value (the local itself for frame locals)
+                int operand(const Expr<Token>& expr) const;
+                /// @brief writes the register src to a resolved variable
+                void store(Storage storage, int depth, int slot, const str_t& name, int src) const;
+                /// @brief an assignment whose value is unused
+                void assign(const Assign<Token>& expr) const;
+                void branch(const Stmt<void>* stmt, const Block<void>* blk) const;
+                /// @brief compiles a statement, its temporaries are free again after it
+                void statement(const Stmt<void>& stmt) const;
+
+                mutable Proto* proto = nullptr;
+                /// @note register the expression visited writes to
+                mutable int dst = 0;
+                /// @note temporaries in use & the most the function needed at once
+                mutable int top = 0, temps = 0;
+                mutable bool result = false;
+                mutable bool supported = true;
+        };
+
+        /// @class RegisterMachine
+        /// @brief Runs the RegisterCompiler's code
+        /// @details threaded dispatch (computed goto) where the compiler has labels as
+        ///          values, a switch everywhere else (or with RIFT_SWITCH_DISPATCH).
+        ///          With the jit, hot code is entered at calls & loop back edges
+        class RegisterMachine
+        {
+            public:
+                /// @param jitting compile hot protos to machine code (see Jit)
+                RegisterMachine(bool jitting = false) : jitting(jitting) {};
+                ~RegisterMachine() = default;
+
+                /// @brief Compiles & runs the program (as Eval::evaluate)
+                /// @note programs using something the compiler doesn't cover run under Eval
+                std::vector<string> evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive);
+
+                /// @brief Runs compiled code, the values of its top level declarations
+                std::vector<string> run(const std::shared_ptr<Proto>& script, bool interactive);
+
+                /// @brief what the jit compiled so far
+                const std::vector<Jit::Stats>& jitted() const { return jit.stats(); }
+
+            private:
+                /// @return whether the proto has machine code entered at pc (compiled once it runs hot)
+                bool native(const Proto& proto, size_t pc);
+                /// @brief a guard of the proto's code failed, too many & it stays interpreted
+                void deopt(const Proto& proto);
+
+                /// @brief a caller, resumed when the callee returns (its Call names the result's register)
+                struct Frame
+                {
+                    const Proto* proto;
+                    const Instr* ip;
+                    size_t base;
+                    std::shared_ptr<Scope> scope;
+                    std::shared_ptr<Closure> closure;
+                };
+
+                std::vector<Value> registers = {};
+                std::vector<Frame> frames = {};
+                bool jitting;
+                Jit jit = {};
+        };
+    }
+}
@@ -12,7 +12,10 @@
 ///                                                       ///
 /////////////////////////////////////////////////////////////
 
+#pragma once
+
 #include <unordered_map>
+#include <unordered_set>
 #include <stack>
 #include <ast/eval.hh>
 
@@ -43,6 +46,14 @@ namespace rift
 
                 friend class Eval;
 
+                /// @brief Resolves where the program's variables live (global, frame, boxed or captured)
+                /// @note an escape pass first finds the locals captured by inner functions
+                void resolve(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @brief Resolves a (lazily parsed) top level function body
+                void resolve(DeclFunc<Token>::Func& func) const;
+                /// @brief Resolves a block within the current scopes
+                void resolve(const Block<void>& block) const;
+
                 // expressions
                 Token visit_assign(const Assign<Token>& expr) const override;
                 Token visit_binary(const Binary<Token>& expr) const override;
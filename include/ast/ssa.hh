@@ -0,0 +1,250 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        namespace ssa
+        {
+            /// @brief what an instruction computes
+            enum class Opcode : uint8_t
+            {
+                Const,   ///< a literal (value)
+                Param,   ///< the frame param taking the slot'th argument
+                Phi,     ///< one operand per predecessor of its block, in their order
+                Copy,    ///< a frame local assigned another value
+                Binary,  ///< value is the operator, never a short circuiting one
+                Unary,   ///< value is the operator
+                IsNil,   ///< the operand is nil (the test of `??`)
+                Load,    ///< a global, boxed or captured variable
+                Store,   ///< writes its operand to a global, boxed or captured variable
+                Closure, ///< a nested function's closure
+                Call,    ///< calls its first operand with the others (one per name)
+                Enter,   ///< pushes a heap scope of slot boxes (captured locals)
+                Leave,   ///< pops it
+                Print,
+                Jump,    ///< to the block's successor
+                Branch,  ///< to the first successor if the operand is truthy, else the second
+                Return
+            };
+
+            struct Block;
+
+            /// @brief an instruction and the value it defines
+            struct Inst
+            {
+                Opcode op;
+                Block* block = nullptr;
+                /// @note def-use chains: operands & the instructions using this one (once per use)
+                std::vector<Inst*> args = {};
+                std::vector<Inst*> users = {};
+
+                /// @note the literal, operator or variable's name
+                Token value = {};
+                /// @note where a loaded, stored or called variable lives
+                Storage storage = Storage::Global;
+                int depth = 0, slot = 0;
+                /// @note binary operand types (Infer), unknown if they may fail at runtime
+                Kind operands = Kind::Unknown;
+                const DeclFunc<Token>::Func* func = nullptr;
+
+                Inst(Opcode op): op(op) {}
+
+                inline bool terminator() const { return op == Opcode::Jump || op == Opcode::Branch || op == Opcode::Return; }
+                /// @brief dropping it when unused can't change what the program does
+                bool pure() const;
+            };
+
+            /// @brief a basic block: phis first, a terminator last
+            struct Block
+            {
+                unsigned id = 0;
+                std::vector<std::unique_ptr<Inst>> insts = {};
+                std::vector<Block*> preds = {}, succs = {};
+
+                inline Inst* terminator() const { return insts.empty() || !insts.back()->terminator() ? nullptr : insts.back().get(); }
+            };
+
+            /// @class Function
+            /// @brief A function body in ssa form, its entry is the first block
+            class Function
+            {
+                public:
+                    Function(const Token& name): name(name) {}
+                    ~Function() = default;
+
+                    Token name;
+                    Tokens params = {};
+                    /// @note the declaration lowered (nullptr: the script)
+                    const DeclFunc<Token>::Func* func = nullptr;
+                    std::vector<std::unique_ptr<Block>> blocks = {};
+
+                    Block* block();
+                    /// @brief appends an instruction (before the terminator, phis before the rest)
+                    Inst* append(Block* blk, Opcode op, std::vector<Inst*> args = {});
+                    /// @brief adds an operand, keeping the def-use chains
+                    void use(Inst* inst, Inst* arg);
+                    /// @brief points every use of old at val
+                    void replace(Inst* old, Inst* val);
+                    /// @brief unlinks an instruction (its memory lives until sweep)
+                    void erase(Inst* inst);
+                    /// @brief a control flow edge
+                    void link(Block* from, Block* to);
+                    /// @brief removes one edge from -> to & the phi operands of it
+                    void unlink(Block* from, Block* to);
+                    /// @brief frees what erase unlinked
+                    void sweep() { erased.clear(); }
+
+                    /// @brief blocks in reverse post order from the entry
+                    std::vector<Block*> order() const;
+                    /// @brief drops the blocks the entry doesn't reach
+                    unsigned prune();
+
+                    /// @return the text form: a `bN:` label per block (& its predecessors), then
+                    ///         an instruction per line, `%N = ...` for those defining a value
+                    string dump() const;
+                    /// @return what is broken in the function (empty: nothing)
+                    string verify() const;
+
+                private:
+                    std::vector<std::unique_ptr<Inst>> erased = {};
+                    unsigned blockId = 0;
+            };
+
+            /// @class Optimizer
+            /// @brief Scalar optimizations over a function in ssa form
+            /// @details sparse conditional constant propagation, copy propagation, global
+            ///          value numbering over the dominator tree, dead code elimination &
+            ///          merging of straight line blocks, repeated until none of them
+            ///          changes anything
+            class Optimizer
+            {
+                public:
+                    struct Report {
+                        unsigned folded = 0, branches = 0, copies = 0, numbered = 0, dead = 0, merged = 0;
+                    };
+
+                    Optimizer() = default;
+                    ~Optimizer() = default;
+
+                    Report run(Function& fn) const;
+
+                    /// @return the instructions folded to constants & (in branches) the branches resolved
+                    unsigned sccp(Function& fn, unsigned& branches) const;
+                    /// @return the copies & trivial phis forwarded to their value
+                    unsigned copies(Function& fn) const;
+                    /// @return the instructions a dominating equivalent replaced
+                    unsigned gvn(Function& fn) const;
+                    /// @return the instructions removed
+                    unsigned dce(Function& fn) const;
+                    /// @return the blocks merged into their only predecessor
+                    unsigned merge(Function& fn) const;
+            };
+        }
+
+        /// @class SSABuilder
+        /// @brief Lowers resolved function bodies into ssa form
+        /// @details frame locals become ssa values (phis placed as the blocks are
+        ///          sealed, Braun et al.), every other variable is loaded & stored
+        ///          explicitly. Short circuits & ternaries are control flow
+        class SSABuilder : public ExprVisitor<Token>, StmtVisitor<void>, 
+                                  DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                SSABuilder() = default;
+                ~SSABuilder() = default;
+
+                /// @brief lowers the script & every function it declares (nested ones too)
+                /// @note skips what uses something only Eval runs (classes), parses lazy bodies first
+                std::vector<std::unique_ptr<ssa::Function>> build(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @return nullptr if the body uses something only Eval runs
+                /// @note a lazily parsed body is parsed & resolved first, as on its first call
+                std::unique_ptr<ssa::Function> build(const DeclFunc<Token>::Func& func) const;
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @brief the function being built & where code goes
+                struct State {
+                    std::unique_ptr<ssa::Function> fn = nullptr;
+                    ssa::Block* cur = nullptr;
+                    /// @note the value of each frame slot at the end of a block
+                    std::unordered_map<ssa::Block*, std::unordered_map<int, ssa::Inst*>> defs = {};
+                    /// @note phis of blocks whose predecessors aren't all known yet
+                    std::unordered_map<ssa::Block*, std::unordered_map<int, ssa::Inst*>> incomplete = {};
+                    std::unordered_set<ssa::Block*> sealed = {};
+                    /// @note phis whose operands are being read
+                    std::unordered_set<ssa::Inst*> pending = {};
+                    bool supported = true;
+                };
+
+                ssa::Inst* lower(const Expr<Token>& expr) const;
+                ssa::Inst* emit(ssa::Opcode op, std::vector<ssa::Inst*> args = {}) const;
+                ssa::Inst* constant(const Token& tok) const;
+                /// @brief ends the current block
+                void jump(ssa::Block* to) const;
+                void branch(ssa::Inst* cond, ssa::Block* yes, ssa::Block* no) const;
+                /// @brief a phi of the values each predecessor of the current block brings
+                ssa::Inst* merge(const std::vector<std::pair<ssa::Block*, ssa::Inst*>>& values) const;
+
+                /// @brief frame slots as ssa values
+                void write(int slot, ssa::Block* blk, ssa::Inst* val) const;
+                ssa::Inst* read(int slot, ssa::Block* blk) const;
+                ssa::Inst* operands(int slot, ssa::Inst* phi) const;
+                ssa::Inst* trivial(ssa::Inst* phi) const;
+                /// @brief every predecessor of the block is known
+                void seal(ssa::Block* blk) const;
+
+                void assign(Storage storage, int depth, int slot, const Token& name, ssa::Inst* val) const;
+                void branch(const Stmt<void>* stmt, const Block<void>* blk) const;
+
+                mutable State state = {};
+                mutable ssa::Inst* value = nullptr;
+                mutable std::vector<std::unique_ptr<ssa::Function>> built = {};
+        };
+    }
+}
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <unordered_set>
 #include <ast/expr.hh>
 #include <ast/grmr.hh>
 #include <utils/macros.hh>
@@ -154,6 +155,9 @@ namespace rift
             public:
                 using vec_prog = std::vector<std::unique_ptr<Decl<Token>>>;
                 vec_prog decls = {};
+                /// @note number of boxed (captured) locals declared in the block
+                ///       & frame slots in use by the end of it (resolver)
+                mutable int slots = 0, frame = 0;
 
                 Block() = default;
                 ~Block() = default;
@@ -162,6 +166,9 @@ namespace rift
 
                 T accept(const StmtVisitor<T> &visitor) const override { return visitor.visit_block_stmt(*this); };
 
+                /// @brief only blocks declaring captured locals need a heap scope
+                inline bool scoped() const { return slots > 0; }
+
                 Block &operator=(const Block<T> &other)
                 {
                     if (this != &other)
@@ -194,7 +201,33 @@ namespace rift
                 std::unique_ptr<Block<void>> blk;   //    {}
                 std::unique_ptr<Stmt<void>> stmt_o; //    todo: used for lambdas <future impl>
 
+                /// @brief what the loop (condition, increment & body) may write
+                struct Writes {
+                    std::unordered_set<int> frame = {};
+                    std::unordered_set<std::string> globals = {};
+                    /// @note a captured local is written, a call is made (callees may write globals & captured locals)
+                    bool boxed = false, calls = false;
+                };
+                /// @note resolver: filled in by the slot pass (not cached, only the optimizer reads it)
+                mutable Writes writes = {};
+
+                /// @note loop invariant code motion: assignments of the hoisted expressions
+                ///       to frame slots, run once before the loop (pre-header)
+                std::vector<std::unique_ptr<Assign<Token>>> invariants = {};
+                /// @note frame size the pre-header slots need
+                int frame = 0;
+
                 T accept(const StmtVisitor<T> &visitor) const override { return visitor.visit_for_stmt(*this); };
+
+                /// @brief the pre-header as every engine runs it: room for the frame slots it
+                ///        fills (room(frame)), then each invariant lowered in order
+                template <typename Room, typename Lower>
+                void preheader(Room&& room, Lower&& lower) const {
+                    if (invariants.empty()) return;
+                    room(frame);
+                    for (const auto& inv : invariants)
+                        lower(*inv);
+                }
         };
     }
 }
\ No newline at end of file
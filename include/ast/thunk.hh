@@ -0,0 +1,142 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <ast/bytecode.hh>
+#include <ast/eval.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        struct Activation;
+
+        /// @brief a node compiled once into its specialized code & the operands it needs
+        /// @details each shape of a node gets its own code (a Binary over two frame locals
+        ///          reads both slots & computes in one call), so running a program makes
+        ///          one indirect call per node instead of an accept/visit pair & a switch
+        struct Thunk
+        {
+            using Fn = Value (*)(const Thunk&, Activation&);
+
+            Fn fn = nullptr;
+            /// @note slots, depths, global indices or flags, as the code reads them
+            int a = 0, b = 0;
+            /// @note a constant operand & the operator (its line, the generic semantics)
+            Value k = {};
+            Token op = {};
+            std::vector<Thunk> kids = {};
+            /// @note the function a declaration binds & the site of a call
+            std::shared_ptr<Proto> proto = nullptr;
+            std::shared_ptr<Site> site = nullptr;
+
+            inline Value operator()(Activation& act) const { return fn(*this, act); }
+        };
+
+        /// @brief the state of a call (or the script) the thunks run against
+        struct Activation
+        {
+            Value* slots = nullptr;
+            std::shared_ptr<Scope> scope = nullptr;
+            Closure* closure = nullptr;
+            /// @note a return sets it, every block & loop up to the call unwinds
+            bool returning = false;
+            Value ret = {};
+            bool interactive = false;
+            /// @note values of the top level declarations (script only)
+            std::vector<Value>* results = nullptr;
+        };
+
+        /// @class ThunkCompiler
+        /// @brief Converts a resolved program into a tree of thunks, once
+        /// @note reuses everything up to resolution (& the optimizer), only the
+        ///       dispatch of the tree walker goes away
+        class ThunkCompiler : public ExprVisitor<Token>, StmtVisitor<void>, 
+                                     DeclVisitor<Token>, ProgramVisitor<Tokens>
+        {
+            public:
+                ThunkCompiler() = default;
+                ~ThunkCompiler() = default;
+
+                /// @return the script, nullptr if it uses something only Eval runs (classes)
+                std::shared_ptr<Proto> compile(const std::unique_ptr<Program<Tokens>>& prgm) const;
+                /// @brief compiles a function's body into its proto
+                /// @return false if the body uses something only Eval runs
+                bool compile(const DeclFunc<Token>::Func& func, Proto& proto) const;
+
+                // expressions
+                Token visit_assign(const Assign<Token>& expr) const override;
+                Token visit_binary(const Binary<Token>& expr) const override;
+                Token visit_grouping(const Grouping<Token>& expr) const override;
+                Token visit_literal(const Literal<Token>& expr) const override;
+                Token visit_var_expr(const VarExpr<Token>& expr) const override;
+                Token visit_unary(const Unary<Token>& expr) const override;
+                Token visit_ternary(const Ternary<Token>& expr) const override;
+                Token visit_call(const Call<Token>& expr) const override;
+
+                // statements
+                void visit_expr_stmt(const StmtExpr<void>& stmt) const override;
+                void visit_print_stmt(const StmtPrint<void>& stmt) const override;
+                void visit_if_stmt(const StmtIf<void>& stmt) const override;
+                void visit_return_stmt(const StmtReturn<void>& stmt) const override;
+                void visit_block_stmt(const Block<void>& block) const override;
+                void visit_for_stmt(const For<void>& decl) const override;
+
+                // declarations
+                Token visit_decl_stmt(const DeclStmt<Token>& decl) const override;
+                Token visit_decl_var(const DeclVar<Token>& decl) const override;
+                Token visit_decl_func(const DeclFunc<Token>& decl) const override;
+                Token visit_decl_class(const DeclClass<Token>& decl) const override;
+
+                // program
+                Tokens visit_program(const Program<Tokens>& prgm) const override;
+
+            private:
+                /// @return the thunk of an expression, statement or declaration
+                Thunk lower(const Expr<Token>& expr) const;
+                Thunk lower(const Stmt<void>& stmt) const;
+                Thunk lower(const Decl<Token>& decl) const;
+                Thunk branch(const Stmt<void>* stmt, const Block<void>* blk) const;
+                /// @brief writes the value of src to a resolved variable
+                Thunk store(Storage storage, int depth, int slot, const str_t& name, Thunk src) const;
+                /// @brief the frame slot is in use
+                void reserve(int slot) const;
+
+                mutable Proto* proto = nullptr;
+                /// @note the thunk the last visit built
+                mutable Thunk out = {};
+                mutable bool result = false;
+                mutable bool supported = true;
+        };
+
+        /// @class ThunkMachine
+        /// @brief Runs the ThunkCompiler's thunks
+        /// @details calls recurse on the native stack as the tree walker's do, frames of
+        ///          up to 8 slots live right there (bigger ones on the heap)
+        class ThunkMachine
+        {
+            public:
+                ThunkMachine() = default;
+                ~ThunkMachine() = default;
+
+                /// @brief Compiles & runs the program (as Eval::evaluate)
+                /// @note programs using something the compiler doesn't cover run under Eval
+                std::vector<string> evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive);
+
+                /// @brief Runs a compiled script, the values of its top level declarations
+                std::vector<string> run(const std::shared_ptr<Proto>& script, bool interactive);
+        };
+    }
+}
@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#pragma once
+
+#include <ast/bytecode.hh>
+#include <ast/compiler.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @class Machine
+        /// @brief A stack vm running the Compiler's bytecode
+        /// @details locals live in one flat array (a frame per call), captured ones in
+        ///          heap scopes, temporaries on an operand stack. Calls push a frame
+        ///          record instead of recursing, so the dispatch loop never leaves
+        class Machine
+        {
+            public:
+                Machine() = default;
+                ~Machine() = default;
+
+                /// @brief Compiles & runs the program (as Eval::evaluate)
+                /// @note programs using something the compiler doesn't cover run under Eval
+                std::vector<string> evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive);
+
+                /// @brief Runs compiled code, the values of its top level declarations
+                std::vector<string> run(const std::shared_ptr<Proto>& script, bool interactive);
+
+                /// @brief drops every global (new program, new table)
+                static void reset();
+
+            private:
+                /// @brief a caller, resumed when the callee returns
+                struct Frame
+                {
+                    const Proto* proto;
+                    const uint8_t* ip;
+                    size_t base;
+                    std::shared_ptr<Scope> scope;
+                    std::shared_ptr<Closure> closure;
+                };
+
+                std::vector<Value> stack = {};
+                std::vector<Value> locals = {};
+                std::vector<Frame> frames = {};
+        };
+    }
+}
@@ -23,6 +23,8 @@
 #include <string>
 #include <iostream>
 
+#define RIFT_VERSION "0.0.1"
+
 namespace rift
 {
     namespace driver
@@ -32,9 +34,29 @@ namespace rift
             {"help",        no_argument,       0,  'h' },
             {"version",     no_argument,       0,  'v' },
             {"interactive", no_argument,       0,  'i' },
+            {"no-cache",    no_argument,       0,  'n' },
+            {"lazy",        no_argument,       0,  'l' },
+            {"opt-stats",   no_argument,       0,  's' },
+            {"inline-size", required_argument, 0,  'I' },
+            {"copy-stats",  no_argument,       0,  'c' },
+            {"engine",      required_argument, 0,  'e' },
+            {"jit",         no_argument,       0,  'j' },
+            {"jit-stats",   no_argument,       0,  'J' },
+            {"dump-ssa",    no_argument,       0,  'D' },
+            {"emit-c",      required_argument, 0,  'C' },
+            {"ctfe-steps",  required_argument, 0,  'E' },
             {nullptr, 0, nullptr, 0}
         };
 
+        /// @brief what runs the program
+        enum class Engine
+        {
+            Eval,     ///< the tree walker
+            VM,       ///< bytecode on the stack vm
+            Register, ///< three address code on the register vm
+            Thunk     ///< the ast compiled into pre-bound closures
+        };
+
         class Driver
         {
             public:
@@ -55,12 +77,41 @@ namespace rift
                 void version();
                 /// @brief Help
                 void help();
+                /// @brief The unsigned value of a numeric option (usage error otherwise)
+                unsigned number(const std::string& option, const char* arg);
 
                 /// @brief Runs the compiler
                 void runFile(std::string path);
 
                 /// @brief Runs the interpreter
                 void runPrompt();
+
+                /// @brief Scans, parses, resolves & evaluates the source
+                void run(std::string lines, bool interactive);
+
+                #pragma mark - Options
+                /// @brief Reuse parsed programs from the ast cache (files only)
+                bool cache = true;
+                /// @brief Only brace-match function bodies until their first call
+                bool lazy = false;
+                /// @brief Report what the optimization passes did (stderr)
+                bool stats = false;
+                bool copyStats = false;
+                /// @note 0: no optimization, 1: folding & pruning, 2: every pass
+                unsigned level = 2;
+                /// @note largest function body inlined, in nodes (0: no inlining)
+                unsigned inlineSize = 16;
+                /// @note steps a call to a pure function may take at compile time (0: never evaluated)
+                unsigned ctfeSteps = 10000;
+                Engine engine = Engine::Eval;
+                /// @brief Compile hot code of the register vm to machine code
+                bool jit = false;
+                /// @brief Report what the jit compiled (stderr)
+                bool jitStats = false;
+                /// @brief Print the optimized ssa form of every function (stderr)
+                bool dumpSSA = false;
+                /// @brief Compile the program to this C file & a native executable instead of running it
+                std::string emitC = "";
         };
     }
 }
\ No newline at end of file
@@ -106,22 +106,35 @@ namespace rift
             Token(TokenType type, std::string lexeme, std::any literal, int line)
             {
                 this->type = type;
-                this->lexeme = lexeme;
-                this->literal = literal;
+                this->lexeme = std::move(lexeme);
+                this->literal = std::move(literal);
                 this->line = line;
-                this->l_type = &typeid(literal);
+                this->l_type = &typeid(this->literal);
             }
 
+            /// @note copies the lexeme & the literal, counted (see copies)
             Token(const Token& other) {
                 this->type = other.type;
                 this->lexeme = other.lexeme;
                 this->literal = other.literal;
                 this->line = other.line;
                 this->l_type = other.l_type;
+                copies++;
+            }
+
+            Token(Token&& other) noexcept {
+                this->type = other.type;
+                this->lexeme = std::move(other.lexeme);
+                this->literal = std::move(other.literal);
+                this->line = other.line;
+                this->l_type = other.l_type;
             }
 
             virtual ~Token() = default;
 
+            /// @brief tokens copied so far (moves are free and not counted)
+            inline static size_t copies = 0;
+
             /// @brief Converts a TokenType to a string
             static std::string convertTypeString(TokenType type);
             /// @brief Converts a Token to a string
@@ -137,7 +150,27 @@ namespace rift
             bool operator==(const Token &token) const;
             bool operator!=(const Token &token) const;
 
-            virtual Token& operator=(const Token& other) = default;
+            virtual Token& operator=(const Token& other) {
+                if (this == &other) return *this;
+                this->type = other.type;
+                this->text = other.text;
+                this->lexeme = other.lexeme;
+                this->literal = other.literal;
+                this->line = other.line;
+                this->l_type = other.l_type;
+                copies++;
+                return *this;
+            }
+
+            virtual Token& operator=(Token&& other) noexcept {
+                this->type = other.type;
+                this->text = std::move(other.text);
+                this->lexeme = std::move(other.lexeme);
+                this->literal = std::move(other.literal);
+                this->line = other.line;
+                this->l_type = other.l_type;
+                return *this;
+            }
 
             std::any getLiteral() const;
         };
@@ -30,4 +30,6 @@ namespace rift
 {
     /// @brief evaluates the given values with operation
     extern any any_arithmetic(any left, any right, const Token& op);
+    /// @brief evaluates the literals of the given tokens with operation (no token copies)
+    extern any any_arithmetic(const Token& left, const Token& right, const Token& op);
 }
\ No newline at end of file
@@ -93,23 +93,23 @@
     else if (left.type() == typeid(long long)) \
         return std::any_cast<long long>(left) op std::any_cast<long long>(right); \
     else if (left.type() == typeid(Token))\
-        return any_arithmetic(std::any_cast<Token>(left).getLiteral(), std::any_cast<Token>(right).getLiteral(), op_tok);\
+        return any_arithmetic(std::any_cast<const Token&>(left).getLiteral(), std::any_cast<const Token&>(right).getLiteral(), op_tok);\
     else \
         rift::error::report(op_tok.line, "Arithmetic Error", "Invalid operands for arithmetic operation", Token(), std::exception());
 
-#define _STRING_ARITHMETIC() \
-        if (expr.op.type == TokenType::GREATER) \
-            return (strcmp(castString(left).c_str(),castString(right).c_str())>0) ? Token(TokenType::TRUE, "true", "true", expr.op.line) : Token(TokenType::FALSE, "false", "false", expr.op.line); \
-        else if (expr.op.type == TokenType::LESS) \
-            return (strcmp(castString(left).c_str(),castString(right).c_str())<0) ? Token(TokenType::TRUE, "true", "true", expr.op.line) : Token(TokenType::FALSE, "false", "false", expr.op.line); \
-        else if (expr.op.type == TokenType::GREATER_EQUAL) \
-            return (strcmp(castString(left).c_str(),castString(right).c_str())>=0) ? Token(TokenType::TRUE, "true", "true", expr.op.line) : Token(TokenType::FALSE, "false", "false", expr.op.line); \
-        else if (expr.op.type == TokenType::LESS_EQUAL) \
-            return (strcmp(castString(left).c_str(),castString(right).c_str())<=0) ? Token(TokenType::TRUE, "true", "true", expr.op.line) : Token(TokenType::FALSE, "false", "false", expr.op.line); \
-        else if (expr.op.type == TokenType::EQUAL_EQUAL) \
-            return (strcmp(castString(left).c_str(),castString(right).c_str())==0) ? Token(TokenType::TRUE, "true", "true", expr.op.line) : Token(TokenType::FALSE, "false", "false", expr.op.line); \
-        else if (expr.op.type == TokenType::BANG_EQUAL) \
-            return (strcmp(castString(left).c_str(),castString(right).c_str())!=0) ? Token(TokenType::TRUE, "true", "true", expr.op.line) : Token(TokenType::FALSE, "false", "false", expr.op.line); \
+#define _STRING_ARITHMETIC(op) \
+        if (op.type == TokenType::GREATER) \
+            return (strcmp(castString(left).c_str(),castString(right).c_str())>0) ? Token(TokenType::TRUE, "true", "true", op.line) : Token(TokenType::FALSE, "false", "false", op.line); \
+        else if (op.type == TokenType::LESS) \
+            return (strcmp(castString(left).c_str(),castString(right).c_str())<0) ? Token(TokenType::TRUE, "true", "true", op.line) : Token(TokenType::FALSE, "false", "false", op.line); \
+        else if (op.type == TokenType::GREATER_EQUAL) \
+            return (strcmp(castString(left).c_str(),castString(right).c_str())>=0) ? Token(TokenType::TRUE, "true", "true", op.line) : Token(TokenType::FALSE, "false", "false", op.line); \
+        else if (op.type == TokenType::LESS_EQUAL) \
+            return (strcmp(castString(left).c_str(),castString(right).c_str())<=0) ? Token(TokenType::TRUE, "true", "true", op.line) : Token(TokenType::FALSE, "false", "false", op.line); \
+        else if (op.type == TokenType::EQUAL_EQUAL) \
+            return (strcmp(castString(left).c_str(),castString(right).c_str())==0) ? Token(TokenType::TRUE, "true", "true", op.line) : Token(TokenType::FALSE, "false", "false", op.line); \
+        else if (op.type == TokenType::BANG_EQUAL) \
+            return (strcmp(castString(left).c_str(),castString(right).c_str())!=0) ? Token(TokenType::TRUE, "true", "true", op.line) : Token(TokenType::FALSE, "false", "false", op.line); \
 
 #pragma mark  - Specific Codebase
 
@@ -117,5 +117,5 @@
             resBool = std::any_cast<bool>(any_arithmetic(left, right, op));\
             return Token(resBool?TokenType::TRUE:TokenType::FALSE, resBool?"true":"false", resBool, op.line);\
         } else if (isString(left) && isString(right)) {\
-            _STRING_ARITHMETIC()\
+            _STRING_ARITHMETIC(op)\
         }\
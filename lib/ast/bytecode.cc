@@ -0,0 +1,53 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#include <ast/bytecode.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Value
+
+        Value Value::from(Token tok)
+        {
+            switch (tok.type) {
+                case TokenType::TRUE: return boolean(true);
+                case TokenType::FALSE: return boolean(false);
+                case TokenType::NIL: return {};
+                case TokenType::NUMERICLITERAL: {
+                    // only ints are unboxed, the other numbers keep their exact type
+                    any literal = tok.getLiteral();
+                    if (literal.type() == typeid(int))
+                        return integer(std::any_cast<int>(literal));
+                    break;
+                }
+                default:
+                    break;
+            }
+            return boxed(std::move(tok));
+        }
+
+        Token Value::to(int line) const
+        {
+            switch (type) {
+                case Type::Nil: return Token();
+                case Type::Bool: return b ? Token(TokenType::TRUE, "true", true, line) : Token(TokenType::FALSE, "false", false, line);
+                case Type::Int: return Token(TokenType::NUMERICLITERAL, std::to_string(i), i, line);
+                case Type::Func: return Token(TokenType::FUN, closure().proto->name.lexeme, ref.get(), line);
+                case Type::Boxed: return token();
+            }
+            return Token();
+        }
+    }
+}
@@ -0,0 +1,775 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/cache.hh>
+
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Format
+
+        static constexpr char magic[4] = {'R', 'F', 'T', 'C'};
+        /// @note bump whenever the node layout changes
+        static constexpr uint32_t format = 9;
+
+        /// @brief FNV-1a, continuing from hash
+        static uint64_t fnv1a(const char* bytes, size_t len, uint64_t hash = 0xcbf29ce484222325ULL)
+        {
+            for (size_t i = 0; i < len; i++) {
+                hash ^= (unsigned char)bytes[i];
+                hash *= 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - Serializer
+        ////////////////////////////////////////////////////////////////////////
+
+        std::vector<char> Serializer::serialize(const std::unique_ptr<Program<Tokens>>& prgm, uint64_t key)
+        {
+            nodes.clear();
+            symbols.clear();
+            interned.clear();
+
+            visit_program(*prgm);
+
+            // the symbol table has to precede the nodes referring to it
+            std::vector<char> body;
+            body.swap(nodes);
+            put<uint32_t>(symbols.size());
+            for (const auto& sym : symbols) {
+                put<uint32_t>(sym.size());
+                nodes.insert(nodes.end(), sym.begin(), sym.end());
+            }
+            nodes.insert(nodes.end(), body.begin(), body.end());
+
+            // the header checks everything after it
+            body.clear();
+            body.swap(nodes);
+            nodes.insert(nodes.end(), magic, magic + sizeof(magic));
+            put<uint32_t>(format);
+            put<uint64_t>(key);
+            put<uint64_t>(fnv1a(body.data(), body.size()));
+            nodes.insert(nodes.end(), body.begin(), body.end());
+
+            std::vector<char> out;
+            out.swap(nodes);
+            return out;
+        }
+
+        template <typename T>
+        void Serializer::put(T val) const
+        {
+            const char* bytes = reinterpret_cast<const char*>(&val);
+            nodes.insert(nodes.end(), bytes, bytes + sizeof(T));
+        }
+
+        void Serializer::tag(Node node) const
+        {
+            put<uint8_t>(static_cast<uint8_t>(node));
+        }
+
+        void Serializer::symbol(const string& str) const
+        {
+            auto it = interned.find(str);
+            if (it == interned.end()) {
+                it = interned.insert({str, (uint32_t)symbols.size()}).first;
+                symbols.push_back(str);
+            }
+            put<uint32_t>(it->second);
+        }
+
+        void Serializer::token(const Token& tok) const
+        {
+            put<uint8_t>(tok.type);
+            symbol(tok.lexeme);
+            put<int32_t>(tok.line);
+        }
+
+        void Serializer::expr(const Expr<Token>* expr) const
+        {
+            if (expr == nullptr) tag(Node::Null);
+            else expr->accept(*this);
+        }
+
+        void Serializer::stmt(const Stmt<void>* stmt) const
+        {
+            if (stmt == nullptr) tag(Node::Null);
+            else stmt->accept(*this);
+        }
+
+        void Serializer::decl(const Decl<Token>* decl) const
+        {
+            if (decl == nullptr) tag(Node::Null);
+            else decl->accept(*this);
+        }
+
+        void Serializer::arm(const StmtIf<void>::Stmt* arm) const
+        {
+            put<uint8_t>(arm != nullptr);
+            if (arm == nullptr) return;
+            expr(arm->expr.get());
+            stmt(arm->stmt.get());
+            stmt(arm->blk.get());
+        }
+
+        #pragma mark - Expressions
+
+        Token Serializer::visit_assign(const Assign<Token>& expr) const
+        {
+            tag(Node::Assign);
+            token(expr.name);
+            put<uint8_t>(static_cast<uint8_t>(expr.storage));
+            put<int32_t>(expr.depth);
+            put<int32_t>(expr.slot);
+            this->expr(expr.value.get());
+            return Token();
+        }
+
+        Token Serializer::visit_binary(const Binary<Token>& expr) const
+        {
+            tag(Node::Binary);
+            token(expr.op);
+            put<uint8_t>(static_cast<uint8_t>(expr.operands));
+            this->expr(expr.left.get());
+            this->expr(expr.right.get());
+            return Token();
+        }
+
+        Token Serializer::visit_grouping(const Grouping<Token>& expr) const
+        {
+            tag(Node::Grouping);
+            this->expr(expr.expr.get());
+            return Token();
+        }
+
+        Token Serializer::visit_literal(const Literal<Token>& expr) const
+        {
+            tag(Node::Literal);
+            token(expr.value);
+            return Token();
+        }
+
+        Token Serializer::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            tag(Node::VarExpr);
+            token(expr.value);
+            put<uint8_t>(static_cast<uint8_t>(expr.storage));
+            put<int32_t>(expr.depth);
+            put<int32_t>(expr.slot);
+            return Token();
+        }
+
+        Token Serializer::visit_unary(const Unary<Token>& expr) const
+        {
+            tag(Node::Unary);
+            token(expr.op);
+            this->expr(expr.expr.get());
+            return Token();
+        }
+
+        Token Serializer::visit_ternary(const Ternary<Token>& expr) const
+        {
+            tag(Node::Ternary);
+            this->expr(expr.condition.get());
+            this->expr(expr.left.get());
+            this->expr(expr.right.get());
+            return Token();
+        }
+
+        Token Serializer::visit_call(const Call<Token>& expr) const
+        {
+            tag(Node::Call);
+            token(expr.name);
+            put<uint8_t>(static_cast<uint8_t>(expr.storage));
+            put<int32_t>(expr.depth);
+            put<int32_t>(expr.slot);
+            put<uint32_t>(expr.args.size());
+            for (const auto& arg : expr.args)
+                this->expr(arg.get());
+            return Token();
+        }
+
+        #pragma mark - Statements
+
+        void Serializer::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            tag(Node::StmtExpr);
+            expr(stmt.expr.get());
+        }
+
+        void Serializer::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            tag(Node::StmtPrint);
+            expr(stmt.expr.get());
+        }
+
+        void Serializer::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            tag(Node::StmtIf);
+            arm(stmt.if_stmt);
+            put<uint32_t>(stmt.elif_stmts.size());
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
+        }
+
+        void Serializer::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            tag(Node::StmtReturn);
+            expr(stmt.expr.get());
+        }
+
+        void Serializer::visit_block_stmt(const Block<void>& block) const
+        {
+            tag(Node::Block);
+            put<int32_t>(block.slots);
+            put<int32_t>(block.frame);
+            put<uint32_t>(block.decls.size());
+            for (const auto& decl : block.decls)
+                this->decl(decl.get());
+        }
+
+        void Serializer::visit_for_stmt(const For<void>& stmt) const
+        {
+            tag(Node::For);
+            decl(stmt.decl.get());
+            this->stmt(stmt.stmt_l.get());
+            // in the order they run, the pre-header sizes the frame for the loop
+            put<int32_t>(stmt.frame);
+            put<uint32_t>(stmt.invariants.size());
+            for (const auto& inv : stmt.invariants)
+                expr(inv.get());
+            expr(stmt.expr.get());
+            this->stmt(stmt.stmt_r.get());
+            this->stmt(stmt.blk.get());
+            this->stmt(stmt.stmt_o.get());
+        }
+
+        #pragma mark - Declarations
+
+        Token Serializer::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            tag(Node::DeclStmt);
+            stmt(decl.stmt.get());
+            return Token();
+        }
+
+        Token Serializer::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            tag(Node::DeclVar);
+            token(decl.identifier);
+            put<uint8_t>(static_cast<uint8_t>(decl.storage));
+            put<int32_t>(decl.slot);
+            expr(decl.expr.get());
+            return Token();
+        }
+
+        Token Serializer::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            tag(Node::DeclFunc);
+            put<uint8_t>(decl.func != nullptr);
+            if (decl.func == nullptr) return Token();
+
+            put<uint8_t>(static_cast<uint8_t>(decl.storage));
+            put<int32_t>(decl.slot);
+            token(decl.func->name);
+            put<uint32_t>(decl.func->params.size());
+            for (const auto& param : decl.func->params)
+                token(param);
+            for (size_t i = 0; i < decl.func->params.size(); i++)
+                put<uint8_t>(static_cast<uint8_t>(i < decl.func->storage.size() ? decl.func->storage[i] : Storage::Frame));
+            put<int32_t>(decl.func->boxes);
+            put<int32_t>(decl.func->frame);
+            put<uint32_t>(decl.func->captures.size());
+            for (const auto& capture : decl.func->captures) {
+                put<uint8_t>(capture.local);
+                put<int32_t>(capture.depth);
+                put<int32_t>(capture.slot);
+            }
+
+            // bodies that were never parsed stay lazy, as their raw tokens
+            put<uint8_t>(decl.func->src != nullptr);
+            if (decl.func->src != nullptr) {
+                put<uint32_t>(decl.func->end - decl.func->begin);
+                for (unsigned i = decl.func->begin; i < decl.func->end; i++)
+                    token(decl.func->src->at(i));
+            } else {
+                stmt(decl.func->blk.get());
+            }
+            return Token();
+        }
+
+        Token Serializer::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            tag(Node::DeclClass);
+            token(decl.identifier);
+            return Token();
+        }
+
+        #pragma mark - Program
+
+        Tokens Serializer::visit_program(const Program<Tokens>& prgm) const
+        {
+            put<uint32_t>(prgm.decls.size());
+            for (const auto& decl : prgm.decls)
+                this->decl(decl.get());
+            return Tokens();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - Deserializer
+        ////////////////////////////////////////////////////////////////////////
+
+        std::unique_ptr<Program<Tokens>> Deserializer::deserialize(uint64_t key)
+        {
+            pos = 0;
+            symbols.clear();
+            frames = {{-1, 0}};
+
+            if (size < sizeof(magic) || memcmp(data, magic, sizeof(magic)) != 0)
+                throw CacheException("not a rift ast cache");
+            pos += sizeof(magic);
+            if (get<uint32_t>() != format)
+                throw CacheException("stale ast cache format");
+            if (get<uint64_t>() != key)
+                throw CacheException("ast cache key mismatch");
+            auto sum = get<uint64_t>();
+            if (fnv1a(data + pos, size - pos) != sum)
+                throw CacheException("corrupt ast cache");
+
+            auto nsyms = count();
+            symbols.reserve(nsyms);
+            for (uint32_t i = 0; i < nsyms; i++) {
+                auto len = count();
+                symbols.emplace_back(data + pos, len);
+                pos += len;
+            }
+
+            Program<Tokens>::vec_t decls = {};
+            auto ndecls = count();
+            decls.reserve(ndecls);
+            for (uint32_t i = 0; i < ndecls; i++)
+                decls.push_back(decl());
+            if (pos != size) throw CacheException("trailing bytes in ast cache");
+
+            return std::make_unique<Program<Tokens>>(std::move(decls));
+        }
+
+        template <typename T>
+        T Deserializer::get()
+        {
+            if (pos + sizeof(T) > size) throw CacheException("truncated ast cache");
+            T val;
+            memcpy(&val, data + pos, sizeof(T));
+            pos += sizeof(T);
+            return val;
+        }
+
+        uint32_t Deserializer::count()
+        {
+            auto n = get<uint32_t>();
+            if (n > size - pos) throw CacheException("truncated ast cache");
+            return n;
+        }
+
+        int32_t Deserializer::extent()
+        {
+            auto n = get<int32_t>();
+            if (n < 0 || (size_t)n > size) throw CacheException("bad frame size in ast cache");
+            return n;
+        }
+
+        void Deserializer::local(Storage storage, int32_t depth, int32_t slot) const
+        {
+            const auto& frame = frames.back();
+            switch (storage) {
+                case Storage::Global:
+                    return;
+                case Storage::Frame: {
+                    int32_t room = frame.size >= 0 ? frame.size : frame.bounds.empty() ? 0 : frame.bounds.back();
+                    if (slot < 0 || slot >= room) throw CacheException("bad frame slot in ast cache");
+                    return;
+                }
+                case Storage::Boxed: {
+                    // depth counts the heap scopes out from the innermost
+                    if (depth < 0 || depth >= (int32_t)frame.scopes.size() || slot < 0 || slot >= frame.scopes[frame.scopes.size() - 1 - depth])
+                        throw CacheException("bad scope slot in ast cache");
+                    return;
+                }
+                case Storage::Upvalue:
+                    if (slot < 0 || slot >= frame.cells) throw CacheException("bad cell in ast cache");
+                    return;
+            }
+        }
+
+        Node Deserializer::tag()
+        {
+            return static_cast<Node>(get<uint8_t>());
+        }
+
+        Token Deserializer::token()
+        {
+            auto type = get<uint8_t>();
+            auto sym = get<uint32_t>();
+            auto line = get<int32_t>();
+            if (type > static_cast<uint8_t>(TokenType::EOFF)) throw CacheException("bad token in ast cache");
+            if (sym >= symbols.size()) throw CacheException("bad symbol in ast cache");
+            // scanned tokens carry their lexeme as the literal
+            return Token(static_cast<TokenType>(type), symbols[sym], symbols[sym], line);
+        }
+
+        Storage Deserializer::storage()
+        {
+            auto storage = get<uint8_t>();
+            if (storage > static_cast<uint8_t>(Storage::Upvalue)) throw CacheException("bad storage in ast cache");
+            return static_cast<Storage>(storage);
+        }
+
+        std::unique_ptr<Expr<Token>> Deserializer::expr()
+        {
+            Token tok;
+            Storage storage;
+            int32_t depth, slot;
+
+            switch (tag()) {
+                case Node::Null:
+                    return nullptr;
+                case Node::Assign: {
+                    tok = token();
+                    storage = this->storage();
+                    depth = get<int32_t>();
+                    slot = get<int32_t>();
+                    local(storage, depth, slot);
+                    auto ret = std::make_unique<Assign<Token>>(tok, expr());
+                    ret->storage = storage;
+                    ret->depth = depth;
+                    ret->slot = slot;
+                    return ret;
+                }
+                case Node::Binary: {
+                    tok = token();
+                    auto operands = get<uint8_t>();
+                    if (operands > static_cast<uint8_t>(Kind::Bool)) throw CacheException("bad operand kind in ast cache");
+                    auto left = expr();
+                    auto right = expr();
+                    auto ret = std::make_unique<Binary<Token>>(std::move(left), tok, std::move(right));
+                    ret->operands = static_cast<Kind>(operands);
+                    return ret;
+                }
+                case Node::Grouping:
+                    return std::make_unique<Grouping<Token>>(expr());
+                case Node::Literal:
+                    return std::make_unique<Literal<Token>>(token());
+                case Node::VarExpr: {
+                    tok = token();
+                    auto ret = std::make_unique<VarExpr<Token>>(tok);
+                    ret->storage = this->storage();
+                    ret->depth = get<int32_t>();
+                    ret->slot = get<int32_t>();
+                    local(ret->storage, ret->depth, ret->slot);
+                    return ret;
+                }
+                case Node::Unary: {
+                    tok = token();
+                    return std::make_unique<Unary<Token>>(tok, expr());
+                }
+                case Node::Ternary: {
+                    auto cond = expr();
+                    auto left = expr();
+                    auto right = expr();
+                    return std::make_unique<Ternary<Token>>(std::move(cond), std::move(left), std::move(right));
+                }
+                case Node::Call: {
+                    tok = token();
+                    storage = this->storage();
+                    depth = get<int32_t>();
+                    slot = get<int32_t>();
+                    local(storage, depth, slot);
+                    Call<Token>::Exprs args = {};
+                    auto nargs = count();
+                    for (uint32_t i = 0; i < nargs; i++)
+                        args.push_back(expr());
+                    auto ret = std::make_unique<Call<Token>>(tok, std::move(args));
+                    ret->storage = storage;
+                    ret->depth = depth;
+                    ret->slot = slot;
+                    return ret;
+                }
+                default:
+                    throw CacheException("expected an expression in ast cache");
+            }
+        }
+
+        StmtIf<void>::Stmt* Deserializer::arm()
+        {
+            if (!get<uint8_t>()) return nullptr;
+            auto ret = new StmtIf<void>::Stmt(expr());
+            ret->stmt = stmt();
+            ret->blk = block();
+            return ret;
+        }
+
+        std::unique_ptr<Block<void>> Deserializer::block()
+        {
+            auto node = tag();
+            if (node == Node::Null) return nullptr;
+            if (node != Node::Block) throw CacheException("expected a block in ast cache");
+
+            Block<void>::vec_prog decls = {};
+            auto slots = extent();
+            auto frame = extent();
+            auto ndecls = count();
+
+            // a heap scope if it declares captured locals, frame room for the rest
+            auto& bounds = frames.back().bounds;
+            bounds.push_back(std::max(frame, bounds.empty() ? 0 : bounds.back()));
+            if (slots > 0) frames.back().scopes.push_back(slots);
+            decls.reserve(ndecls);
+            for (uint32_t i = 0; i < ndecls; i++)
+                decls.push_back(decl());
+            if (slots > 0) frames.back().scopes.pop_back();
+            frames.back().bounds.pop_back();
+
+            auto ret = std::make_unique<Block<void>>(std::move(decls));
+            ret->slots = slots;
+            ret->frame = frame;
+            return ret;
+        }
+
+        std::unique_ptr<Stmt<void>> Deserializer::stmt()
+        {
+            switch (tag()) {
+                case Node::Null:
+                    return nullptr;
+                case Node::StmtExpr:
+                    return std::make_unique<StmtExpr<void>>(expr());
+                case Node::StmtPrint: {
+                    auto val = expr();
+                    return std::make_unique<StmtPrint<void>>(val);
+                }
+                case Node::StmtIf: {
+                    auto ret = std::make_unique<StmtIf<void>>();
+                    ret->if_stmt = arm();
+                    auto nelifs = count();
+                    for (uint32_t i = 0; i < nelifs; i++)
+                        ret->elif_stmts.push_back(arm());
+                    ret->else_stmt = arm();
+                    return ret;
+                }
+                case Node::StmtReturn:
+                    return std::make_unique<StmtReturn<void>>(expr());
+                case Node::Block:
+                    pos--; // let block() re-read its tag
+                    return block();
+                case Node::For: {
+                    auto ret = std::make_unique<For<void>>();
+                    ret->decl = decl();
+                    ret->stmt_l = stmt();
+                    ret->frame = extent();
+                    auto ninvs = count();
+
+                    // only a pre-header makes room for the frame slots it fills
+                    auto& bounds = frames.back().bounds;
+                    bounds.push_back(std::max(ninvs > 0 ? ret->frame : 0, bounds.empty() ? 0 : bounds.back()));
+                    for (uint32_t i = 0; i < ninvs; i++) {
+                        auto inv = expr();
+                        if (inv == nullptr || typeid(*inv) != typeid(Assign<Token>))
+                            throw CacheException("loop invariant is not an assignment in ast cache");
+                        ret->invariants.emplace_back(static_cast<Assign<Token>*>(inv.release()));
+                    }
+                    ret->expr = expr();
+                    ret->stmt_r = stmt();
+                    ret->blk = block();
+                    ret->stmt_o = stmt();
+                    frames.back().bounds.pop_back();
+                    return ret;
+                }
+                default:
+                    throw CacheException("expected a statement in ast cache");
+            }
+        }
+
+        std::unique_ptr<Decl<Token>> Deserializer::decl()
+        {
+            switch (tag()) {
+                case Node::Null:
+                    return nullptr;
+                case Node::DeclStmt:
+                    return std::make_unique<DeclStmt<Token>>(stmt());
+                case Node::DeclVar: {
+                    auto idt = token();
+                    auto storage = this->storage();
+                    auto slot = get<int32_t>();
+                    local(storage, 0, slot);
+                    auto val = expr();
+                    auto ret = val == nullptr ? std::make_unique<DeclVar<Token>>(idt) : std::make_unique<DeclVar<Token>>(idt, std::move(val));
+                    ret->storage = storage;
+                    ret->slot = slot;
+                    return ret;
+                }
+                case Node::DeclFunc: {
+                    if (!get<uint8_t>()) return std::make_unique<DeclFunc<Token>>();
+                    auto storage = this->storage();
+                    auto slot = get<int32_t>();
+                    local(storage, 0, slot);
+                    auto func = std::make_unique<DeclFunc<Token>::Func>();
+                    func->name = token();
+                    auto nparams = count();
+                    for (uint32_t i = 0; i < nparams; i++)
+                        func->params.push_back(token());
+                    for (uint32_t i = 0; i < nparams; i++)
+                        func->storage.push_back(this->storage());
+                    func->boxes = extent();
+                    func->frame = extent();
+                    // params fill the first boxed & frame slots, in order
+                    auto boxed = std::count(func->storage.begin(), func->storage.end(), Storage::Boxed);
+                    if (boxed > func->boxes || (int32_t)nparams - boxed > func->frame)
+                        throw CacheException("bad params in ast cache");
+
+                    // cells are made where the function is declared, out of its scopes & cells
+                    auto ncaptures = count();
+                    for (uint32_t i = 0; i < ncaptures; i++) {
+                        bool local = get<uint8_t>();
+                        auto depth = get<int32_t>();
+                        auto slot = get<int32_t>();
+                        this->local(local ? Storage::Boxed : Storage::Upvalue, depth, slot);
+                        func->captures.push_back({local, depth, slot});
+                    }
+
+                    if (get<uint8_t>()) {
+                        auto ntoks = count();
+                        func->src = std::make_shared<Tokens>();
+                        func->src->reserve(ntoks);
+                        for (uint32_t i = 0; i < ntoks; i++)
+                            func->src->push_back(token());
+                        func->end = ntoks;
+                    } else {
+                        frames.push_back({func->frame, (int32_t)ncaptures});
+                        if (func->boxes > 0) frames.back().scopes.push_back(func->boxes);
+                        func->blk = block();
+                        frames.pop_back();
+                    }
+                    auto ret = std::make_unique<DeclFunc<Token>>(std::move(func));
+                    ret->storage = storage;
+                    ret->slot = slot;
+                    return ret;
+                }
+                case Node::DeclClass:
+                    return std::make_unique<DeclClass<Token>>(token(), std::unordered_map<Token, DeclFunc<Token>::Func>{});
+                default:
+                    throw CacheException("expected a declaration in ast cache");
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - Cache
+        ////////////////////////////////////////////////////////////////////////
+
+        uint64_t Cache::key(const string& source) const
+        {
+            // FNV-1a over compiler version, cache format & source
+            uint64_t hash = fnv1a(version.data(), version.size() + 1);
+            hash = fnv1a(reinterpret_cast<const char*>(&format), sizeof(format), hash);
+            return fnv1a(source.data(), source.size(), hash);
+        }
+
+        string Cache::path(uint64_t key) const
+        {
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.rfc", (unsigned long long)key);
+            return (std::filesystem::path(dir) / name).string();
+        }
+
+        string Cache::defaultDir()
+        {
+            if (const char* env = getenv("RIFT_CACHE_DIR")) return env;
+            if (const char* xdg = getenv("XDG_CACHE_HOME")) return (std::filesystem::path(xdg) / "rift").string();
+            if (const char* home = getenv("HOME")) return (std::filesystem::path(home) / ".cache" / "rift").string();
+            return "";
+        }
+
+        string Cache::pipeline(const string& compiler, unsigned level, unsigned inlineSize, unsigned ctfeSteps, bool lazy)
+        {
+            return compiler + "-O" + std::to_string(level) + "-inline" + std::to_string(inlineSize) + "-ctfe" + std::to_string(ctfeSteps) + "-lazy" + std::to_string(lazy);
+        }
+
+        std::unique_ptr<Program<Tokens>> Cache::load(const string& source) const
+        {
+            if (dir.empty()) return nullptr;
+
+            auto k = key(source);
+            int fd = open(path(k).c_str(), O_RDONLY);
+            if (fd < 0) return nullptr;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size == 0) {
+                close(fd);
+                return nullptr;
+            }
+            void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (map == MAP_FAILED) return nullptr;
+
+            std::unique_ptr<Program<Tokens>> prgm = nullptr;
+            try {
+                prgm = Deserializer(static_cast<const char*>(map), st.st_size).deserialize(k);
+            } catch (const CacheException& e) {
+                prgm = nullptr; // stale or corrupt, reparse & overwrite
+            }
+            munmap(map, st.st_size);
+            return prgm;
+        }
+
+        void Cache::store(const string& source, const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            if (dir.empty() || prgm == nullptr) return;
+
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+            if (ec) return;
+
+            auto k = key(source);
+            auto bytes = Serializer().serialize(prgm, k);
+
+            // write then rename so concurrent runs never map a partial file
+            auto dst = path(k);
+            auto tmp = dst + "." + std::to_string(getpid());
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                if (!out) return;
+                out.write(bytes.data(), bytes.size());
+                if (!out) {
+                    out.close();
+                    std::filesystem::remove(tmp, ec);
+                    return;
+                }
+            }
+            std::filesystem::rename(tmp, dst, ec);
+            if (ec) std::filesystem::remove(tmp, ec);
+        }
+    }
+}
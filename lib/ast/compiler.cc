@@ -0,0 +1,462 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#include <ast/compiler.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        std::shared_ptr<Proto> Compiler::compile(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            auto script = std::make_shared<Proto>();
+            proto = script.get();
+            supported = true;
+            prgm->accept(*this);
+            emit(Op::Halt);
+            proto = nullptr;
+            return supported ? script : nullptr;
+        }
+
+        bool Compiler::compile(const DeclFunc<Token>::Func& func, Proto& target) const
+        {
+            auto outer = std::exchange(proto, &target);
+            auto top = std::exchange(result, false);
+
+            target.name = func.name;
+            target.frame = func.frame;
+            target.boxes = func.boxes;
+            target.params = func.storage;
+            target.captures = func.captures;
+
+            if (func.blk != nullptr) {
+                target.code.clear();
+                func.blk->accept(*this);
+                emit(Op::ReturnNil);
+                target.lazy = nullptr;
+            }
+
+            proto = outer;
+            result = top;
+            return supported;
+        }
+
+        void Compiler::emit(Op op) const
+        {
+            proto->code.push_back(static_cast<uint8_t>(op));
+        }
+
+        void Compiler::emit(Op op, size_t a) const
+        {
+            // operands are 16 bits, anything larger is left to Eval
+            if (a > UINT16_MAX) supported = false;
+            emit(op);
+            proto->code.push_back(a & 0xff);
+            proto->code.push_back((a >> 8) & 0xff);
+        }
+
+        void Compiler::emit(Op op, size_t a, size_t b) const
+        {
+            emit(op, a);
+            if (b > UINT16_MAX) supported = false;
+            proto->code.push_back(b & 0xff);
+            proto->code.push_back((b >> 8) & 0xff);
+        }
+
+        size_t Compiler::jump(Op op) const
+        {
+            emit(op);
+            for (int i = 0; i < 4; i++) proto->code.push_back(0);
+            return proto->code.size() - 4;
+        }
+
+        void Compiler::patch(size_t at) const
+        {
+            uint32_t target = proto->code.size();
+            for (int i = 0; i < 4; i++) proto->code[at + i] = (target >> (8 * i)) & 0xff;
+        }
+
+        void Compiler::loop(size_t target) const
+        {
+            emit(Op::Jump);
+            for (int i = 0; i < 4; i++) proto->code.push_back((target >> (8 * i)) & 0xff);
+        }
+
+        size_t Compiler::constant(Value value) const
+        {
+            proto->constants.push_back(std::move(value));
+            return proto->constants.size() - 1;
+        }
+
+        size_t Compiler::op(const Token& tok) const
+        {
+            proto->ops.push_back(tok);
+            return proto->ops.size() - 1;
+        }
+
+        void Compiler::load(Storage storage, int depth, int slot, const str_t& name) const
+        {
+            switch (storage) {
+                case Storage::Frame:
+                    proto->frame = std::max(proto->frame, slot + 1);
+                    emit(Op::GetLocal, slot);
+                    break;
+                case Storage::Boxed: emit(Op::GetBoxed, depth, slot); break;
+                case Storage::Upvalue: emit(Op::GetUpvalue, slot); break;
+                case Storage::Global: emit(Op::GetGlobal, Globals::getInstance().index(name)); break;
+            }
+        }
+
+        void Compiler::store(Storage storage, int depth, int slot, const str_t& name) const
+        {
+            switch (storage) {
+                case Storage::Frame:
+                    proto->frame = std::max(proto->frame, slot + 1);
+                    emit(Op::SetLocal, slot);
+                    break;
+                case Storage::Boxed: emit(Op::SetBoxed, depth, slot); break;
+                case Storage::Upvalue: emit(Op::SetUpvalue, slot); break;
+                case Storage::Global: emit(Op::SetGlobal, Globals::getInstance().index(name)); break;
+            }
+        }
+
+        void Compiler::assign(const Assign<Token>& expr) const
+        {
+            expr.value->accept(*this);
+            store(expr.storage, expr.depth, expr.slot, expr.name.lexeme);
+        }
+
+        void Compiler::branch(const Stmt<void>* stmt, const Block<void>* blk) const
+        {
+            if (blk != nullptr) blk->accept(*this);
+            else if (stmt != nullptr) stmt->accept(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Compiler::visit_assign(const Assign<Token>& expr) const
+        {
+            expr.value->accept(*this);
+            emit(Op::Dup);
+            store(expr.storage, expr.depth, expr.slot, expr.name.lexeme);
+            return {};
+        }
+
+        Token Compiler::visit_binary(const Binary<Token>& expr) const
+        {
+            // the short circuiting ones only evaluate what they need (as Eval does)
+            switch (expr.op.type) {
+                case TokenType::NULLISH_COAL: {
+                    expr.left->accept(*this);
+                    auto done = jump(Op::JumpIfNotNil);
+                    expr.right->accept(*this);
+                    patch(done);
+                    return {};
+                }
+                case TokenType::LOG_AND: {
+                    expr.left->accept(*this);
+                    auto left = jump(Op::JumpIfFalse);
+                    expr.right->accept(*this);
+                    auto right = jump(Op::JumpIfFalse);
+                    emit(Op::True);
+                    auto done = jump(Op::Jump);
+                    patch(left);
+                    patch(right);
+                    emit(Op::False);
+                    patch(done);
+                    return {};
+                }
+                case TokenType::LOG_OR: {
+                    expr.left->accept(*this);
+                    auto left = jump(Op::JumpIfTrue);
+                    expr.right->accept(*this);
+                    auto right = jump(Op::JumpIfTrue);
+                    emit(Op::False);
+                    auto done = jump(Op::Jump);
+                    patch(left);
+                    patch(right);
+                    emit(Op::True);
+                    patch(done);
+                    return {};
+                }
+                default:
+                    break;
+            }
+
+            Op code;
+            switch (expr.op.type) {
+                case TokenType::PLUS: code = Op::Add; break;
+                case TokenType::MINUS: code = Op::Sub; break;
+                case TokenType::STAR: code = Op::Mul; break;
+                case TokenType::SLASH: code = Op::Div; break;
+                case TokenType::LESS: code = Op::Less; break;
+                case TokenType::LESS_EQUAL: code = Op::LessEqual; break;
+                case TokenType::GREATER: code = Op::Greater; break;
+                case TokenType::GREATER_EQUAL: code = Op::GreaterEqual; break;
+                case TokenType::EQUAL_EQUAL: code = Op::Equal; break;
+                case TokenType::BANG_EQUAL: code = Op::NotEqual; break;
+                default:
+                    supported = false;
+                    return {};
+            }
+            expr.left->accept(*this);
+            expr.right->accept(*this);
+            emit(code, op(expr.op));
+            return {};
+        }
+
+        Token Compiler::visit_grouping(const Grouping<Token>& expr) const
+        {
+            return expr.expr->accept(*this);
+        }
+
+        Token Compiler::visit_literal(const Literal<Token>& expr) const
+        {
+            auto value = Value::from(Eval::literal(expr));
+            switch (value.type) {
+                case Value::Type::Nil: emit(Op::Nil); break;
+                case Value::Type::Bool: emit(value.b ? Op::True : Op::False); break;
+                default: emit(Op::Const, constant(std::move(value))); break;
+            }
+            return {};
+        }
+
+        Token Compiler::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            load(expr.storage, expr.depth, expr.slot, expr.value.lexeme);
+            return {};
+        }
+
+        Token Compiler::visit_unary(const Unary<Token>& expr) const
+        {
+            expr.expr->accept(*this);
+            if (expr.op.type == TokenType::MINUS) emit(Op::Negate, op(expr.op));
+            else if (expr.op.type == TokenType::BANG) emit(Op::Not, op(expr.op));
+            else supported = false;
+            return {};
+        }
+
+        Token Compiler::visit_ternary(const Ternary<Token>& expr) const
+        {
+            expr.condition->accept(*this);
+            auto other = jump(Op::JumpIfFalse);
+            expr.left->accept(*this);
+            auto done = jump(Op::Jump);
+            patch(other);
+            expr.right->accept(*this);
+            patch(done);
+            return {};
+        }
+
+        Token Compiler::visit_call(const Call<Token>& expr) const
+        {
+            Site site;
+            site.name = expr.name;
+            site.storage = expr.storage;
+            site.depth = expr.depth;
+            site.slot = expr.storage == Storage::Global ? Globals::getInstance().index(expr.name.lexeme) : expr.slot;
+            if (expr.storage == Storage::Frame)
+                proto->frame = std::max(proto->frame, expr.slot + 1);
+
+            // arguments go on the stack, the callee's params take them in order
+            for (const auto& arg : expr.args)
+                arg->accept(*this);
+            site.args = expr.args.size();
+            proto->sites.push_back(std::move(site));
+            emit(Op::Call, proto->sites.size() - 1);
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Compiler::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            if (typeid(*stmt.expr) == typeid(Assign<Token>)) {
+                assign(static_cast<const Assign<Token>&>(*stmt.expr));
+                return;
+            }
+            stmt.expr->accept(*this);
+            emit(Op::Pop);
+        }
+
+        void Compiler::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            stmt.expr->accept(*this);
+            emit(Op::Print);
+        }
+
+        void Compiler::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            std::vector<size_t> done = {};
+
+            // if, then each elif, the first one holding runs
+            stmt.if_stmt->expr->accept(*this);
+            auto next = jump(Op::JumpIfFalse);
+            branch(stmt.if_stmt->stmt.get(), stmt.if_stmt->blk.get());
+            for (const auto& elif_stmt : stmt.elif_stmts) {
+                done.push_back(jump(Op::Jump));
+                patch(next);
+                elif_stmt->expr->accept(*this);
+                next = jump(Op::JumpIfFalse);
+                branch(elif_stmt->stmt.get(), elif_stmt->blk.get());
+            }
+
+            if (stmt.else_stmt != nullptr) {
+                done.push_back(jump(Op::Jump));
+                patch(next);
+                branch(stmt.else_stmt->stmt.get(), stmt.else_stmt->blk.get());
+            } else {
+                patch(next);
+            }
+            for (auto at : done)
+                patch(at);
+        }
+
+        void Compiler::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            if (stmt.expr == nullptr) {
+                emit(Op::ReturnNil);
+                return;
+            }
+            stmt.expr->accept(*this);
+            emit(Op::Return);
+        }
+
+        void Compiler::visit_block_stmt(const Block<void>& block) const
+        {
+            proto->frame = std::max(proto->frame, block.frame);
+            if (block.scoped())
+                emit(Op::PushScope, block.slots);
+            for (const auto& decl : block.decls)
+                decl->accept(*this);
+            if (block.scoped())
+                emit(Op::PopScope);
+        }
+
+        void Compiler::visit_for_stmt(const For<void>& decl) const
+        {
+            if (decl.decl != nullptr) decl.decl->accept(*this);
+            else if (decl.stmt_l != nullptr) decl.stmt_l->accept(*this);
+
+            decl.preheader([this](int frame) { proto->frame = std::max(proto->frame, frame); },
+                           [this](const Assign<Token>& inv) { assign(inv); });
+
+            auto top = proto->code.size();
+            decl.expr->accept(*this);
+            auto exit = jump(Op::JumpIfFalse);
+            if (decl.stmt_o != nullptr) decl.stmt_o->accept(*this);
+            else if (decl.blk != nullptr) decl.blk->accept(*this);
+            if (decl.stmt_r != nullptr) decl.stmt_r->accept(*this);
+            loop(top);
+            patch(exit);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Compiler::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            bool top = std::exchange(result, false);
+            // a top level expression results in its value (as in Eval)
+            if (top && typeid(*decl.stmt) == typeid(StmtExpr<void>)) {
+                static_cast<const StmtExpr<void>&>(*decl.stmt).expr->accept(*this);
+                emit(Op::Result);
+                return {};
+            }
+            decl.stmt->accept(*this);
+            if (top) {
+                emit(Op::Nil);
+                emit(Op::Result);
+            }
+            return {};
+        }
+
+        Token Compiler::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            bool top = std::exchange(result, false);
+            if (decl.expr != nullptr) {
+                if (!top && typeid(*decl.expr) == typeid(Assign<Token>)) {
+                    assign(static_cast<const Assign<Token>&>(*decl.expr));
+                    return {};
+                }
+                decl.expr->accept(*this);
+                emit(top ? Op::Result : Op::Pop);
+                return {};
+            }
+
+            emit(Op::Nil);
+            store(decl.storage, 0, decl.slot, decl.identifier.lexeme);
+            if (top) {
+                emit(Op::Nil);
+                emit(Op::Result);
+            }
+            return {};
+        }
+
+        Token Compiler::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            bool top = std::exchange(result, false);
+            const auto& func = *decl.func;
+
+            // a declaration without a body binds nil (as in Eval)
+            if (func.defined()) {
+                auto target = std::make_shared<Proto>();
+                target->lazy = func.blk == nullptr ? decl.func.get() : nullptr;
+                if (!compile(func, *target)) return {};
+                proto->protos.push_back(std::move(target));
+                emit(Op::Closure, proto->protos.size() - 1);
+            } else {
+                emit(Op::Nil);
+            }
+
+            if (decl.storage == Storage::Global)
+                emit(Op::DefineFunc, Globals::getInstance().index(func.name.lexeme), op(func.name));
+            else
+                store(decl.storage, 0, decl.slot, func.name.lexeme);
+
+            if (top) {
+                emit(Op::Const, constant(Value::boxed(func.name)));
+                emit(Op::Result);
+            }
+            return {};
+        }
+
+        Token Compiler::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            // classes only exist in the tree walker for now
+            supported = false;
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Compiler::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls) {
+                result = true;
+                decl->accept(*this);
+            }
+            result = false;
+            return {};
+        }
+    }
+}
@@ -0,0 +1,392 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/ctfe.hh>
+#include <ast/fold.hh>
+#include <ast/inline.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @brief a value left to the runtime
+        static const Token unknown = Token(TokenType::IGNORE);
+        /// @brief calls nested deeper than this are left to the runtime
+        static const size_t maxDepth = 256;
+
+        #pragma mark - Helpers
+
+        static Token boolean(bool val, int line)
+        {
+            return val ? Token(TokenType::TRUE, "true", true, line) : Token(TokenType::FALSE, "false", false, line);
+        }
+
+        /// @brief the body only reads & writes its frame, collects the functions it calls
+        static bool pure(const Expr<Token>* expr, std::unordered_set<string>& callees)
+        {
+            if (expr == nullptr || dynamic_cast<const Literal<Token>*>(expr) != nullptr) return true;
+            if (auto var = dynamic_cast<const VarExpr<Token>*>(expr))
+                return var->storage == Storage::Frame;
+            if (auto assign = dynamic_cast<const Assign<Token>*>(expr))
+                return assign->storage == Storage::Frame && pure(assign->value.get(), callees);
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr))
+                return pure(bin->left.get(), callees) && pure(bin->right.get(), callees);
+            if (auto group = dynamic_cast<const Grouping<Token>*>(expr))
+                return pure(group->expr.get(), callees);
+            if (auto unary = dynamic_cast<const Unary<Token>*>(expr))
+                return pure(unary->expr.get(), callees);
+            if (auto ternary = dynamic_cast<const Ternary<Token>*>(expr))
+                return pure(ternary->condition.get(), callees) && pure(ternary->left.get(), callees) && pure(ternary->right.get(), callees);
+            if (auto call = dynamic_cast<const Call<Token>*>(expr)) {
+                if (call->storage != Storage::Global) return false;
+                callees.insert(call->name.lexeme);
+                for (const auto& arg : call->args)
+                    if (!pure(arg.get(), callees)) return false;
+                return true;
+            }
+            return false;
+        }
+
+        static bool pure(const Stmt<void>* stmt, std::unordered_set<string>& callees);
+
+        static bool pure(const Decl<Token>* decl, std::unordered_set<string>& callees)
+        {
+            if (auto stmt = dynamic_cast<const DeclStmt<Token>*>(decl))
+                return pure(stmt->stmt.get(), callees);
+            if (auto var = dynamic_cast<const DeclVar<Token>*>(decl))
+                return var->storage == Storage::Frame && pure(var->expr.get(), callees);
+            // nested functions & classes
+            return false;
+        }
+
+        static bool pure(const Stmt<void>* stmt, std::unordered_set<string>& callees)
+        {
+            if (stmt == nullptr) return true;
+            if (auto expr = dynamic_cast<const StmtExpr<void>*>(stmt))
+                return pure(expr->expr.get(), callees);
+            if (auto ret = dynamic_cast<const StmtReturn<void>*>(stmt))
+                return pure(ret->expr.get(), callees);
+            if (auto blk = dynamic_cast<const Block<void>*>(stmt)) {
+                for (const auto& decl : blk->decls)
+                    if (!pure(decl.get(), callees)) return false;
+                return true;
+            }
+            if (auto ifs = dynamic_cast<const StmtIf<void>*>(stmt)) {
+                auto arm = [&callees](const StmtIf<void>::Stmt* arm) {
+                    return arm == nullptr || (pure(arm->expr.get(), callees) && pure(arm->blk.get(), callees) && pure(arm->stmt.get(), callees));
+                };
+                if (!arm(ifs->if_stmt) || !arm(ifs->else_stmt)) return false;
+                for (const auto& elif : ifs->elif_stmts)
+                    if (!arm(elif)) return false;
+                return true;
+            }
+            if (auto loop = dynamic_cast<const For<void>*>(stmt)) {
+                for (const auto& inv : loop->invariants)
+                    if (!pure(inv.get(), callees)) return false;
+                return (loop->decl == nullptr || pure(loop->decl.get(), callees)) && pure(loop->stmt_l.get(), callees) &&
+                       pure(loop->expr.get(), callees) && pure(loop->stmt_r.get(), callees) &&
+                       pure(loop->blk.get(), callees) && pure(loop->stmt_o.get(), callees);
+            }
+            // print
+            return false;
+        }
+
+        void Ctfe::analyze(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            // names bound once, to a function nothing ever reassigns
+            std::unordered_set<string> names = Inline::written(prgm), twice = {};
+            std::unordered_map<string, const DeclFunc<Token>::Func*> found = {};
+            for (const auto& decl : prgm->decls) {
+                auto func = dynamic_cast<const DeclFunc<Token>*>(decl.get());
+                if (func == nullptr || func->func == nullptr) continue;
+                const auto& name = func->func->name.lexeme;
+                if (found.contains(name)) twice.insert(name);
+                found[name] = func->func.get();
+            }
+
+            funcs = {};
+            declared = {};
+            std::unordered_map<string, std::unordered_set<string>> callees = {};
+            for (const auto& [name, func] : found) {
+                // lazy bodies aren't there yet, captured params need a boxed scope
+                if (twice.contains(name) || names.contains(name) || func->blk == nullptr || func->boxes > 0) continue;
+                if (!pure(func->blk.get(), callees[name])) continue;
+                funcs[name] = func;
+            }
+
+            // a function calling an impure one is impure too
+            for (bool changed = true; changed; ) {
+                changed = false;
+                for (auto it = funcs.begin(); it != funcs.end(); ) {
+                    const auto& called = callees[it->first];
+                    if (std::all_of(called.begin(), called.end(), [this](const string& callee) { return funcs.contains(callee); })) {
+                        it++;
+                        continue;
+                    }
+                    it = funcs.erase(it);
+                    changed = true;
+                }
+            }
+        }
+
+        void Ctfe::declare(const string& name) const
+        {
+            declared.insert(name);
+        }
+
+        bool Ctfe::callable(const Call<Token>& call) const
+        {
+            return call.storage == Storage::Global && funcs.contains(call.name.lexeme) && declared.contains(call.name.lexeme);
+        }
+
+        Token Ctfe::evaluate(const Call<Token>& call, const std::vector<Token>& args) const
+        {
+            if (!callable(call)) return unknown;
+
+            // extra arguments are dropped & missing ones nil, as the evaluator does
+            const auto& func = *funcs.at(call.name.lexeme);
+            std::vector<Token> params(func.params.size(), Token(TokenType::NIL, "nil", nullptr, call.name.line));
+            for (size_t i = 0; i < func.params.size() && i < args.size(); i++)
+                params[i] = args[i];
+
+            steps = 0;
+            frames.clear();
+            Token val = unknown;
+            try {
+                val = this->call(func, std::move(params));
+            } catch (const Abandon&) {
+                return unknown;
+            }
+
+            count++;
+            val.line = call.name.line;
+            return val;
+        }
+
+        Token Ctfe::call(const DeclFunc<Token>::Func& func, std::vector<Token>&& args) const
+        {
+            if (frames.size() >= maxDepth) throw Abandon();
+
+            // params take the first frame slots, in order
+            args.resize(std::max<size_t>(args.size(), func.frame));
+            frames.push_back(std::move(args));
+            func.blk->accept(*this);
+            frames.pop_back();
+
+            // falling off the end returns nil
+            Token val = returning ? returned : Token(TokenType::NIL, "nil", nullptr, func.name.line);
+            returning = false;
+            returned = Token();
+            return val;
+        }
+
+        Token& Ctfe::local(int slot) const
+        {
+            auto& frame = frames.back();
+            if (slot < 0) throw Abandon();
+            if ((size_t)slot >= frame.size()) frame.resize(slot + 1);
+            return frame[slot];
+        }
+
+        void Ctfe::step() const
+        {
+            if (++steps > budget) throw Abandon();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Ctfe::visit_literal(const Literal<Token>& expr) const
+        {
+            step();
+            return expr.value;
+        }
+
+        Token Ctfe::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            step();
+            return local(expr.slot);
+        }
+
+        Token Ctfe::visit_assign(const Assign<Token>& expr) const
+        {
+            step();
+            Token val = expr.value->accept(*this);
+            local(expr.slot) = val;
+            return val;
+        }
+
+        Token Ctfe::visit_grouping(const Grouping<Token>& expr) const
+        {
+            step();
+            return expr.expr->accept(*this);
+        }
+
+        Token Ctfe::visit_unary(const Unary<Token>& expr) const
+        {
+            step();
+            Token right = expr.expr->accept(*this);
+            if (!Fold::foldable(expr.op, right)) throw Abandon();
+            return Eval::unary(expr.op, right);
+        }
+
+        Token Ctfe::visit_binary(const Binary<Token>& expr) const
+        {
+            step();
+            Token left = expr.left->accept(*this);
+            switch (expr.op.type) {
+                case TokenType::NULLISH_COAL:
+                    return left.type == TokenType::NIL ? expr.right->accept(*this) : left;
+                case TokenType::LOG_AND:
+                    return boolean(truthy(left) && truthy(expr.right->accept(*this)), expr.op.line);
+                case TokenType::LOG_OR:
+                    return boolean(truthy(left) || truthy(expr.right->accept(*this)), expr.op.line);
+                default:
+                    break;
+            }
+
+            Token right = expr.right->accept(*this);
+            // a > b is b < a, on whatever the evaluator compares
+            if (expr.op.type == TokenType::GREATER && !Fold::foldable(expr.op, left, right)) {
+                Token less = Token(TokenType::LESS, "<", "", expr.op.line);
+                if (!Fold::foldable(less, right, left)) throw Abandon();
+                return Eval::binary(less, right, left);
+            }
+            if (!Fold::foldable(expr.op, left, right)) throw Abandon();
+            return Eval::binary(expr.op, left, right);
+        }
+
+        Token Ctfe::visit_ternary(const Ternary<Token>& expr) const
+        {
+            step();
+            return truthy(expr.condition->accept(*this)) ? expr.left->accept(*this) : expr.right->accept(*this);
+        }
+
+        Token Ctfe::visit_call(const Call<Token>& expr) const
+        {
+            step();
+            if (!callable(expr)) throw Abandon();
+
+            // arguments are evaluated in the caller's frame, in order
+            const auto& func = *funcs.at(expr.name.lexeme);
+            std::vector<Token> args(func.params.size(), Token(TokenType::NIL, "nil", nullptr, expr.name.line));
+            for (size_t i = 0; i < expr.args.size(); i++) {
+                Token val = expr.args[i]->accept(*this);
+                if (i < args.size()) args[i] = std::move(val);
+            }
+            return call(func, std::move(args));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Ctfe::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            step();
+            stmt.expr->accept(*this);
+        }
+
+        void Ctfe::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            throw Abandon();
+        }
+
+        void Ctfe::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            step();
+            auto run = [this](const StmtIf<void>::Stmt* arm) {
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            if (truthy(stmt.if_stmt->expr->accept(*this))) return run(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                if (truthy(elif->expr->accept(*this))) return run(elif);
+            if (stmt.else_stmt != nullptr) run(stmt.else_stmt);
+        }
+
+        void Ctfe::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            step();
+            returned = stmt.expr != nullptr ? stmt.expr->accept(*this) : Token(TokenType::NIL, "nil", nullptr, -1);
+            returning = true;
+        }
+
+        void Ctfe::visit_block_stmt(const Block<void>& block) const
+        {
+            step();
+            for (const auto& decl : block.decls) {
+                if (returning) break;
+                decl->accept(*this);
+            }
+        }
+
+        void Ctfe::visit_for_stmt(const For<void>& stmt) const
+        {
+            step();
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            else if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+            for (const auto& inv : stmt.invariants)
+                inv->accept(*this);
+
+            while (!returning && truthy(stmt.expr->accept(*this))) {
+                if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+                else if (stmt.blk != nullptr) stmt.blk->accept(*this);
+                if (returning) break;
+                if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Ctfe::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return unknown;
+        }
+
+        Token Ctfe::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            step();
+            // the initializer is an assignment to the new slot
+            if (decl.expr != nullptr) decl.expr->accept(*this);
+            else local(decl.slot) = Token(TokenType::NIL, "nil", nullptr, decl.identifier.line);
+            return unknown;
+        }
+
+        Token Ctfe::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            throw Abandon();
+        }
+
+        Token Ctfe::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            throw Abandon();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Ctfe::visit_program(const Program<Tokens>& prgm) const
+        {
+            // only calls run, never a whole program
+            return Tokens();
+        }
+    }
+}
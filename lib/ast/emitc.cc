@@ -0,0 +1,298 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <ast/emitc.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        using ssa::Opcode;
+
+        #pragma mark - Helpers
+
+        string CEmitter::quote(const string& text)
+        {
+            std::ostringstream out;
+            out << '"';
+            for (unsigned char c : text) {
+                if (c == '"' || c == '\\') out << '\\' << c;
+                else if (c == '\n') out << "\\n";
+                else if (c < 0x20 || c >= 0x7f) out << '\\' << std::oct << (c >> 6) << ((c >> 3) & 7) << (c & 7) << std::dec;
+                else out << c;
+            }
+            out << '"';
+            return out.str();
+        }
+
+        string CEmitter::value(const ssa::Inst* inst) const
+        {
+            return "v" + std::to_string(ids.at(inst));
+        }
+
+        string CEmitter::constant(const Token& tok) const
+        {
+            const auto& literal = tok.getLiteral();
+            if (tok.type == TokenType::NIL) return "rt_nil()";
+            if (tok.type == TokenType::TRUE || tok.type == TokenType::FALSE) return tok.type == TokenType::TRUE ? "rt_bool(1)" : "rt_bool(0)";
+            if (literal.type() == typeid(int)) {
+                int i = std::any_cast<int>(literal);
+                return i == INT_MIN ? "rt_int(INT32_MIN)" : "rt_int(" + std::to_string(i) + ")";
+            }
+            if (isString(tok)) {
+                strings.push_back(castString(tok));
+                return "K[" + std::to_string(strings.size() - 1) + "]";
+            }
+            failure = "line " + std::to_string(tok.line) + ": the runtime has no value like '" + tok.lexeme + "'";
+            return "rt_nil()";
+        }
+
+        string CEmitter::variable(const ssa::Inst& inst) const
+        {
+            switch (inst.storage) {
+                case Storage::Boxed: return "(*rt_at(scope, " + std::to_string(inst.depth) + ", " + std::to_string(inst.slot) + "))";
+                case Storage::Upvalue: return "(*self->cells[" + std::to_string(inst.slot) + "])";
+                default: break;
+            }
+            auto it = globals.find(inst.value.lexeme);
+            int at = it != globals.end() ? it->second : (globals[inst.value.lexeme] = globals.size());
+            return "G[" + std::to_string(at) + "]";
+        }
+
+        string CEmitter::edge(const ssa::Block& blk, size_t succ) const
+        {
+            // which of the target's predecessors this edge is (a block may branch twice to it)
+            const ssa::Block* to = blk.succs[succ];
+            size_t nth = std::count(blk.succs.begin(), blk.succs.begin() + succ, to), pred = 0;
+            for (; pred < to->preds.size(); pred++)
+                if (to->preds[pred] == &blk && nth-- == 0) break;
+
+            std::vector<std::pair<string, string>> copies = {};
+            for (const auto& inst : to->insts) {
+                if (inst->op != Opcode::Phi) break;
+                copies.push_back({value(inst.get()), value(inst->args[pred])});
+            }
+            if (copies.empty()) return "";
+            if (copies.size() == 1) return copies[0].first + " = " + copies[0].second + "; ";
+
+            // the phis of a block read their operands all at once
+            string ret = "{ rt_value ";
+            for (size_t i = 0; i < copies.size(); i++)
+                ret += (i ? ", t" : "t") + std::to_string(i) + " = " + copies[i].second;
+            ret += "; ";
+            for (size_t i = 0; i < copies.size(); i++)
+                ret += copies[i].first + " = t" + std::to_string(i) + "; ";
+            return ret + "} ";
+        }
+
+        string CEmitter::emit(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            failure = "";
+            fns = SSABuilder().build(prgm);
+            index.clear();
+            globals.clear();
+            strings.clear();
+            if (fns.empty() || fns[0]->func != nullptr) {
+                failure = "the program uses something only the tree walker runs (classes)";
+                return "";
+            }
+            for (size_t i = 1; i < fns.size(); i++)
+                index[fns[i]->func] = i;
+
+            std::ostringstream body;
+            for (size_t i = fns.size(); i-- > 0; ) {
+                ssa::Optimizer().run(*fns[i]);
+                function(body, *fns[i], i);
+                body << std::endl;
+            }
+            if (!failure.empty()) return "";
+
+            std::ostringstream out;
+            out << "/* generated by rift --emit-c */" << std::endl;
+            out << "#include \"rift_rt.h\"" << std::endl << std::endl;
+            out << "static rt_value G[" << std::max<size_t>(globals.size(), 1) << "];" << std::endl;
+            out << "static rt_value K[" << std::max<size_t>(strings.size(), 1) << "];" << std::endl << std::endl;
+            for (size_t i = 1; i < fns.size(); i++)
+                out << "static rt_value f" << i << "(rt_closure* self, int argc, const rt_value* args); /* " << fns[i]->name.lexeme << " */" << std::endl;
+            out << std::endl << body.str();
+            return out.str();
+        }
+
+        bool CEmitter::build(const std::unique_ptr<Program<Tokens>>& prgm, const string& path, const string& exe) const
+        {
+            string code = emit(prgm);
+            if (code.empty()) return false;
+
+            auto dir = std::filesystem::path(path).parent_path();
+            auto rt = (dir / "rift_rt.c").string();
+            std::ofstream(path) << code;
+            std::ofstream((dir / "rift_rt.h").string()) << header;
+            std::ofstream(rt) << source;
+
+            const char* cc = std::getenv("CC");
+            string cmd = string(cc != nullptr && *cc ? cc : "cc") + " -std=c99 -O2 -o '" + exe + "' '" + path + "' '" + rt + "'";
+            if (std::system(cmd.c_str()) != 0) {
+                failure = "'" + cmd + "' failed";
+                return false;
+            }
+            return true;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - FUNCTIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        void CEmitter::function(std::ostream& out, const ssa::Function& fn, size_t at) const
+        {
+            script = fn.func == nullptr;
+            ids.clear();
+            std::vector<string> vals = {};
+            for (const auto& blk : fn.blocks) {
+                for (const auto& inst : blk->insts) {
+                    // only what other instructions may read gets a C local
+                    if (inst->users.empty() && inst->op != Opcode::Phi && inst->op != Opcode::Closure) continue;
+                    ids[inst.get()] = ids.size();
+                    vals.push_back(value(inst.get()));
+                }
+            }
+
+            if (script) {
+                out << "int main(void)" << std::endl << "{" << std::endl;
+                out << "    rt_closure* self = NULL;" << std::endl;
+            } else {
+                out << "/* " << fn.name.lexeme << " */" << std::endl;
+                out << "static rt_value f" << at << "(rt_closure* self, int argc, const rt_value* args)" << std::endl << "{" << std::endl;
+            }
+            out << "    rt_scope* scope = NULL;" << std::endl;
+            for (size_t i = 0; i < vals.size(); i += 16) {
+                out << "    rt_value ";
+                for (size_t j = i; j < std::min(i + 16, vals.size()); j++)
+                    out << (j > i ? ", " : "") << vals[j];
+                out << ";" << std::endl;
+            }
+            out << "    (void)self; (void)scope;" << std::endl;
+
+            if (!script) {
+                out << "    (void)argc; (void)args;" << std::endl;
+                // captured params go to the call's heap scope
+                const auto& func = *fn.func;
+                if (func.boxes > 0)
+                    out << "    scope = rt_enter(NULL, " << func.boxes << ");" << std::endl;
+                for (size_t i = 0, b = 0; i < func.params.size() && i < func.storage.size(); i++) {
+                    if (func.storage[i] != Storage::Boxed) continue;
+                    out << "    scope->slots[" << b++ << "] = rt_arg(argc, args, " << i << ");" << std::endl;
+                }
+            }
+
+            std::ostringstream code;
+            for (const auto& blk : fn.blocks) {
+                if (!blk->preds.empty()) code << "b" << blk->id << ":;" << std::endl;
+                for (const auto& inst : blk->insts)
+                    instruction(code, *inst);
+            }
+            // the script comes last, every string constant is known by then
+            for (size_t i = 0; script && i < strings.size(); i++)
+                out << "    K[" << i << "] = rt_str_new(" << quote(strings[i]) << ", " << strings[i].size() << ");" << std::endl;
+            out << code.str() << "}" << std::endl;
+        }
+
+        void CEmitter::instruction(std::ostream& out, const ssa::Inst& inst) const
+        {
+            const auto& args = inst.args;
+            string def = ids.count(&inst) ? value(&inst) + " = " : "";
+            auto arg = [&](size_t i) { return value(args[i]); };
+            auto label = [&](size_t succ) { return "goto b" + std::to_string(inst.block->succs[succ]->id) + ";"; };
+
+            // unread loads are left out, everything else runs for its effects
+            if (def.empty() && (inst.op == Opcode::Load || inst.op == Opcode::Const || inst.op == Opcode::Copy || inst.op == Opcode::Param)) return;
+
+            out << "    ";
+            switch (inst.op) {
+                case Opcode::Const: out << def << constant(inst.value) << ";"; break;
+                case Opcode::Param: out << def << "rt_arg(argc, args, " << inst.slot << ");"; break;
+                case Opcode::Phi: out << "/* " << value(&inst) << ": phi */"; break;
+                case Opcode::Copy: out << def << arg(0) << ";"; break;
+                case Opcode::Binary: {
+                    // ints Infer proved skip the tag checks
+                    bool ints = inst.operands == Kind::Int;
+                    string l = arg(0) + ".as.i", r = arg(1) + ".as.i";
+                    string call;
+                    switch (inst.value.type) {
+                        case TokenType::PLUS: call = ints ? "rt_int(rt_wrap((int64_t)" + l + " + " + r + "))" : "rt_add"; break;
+                        case TokenType::MINUS: call = ints ? "rt_int(rt_wrap((int64_t)" + l + " - " + r + "))" : "rt_sub"; break;
+                        case TokenType::STAR: call = ints ? "rt_int(rt_wrap((int64_t)" + l + " * " + r + "))" : "rt_mul"; break;
+                        case TokenType::SLASH: call = ints ? "rt_int(rt_idiv(" + l + ", " + r + "))" : "rt_div"; break;
+                        case TokenType::LESS: call = ints ? "rt_bool(" + l + " < " + r + ")" : "rt_lt"; break;
+                        case TokenType::LESS_EQUAL: call = ints ? "rt_bool(" + l + " <= " + r + ")" : "rt_le"; break;
+                        case TokenType::GREATER: call = ints ? "rt_bool(" + l + " > " + r + ")" : "rt_gt"; break;
+                        case TokenType::GREATER_EQUAL: call = ints ? "rt_bool(" + l + " >= " + r + ")" : "rt_ge"; break;
+                        case TokenType::EQUAL_EQUAL: call = ints ? "rt_bool(" + l + " == " + r + ")" : "rt_eq"; break;
+                        case TokenType::BANG_EQUAL: call = ints ? "rt_bool(" + l + " != " + r + ")" : "rt_ne"; break;
+                        default:
+                            failure = "line " + std::to_string(inst.value.line) + ": the runtime has no operator '" + inst.value.lexeme + "'";
+                            break;
+                    }
+                    out << def << call << (ints ? "" : "(" + arg(0) + ", " + arg(1) + ")") << ";";
+                    break;
+                }
+                case Opcode::Unary: out << def << (inst.value.type == TokenType::MINUS ? "rt_neg(" : "rt_not(") << arg(0) << ");"; break;
+                case Opcode::IsNil: out << def << "rt_bool(rt_isnil(" << arg(0) << "));"; break;
+                case Opcode::Load: out << def << variable(inst) << ";"; break;
+                case Opcode::Store: out << variable(inst) << " = " << arg(0) << ";"; break;
+                case Opcode::Closure: {
+                    auto it = index.find(inst.func);
+                    if (it == index.end()) {
+                        failure = "function '" + inst.value.lexeme + "' has no body to compile";
+                        break;
+                    }
+                    // capture only what the body uses, one shared cell per variable (as the vms do)
+                    const auto& captures = inst.func->captures;
+                    out << def << "rt_closure_new(f" << it->second << ", " << quote(inst.value.lexeme) << ", " << captures.size() << ");";
+                    for (size_t i = 0; i < captures.size(); i++) {
+                        out << std::endl << "    " << value(&inst) << ".as.f->cells[" << i << "] = ";
+                        if (captures[i].local) out << "rt_at(scope, " << captures[i].depth << ", " << captures[i].slot << ");";
+                        else out << "self->cells[" << captures[i].slot << "];";
+                    }
+                    break;
+                }
+                case Opcode::Call: {
+                    // arguments in order: the callee's i-th param takes the i-th
+                    if (args.size() == 1) {
+                        out << def << "rt_call(" << arg(0) << ", " << quote(inst.value.lexeme) << ", 0, NULL);";
+                        break;
+                    }
+                    out << def << "rt_call(" << arg(0) << ", " << quote(inst.value.lexeme) << ", " << args.size() - 1 << ", (rt_value[]){";
+                    for (size_t i = 1; i < args.size(); i++)
+                        out << (i > 1 ? ", " : "") << arg(i);
+                    out << "});";
+                    break;
+                }
+                case Opcode::Enter: out << "scope = rt_enter(scope, " << inst.slot << ");"; break;
+                case Opcode::Leave: out << "scope = scope->enclosing;"; break;
+                case Opcode::Print: out << "rt_print(" << arg(0) << ");"; break;
+                case Opcode::Jump: out << edge(*inst.block, 0) << label(0); break;
+                case Opcode::Branch:
+                    out << "if (rt_truthy(" << arg(0) << ")) { " << edge(*inst.block, 0) << label(0) << " } else { " << edge(*inst.block, 1) << label(1) << " }";
+                    break;
+                case Opcode::Return: out << (script ? "return 0;" : "return " + arg(0) + ";"); break;
+            }
+            out << std::endl;
+        }
+    }
+}
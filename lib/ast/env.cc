@@ -23,47 +23,58 @@ namespace rift
     {
         class Expr;
 
+        static const Token nil = Token(rift::scanner::TokenType::NIL, "nil", "nil", -1);
+
         template <typename T>
-        T Environment::getEnv(const str_t& name) const
+        const T& Environment::getEnv(const str_t& name) const
         {
-            if (!values.contains(name)) {
-                
-                if(child != nullptr)
-                    return child->getEnv<T>(name);
-
-                return Token(rift::scanner::TokenType::NIL, "nil", "nil", -1);
+            // innermost scope first, globals last
+            for (size_t i = open; i-- > 0;) {
+                auto it = scopes[i].symbols.find(name);
+                if (it != scopes[i].symbols.end()) return values[it->second];
             }
-            return values.at(name);
+
+            auto idx = symbols.find(name);
+            if (idx == nullptr) return nil;
+            return get(*idx);
         }
 
         template <typename T>
         void Environment::setEnv(const str_t& name, T value, bool is_const)
         {
-            if (!values.contains(name) && child != nullptr) {
-                child->setEnv(name, value, is_const);
+            for (size_t i = open; i-- > 0;) {
+                auto it = scopes[i].symbols.find(name);
+                if (it == scopes[i].symbols.end()) continue;
+                if (fixed[it->second])
+                    error::report(0, "Environment", "Cannot reassign a constant variable", values[it->second], std::exception());
+                values[it->second] = std::move(value);
+                fixed[it->second] = is_const;
+                return;
+            }
+
+            if (open == 0 || symbols.contains(name)) {
+                assign(index(name), std::move(value), is_const);
             } else {
-                if (values.contains(name) && const_keys.contains(name)) {
-                    error::report(0, "Environment", "Cannot reassign a constant variable", values.at(name), std::exception());
-                } else {
-                    values[name] = value;
-                    if (is_const) const_keys.insert(name);
-                }
+                // new name, declared in the innermost scope
+                scopes[open - 1].symbols[name] = values.size();
+                values.push_back(std::move(value));
+                fixed.push_back(is_const);
             }
         }
 
         void Environment::printState()
         {
-            Environment *curr = this;
-            while (curr != nullptr) {
-                for (const auto& [key, value] : curr->values) {
-                    std::cout << key << " => " << value.to_string() << std::endl;
-                }
-                curr = curr->child;
+            symbols.each([this](const str_t& key, size_t idx) {
+                std::cout << key << " => " << get(idx).to_string() << std::endl;
+            });
+            for (size_t i = 0; i < open; i++) {
+                for (const auto& [key, idx] : scopes[i].symbols)
+                    std::cout << key << " => " << values[idx].to_string() << std::endl;
             }
         }
 
         template void Environment::setEnv<rift::scanner::Token>(const str_t&, rift::scanner::Token, bool);
-        template rift::scanner::Token Environment::getEnv<rift::scanner::Token>(const str_t&) const;
+        template const rift::scanner::Token& Environment::getEnv<rift::scanner::Token>(const str_t&) const;
 
         // template void Environment::setEnv<rift::ast::Expr*>(const str_t&, rift::ast::Expr*, bool);
         // template rift::ast::Expr* Environment::getEnv<rift::ast::Expr*>(const str_t&) const;
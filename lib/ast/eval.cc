@@ -14,10 +14,14 @@
 
 #include <ast/grmr.hh>
 #include <ast/eval.hh>
+#include <ast/parser.hh>
+#include <ast/resolver.hh>
 #include <error/error.hh>
 #include <utils/macros.hh>
 #include <ast/env.hh>
 #include <vector>
+#include <utility>
+#include <charconv>
 
 namespace rift
 {
@@ -26,52 +30,184 @@ namespace rift
         
         #pragma mark - Static Variables
 
-        static Token return_token = Token(TokenType::NIL, "", "", -1);
         static Environment* curr_env = &rift::ast::Environment::getInstance(false);
-        static std::unordered_map<Expr<Token>*, int> locals = {};
+        /// @brief innermost boxed scope of the running function, holding its captured locals
+        static std::shared_ptr<Environment> scope = nullptr;
+        /// @brief cells of the running closure's captured variables (nullptr: captures nothing)
+        static std::shared_ptr<std::vector<Upvalue>> upvalues = nullptr;
+        /// @brief flat frame region for the locals no closure captures, base of the current frame
+        static std::vector<Token> stack = {};
+        static size_t base = 0;
+        /// @brief the REPL may redefine functions
+        static bool repl = false;
+
+        /// @brief global table index of a site, looked up by name again once the table's version moved
+        template <typename T>
+        static inline size_t global(const T& site, const str_t& name)
+        {
+            if (site.version != curr_env->version) {
+                site.global = curr_env->index(name);
+                site.version = curr_env->version;
+            }
+            return site.global;
+        }
 
+        /// @brief a resolved local, in the current frame, a boxed scope or a captured cell
+        static inline Token& local(Storage storage, int depth, int slot)
+        {
+            if (storage == Storage::Frame)
+                return stack[base + slot];
+            if (storage == Storage::Upvalue)
+                return (*upvalues)[slot].get();
+            return scope->at(depth, slot);
+        }
 
-        #pragma mark - Eval
-        /*============================================================================*
-        * Eval
-        *============================================================================*/
 
-        Token Eval::lookup(Expr<Token>* expr, std::string key)
+        /// @brief a number result, formatted the way the generic path formats it
+        template <typename T>
+        static inline Token number(T value, int line)
         {
-            if (locals.find(expr) != locals.end()) {
-                auto depth = locals[expr];
-                return curr_env->at(depth)->getEnv<Token>(key);
-            } else {
-                // return curr_env->getEnv<Token>(key);
-                return Environment::getInstance(false).getEnv<Token>(key);
-            }   
+            return Token(TokenType::NUMERICLITERAL, std::to_string(value), value, line);
+        }
+
+        static inline Token boolean(bool value, int line)
+        {
+            return value ? Token(TokenType::TRUE, "true", true, line) : Token(TokenType::FALSE, "false", false, line);
+        }
+
+        /// @brief a binary operation on operands of a statically known numeric type
+        template <typename T>
+        static Token arithmetic(const Token& op, T l, T r)
+        {
+            switch (op.type) {
+                case TokenType::PLUS: return number<T>(l + r, op.line);
+                case TokenType::MINUS: return number<T>(l - r, op.line);
+                case TokenType::STAR: return number<T>(l * r, op.line);
+                case TokenType::SLASH:
+                    if (r == T(0)) rift::error::runTimeError("Division by zero");
+                    return number<T>(l / r, op.line);
+                case TokenType::GREATER: return boolean(l > r, op.line);
+                case TokenType::GREATER_EQUAL: return boolean(l >= r, op.line);
+                case TokenType::LESS: return boolean(l < r, op.line);
+                case TokenType::LESS_EQUAL: return boolean(l <= r, op.line);
+                case TokenType::BANG_EQUAL: return boolean(l != r, op.line);
+                case TokenType::EQUAL_EQUAL: return boolean(l == r, op.line);
+                default: break;
+            }
+            rift::error::runTimeError("Unknown operator for a binary expression");
+            return Token();
+        }
+
+        /// @brief two strings concatenated, unquoted
+        static Token concat(const Token& op, const Token& left, const Token& right)
+        {
+            std::string_view l = left.lexeme, r = right.lexeme;
+            if (l.size() > 1 && l.front() == '"' && l.back() == '"') l = l.substr(1, l.size()-2);
+            if (r.size() > 1 && r.front() == '"' && r.back() == '"') r = r.substr(1, r.size()-2);
+            string sum;
+            sum.reserve(l.size() + r.size());
+            sum.append(l).append(r);
+            return Token(TokenType::STRINGLITERAL, std::move(sum), 0, op.line);
+        }
+
+        /// @brief a binary operation the type inference specialized (no operand checks)
+        static Token typed(const Binary<Token>& expr, const Token& left, const Token& right)
+        {
+            const auto& op = expr.op;
+            switch (expr.operands) {
+                case Kind::Int: {
+                    int l = 0, r = 0;
+                    std::from_chars(left.lexeme.data(), left.lexeme.data() + left.lexeme.size(), l);
+                    std::from_chars(right.lexeme.data(), right.lexeme.data() + right.lexeme.size(), r);
+                    return arithmetic<int>(op, l, r);
+                }
+                case Kind::Double:
+                    return arithmetic<double>(op, std::strtod(left.lexeme.c_str(), nullptr), std::strtod(right.lexeme.c_str(), nullptr));
+                case Kind::String: {
+                    if (op.type == TokenType::PLUS)
+                        return concat(op, left, right);
+                    int cmp = strcmp(left.lexeme.c_str(), right.lexeme.c_str());
+                    switch (op.type) {
+                        case TokenType::GREATER: return boolean(cmp > 0, op.line);
+                        case TokenType::GREATER_EQUAL: return boolean(cmp >= 0, op.line);
+                        case TokenType::LESS: return boolean(cmp < 0, op.line);
+                        case TokenType::LESS_EQUAL: return boolean(cmp <= 0, op.line);
+                        case TokenType::BANG_EQUAL: return boolean(cmp != 0, op.line);
+                        case TokenType::EQUAL_EQUAL: return boolean(cmp == 0, op.line);
+                        default: break;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            rift::error::runTimeError("Unknown operator for a binary expression");
+            return Token();
         }
 
-        void Eval::resolve(Expr<Token>* expr, int depth)
+        #pragma mark - Quickening
+
+        /// @brief runs of the same operand types before a node specializes to them
+        static constexpr uint8_t QUICKEN = 4;
+
+        /// @brief an int token's value (false: not an int, or out of range)
+        static inline bool integer(const Token& tok, int& value)
+        {
+            if (tok.type != TokenType::NUMERICLITERAL) return false;
+            const char* first = tok.lexeme.data();
+            const char* last = first + tok.lexeme.size();
+            auto [end, ec] = std::from_chars(first, last, value);
+            return ec == std::errc() && end == last;
+        }
+
+        /// @brief what a value is at runtime, as far as a node specializes on it
+        static inline Kind kind(const Token& tok)
         {
-            locals[expr] = depth;
+            int value = 0;
+            if (integer(tok, value)) return Kind::Int;
+            if (tok.type == TokenType::STRINGLITERAL) return Kind::String;
+            return Kind::Unknown;
+        }
+
+        /// @brief records the operand types of a run, the node rewrites itself once they're stable
+        static void observe(const Binary<Token>& expr, const Token& left, const Token& right)
+        {
+            Kind l = kind(left), r = kind(right);
+            bool specializes = l == r && (l == Kind::Int || (l == Kind::String && expr.op.type == TokenType::PLUS));
+            if (!specializes || (expr.runs > 0 && expr.seen != l)) {
+                expr.seen = Kind::Unknown;
+                expr.quick = Quick::Generic;
+                return;
+            }
+            expr.seen = l;
+            if (++expr.runs >= QUICKEN)
+                expr.quick = l == Kind::Int ? Quick::Int : Quick::String;
         }
 
+        /// @brief a guard failed: back to the generic node, for good
+        static inline void deopt(const Binary<Token>& expr)
+        {
+            expr.seen = Kind::Unknown;
+            expr.quick = Quick::Generic;
+        }
+
+        #pragma mark - Eval
+        /*============================================================================*
+        * Eval
+        *============================================================================*/
+
         std::vector<string> Eval::evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive)
         {
             std::vector<std::string> res;
 
+            // every REPL line may rebind globals, drop whatever the sites cached
+            repl = interactive;
+            if (interactive) curr_env->version++;
+
             try {
                 auto toks = prgm->accept(*this);
-                for (const auto& tok : toks) {
-                    any val = tok.getLiteral();
-                    if (isNumber(tok)) {
-                        res.push_back(castNumberString(tok));
-                    } else if (isString(tok)) {
-                        res.push_back(castString(tok));
-                    } else if (val.type() == typeid(bool)) {
-                        res.push_back(std::any_cast<bool>(val) ? "true" : "false");
-                    } else if (val.type() == typeid(std::nullptr_t)) {
-                        res.push_back("null");
-                    } else {
-                        res.push_back("undefined");
-                    }
-                }
+                for (const auto& tok : toks)
+                    res.push_back(show(tok));
             } catch (const std::runtime_error& e) {
                 error::runTimeError(e.what());
             }
@@ -79,15 +215,141 @@ namespace rift
             return res;
         }
 
+        #pragma mark - Semantics
+        /*============================================================================*
+        * Semantics (shared with the vm)
+        *============================================================================*/
+
+        string Eval::show(const Token& tok)
+        {
+            any val = tok.getLiteral();
+            if (isNumber(tok))
+                return castNumberString(tok);
+            else if (isString(tok))
+                return castString(tok);
+            else if (val.type() == typeid(bool))
+                return std::any_cast<bool>(val) ? "true" : "false";
+            else if (val.type() == typeid(std::nullptr_t))
+                return "null";
+            return "undefined";
+        }
+
+        string Eval::text(const Token& tok)
+        {
+            std::string res = castAnyString(tok);
+            if (res.at(0) == '"' && res.at(res.size()-1) == '"') 
+                res = res.substr(1, res.size()-2);
+            return res;
+        }
+
+        Token Eval::binary(const Token& op, const Token& left, const Token& right)
+        {
+            string l_s, r_s;
+            any resAny;
+            bool resBool;
+
+            // Operators which depend on evaluation of both
+            switch (op.type) {
+                /* arthimetic ops */
+                case TokenType::MINUS:
+                    if (!isNumber(left) && !isNumber(right))
+                        rift::error::runTimeError("Expected a number for '-' operator");
+                    resAny = any_arithmetic(left, right, op);
+                    return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, op.line);
+                case TokenType::PLUS:
+                    if ((!isNumber(left) && !isNumber(right)) && (!isString(left) && !isString(right)))
+                        rift::error::runTimeError("Expected a number or string for '+' operator");
+                    if (isNumber(left) && isNumber(right)) {
+                        resAny = any_arithmetic(left, right, op);
+                        return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, op.line);
+                    } else if (isString(left) && isString(right)) {
+                        l_s = castString(left), r_s = castString(right);
+                        if (l_s[0] == '"' && l_s[l_s.size()-1] == '"') l_s = l_s.substr(1, l_s.size()-2);
+                        if (r_s[0] == '"' && r_s[r_s.size()-1] == '"') r_s = r_s.substr(1, r_s.size()-2);
+                        return Token(TokenType::STRINGLITERAL, l_s + r_s, 0, op.line);
+                    } else if (isString(left) && isNumber(right)) {
+                        return Token(TokenType::STRINGLITERAL, castString(left) + castNumberString(right), 0, op.line);
+                    } else if (isNumber(left) && isString(right)) {
+                        return Token(TokenType::STRINGLITERAL, castNumberString(left) + castString(right), 0, op.line);
+                    }
+                    rift::error::runTimeError("Expected a number or string for '+' operator");
+                case TokenType::SLASH: {
+                    if (!isNumber(left) && !isNumber(right))
+                        rift::error::runTimeError("Expected a number for '/' operator");
+                    int divisor = 0;
+                    if (integer(right, divisor) && divisor == 0)
+                        rift::error::runTimeError("Division by zero");
+                    resAny = any_arithmetic(left, right, op);
+                    return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, op.line);
+                }
+                case TokenType::STAR:
+                    if (!isNumber(left) && !isNumber(right))
+                        rift::error::runTimeError("Expected a number for '*' operator");
+                    resAny = any_arithmetic(left, right, op);
+                    return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, op.line);
+                /* comparison ops */
+                case TokenType::GREATER:
+                    _BOOL_LOGIC(op);
+                    rift::error::runTimeError("Expected a number or string for '>' operator");
+                case TokenType::GREATER_EQUAL:
+                    _BOOL_LOGIC(op);
+                    rift::error::runTimeError("Expected a number or string for '>=' operator");
+                case TokenType::LESS:
+                    _BOOL_LOGIC(op);
+                    rift::error::runTimeError("Expected a number or string for '<' operator");
+                case TokenType::LESS_EQUAL:
+                    _BOOL_LOGIC(op);
+                    rift::error::runTimeError("Expected a number or string for '<=' operator");
+                case TokenType::BANG_EQUAL:
+                    _BOOL_LOGIC(op);
+                    rift::error::runTimeError("Expected a number or string for '!=' operator");
+                case TokenType::EQUAL_EQUAL:
+                    _BOOL_LOGIC(op);
+                    rift::error::runTimeError("Expected a number or string for '==' operator");
+                default:
+                    rift::error::runTimeError("Unknown operator for a binary expression");
+            }
+
+            return Token();
+        }
+
+        Token Eval::unary(const Token& op, const Token& right)
+        {
+            bool res = false;
+            any resAny;
+ 
+            switch (op.type) {
+                case TokenType::MINUS:
+                    if (!isNumber(right))
+                        rift::error::runTimeError("Expected a number after '-' operator");
+
+                resAny = any_arithmetic(right, Token(TokenType::NUMERICLITERAL, "-1", -1, op.line), Token(TokenType::STAR, "-", "", op.line));
+                return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, op.line);
+
+                case TokenType::BANG:
+                    if (right.type == TokenType::TRUE || right.type == TokenType::FALSE)
+                        res = truthy(right);
+                    else if (isNumber(right))
+                        res = std::any_cast<bool>(any_arithmetic(right, Token(TokenType::NUMERICLITERAL, "0", 0, op.line), Token(TokenType::EQUAL_EQUAL, "==", "", op.line)));
+                    else if (isString(right))
+                        res = castString(right).empty();
+                    else
+                        rift::error::runTimeError("Expected a number or string after '!' operator");
+                    return Token(res?TokenType::TRUE:TokenType::FALSE, std::to_string(!res), !res, op.line);
+                default:
+                    rift::error::runTimeError("Unknown operator for a unary expression");
+            }
+            return Token();
+        }
+
         #pragma mark - Eval Visitor
         /*============================================================================*
         * Eval Visitor
         *============================================================================*/
 
-        Token Eval::visit_literal(const Literal<Token>& expr) const
+        Token Eval::literal(const Literal<Token>& expr)
         {
-            Token val = expr.value;
-            any literal = val.getLiteral();
+            any literal = expr.value.getLiteral();
 
             if (literal.type() == typeid(std::string)) 
                 return Token(TokenType::STRINGLITERAL, std::any_cast<std::string>(literal), 0, expr.value.line);
@@ -126,138 +388,111 @@ namespace rift
             return Token();
         }
 
+        Token Eval::visit_literal(const Literal<Token>& expr) const
+        {
+            return literal(expr);
+        }
+
         Token Eval::visit_var_expr(const VarExpr<Token>& expr) const
         {
-            Token val = expr.value;
-            any literal;
+            if (expr.storage != Storage::Global)
+                return local(expr.storage, expr.depth, expr.slot);
+            return curr_env->get(global(expr, expr.value.lexeme));
+        }
 
-            // Token res = curr_env->getEnv<Token>(val.lexeme);
-            VarExpr<Token>& expr_ref = const_cast<VarExpr<Token>&>(expr);
-            return Eval::lookup(&expr_ref, val.lexeme);
+        const Token& Eval::operand(const Expr<Token>& expr, Token& tmp) const
+        {
+            if (typeid(expr) == typeid(VarExpr<Token>)) {
+                const auto& var = static_cast<const VarExpr<Token>&>(expr);
+                if (var.storage != Storage::Global)
+                    return local(var.storage, var.depth, var.slot);
+                return curr_env->get(global(var, var.value.lexeme));
+            }
+            tmp = expr.accept(*this);
+            return tmp;
         }
 
         Token Eval::visit_binary(const Binary<Token>& expr) const
         {
-            Token left;
-            Token right;
-
-            string l_s, r_s;
-            any resAny;
-            bool resBool;
-
             // Operators that can't evaulate yet
             switch (expr.op.type) {
-                case NULLISH_COAL:
-                    left = expr.left.get()->accept(*this);
-                    if (left.type == TokenType::NIL) {
-                        right = expr.right.get()->accept(*this);
-                        return right;
-                    }
+                case NULLISH_COAL: {
+                    Token left = expr.left.get()->accept(*this);
+                    if (left.type == TokenType::NIL)
+                        return expr.right.get()->accept(*this);
                     return left;
+                }
                 case LOG_AND:
-                    left = expr.left.get()->accept(*this);
-                    if(truthy(left)) {
+                    if(truthy(expr.left.get()->accept(*this))) {
                         if(truthy(expr.right.get()->accept(*this)))
                             return Token(TokenType::TRUE, "true", "true", expr.op.line);
-                        return Token(TokenType::FALSE, "false", "false", expr.op.line);
                     }
-                    return Token();
+                    return Token(TokenType::FALSE, "false", "false", expr.op.line);
                 case LOG_OR:
-                    left = expr.left.get()->accept(*this);
-                    if (truthy(left)) {
-                        right = expr.right.get()->accept(*this);
+                    if (truthy(expr.left.get()->accept(*this)))
                         return Token(TokenType::TRUE, "true", "true", expr.op.line);
-                    } else {
-                        right = expr.left.get()->accept(*this);
-                        if (truthy(right)) return Token(TokenType::TRUE, "true", "true", expr.op.line);
-                        return Token(TokenType::FALSE, "false", "false", expr.op.line);
-                    }
+                    if (truthy(expr.right.get()->accept(*this))) return Token(TokenType::TRUE, "true", "true", expr.op.line);
+                    return Token(TokenType::FALSE, "false", "false", expr.op.line);
                 default:
                     break;
             }
 
-            left = expr.left.get()->accept(*this);
-            right = expr.right.get()->accept(*this);
-
-            // Operators which depend on evaluation of both
-            switch (expr.op.type) {
-                /* arthimetic ops */
-                case TokenType::MINUS:
-                    if (!isNumber(left) && !isNumber(right))
-                        rift::error::runTimeError("Expected a number for '-' operator");
-                    resAny = any_arithmetic(left, right, expr.op);
-                    return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, expr.op.line);
-                case TokenType::PLUS:
-                    if ((!isNumber(left) && !isNumber(right)) && (!isString(left) && !isString(right)))
-                        rift::error::runTimeError("Expected a number or string for '+' operator");
-                    if (isNumber(left) && isNumber(right)) {
-                        resAny = any_arithmetic(left, right, expr.op);
-                        return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, expr.op.line);
-                    } else if (isString(left) && isString(right)) {
-                        l_s = castString(left), r_s = castString(right);
-                        if (l_s[0] == '"' && l_s[l_s.size()-1] == '"') l_s = l_s.substr(1, l_s.size()-2);
-                        if (r_s[0] == '"' && r_s[r_s.size()-1] == '"') r_s = r_s.substr(1, r_s.size()-2);
-                        return Token(TokenType::STRINGLITERAL, l_s + r_s, 0, expr.op.line);
-                    } else if (isString(left) && isNumber(right)) {
-                        return Token(TokenType::STRINGLITERAL, castString(left) + castNumberString(right), 0, expr.op.line);
-                    } else if (isNumber(left) && isString(right)) {
-                        return Token(TokenType::STRINGLITERAL, castNumberString(left) + castString(right), 0, expr.op.line);
+            // the left operand is read in place only if evaluating the right one cannot
+            // write it (or move the frame it lives in)
+            Token l_tmp, r_tmp;
+            const auto& r_type = typeid(*expr.right);
+            bool inert = r_type == typeid(VarExpr<Token>) || r_type == typeid(Literal<Token>);
+            const Token& left = inert ? operand(*expr.left, l_tmp) : (l_tmp = expr.left->accept(*this));
+            const Token& right = operand(*expr.right, r_tmp);
+
+            // operand types known ahead of time
+            if (expr.operands != Kind::Unknown)
+                return typed(expr, left, right);
+
+            // else the ones seen so far: quickened nodes run their specialization behind a guard
+            switch (expr.quick) {
+                case Quick::Int: {
+                    int l = 0, r = 0;
+                    if (!integer(left, l) || !integer(right, r)) {
+                        deopt(expr);
+                        break;
                     }
-                    rift::error::runTimeError("Expected a number or string for '+' operator");
-                case TokenType::SLASH:
-                    if (!isNumber(left) && !isNumber(right))
-                        rift::error::runTimeError("Expected a number for '-' operator");
-                    resAny = any_arithmetic(left, right, expr.op);
-                    return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, expr.op.line);
-                case TokenType::STAR:
-                    if (!isNumber(left) && !isNumber(right))
-                        rift::error::runTimeError("Expected a number for '*' operator");
-                    resAny = any_arithmetic(left, right, expr.op);
-                    return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, expr.op.line);
-                /* comparison ops */
-                case TokenType::GREATER:
-                    if(strcmp(castString(left).c_str(),castString(right).c_str())>0)
-                        return Token(TokenType::TRUE, "true", "true", expr.op.line);
-                    return Token(TokenType::FALSE, "false", "false", expr.op.line);
-                    rift::error::runTimeError("Expected a number or string for '>' operator");
-                case TokenType::GREATER_EQUAL:
-                    _BOOL_LOGIC(expr.op);
-                    rift::error::runTimeError("Expected a number or string for '>=' operator");
-                case TokenType::LESS:
-                    _BOOL_LOGIC(expr.op);
-                    rift::error::runTimeError("Expected a number or string for '<' operator");
-                case TokenType::LESS_EQUAL:
-                    _BOOL_LOGIC(expr.op);
-                    rift::error::runTimeError("Expected a number or string for '<=' operator");
-                case TokenType::BANG_EQUAL:
-                    _BOOL_LOGIC(expr.op);
-                    rift::error::runTimeError("Expected a number or string for '!=' operator");
-                case TokenType::EQUAL_EQUAL:
-                    _BOOL_LOGIC(expr.op);
-                    rift::error::runTimeError("Expected a number or string for '==' operator");
-                default:
-                    rift::error::runTimeError("Unknown operator for a binary expression");
+                    return arithmetic<int>(expr.op, l, r);
+                }
+                case Quick::String:
+                    if (left.type != TokenType::STRINGLITERAL || right.type != TokenType::STRINGLITERAL) {
+                        deopt(expr);
+                        break;
+                    }
+                    return concat(expr.op, left, right);
+                case Quick::Unseen:
+                    observe(expr, left, right);
+                    break;
+                case Quick::Generic:
+                    break;
             }
 
-            return Token();
+            return binary(expr.op, left, right);
+        }
+
+        void Eval::store(const Assign<Token>& expr) const
+        {
+            auto val = expr.value->accept(*this);
+
+            if (expr.storage != Storage::Global)
+                local(expr.storage, expr.depth, expr.slot) = std::move(val);
+            else
+                curr_env->assign(global(expr, expr.name.lexeme), std::move(val), false);
         }
 
         Token Eval::visit_assign(const Assign<Token>& expr) const
         {
-            auto name = expr.name.lexeme;
             auto val = expr.value->accept(*this);
 
-            const Expr<Token>* const_expr = &expr;
-            Expr<Token>* expr_ptr = const_cast<Expr<Token>*>(const_expr);
-            
-            if (locals.find(expr_ptr) != locals.end()) {
-                auto depth = locals[expr_ptr];
-                curr_env->at(depth)->setEnv<Token>(expr.name.lexeme, val, false);
-            } else {
-                // curr_env->setEnv<Token>(expr.name.lexeme, val, false);
-                // couldnt find it in locals so must be in globals
-                Environment::getInstance(false).setEnv<Token>(expr.name.lexeme, val, false);
-            }   
+            if (expr.storage != Storage::Global)
+                local(expr.storage, expr.depth, expr.slot) = val;
+            else
+                curr_env->assign(global(expr, expr.name.lexeme), val, false);
 
             return val;
         }
@@ -269,32 +504,7 @@ namespace rift
 
         Token Eval::visit_unary(const Unary<Token>& expr) const
         {
-            Token right = expr.expr.get()->accept(*this);
-            bool res = false;
-            any resAny;
- 
-            switch (expr.op.type) {
-                case TokenType::MINUS:
-                    if (!isNumber(right))
-                        rift::error::runTimeError("Expected a number after '-' operator");
-
-                resAny = any_arithmetic(right, Token(TokenType::NUMERICLITERAL, "-1", -1, expr.op.line), Token(TokenType::STAR, "-", "", expr.op.line));
-                return Token(TokenType::NUMERICLITERAL, castNumberString(resAny), resAny, expr.op.line);
-
-                case TokenType::BANG:
-                    if (right.type == TokenType::TRUE || right.type == TokenType::FALSE)
-                        res = truthy(right);
-                    else if (isNumber(right))
-                        res = std::any_cast<bool>(any_arithmetic(right, Token(TokenType::NUMERICLITERAL, "0", 0, expr.op.line), Token(TokenType::EQUAL_EQUAL, "==", "", expr.op.line)));
-                    else if (isString(right))
-                        res = castString(right).empty();
-                    else
-                        rift::error::runTimeError("Expected a number or string after '!' operator");
-                    return Token(res?TokenType::TRUE:TokenType::FALSE, std::to_string(!res), !res, expr.op.line);
-                default:
-                    rift::error::runTimeError("Unknown operator for a unary expression");
-            }
-            return Token();
+            return unary(expr.op, expr.expr->accept(*this));
         }
 
         Token Eval::visit_ternary(const Ternary<Token>& expr) const
@@ -302,36 +512,68 @@ namespace rift
             Token cond = expr.condition->accept(*this);
 
             if(truthy(cond)) 
-                return Token(expr.left->accept(*this));
-            return Token(expr.right->accept(*this));
+                return expr.left->accept(*this);
+            return expr.right->accept(*this);
         }
 
         Token Eval::visit_call(const Call<Token>& expr) const
         {
-            auto name = curr_env->getEnv<Token>(expr.name.lexeme);
-
-            if (name.type == TokenType::NIL)
-                rift::error::runTimeError("Undefined function '" + name.lexeme + "'");
-
-            // set new env with closure
-            auto func = std::any_cast<DeclFunc<Token>::Func*>(name.literal);
-            // curr_env = new Environment(func->closure);
-
-
-            // map arguments to parameters
-            for (const auto& arg : expr.args) {
-                curr_env->setEnv<Token>(arg.first, arg.second->accept(*this), false);
+            // the closure called (its cells are held for the call, the variable may be rebound)
+            const DeclFunc<Token>::Closure* closure = nullptr;
+            if (expr.storage != Storage::Global) {
+                auto& name = local(expr.storage, expr.depth, expr.slot);
+                if (name.type != TokenType::FUN)
+                    rift::error::runTimeError("Undefined function '" + expr.name.lexeme + "'");
+                closure = std::any_cast<std::shared_ptr<DeclFunc<Token>::Closure>>(name.literal).get();
+            } else {
+                // global callees are cached on the site until a function is (re)bound
+                if (expr.version != curr_env->version) {
+                    const auto& name = curr_env->get(curr_env->index(expr.name.lexeme));
+                    if (name.type != TokenType::FUN)
+                        rift::error::runTimeError("Undefined function '" + expr.name.lexeme + "'");
+                    expr.callee = std::any_cast<std::shared_ptr<DeclFunc<Token>::Closure>>(name.literal).get();
+                    expr.version = curr_env->version;
+                }
+                closure = static_cast<const DeclFunc<Token>::Closure*>(expr.callee);
+            }
+            DeclFunc<Token>::Func* func = closure->func.get();
+            auto cells = closure->upvalues;
+            // lazily parsed functions get their body (and its resolution) on the first call
+            if (Parser::materialize(*func))
+                Resolver().resolve(*func);
+
+            // push a frame, captured params go to the function's first boxed scope
+            size_t frame = stack.size();
+            stack.resize(frame + func->frame);
+            auto boxes = func->boxes > 0 ? std::make_shared<Environment>(nullptr, func->boxes) : nullptr;
+
+            // arguments fill the params' slots in order (evaluated in the caller's frame),
+            // missing ones stay nil & extras are dropped
+            for (size_t i = 0, f = 0, b = 0; i < expr.args.size(); i++) {
+                Token val = expr.args[i]->accept(*this);
+                if (i >= func->params.size()) continue;
+                if (func->storage[i] == Storage::Boxed)
+                    boxes->slots[b++] = std::move(val);
+                else
+                    stack[frame + f++] = std::move(val);
             }
 
+            auto caller = scope;
+            auto caller_cells = upvalues;
+            auto caller_base = base;
+            scope = boxes;
+            upvalues = std::move(cells);
+            base = frame;
             func->blk->accept(*this);
-
-            // cleanup
-            auto tmp = return_token;
-            return_token = Token(TokenType::NIL, "", "", -1);
-            // delete curr_env;
-            // curr_env = &rift::ast::Environment::getInstance(false);
-
-            return tmp;
+            scope = caller;
+            upvalues = caller_cells;
+            base = caller_base;
+            stack.resize(frame);
+
+            // the body returned a value or ran off its end (nil)
+            if (completion.signal != Signal::Return) return Token();
+            completion.signal = Signal::Normal;
+            return std::move(completion.value);
         }
 
         #pragma mark - Stmt Visitors
@@ -341,16 +583,16 @@ namespace rift
 
         void Eval::visit_expr_stmt(const StmtExpr<void>& stmt) const
         {
-            stmt.expr->accept(*this);
+            // the statement drops the value, no need to copy it out of the variable
+            if (typeid(*stmt.expr) == typeid(Assign<Token>))
+                store(static_cast<const Assign<Token>&>(*stmt.expr));
+            else
+                stmt.expr->accept(*this);
         }
 
         void Eval::visit_print_stmt(const StmtPrint<void>& stmt) const
         {
-            Token val = stmt.expr->accept(*this);
-            std::string res = castAnyString(val);
-            if (res.at(0) == '"' && res.at(res.size()-1) == '"') 
-                res = res.substr(1, res.size()-2);
-            std::cout << res << std::endl;
+            std::cout << text(stmt.expr->accept(*this)) << std::endl;
             // return val;
         }
 
@@ -358,24 +600,23 @@ namespace rift
         {
             auto if_stmt = stmt.if_stmt;
             // if stmt
-            // auto expr = std::move(if_stmt->expr);
-            // if (expr == nullptr) rift::error::runTimeError("If statement expression should not be null");
             auto expr_tok = if_stmt->expr->accept(*this);
 
             if (truthy(expr_tok)) {
                 if (if_stmt->blk != nullptr) if_stmt->blk->accept(*this);
                 else if (if_stmt->stmt != nullptr) if_stmt->stmt->accept(*this);
                 else rift::error::runTimeError("If statement should have a statement or block");
+                return;
             }
 
-            // elif stmt
-            auto elif_stmts = stmt.elif_stmts;
-            for (const auto& elif_stmt : elif_stmts) {
+            // elif stmt (only the first one that holds runs)
+            for (const auto& elif_stmt : stmt.elif_stmts) {
                 if(elif_stmt->expr == nullptr) rift::error::runTimeError("Elif statement expression should not be null");
                 if(truthy(elif_stmt->expr->accept(*this))) {
                     if (elif_stmt->blk != nullptr) elif_stmt->blk->accept(*this);
                     else if (elif_stmt->stmt != nullptr) elif_stmt->stmt->accept(*this);
                     else rift::error::runTimeError("Elif statement should have a statement or block");
+                    return;
                 }
             }
 
@@ -390,24 +631,25 @@ namespace rift
 
         void Eval::visit_return_stmt(const StmtReturn<void>& stmt) const
         {
-            return_token = stmt.expr->accept(*this);
-            // return return_token;
+            completion.value = stmt.expr != nullptr ? stmt.expr->accept(*this) : Token();
+            completion.signal = Signal::Return;
         }
 
         #pragma mark - Program / Block Visitor
 
         void Eval::visit_block_stmt(const Block<void>& block) const
         {
-            Tokens toks = {};
+            auto outer = scope;
+            if (block.scoped())
+                scope = std::make_shared<Environment>(outer, block.slots); // add scope
+            if (stack.size() < base + block.frame)
+                stack.resize(base + block.frame);
 
-            curr_env->addChild(); // add scope
             for (auto it=block.decls.begin(); it!=block.decls.end(); it++) {
-                    if (return_token.line != -1) break; // -1 = no return
-                    toks.push_back((*it)->accept(*this));
+                (*it)->accept(*this);
+                if (completion.signal != Signal::Normal) break; // unwinding
             }
-            curr_env->removeChild(); // remove scope
-
-            // return return_token;
+            scope = outer; // remove scope
         }
 
         void Eval::visit_for_stmt(const For<void>& decl) const
@@ -416,14 +658,21 @@ namespace rift
             if (decl.decl != nullptr) decl.decl->accept(*this);
             else if (decl.stmt_l != nullptr) decl.stmt_l->accept(*this);
 
+            decl.preheader([](int frame) { if (stack.size() < base + frame) stack.resize(base + frame); },
+                           [this](const Assign<Token>& inv) { inv.accept(*this); });
+
             while(truthy(decl.expr->accept(*this))) {
                 if(decl.stmt_o != nullptr) decl.stmt_o->accept(*this);
                 else if (decl.blk != nullptr) decl.blk->accept(*this);
                 else rift::error::runTimeError("For statement should have a statement or block");
 
+                // a return leaves the loop too, a break just the loop
+                if (completion.signal != Signal::Normal) {
+                    if (completion.signal == Signal::Return) break;
+                    if (std::exchange(completion.signal, Signal::Normal) == Signal::Break) break;
+                }
                 if (decl.stmt_r != nullptr) decl.stmt_r->accept(*this);
             }
-            // return return_token;
         }
 
         #pragma mark - Decl Visitors
@@ -442,6 +691,9 @@ namespace rift
             // check performed in parser, undefined variables are CT errors
             if (decl.expr != nullptr) {
                 return decl.expr->accept(*this);
+            } else if (decl.storage != Storage::Global) {
+                local(decl.storage, 0, decl.slot) = Token();
+                return Token();
             } else {
                 // declaration just set it to a nil token
                 curr_env->setEnv<Token>(decl.identifier.lexeme, Token(), decl.identifier.type == TokenType::C_IDENTIFIER);
@@ -452,20 +704,40 @@ namespace rift
         Token Eval::visit_decl_func(const DeclFunc<Token>& decl) const
         {
             auto name = decl.func->name;
-            auto params = decl.func->params;
-            decl.func->closure = new Environment(Environment::getInstance(false)); // grab a copy of global env
+            // capture only what the body uses, one shared cell per variable,
+            // each run of the declaration makes a closure of its own
+            std::shared_ptr<std::vector<Upvalue>> cells = nullptr;
+            if (!decl.func->captures.empty()) {
+                cells = std::make_shared<std::vector<Upvalue>>();
+                cells->reserve(decl.func->captures.size());
+                for (const auto& capture : decl.func->captures) {
+                    if (!capture.local) {
+                        cells->push_back((*upvalues)[capture.slot]);
+                        continue;
+                    }
+                    auto env = scope;
+                    for (int depth = capture.depth; depth > 0; depth--)
+                        env = env->enclosing;
+                    cells->push_back({env, capture.slot});
+                }
+            }
+
+            auto closure = std::make_shared<DeclFunc<Token>::Closure>(DeclFunc<Token>::Closure{decl.func, std::move(cells)});
+            Token val = Token(TokenType::FUN, name.lexeme, std::move(closure), name.line);
+            // this is just a declaration for now, will add stmt when support fat arrow lambdas
+            if (!decl.func->defined())
+                val = Token(TokenType::NIL, "null", nullptr, name.line);
+
+            if (decl.storage != Storage::Global) {
+                local(decl.storage, 0, decl.slot) = std::move(val);
+                return {name};
+            }
 
             // quick check
-            if (curr_env->getEnv<Token>(name.lexeme).type != TokenType::NIL)
+            if (!repl && curr_env->getEnv<Token>(name.lexeme).type != TokenType::NIL)
                 rift::error::runTimeError("Function '" + name.lexeme + "' already defined");
 
-            if (decl.func->blk) {
-                curr_env->setEnv<Token>(name.lexeme, Token(TokenType::FUN, name.lexeme, decl.func.get(), name.line), false);
-            } else {
-                // rift::error::runTimeError("Function '" + name.lexeme + "' should have a block (no support for lambdas yet)");
-                // this is just a declaration for now, will add stmt when support fat arrow lambdas
-                curr_env->setEnv<Token>(name.lexeme, Token(TokenType::NIL, "null", nullptr, name.line), false);
-            }
+            curr_env->setEnv<Token>(name.lexeme, std::move(val), false);
             return {name};
         }
 
@@ -474,9 +746,6 @@ namespace rift
             auto tok = decl.identifier;
             auto name = tok.lexeme;
             
-            // create class
-            auto class_env = new Environment(Environment::getInstance(false)); // grab a copy of global env
-
             // check if class already exists
             if (curr_env->getEnv<Token>(name).type != TokenType::NIL)
                 rift::error::runTimeError("Class '" + name + "' already defined");
@@ -494,7 +763,18 @@ namespace rift
         {
             Tokens toks = {};
             for (auto it=prgm.decls.begin(); it!=prgm.decls.end(); it++) {
-                toks.push_back((*it)->accept(*this));
+                // a top level expression results in its value (what the prompt shows)
+                auto decl = dynamic_cast<const DeclStmt<Token>*>(it->get());
+                if (decl != nullptr && typeid(*decl->stmt) == typeid(StmtExpr<void>))
+                    toks.push_back(static_cast<const StmtExpr<void>&>(*decl->stmt).expr->accept(*this));
+                else
+                    toks.push_back((*it)->accept(*this));
+
+                // a top level return ends the script
+                if (completion.signal != Signal::Normal) {
+                    completion = {};
+                    break;
+                }
             }
             return toks;
         }
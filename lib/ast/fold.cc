@@ -0,0 +1,384 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/fold.hh>
+#include <ast/inline.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @brief a value only known at runtime
+        static const Token unknown = Token(TokenType::IGNORE);
+
+        #pragma mark - Helpers
+
+        bool Fold::constant(const Token& tok)
+        {
+            switch (tok.type) {
+                case TokenType::NUMERICLITERAL:
+                case TokenType::STRINGLITERAL:
+                case TokenType::TRUE:
+                case TokenType::FALSE:
+                case TokenType::NIL:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        unsigned Fold::size(const Expr<Token>* expr)
+        {
+            if (expr == nullptr) return 0;
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr))
+                return 1 + size(bin->left.get()) + size(bin->right.get());
+            if (auto un = dynamic_cast<const Unary<Token>*>(expr))
+                return 1 + size(un->expr.get());
+            if (auto grp = dynamic_cast<const Grouping<Token>*>(expr))
+                return 1 + size(grp->expr.get());
+            if (auto tern = dynamic_cast<const Ternary<Token>*>(expr))
+                return 1 + size(tern->condition.get()) + size(tern->left.get()) + size(tern->right.get());
+            if (auto asgn = dynamic_cast<const Assign<Token>*>(expr))
+                return 1 + size(asgn->value.get());
+            if (auto call = dynamic_cast<const Call<Token>*>(expr)) {
+                unsigned ret = 1;
+                for (const auto& arg : call->args)
+                    ret += size(arg.get());
+                return ret;
+            }
+            return 1;
+        }
+
+        /// @brief only fold what the evaluator computes without a runtime error
+        bool Fold::foldable(const Token& op, const Token& left, const Token& right)
+        {
+            bool nums = isNumber(left) && isNumber(right) && left.getLiteral().type() == right.getLiteral().type();
+            bool strs = isString(left) && isString(right);
+
+            switch (op.type) {
+                case TokenType::MINUS:
+                case TokenType::STAR:
+                    return nums;
+                case TokenType::SLASH:
+                    return nums && std::stod(castNumberString(right.getLiteral())) != 0;
+                case TokenType::PLUS:
+                    return nums || strs || (isString(left) && isNumber(right)) || (isNumber(left) && isString(right));
+                case TokenType::GREATER:
+                case TokenType::GREATER_EQUAL:
+                case TokenType::LESS:
+                case TokenType::LESS_EQUAL:
+                case TokenType::BANG_EQUAL:
+                case TokenType::EQUAL_EQUAL:
+                    return nums || strs;
+                default:
+                    return false;
+            }
+        }
+
+        bool Fold::foldable(const Token& op, const Token& right)
+        {
+            // the evaluator works against an int literal (-1 / 0)
+            bool integer = right.getLiteral().type() == typeid(int);
+            switch (op.type) {
+                case TokenType::MINUS:
+                    return integer;
+                case TokenType::BANG:
+                    return right.type == TokenType::TRUE || right.type == TokenType::FALSE || integer || isString(right);
+                default:
+                    return false;
+            }
+        }
+
+        static Token boolean(bool val, int line)
+        {
+            return val ? Token(TokenType::TRUE, "true", true, line) : Token(TokenType::FALSE, "false", false, line);
+        }
+
+        Token Fold::fold(const std::unique_ptr<Expr<Token>>& ptr) const
+        {
+            if (ptr == nullptr) return unknown;
+
+            Token val = ptr->accept(*this);
+            auto& owner = const_cast<std::unique_ptr<Expr<Token>>&>(ptr);
+            if (replacement != nullptr)
+                owner = std::move(replacement);
+            else if (constant(val) && dynamic_cast<const Literal<Token>*>(owner.get()) == nullptr)
+                owner = std::make_unique<Literal<Token>>(val);
+            return val;
+        }
+
+        unsigned Fold::run(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            if (steps > 0) ctfe.analyze(prgm);
+            // a constant some assignment writes keeps its runtime value, as the evaluator runs it
+            assigned = Inline::assigned(prgm);
+            unparsed = std::any_of(prgm->decls.begin(), prgm->decls.end(), [](const auto& decl) {
+                auto func = dynamic_cast<const DeclFunc<Token>*>(decl.get());
+                return func != nullptr && func->func != nullptr && func->func->blk == nullptr;
+            });
+            visit_program(*prgm);
+            return removed;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Fold::visit_literal(const Literal<Token>& expr) const
+        {
+            return expr.value;
+        }
+
+        Token Fold::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            for (auto scope = scopes.rbegin(); scope != scopes.rend(); scope++) {
+                auto it = scope->find(expr.value.lexeme);
+                if (it == scope->end()) continue;
+                if (!constant(it->second)) return unknown;
+
+                uses++;
+                Token val = it->second;
+                val.line = expr.value.line;
+                return val;
+            }
+            return unknown;
+        }
+
+        Token Fold::visit_assign(const Assign<Token>& expr) const
+        {
+            fold(expr.value);
+            return unknown;
+        }
+
+        Token Fold::visit_grouping(const Grouping<Token>& expr) const
+        {
+            Token val = fold(expr.expr);
+            if (constant(val)) removed++;
+            return val;
+        }
+
+        Token Fold::visit_unary(const Unary<Token>& expr) const
+        {
+            Token right = fold(expr.expr);
+            if (!constant(right) || !foldable(expr.op, right)) return unknown;
+
+            removed++;
+            return Eval().visit_unary(expr);
+        }
+
+        Token Fold::visit_binary(const Binary<Token>& expr) const
+        {
+            Token left = fold(expr.left);
+            Token right;
+
+            // short circuits simplify on their left side alone
+            switch (expr.op.type) {
+                case TokenType::NULLISH_COAL:
+                    if (!constant(left)) {
+                        fold(expr.right);
+                        return unknown;
+                    }
+                    if (left.type != TokenType::NIL) {
+                        removed += 1 + size(expr.right.get());
+                        return left;
+                    }
+                    right = fold(expr.right);
+                    removed += 2;
+                    replacement = std::move(const_cast<std::unique_ptr<Expr<Token>>&>(expr.right));
+                    return right;
+                case TokenType::LOG_AND:
+                    if (constant(left) && !truthy(left)) {
+                        removed += 1 + size(expr.right.get());
+                        return boolean(false, expr.op.line);
+                    }
+                    right = fold(expr.right);
+                    if (!constant(left) || !constant(right)) return unknown;
+                    removed += 2;
+                    return boolean(truthy(right), expr.op.line);
+                case TokenType::LOG_OR:
+                    if (constant(left) && truthy(left)) {
+                        removed += 1 + size(expr.right.get());
+                        return boolean(true, expr.op.line);
+                    }
+                    right = fold(expr.right);
+                    if (!constant(left) || !constant(right)) return unknown;
+                    removed += 2;
+                    return boolean(truthy(right), expr.op.line);
+                default:
+                    break;
+            }
+
+            right = fold(expr.right);
+            if (!constant(left) || !constant(right) || !foldable(expr.op, left, right))
+                return unknown;
+
+            // both sides are literals by now
+            removed += 2;
+            return Eval().visit_binary(expr);
+        }
+
+        Token Fold::visit_ternary(const Ternary<Token>& expr) const
+        {
+            Token cond = fold(expr.condition);
+            if (!constant(cond)) {
+                fold(expr.left);
+                fold(expr.right);
+                return unknown;
+            }
+
+            auto& taken = truthy(cond) ? expr.left : expr.right;
+            auto& other = truthy(cond) ? expr.right : expr.left;
+            removed += 2 + size(other.get());
+
+            Token val = fold(taken);
+            replacement = std::move(const_cast<std::unique_ptr<Expr<Token>>&>(taken));
+            return val;
+        }
+
+        Token Fold::visit_call(const Call<Token>& expr) const
+        {
+            std::vector<Token> args = {};
+            bool constants = true;
+            for (const auto& arg : expr.args) {
+                Token val = fold(arg);
+                constants = constants && constant(val);
+                args.push_back(val);
+            }
+
+            // a pure function on constants runs now, its result replaces the call
+            if (steps == 0 || !constants || !ctfe.callable(expr)) return unknown;
+            Token val = ctfe.evaluate(expr, args);
+            if (constant(val)) removed += size(&expr) - 1;
+            return val;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Fold::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            fold(stmt.expr);
+        }
+
+        void Fold::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            fold(stmt.expr);
+        }
+
+        void Fold::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            fold(stmt.expr);
+        }
+
+        void Fold::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            auto arm = [this](const StmtIf<void>::Stmt* arm) {
+                if (arm == nullptr) return;
+                fold(arm->expr);
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            arm(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
+        }
+
+        void Fold::visit_block_stmt(const Block<void>& block) const
+        {
+            scopes.push_back({});
+            for (const auto& decl : block.decls)
+                if (decl != nullptr) decl->accept(*this);
+            scopes.pop_back();
+        }
+
+        void Fold::visit_for_stmt(const For<void>& stmt) const
+        {
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            else if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+
+            fold(stmt.expr);
+            if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+
+            if (stmt.blk != nullptr) stmt.blk->accept(*this);
+            else if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Fold::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return unknown;
+        }
+
+        Token Fold::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            // the initializer is an assignment to the new name, only its value folds
+            Token val = unknown;
+            if (auto asgn = dynamic_cast<const Assign<Token>*>(decl.expr.get()))
+                val = fold(asgn->value);
+            else
+                fold(decl.expr);
+
+            // constants keep their value, anything else shadows outer names
+            // (a body not parsed yet may write any global)
+            bool is_const = decl.identifier.type == TokenType::C_IDENTIFIER && constant(val) &&
+                            !assigned.contains(decl.identifier.lexeme) && !(unparsed && scopes.size() == 1);
+            scopes.back()[decl.identifier.lexeme] = is_const ? val : unknown;
+            return unknown;
+        }
+
+        Token Fold::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            if (decl.func == nullptr) return unknown;
+            scopes.back()[decl.func->name.lexeme] = unknown;
+            // calls after a top level declaration find the function bound
+            if (steps > 0 && scopes.size() == 1) ctfe.declare(decl.func->name.lexeme);
+
+            // lazily parsed bodies are left alone
+            if (decl.func->blk != nullptr) {
+                scopes.push_back({});
+                for (const auto& param : decl.func->params)
+                    scopes.back()[param.lexeme] = unknown;
+                decl.func->blk->accept(*this);
+                scopes.pop_back();
+            }
+            return unknown;
+        }
+
+        Token Fold::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            scopes.back()[decl.identifier.lexeme] = unknown;
+            return unknown;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Fold::visit_program(const Program<Tokens>& prgm) const
+        {
+            scopes = {{}};
+            for (const auto& decl : prgm.decls)
+                if (decl != nullptr) decl->accept(*this);
+            scopes.clear();
+            return Tokens();
+        }
+    }
+}
@@ -0,0 +1,299 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/hoist.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        unsigned Hoist::run(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            unsigned before = moved;
+
+            // top level locals live in the frame at the bottom of the stack
+            high = 0;
+            for (const auto& decl : prgm->decls)
+                if (auto stmt = dynamic_cast<const DeclStmt<Token>*>(decl.get()))
+                    high = std::max(high, frame(stmt->stmt.get()));
+
+            loops = {};
+            prgm->accept(*this);
+            return moved - before;
+        }
+
+        int Hoist::frame(const Stmt<void>* stmt)
+        {
+            if (auto blk = dynamic_cast<const Block<void>*>(stmt))
+                return blk->frame;
+            if (auto loop = dynamic_cast<const For<void>*>(stmt))
+                return std::max({loop->frame, frame(loop->blk.get()), frame(loop->stmt_o.get())});
+            if (auto ifs = dynamic_cast<const StmtIf<void>*>(stmt)) {
+                int ret = 0;
+                auto arm = [&ret](const StmtIf<void>::Stmt* arm) {
+                    if (arm != nullptr) ret = std::max({ret, frame(arm->blk.get()), frame(arm->stmt.get())});
+                };
+                arm(ifs->if_stmt);
+                for (const auto& elif : ifs->elif_stmts)
+                    arm(elif);
+                arm(ifs->else_stmt);
+                return ret;
+            }
+            return 0;
+        }
+
+        bool Hoist::invariant(const Expr<Token>* expr, const For<void>& loop, bool speculative)
+        {
+            if (auto group = dynamic_cast<const Grouping<Token>*>(expr))
+                return invariant(group->expr.get(), loop, speculative);
+            if (dynamic_cast<const Literal<Token>*>(expr) != nullptr)
+                return true;
+
+            if (auto var = dynamic_cast<const VarExpr<Token>*>(expr)) {
+                const auto& writes = loop.writes;
+                switch (var->storage) {
+                    case Storage::Frame: return !writes.frame.contains(var->slot);
+                    case Storage::Global: return !writes.calls && !writes.globals.contains(var->value.lexeme);
+                    case Storage::Boxed:
+                    case Storage::Upvalue: return !writes.calls && !writes.boxed;
+                }
+            }
+
+            // run ahead of time: typed operands cannot fail, a division may (by zero)
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr)) {
+                if (speculative && (bin->operands == Kind::Unknown || bin->op.type == TokenType::SLASH))
+                    return false;
+                return invariant(bin->left.get(), loop, speculative) && invariant(bin->right.get(), loop, speculative);
+            }
+            if (auto unary = dynamic_cast<const Unary<Token>*>(expr))
+                return !speculative && invariant(unary->expr.get(), loop, speculative);
+            return false;
+        }
+
+        void Hoist::hoist(const std::unique_ptr<Expr<Token>>& expr) const
+        {
+            if (expr == nullptr) return;
+
+            const Expr<Token>* op = expr.get();
+            while (auto group = dynamic_cast<const Grouping<Token>*>(op))
+                op = group->expr.get();
+
+            // only operations are worth a slot, the outermost loop they are invariant in gets them
+            // (what the first test of the innermost condition evaluates anyway may fail there too)
+            bool tested = must;
+            must = false;
+            if (auto bin = dynamic_cast<const Binary<Token>*>(op)) {
+                for (size_t i = 0; i < loops.size(); i++) {
+                    if (!invariant(expr.get(), *loops[i], !tested || i + 1 < loops.size())) continue;
+
+                    int slot = high++;
+                    Token name(TokenType::IDENTIFIER, "%inv" + std::to_string(slot), "", bin->op.line);
+                    auto& owner = const_cast<std::unique_ptr<Expr<Token>>&>(expr);
+
+                    auto read = std::make_unique<VarExpr<Token>>(name);
+                    read->storage = Storage::Frame;
+                    read->slot = slot;
+                    auto assign = std::make_unique<Assign<Token>>(name, std::move(owner));
+                    assign->storage = Storage::Frame;
+                    assign->slot = slot;
+                    owner = std::move(read);
+
+                    loops[i]->invariants.push_back(std::move(assign));
+                    loops[i]->frame = std::max(loops[i]->frame, slot + 1);
+                    // the pre-header runs inside the loops enclosing loops[i]
+                    for (size_t j = 0; j < i; j++)
+                        loops[j]->writes.frame.insert(slot);
+                    moved++;
+                    return;
+                }
+            }
+
+            if (!loops.empty()) {
+                must = tested;
+                expr->accept(*this);
+                must = false;
+            }
+        }
+
+        void Hoist::function(DeclFunc<Token>::Func& func) const
+        {
+            // lazily parsed bodies are never optimized
+            if (func.blk == nullptr) return;
+
+            auto outer = std::move(loops);
+            auto outer_high = high;
+            loops = {};
+            high = func.frame;
+
+            func.blk->accept(*this);
+            func.frame = high;
+
+            loops = std::move(outer);
+            high = outer_high;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Hoist::visit_assign(const Assign<Token>& expr) const
+        {
+            hoist(expr.value);
+            return expr.name;
+        }
+
+        Token Hoist::visit_binary(const Binary<Token>& expr) const
+        {
+            bool tested = must;
+            hoist(expr.left);
+            // the right side of a short circuit may not run
+            must = tested && expr.op.type != TokenType::NULLISH_COAL && expr.op.type != TokenType::LOG_AND && expr.op.type != TokenType::LOG_OR;
+            hoist(expr.right);
+            return expr.op;
+        }
+
+        Token Hoist::visit_grouping(const Grouping<Token>& expr) const
+        {
+            hoist(expr.expr);
+            return Token();
+        }
+
+        Token Hoist::visit_literal(const Literal<Token>& expr) const
+        {
+            return expr.value;
+        }
+
+        Token Hoist::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            return expr.value;
+        }
+
+        Token Hoist::visit_unary(const Unary<Token>& expr) const
+        {
+            hoist(expr.expr);
+            return expr.op;
+        }
+
+        Token Hoist::visit_ternary(const Ternary<Token>& expr) const
+        {
+            hoist(expr.condition);
+            must = false;
+            hoist(expr.left);
+            hoist(expr.right);
+            return Token();
+        }
+
+        Token Hoist::visit_call(const Call<Token>& expr) const
+        {
+            for (const auto& arg : expr.args)
+                hoist(arg);
+            return expr.name;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Hoist::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            hoist(stmt.expr);
+        }
+
+        void Hoist::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            hoist(stmt.expr);
+        }
+
+        void Hoist::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            auto arm = [this](const StmtIf<void>::Stmt* arm) {
+                if (arm == nullptr) return;
+                hoist(arm->expr);
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            arm(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
+        }
+
+        void Hoist::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            hoist(stmt.expr);
+        }
+
+        void Hoist::visit_block_stmt(const Block<void>& block) const
+        {
+            for (const auto& decl : block.decls)
+                if (decl != nullptr) decl->accept(*this);
+        }
+
+        void Hoist::visit_for_stmt(const For<void>& stmt) const
+        {
+            // the initializer runs once, in the enclosing loops
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            else if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+
+            loops.push_back(const_cast<For<void>*>(&stmt));
+            must = true;
+            hoist(stmt.expr);
+            if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+            if (stmt.blk != nullptr) stmt.blk->accept(*this);
+            else if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+            loops.pop_back();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Hoist::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return Token();
+        }
+
+        Token Hoist::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            hoist(decl.expr);
+            return decl.identifier;
+        }
+
+        Token Hoist::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            if (decl.func != nullptr) function(*decl.func);
+            return Token();
+        }
+
+        Token Hoist::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            return decl.identifier;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Hoist::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls)
+                if (decl != nullptr) decl->accept(*this);
+            return Tokens();
+        }
+    }
+}
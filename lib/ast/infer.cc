@@ -0,0 +1,341 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/infer.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        static bool number(Kind kind)
+        {
+            return kind == Kind::Int || kind == Kind::Double;
+        }
+
+        unsigned Infer::run(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            unsigned before = tagged;
+            types = {};
+            prgm->accept(*this);
+            return tagged - before;
+        }
+
+        Kind Infer::kind(const std::unique_ptr<Expr<Token>>& expr) const
+        {
+            last = Kind::Unknown;
+            if (expr != nullptr) expr->accept(*this);
+            return last;
+        }
+
+        void Infer::bind(Storage storage, int slot, const string& name, Kind kind) const
+        {
+            // captured locals may change behind our back (closures), never tracked
+            if (storage == Storage::Boxed || storage == Storage::Upvalue) return;
+
+            if (storage == Storage::Frame) {
+                if (kind == Kind::Unknown) types.frame.erase(slot);
+                else types.frame[slot] = kind;
+            } else {
+                if (kind == Kind::Unknown) types.globals.erase(name);
+                else types.globals[name] = kind;
+            }
+        }
+
+        void Infer::function(const DeclFunc<Token>::Func& func) const
+        {
+            // not parsed yet (lazy), runs on the generic path
+            if (func.blk == nullptr) return;
+
+            Types outer = types;
+            types = {};
+            func.blk->accept(*this);
+            types = outer;
+        }
+
+        Infer::Types Infer::merge(const Types& a, const Types& b)
+        {
+            Types ret = {};
+            for (const auto& [slot, kind] : a.frame) {
+                auto it = b.frame.find(slot);
+                if (it != b.frame.end() && it->second == kind) ret.frame[slot] = kind;
+            }
+            for (const auto& [name, kind] : a.globals) {
+                auto it = b.globals.find(name);
+                if (it != b.globals.end() && it->second == kind) ret.globals[name] = kind;
+            }
+            return ret;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Infer::visit_assign(const Assign<Token>& expr) const
+        {
+            auto value = kind(expr.value);
+            bind(expr.storage, expr.slot, expr.name.lexeme, value);
+            last = value;
+            return Token();
+        }
+
+        Token Infer::visit_binary(const Binary<Token>& expr) const
+        {
+            auto left = kind(expr.left);
+
+            // the right side of a short circuit may not run
+            if (expr.op.type == TokenType::NULLISH_COAL || expr.op.type == TokenType::LOG_AND || expr.op.type == TokenType::LOG_OR) {
+                Types skipped = types;
+                auto right = kind(expr.right);
+                types = merge(skipped, types);
+                if (expr.op.type == TokenType::NULLISH_COAL)
+                    last = left == right ? left : Kind::Unknown;
+                else
+                    last = Kind::Bool;
+                return Token();
+            }
+
+            auto right = kind(expr.right);
+            bool same = left == right && left != Kind::Unknown;
+            // loops revisit their body, only the final pass' view counts
+            bool known = expr.operands != Kind::Unknown;
+            expr.operands = Kind::Unknown;
+            last = Kind::Unknown;
+
+            switch (expr.op.type) {
+                case TokenType::PLUS:
+                    if (same && (number(left) || left == Kind::String)) {
+                        expr.operands = left;
+                        last = left;
+                    }
+                    break;
+                case TokenType::MINUS:
+                case TokenType::STAR:
+                case TokenType::SLASH:
+                    if (same && number(left)) {
+                        expr.operands = left;
+                        last = left;
+                    }
+                    break;
+                case TokenType::GREATER:
+                case TokenType::GREATER_EQUAL:
+                case TokenType::LESS:
+                case TokenType::LESS_EQUAL:
+                case TokenType::EQUAL_EQUAL:
+                case TokenType::BANG_EQUAL:
+                    if (same && (number(left) || left == Kind::String))
+                        expr.operands = left;
+                    last = Kind::Bool;
+                    break;
+                default:
+                    break;
+            }
+
+            if (!known && expr.operands != Kind::Unknown) tagged++;
+            else if (known && expr.operands == Kind::Unknown) tagged--;
+            return Token();
+        }
+
+        Token Infer::visit_grouping(const Grouping<Token>& expr) const
+        {
+            last = kind(expr.expr);
+            return Token();
+        }
+
+        Token Infer::visit_literal(const Literal<Token>& expr) const
+        {
+            switch (expr.value.type) {
+                case TokenType::TRUE:
+                case TokenType::FALSE:
+                    last = Kind::Bool;
+                    break;
+                case TokenType::STRINGLITERAL:
+                    last = Kind::String;
+                    break;
+                case TokenType::NUMERICLITERAL: {
+                    auto literal = expr.value.getLiteral();
+                    if (literal.type() == typeid(int)) last = Kind::Int;
+                    else if (literal.type() == typeid(double)) last = Kind::Double;
+                    else last = Kind::Unknown;
+                    break;
+                }
+                default:
+                    last = Kind::Unknown;
+            }
+            return Token();
+        }
+
+        Token Infer::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            last = Kind::Unknown;
+            if (expr.storage == Storage::Frame) {
+                auto it = types.frame.find(expr.slot);
+                if (it != types.frame.end()) last = it->second;
+            } else if (expr.storage == Storage::Global) {
+                auto it = types.globals.find(expr.value.lexeme);
+                if (it != types.globals.end()) last = it->second;
+            }
+            return Token();
+        }
+
+        Token Infer::visit_unary(const Unary<Token>& expr) const
+        {
+            auto right = kind(expr.expr);
+            // negation multiplies by an int -1, only ints stay what they are
+            if (expr.op.type == TokenType::MINUS) last = right == Kind::Int ? Kind::Int : Kind::Unknown;
+            else last = Kind::Bool;
+            return Token();
+        }
+
+        Token Infer::visit_ternary(const Ternary<Token>& expr) const
+        {
+            kind(expr.condition);
+            Types branch = types;
+            auto left = kind(expr.left);
+            Types taken = types;
+            types = branch;
+            auto right = kind(expr.right);
+            types = merge(taken, types);
+            last = left == right ? left : Kind::Unknown;
+            return Token();
+        }
+
+        Token Infer::visit_call(const Call<Token>& expr) const
+        {
+            for (const auto& arg : expr.args)
+                kind(arg);
+            // the callee may assign any global
+            types.globals.clear();
+            last = Kind::Unknown;
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Infer::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            kind(stmt.expr);
+        }
+
+        void Infer::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            kind(stmt.expr);
+        }
+
+        void Infer::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            // state where the next condition is tested, state after the arms run
+            Types test = types, out = {};
+            bool first = true;
+
+            auto arm = [&](const StmtIf<void>::Stmt* arm) {
+                if (arm == nullptr) return;
+                types = test;
+                if (arm->expr != nullptr) {
+                    kind(arm->expr);
+                    test = types;
+                }
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+                out = first ? types : merge(out, types);
+                first = false;
+            };
+
+            arm(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
+
+            // no else: every condition may fail
+            types = stmt.else_stmt == nullptr ? merge(out, test) : out;
+        }
+
+        void Infer::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            kind(stmt.expr);
+        }
+
+        void Infer::visit_block_stmt(const Block<void>& block) const
+        {
+            for (const auto& decl : block.decls)
+                if (decl != nullptr) decl->accept(*this);
+        }
+
+        void Infer::visit_for_stmt(const For<void>& stmt) const
+        {
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            else if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+
+            // iterate until the loop entry is stable, the last pass tags with it
+            Types exit = {};
+            while (true) {
+                Types entry = types;
+                kind(stmt.expr);
+                exit = types;
+                if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+                else if (stmt.blk != nullptr) stmt.blk->accept(*this);
+                if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+
+                types = merge(entry, types);
+                if (types == entry) break;
+            }
+            types = exit;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Infer::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return Token();
+        }
+
+        Token Infer::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            bind(decl.storage, decl.slot, decl.identifier.lexeme, kind(decl.expr));
+            return Token();
+        }
+
+        Token Infer::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            if (decl.func != nullptr) function(*decl.func);
+            // the name now holds a function
+            bind(decl.storage, decl.slot, decl.func != nullptr ? decl.func->name.lexeme : "", Kind::Unknown);
+            return Token();
+        }
+
+        Token Infer::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            for (const auto& method : decl.Methods)
+                function(method.second);
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Infer::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls)
+                if (decl != nullptr) decl->accept(*this);
+            return Tokens();
+        }
+    }
+}
@@ -0,0 +1,494 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/inline.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        /// @return the expression a single-return body returns (nullptr: not one)
+        static const Expr<Token>* returned(const DeclFunc<Token>::Func& func)
+        {
+            if (func.blk == nullptr || func.blk->decls.size() != 1) return nullptr;
+            auto stmt = dynamic_cast<const DeclStmt<Token>*>(func.blk->decls.front().get());
+            if (stmt == nullptr) return nullptr;
+            auto ret = dynamic_cast<const StmtReturn<void>*>(stmt->stmt.get());
+            return ret != nullptr ? ret->expr.get() : nullptr;
+        }
+
+        /// @brief global names something other than their function declaration writes
+        /// @note any: every name an assignment writes instead, whatever its storage
+        static void written(const Expr<Token>* expr, std::unordered_set<string>& names, bool any)
+        {
+            if (expr == nullptr) return;
+            if (auto assign = dynamic_cast<const Assign<Token>*>(expr)) {
+                if (any || assign->storage == Storage::Global) names.insert(assign->name.lexeme);
+                written(assign->value.get(), names, any);
+            } else if (auto bin = dynamic_cast<const Binary<Token>*>(expr)) {
+                written(bin->left.get(), names, any);
+                written(bin->right.get(), names, any);
+            } else if (auto group = dynamic_cast<const Grouping<Token>*>(expr)) {
+                written(group->expr.get(), names, any);
+            } else if (auto unary = dynamic_cast<const Unary<Token>*>(expr)) {
+                written(unary->expr.get(), names, any);
+            } else if (auto ternary = dynamic_cast<const Ternary<Token>*>(expr)) {
+                written(ternary->condition.get(), names, any);
+                written(ternary->left.get(), names, any);
+                written(ternary->right.get(), names, any);
+            } else if (auto call = dynamic_cast<const Call<Token>*>(expr)) {
+                for (const auto& arg : call->args)
+                    written(arg.get(), names, any);
+            }
+        }
+
+        static void written(const Stmt<void>* stmt, std::unordered_set<string>& names, bool any);
+
+        static void written(const Decl<Token>* decl, std::unordered_set<string>& names, bool any)
+        {
+            if (auto stmt = dynamic_cast<const DeclStmt<Token>*>(decl)) {
+                written(stmt->stmt.get(), names, any);
+            } else if (auto var = dynamic_cast<const DeclVar<Token>*>(decl)) {
+                if (!any && var->storage == Storage::Global) names.insert(var->identifier.lexeme);
+                // the initializer is an assignment to the new name, only its value writes
+                auto init = dynamic_cast<const Assign<Token>*>(var->expr.get());
+                written(init != nullptr ? init->value.get() : var->expr.get(), names, any);
+            } else if (auto func = dynamic_cast<const DeclFunc<Token>*>(decl)) {
+                if (func->func != nullptr && func->func->blk != nullptr) written(func->func->blk.get(), names, any);
+            } else if (auto cls = dynamic_cast<const DeclClass<Token>*>(decl)) {
+                if (!any) names.insert(cls->identifier.lexeme);
+            }
+        }
+
+        static void written(const Stmt<void>* stmt, std::unordered_set<string>& names, bool any)
+        {
+            if (stmt == nullptr) return;
+            if (auto expr = dynamic_cast<const StmtExpr<void>*>(stmt)) {
+                written(expr->expr.get(), names, any);
+            } else if (auto print = dynamic_cast<const StmtPrint<void>*>(stmt)) {
+                written(print->expr.get(), names, any);
+            } else if (auto ret = dynamic_cast<const StmtReturn<void>*>(stmt)) {
+                written(ret->expr.get(), names, any);
+            } else if (auto blk = dynamic_cast<const Block<void>*>(stmt)) {
+                for (const auto& decl : blk->decls)
+                    written(decl.get(), names, any);
+            } else if (auto ifs = dynamic_cast<const StmtIf<void>*>(stmt)) {
+                auto arm = [&names, any](const StmtIf<void>::Stmt* arm) {
+                    if (arm == nullptr) return;
+                    written(arm->expr.get(), names, any);
+                    written(arm->blk.get(), names, any);
+                    written(arm->stmt.get(), names, any);
+                };
+                arm(ifs->if_stmt);
+                for (const auto& elif : ifs->elif_stmts)
+                    arm(elif);
+                arm(ifs->else_stmt);
+            } else if (auto loop = dynamic_cast<const For<void>*>(stmt)) {
+                written(loop->decl.get(), names, any);
+                written(loop->stmt_l.get(), names, any);
+                written(loop->expr.get(), names, any);
+                written(loop->stmt_r.get(), names, any);
+                written(loop->blk.get(), names, any);
+                written(loop->stmt_o.get(), names, any);
+            }
+        }
+
+        std::unordered_set<string> Inline::written(const std::unique_ptr<Program<Tokens>>& prgm)
+        {
+            std::unordered_set<string> names = {};
+            for (const auto& decl : prgm->decls)
+                rift::ast::written(decl.get(), names, false);
+            return names;
+        }
+
+        std::unordered_set<string> Inline::assigned(const std::unique_ptr<Program<Tokens>>& prgm)
+        {
+            std::unordered_set<string> names = {};
+            for (const auto& decl : prgm->decls)
+                rift::ast::written(decl.get(), names, true);
+            return names;
+        }
+
+        unsigned Inline::run(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            unsigned before = count;
+
+            // names bound once, to a function nothing ever reassigns
+            std::unordered_set<string> names = written(prgm), twice = {};
+            std::unordered_map<string, const DeclFunc<Token>::Func*> found = {};
+            for (const auto& decl : prgm->decls) {
+                auto func = dynamic_cast<const DeclFunc<Token>*>(decl.get());
+                if (func == nullptr || func->func == nullptr) continue;
+                const auto& name = func->func->name.lexeme;
+                if (found.contains(name)) twice.insert(name);
+                found[name] = func->func.get();
+            }
+
+            funcs = {};
+            for (const auto& [name, func] : found) {
+                auto body = returned(*func);
+                if (body == nullptr || twice.contains(name) || names.contains(name)) continue;
+                // captured params need a boxed scope
+                if (func->boxes > 0 || size(body) > limit) continue;
+                funcs[name] = func;
+            }
+
+            active = {};
+            declared = {};
+            if (!funcs.empty()) prgm->accept(*this);
+            return count - before;
+        }
+
+        bool Inline::scan(const Expr<Token>* expr, const string& self, Uses& uses, bool conditional)
+        {
+            if (expr == nullptr) return true;
+            if (dynamic_cast<const Literal<Token>*>(expr) != nullptr) return true;
+
+            if (auto var = dynamic_cast<const VarExpr<Token>*>(expr)) {
+                if (var->storage == Storage::Boxed || var->storage == Storage::Upvalue) return false;
+                if (var->storage == Storage::Frame) {
+                    if (var->slot < 0 || var->slot >= (int)uses.reads.size()) return false;
+                    uses.reads[var->slot]++;
+                    if (conditional) uses.conditional[var->slot] = true;
+                }
+                return true;
+            }
+            // a body writing anything is not an expression we can copy around
+            if (dynamic_cast<const Assign<Token>*>(expr) != nullptr) return false;
+
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr)) {
+                bool shorts = bin->op.type == TokenType::NULLISH_COAL || bin->op.type == TokenType::LOG_AND || bin->op.type == TokenType::LOG_OR;
+                return scan(bin->left.get(), self, uses, conditional) && scan(bin->right.get(), self, uses, conditional || shorts);
+            }
+            if (auto group = dynamic_cast<const Grouping<Token>*>(expr))
+                return scan(group->expr.get(), self, uses, conditional);
+            if (auto unary = dynamic_cast<const Unary<Token>*>(expr))
+                return scan(unary->expr.get(), self, uses, conditional);
+            if (auto ternary = dynamic_cast<const Ternary<Token>*>(expr))
+                return scan(ternary->condition.get(), self, uses, conditional) &&
+                       scan(ternary->left.get(), self, uses, true) && scan(ternary->right.get(), self, uses, true);
+            if (auto call = dynamic_cast<const Call<Token>*>(expr)) {
+                // only global callees, never itself (recursion)
+                if (call->storage != Storage::Global || call->name.lexeme == self) return false;
+                uses.calls = true;
+                for (const auto& arg : call->args)
+                    if (!scan(arg.get(), self, uses, conditional)) return false;
+                return true;
+            }
+            return false;
+        }
+
+        /// @return reads & literals only (no side effects)
+        static bool pure(const Expr<Token>* expr)
+        {
+            if (expr == nullptr) return true;
+            if (dynamic_cast<const Literal<Token>*>(expr) != nullptr || dynamic_cast<const VarExpr<Token>*>(expr) != nullptr)
+                return true;
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr))
+                return pure(bin->left.get()) && pure(bin->right.get());
+            if (auto group = dynamic_cast<const Grouping<Token>*>(expr))
+                return pure(group->expr.get());
+            if (auto unary = dynamic_cast<const Unary<Token>*>(expr))
+                return pure(unary->expr.get());
+            if (auto ternary = dynamic_cast<const Ternary<Token>*>(expr))
+                return pure(ternary->condition.get()) && pure(ternary->left.get()) && pure(ternary->right.get());
+            return false;
+        }
+
+        std::unique_ptr<Expr<Token>> Inline::substitute(const Call<Token>& call) const
+        {
+            if (call.storage != Storage::Global || active.size() >= depth) return nullptr;
+            // a call ahead of the declaration finds no function bound, it stays to fail
+            auto it = funcs.find(call.name.lexeme);
+            if (it == funcs.end() || !declared.contains(call.name.lexeme)) return nullptr;
+            if (std::find(active.begin(), active.end(), call.name.lexeme) != active.end()) return nullptr;
+
+            const auto& func = *it->second;
+            auto body = returned(func);
+            Uses uses = {std::vector<unsigned>(func.params.size(), 0), std::vector<bool>(func.params.size(), false), false};
+            if (body == nullptr || !scan(body, func.name.lexeme, uses, false)) return nullptr;
+
+            // extra arguments are not ours to drop
+            if (call.args.size() > func.params.size()) return nullptr;
+
+            std::vector<const Expr<Token>*> params(func.params.size(), nullptr);
+            for (size_t i = 0; i < call.args.size(); i++) {
+                const Expr<Token>* val = call.args[i].get();
+                auto var = dynamic_cast<const VarExpr<Token>*>(val);
+                bool literal = dynamic_cast<const Literal<Token>*>(val) != nullptr;
+
+                if (uses.calls) {
+                    // a callee may write any global or captured local, not the caller's frame
+                    if (!literal && (var == nullptr || var->storage != Storage::Frame)) return nullptr;
+                } else if (!literal && var == nullptr) {
+                    // evaluated exactly once, where the parameter is read
+                    if (!pure(val) || uses.reads[i] != 1 || uses.conditional[i]) return nullptr;
+                }
+                params[i] = val;
+            }
+
+            return clone(body, params);
+        }
+
+        std::unique_ptr<Expr<Token>> Inline::clone(const Expr<Token>* expr, const std::vector<const Expr<Token>*>& params)
+        {
+            if (expr == nullptr) return nullptr;
+
+            if (auto lit = dynamic_cast<const Literal<Token>*>(expr))
+                return std::make_unique<Literal<Token>>(lit->value);
+
+            if (auto var = dynamic_cast<const VarExpr<Token>*>(expr)) {
+                if (var->storage == Storage::Frame && var->slot >= 0 && var->slot < (int)params.size()) {
+                    if (params[var->slot] == nullptr)
+                        return std::make_unique<Literal<Token>>(Token(TokenType::NIL, "nil", nullptr, var->value.line));
+                    return clone(params[var->slot], {});
+                }
+                auto ret = std::make_unique<VarExpr<Token>>(var->value);
+                ret->storage = var->storage;
+                ret->depth = var->depth;
+                ret->slot = var->slot;
+                return ret;
+            }
+
+            if (auto assign = dynamic_cast<const Assign<Token>*>(expr)) {
+                auto ret = std::make_unique<Assign<Token>>(assign->name, clone(assign->value.get(), params));
+                ret->storage = assign->storage;
+                ret->depth = assign->depth;
+                ret->slot = assign->slot;
+                return ret;
+            }
+
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr)) {
+                auto ret = std::make_unique<Binary<Token>>(clone(bin->left.get(), params), bin->op, clone(bin->right.get(), params));
+                ret->operands = bin->operands;
+                return ret;
+            }
+
+            if (auto group = dynamic_cast<const Grouping<Token>*>(expr))
+                return std::make_unique<Grouping<Token>>(clone(group->expr.get(), params));
+
+            if (auto unary = dynamic_cast<const Unary<Token>*>(expr))
+                return std::make_unique<Unary<Token>>(unary->op, clone(unary->expr.get(), params));
+
+            if (auto ternary = dynamic_cast<const Ternary<Token>*>(expr))
+                return std::make_unique<Ternary<Token>>(clone(ternary->condition.get(), params), clone(ternary->left.get(), params), clone(ternary->right.get(), params));
+
+            if (auto call = dynamic_cast<const Call<Token>*>(expr)) {
+                Call<Token>::Exprs args = {};
+                for (const auto& arg : call->args)
+                    args.push_back(clone(arg.get(), params));
+                auto ret = std::make_unique<Call<Token>>(call->name, std::move(args));
+                ret->storage = call->storage;
+                ret->depth = call->depth;
+                ret->slot = call->slot;
+                return ret;
+            }
+
+            return nullptr;
+        }
+
+        unsigned Inline::size(const Expr<Token>* expr)
+        {
+            if (expr == nullptr) return 0;
+            if (auto assign = dynamic_cast<const Assign<Token>*>(expr))
+                return 1 + size(assign->value.get());
+            if (auto bin = dynamic_cast<const Binary<Token>*>(expr))
+                return 1 + size(bin->left.get()) + size(bin->right.get());
+            if (auto group = dynamic_cast<const Grouping<Token>*>(expr))
+                return 1 + size(group->expr.get());
+            if (auto unary = dynamic_cast<const Unary<Token>*>(expr))
+                return 1 + size(unary->expr.get());
+            if (auto ternary = dynamic_cast<const Ternary<Token>*>(expr))
+                return 1 + size(ternary->condition.get()) + size(ternary->left.get()) + size(ternary->right.get());
+            if (auto call = dynamic_cast<const Call<Token>*>(expr)) {
+                unsigned ret = 1;
+                for (const auto& arg : call->args)
+                    ret += size(arg.get());
+                return ret;
+            }
+            return 1;
+        }
+
+        void Inline::expand(const std::unique_ptr<Expr<Token>>& expr) const
+        {
+            if (expr == nullptr) return;
+
+            // arguments first, they are copied into the body
+            expr->accept(*this);
+
+            auto call = dynamic_cast<const Call<Token>*>(expr.get());
+            if (call == nullptr) return;
+            auto body = substitute(*call);
+            if (body == nullptr) return;
+
+            active.push_back(call->name.lexeme);
+            auto& owner = const_cast<std::unique_ptr<Expr<Token>>&>(expr);
+            owner = std::move(body);
+            count++;
+            // calls made by the body (not those in the arguments, already done)
+            owner->accept(*this);
+            active.pop_back();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Inline::visit_assign(const Assign<Token>& expr) const
+        {
+            expand(expr.value);
+            return Token();
+        }
+
+        Token Inline::visit_binary(const Binary<Token>& expr) const
+        {
+            expand(expr.left);
+            expand(expr.right);
+            return Token();
+        }
+
+        Token Inline::visit_grouping(const Grouping<Token>& expr) const
+        {
+            expand(expr.expr);
+            return Token();
+        }
+
+        Token Inline::visit_literal(const Literal<Token>& expr) const
+        {
+            return Token();
+        }
+
+        Token Inline::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            return Token();
+        }
+
+        Token Inline::visit_unary(const Unary<Token>& expr) const
+        {
+            expand(expr.expr);
+            return Token();
+        }
+
+        Token Inline::visit_ternary(const Ternary<Token>& expr) const
+        {
+            expand(expr.condition);
+            expand(expr.left);
+            expand(expr.right);
+            return Token();
+        }
+
+        Token Inline::visit_call(const Call<Token>& expr) const
+        {
+            for (const auto& arg : expr.args)
+                expand(arg);
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Inline::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            expand(stmt.expr);
+        }
+
+        void Inline::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            expand(stmt.expr);
+        }
+
+        void Inline::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            auto arm = [this](const StmtIf<void>::Stmt* arm) {
+                if (arm == nullptr) return;
+                expand(arm->expr);
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            arm(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
+        }
+
+        void Inline::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            expand(stmt.expr);
+        }
+
+        void Inline::visit_block_stmt(const Block<void>& block) const
+        {
+            for (const auto& decl : block.decls)
+                if (decl != nullptr) decl->accept(*this);
+        }
+
+        void Inline::visit_for_stmt(const For<void>& stmt) const
+        {
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+            expand(stmt.expr);
+            if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+            if (stmt.blk != nullptr) stmt.blk->accept(*this);
+            if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Inline::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return Token();
+        }
+
+        Token Inline::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            expand(decl.expr);
+            return Token();
+        }
+
+        Token Inline::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            if (decl.func != nullptr && decl.func->blk != nullptr)
+                decl.func->blk->accept(*this);
+            return Token();
+        }
+
+        Token Inline::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Inline::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls) {
+                if (decl == nullptr) continue;
+                decl->accept(*this);
+                // calls after a top level declaration find the function bound
+                if (auto func = dynamic_cast<const DeclFunc<Token>*>(decl.get()); func != nullptr && func->func != nullptr)
+                    declared.insert(func->func->name.lexeme);
+            }
+            return Tokens();
+        }
+    }
+}
@@ -0,0 +1,406 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/jit.hh>
+#include <chrono>
+#include <cstring>
+
+#ifdef RIFT_JIT
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
+namespace rift
+{
+    namespace ast
+    {
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - ASSEMBLER
+        ////////////////////////////////////////////////////////////////////////
+
+        void Assembler::byte(uint8_t b)
+        {
+            code.push_back(b);
+        }
+
+        void Assembler::dword(int32_t d)
+        {
+            for (int i = 0; i < 4; i++)
+                code.push_back(static_cast<uint8_t>(static_cast<uint32_t>(d) >> (8 * i)));
+        }
+
+        void Assembler::mem(uint8_t reg, Mem m)
+        {
+            // mod 10: [base + disp32], rsp as a base takes a SIB byte
+            byte(0x80 | (reg & 7) << 3 | (m.base & 7));
+            if (m.base == rsp) byte(0x24);
+            dword(m.disp);
+        }
+
+        void Assembler::direct(uint8_t reg, Reg rm)
+        {
+            byte(0xC0 | (reg & 7) << 3 | (rm & 7));
+        }
+
+        void Assembler::rel32(Label label)
+        {
+            fixups.emplace_back(code.size(), label);
+            dword(0);
+        }
+
+        void Assembler::mov(Reg dst, int32_t imm) { byte(0xB8 + dst); dword(imm); }
+        void Assembler::mov(Reg dst, Reg src) { byte(0x89); direct(src, dst); }
+        void Assembler::mov(Reg dst, Mem src) { byte(0x8B); mem(dst, src); }
+        void Assembler::mov(Mem dst, Reg src) { byte(0x89); mem(src, dst); }
+        void Assembler::mov8(Mem dst, uint8_t imm) { byte(0xC6); mem(0, dst); byte(imm); }
+        void Assembler::mov8(Mem dst, Reg src) { byte(0x88); mem(src, dst); }
+        void Assembler::mov32(Mem dst, int32_t imm) { byte(0xC7); mem(0, dst); dword(imm); }
+        void Assembler::movzx8(Reg dst, Mem src) { byte(0x0F); byte(0xB6); mem(dst, src); }
+        void Assembler::movzx8(Reg dst, Reg src) { byte(0x0F); byte(0xB6); direct(dst, src); }
+
+        void Assembler::add(Reg dst, Mem src) { byte(0x03); mem(dst, src); }
+        void Assembler::add(Reg dst, int32_t imm) { byte(0x81); direct(0, dst); dword(imm); }
+        void Assembler::sub(Reg dst, Mem src) { byte(0x2B); mem(dst, src); }
+        void Assembler::sub(Reg dst, int32_t imm) { byte(0x81); direct(5, dst); dword(imm); }
+        void Assembler::imul(Reg dst, Mem src) { byte(0x0F); byte(0xAF); mem(dst, src); }
+        void Assembler::imul(Reg dst, int32_t imm) { byte(0x69); direct(dst, dst); dword(imm); }
+        void Assembler::cmp(Reg left, Mem right) { byte(0x3B); mem(left, right); }
+        void Assembler::cmp(Reg left, int32_t imm) { byte(0x81); direct(7, left); dword(imm); }
+        void Assembler::cmp8(Mem left, uint8_t imm) { byte(0x80); mem(7, left); byte(imm); }
+        void Assembler::cmp8(Reg left, uint8_t imm) { byte(0x80); direct(7, left); byte(imm); }
+        void Assembler::neg(Reg dst) { byte(0xF7); direct(3, dst); }
+        void Assembler::cdq() { byte(0x99); }
+        void Assembler::idiv(Reg divisor) { byte(0xF7); direct(7, divisor); }
+        void Assembler::setcc(Cond cond, Reg dst) { byte(0x0F); byte(0x90 + cond); direct(0, dst); }
+
+        Assembler::Label Assembler::label()
+        {
+            bound.push_back(-1);
+            return bound.size() - 1;
+        }
+
+        void Assembler::bind(Label label)
+        {
+            bound[label] = code.size();
+        }
+
+        void Assembler::jmp(Label label) { byte(0xE9); rel32(label); }
+        void Assembler::jcc(Cond cond, Label label) { byte(0x0F); byte(0x80 + cond); rel32(label); }
+        void Assembler::ret() { byte(0xC3); }
+
+        const std::vector<uint8_t>& Assembler::finish()
+        {
+            // relative to the end of the jump
+            for (const auto& [at, label] : fixups) {
+                auto rel = static_cast<int32_t>(bound[label] - static_cast<int64_t>(at + 4));
+                for (int i = 0; i < 4; i++)
+                    code[at + i] = static_cast<uint8_t>(static_cast<uint32_t>(rel) >> (8 * i));
+            }
+            fixups.clear();
+            return code;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - JIT
+        ////////////////////////////////////////////////////////////////////////
+
+        Native::~Native()
+        {
+            #ifdef RIFT_JIT
+                munmap(pages, mapped);
+            #endif
+        }
+
+        #pragma mark - Helpers
+
+        /// @brief where a value keeps its type & its int (or bool), found once
+        struct Layout
+        {
+            int32_t stride, type, payload;
+
+            static const Layout& get() {
+                static const Layout layout = [] {
+                    Value v;
+                    auto base = reinterpret_cast<const char*>(&v);
+                    return Layout{
+                        static_cast<int32_t>(sizeof(Value)),
+                        static_cast<int32_t>(reinterpret_cast<const char*>(&v.type) - base),
+                        static_cast<int32_t>(reinterpret_cast<const char*>(&v.i) - base)
+                    };
+                }();
+                return layout;
+            }
+        };
+
+        static constexpr uint8_t NIL = static_cast<uint8_t>(Value::Type::Nil);
+        static constexpr uint8_t BOOL = static_cast<uint8_t>(Value::Type::Bool);
+        static constexpr uint8_t INT = static_cast<uint8_t>(Value::Type::Int);
+        static constexpr uint8_t BOXED = static_cast<uint8_t>(Value::Type::Boxed);
+
+        static inline bool integer(const Proto& proto, size_t k)
+        {
+            return proto.constants[k].type == Value::Type::Int;
+        }
+
+        /// @brief whether the jit translates the instruction (the rest leave to the interpreter)
+        static bool translates(const Proto& proto, const Instr& instr)
+        {
+            switch (instr.op) {
+                case RegOp::Move: case RegOp::LoadNil: case RegOp::LoadBool:
+                case RegOp::Add: case RegOp::Sub: case RegOp::Mul: case RegOp::Div:
+                case RegOp::Less: case RegOp::LessEqual: case RegOp::Greater: case RegOp::GreaterEqual:
+                case RegOp::Equal: case RegOp::NotEqual: case RegOp::Negate:
+                case RegOp::Jump: case RegOp::JumpIfFalse: case RegOp::JumpIfTrue: case RegOp::JumpIfNotNil:
+                    return true;
+                case RegOp::LoadK:
+                    return integer(proto, instr.b);
+                case RegOp::AddK: case RegOp::SubK: case RegOp::MulK:
+                case RegOp::LessK: case RegOp::LessEqualK: case RegOp::GreaterK: case RegOp::GreaterEqualK:
+                case RegOp::EqualK: case RegOp::NotEqualK:
+                    return integer(proto, instr.c);
+                case RegOp::DivK:
+                    // dividing by zero (an error) & INT_MIN / -1 (a trap) stay interpreted
+                    return integer(proto, instr.c) && proto.constants[instr.c].i != 0 && proto.constants[instr.c].i != -1;
+                default:
+                    return false;
+            }
+        }
+
+        /// @brief the comparison's condition code (signed)
+        static Assembler::Cond condition(RegOp op)
+        {
+            switch (op) {
+                case RegOp::Less: case RegOp::LessK: return Assembler::L;
+                case RegOp::LessEqual: case RegOp::LessEqualK: return Assembler::LE;
+                case RegOp::Greater: case RegOp::GreaterK: return Assembler::G;
+                case RegOp::GreaterEqual: case RegOp::GreaterEqualK: return Assembler::GE;
+                case RegOp::Equal: case RegOp::EqualK: return Assembler::E;
+                default: return Assembler::NE;
+            }
+        }
+
+        std::shared_ptr<Native> Jit::compile(const Proto& proto)
+        {
+            #ifndef RIFT_JIT
+                return nullptr;
+            #else
+                using A = Assembler;
+                auto start = std::chrono::steady_clock::now();
+                const auto& instrs = proto.instrs;
+                const auto& layout = Layout::get();
+
+                // only worth it if most of the code translates, entered at the start & loop headers
+                std::vector<bool> entries(instrs.size() + 1, false);
+                entries[0] = true;
+                size_t translated = 0;
+                for (size_t pc = 0; pc < instrs.size(); pc++) {
+                    if (translates(proto, instrs[pc])) translated++;
+                    if (instrs[pc].op == RegOp::Jump && instrs[pc].a <= pc) entries[instrs[pc].a] = true;
+                }
+                if (translated * 2 < instrs.size())
+                    return nullptr;
+
+                // rdi: the register window, esi: the instruction to start at
+                A as;
+                auto type = [&](int reg) { return A::Mem{A::rdi, reg * layout.stride + layout.type}; };
+                auto payload = [&](int reg) { return A::Mem{A::rdi, reg * layout.stride + layout.payload}; };
+                std::vector<A::Label> labels(instrs.size() + 1), deopts(instrs.size(), SIZE_MAX);
+                for (auto& label : labels) label = as.label();
+                auto deopt = [&](size_t pc) {
+                    if (deopts[pc] == SIZE_MAX) deopts[pc] = as.label();
+                    return deopts[pc];
+                };
+                // the register holds an int / may take one (nothing it holds needs releasing)
+                auto expect = [&](int reg, size_t pc) { as.cmp8(type(reg), INT); as.jcc(A::NE, deopt(pc)); };
+                auto writable = [&](int reg, size_t pc) { as.cmp8(type(reg), INT); as.jcc(A::A, deopt(pc)); };
+                auto store = [&](int reg, uint8_t tag) { as.mov8(type(reg), tag); as.mov(payload(reg), A::rax); };
+
+                for (size_t pc = 0; pc < entries.size(); pc++) {
+                    if (!entries[pc]) continue;
+                    as.cmp(A::rsi, static_cast<int32_t>(pc));
+                    as.jcc(A::E, labels[pc]);
+                }
+                as.mov(A::rax, A::rsi);
+                as.ret();
+
+                for (size_t pc = 0; pc < instrs.size(); pc++) {
+                    const auto& in = instrs[pc];
+                    as.bind(labels[pc]);
+                    if (!translates(proto, in)) {
+                        as.mov(A::rax, static_cast<int32_t>(pc));
+                        as.ret();
+                        continue;
+                    }
+
+                    switch (in.op) {
+                        case RegOp::Move:
+                            if (in.a == in.b) break;
+                            as.movzx8(A::rax, type(in.b));
+                            as.cmp8(A::rax, INT);
+                            as.jcc(A::A, deopt(pc));
+                            writable(in.a, pc);
+                            as.mov8(type(in.a), A::rax);
+                            as.mov(A::rcx, payload(in.b));
+                            as.mov(payload(in.a), A::rcx);
+                            break;
+                        case RegOp::LoadK:
+                            writable(in.a, pc);
+                            as.mov8(type(in.a), INT);
+                            as.mov32(payload(in.a), proto.constants[in.b].i);
+                            break;
+                        case RegOp::LoadNil:
+                            writable(in.a, pc);
+                            as.mov8(type(in.a), NIL);
+                            as.mov32(payload(in.a), 0);
+                            break;
+                        case RegOp::LoadBool:
+                            writable(in.a, pc);
+                            as.mov8(type(in.a), BOOL);
+                            as.mov32(payload(in.a), in.b != 0);
+                            break;
+
+                        case RegOp::Add: case RegOp::Sub: case RegOp::Mul:
+                        case RegOp::AddK: case RegOp::SubK: case RegOp::MulK: {
+                            bool k = in.op == RegOp::AddK || in.op == RegOp::SubK || in.op == RegOp::MulK;
+                            expect(in.b, pc);
+                            if (!k) expect(in.c, pc);
+                            writable(in.a, pc);
+                            as.mov(A::rax, payload(in.b));
+                            int32_t imm = k ? proto.constants[in.c].i : 0;
+                            switch (in.op) {
+                                case RegOp::Add: as.add(A::rax, payload(in.c)); break;
+                                case RegOp::Sub: as.sub(A::rax, payload(in.c)); break;
+                                case RegOp::Mul: as.imul(A::rax, payload(in.c)); break;
+                                case RegOp::AddK: as.add(A::rax, imm); break;
+                                case RegOp::SubK: as.sub(A::rax, imm); break;
+                                default: as.imul(A::rax, imm); break;
+                            }
+                            store(in.a, INT);
+                            break;
+                        }
+                        case RegOp::Div: case RegOp::DivK:
+                            expect(in.b, pc);
+                            if (in.op == RegOp::Div) {
+                                expect(in.c, pc);
+                                as.mov(A::rcx, payload(in.c));
+                                // dividing by zero (an error) & INT_MIN / -1 (a trap) stay interpreted
+                                as.cmp(A::rcx, 0);
+                                as.jcc(A::E, deopt(pc));
+                                as.cmp(A::rcx, -1);
+                                as.jcc(A::E, deopt(pc));
+                            } else {
+                                as.mov(A::rcx, proto.constants[in.c].i);
+                            }
+                            writable(in.a, pc);
+                            as.mov(A::rax, payload(in.b));
+                            as.cdq();
+                            as.idiv(A::rcx);
+                            store(in.a, INT);
+                            break;
+                        case RegOp::Less: case RegOp::LessEqual: case RegOp::Greater: case RegOp::GreaterEqual:
+                        case RegOp::Equal: case RegOp::NotEqual:
+                        case RegOp::LessK: case RegOp::LessEqualK: case RegOp::GreaterK: case RegOp::GreaterEqualK:
+                        case RegOp::EqualK: case RegOp::NotEqualK: {
+                            bool k = in.op >= RegOp::AddK;
+                            expect(in.b, pc);
+                            if (!k) expect(in.c, pc);
+                            writable(in.a, pc);
+                            as.mov(A::rax, payload(in.b));
+                            if (k) as.cmp(A::rax, proto.constants[in.c].i);
+                            else as.cmp(A::rax, payload(in.c));
+                            as.setcc(condition(in.op), A::rax);
+                            as.movzx8(A::rax, A::rax);
+                            store(in.a, BOOL);
+                            break;
+                        }
+                        case RegOp::Negate:
+                            expect(in.b, pc);
+                            writable(in.a, pc);
+                            as.mov(A::rax, payload(in.b));
+                            as.neg(A::rax);
+                            store(in.a, INT);
+                            break;
+
+                        case RegOp::Jump:
+                            as.jmp(labels[in.a]);
+                            break;
+                        case RegOp::JumpIfFalse: case RegOp::JumpIfTrue: {
+                            // a bool tests its payload, a boxed value is left to the interpreter,
+                            // the rest are truthy
+                            auto other = as.label();
+                            bool falsy = in.op == RegOp::JumpIfFalse;
+                            as.movzx8(A::rax, type(in.b));
+                            as.cmp8(A::rax, BOOL);
+                            as.jcc(A::NE, other);
+                            as.cmp8(payload(in.b), 0);
+                            as.jcc(falsy ? A::E : A::NE, labels[in.a]);
+                            as.jmp(labels[pc + 1]);
+                            as.bind(other);
+                            as.cmp8(A::rax, BOXED);
+                            as.jcc(A::E, deopt(pc));
+                            if (!falsy) as.jmp(labels[in.a]);
+                            break;
+                        }
+                        case RegOp::JumpIfNotNil:
+                            as.movzx8(A::rax, type(in.b));
+                            as.cmp8(A::rax, NIL);
+                            as.jcc(A::E, labels[pc + 1]);
+                            as.cmp8(A::rax, BOXED);
+                            as.jcc(A::E, deopt(pc));
+                            as.jmp(labels[in.a]);
+                            break;
+                        default:
+                            break;
+                    }
+                }
+                as.bind(labels[instrs.size()]);
+                as.mov(A::rax, static_cast<int32_t>(instrs.size()));
+                as.ret();
+
+                // a guard failed: the interpreter redoes the instruction
+                for (size_t pc = 0; pc < deopts.size(); pc++) {
+                    if (deopts[pc] == SIZE_MAX) continue;
+                    as.bind(deopts[pc]);
+                    as.mov(A::rax, static_cast<int32_t>(pc | Native::DEOPT));
+                    as.ret();
+                }
+
+                // writable pages for the copy, executable ones for the run
+                const auto& code = as.finish();
+                size_t page = sysconf(_SC_PAGESIZE);
+                size_t mapped = (code.size() + page - 1) / page * page;
+                void* pages = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (pages == MAP_FAILED)
+                    return nullptr;
+                std::memcpy(pages, code.data(), code.size());
+                if (mprotect(pages, mapped, PROT_READ | PROT_EXEC) != 0) {
+                    munmap(pages, mapped);
+                    return nullptr;
+                }
+
+                auto native = std::make_shared<Native>(pages, mapped, code.size());
+                native->entries = std::move(entries);
+
+                Stats stats;
+                stats.name = proto.name.lexeme.empty() ? "<script>" : proto.name.lexeme;
+                stats.bytes = code.size();
+                stats.instrs = instrs.size();
+                stats.translated = translated;
+                stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                compiled.push_back(std::move(stats));
+                return native;
+            #endif
+        }
+    }
+}
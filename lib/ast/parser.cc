@@ -41,6 +41,22 @@ namespace rift
             }
         }
 
+        bool Parser::materialize(DeclFunc<Token>::Func& func)
+        {
+            if (func.blk != nullptr || func.src == nullptr) return false;
+
+            Parser parser(func.src);
+            parser.curr = func.begin;
+            parser.depth = 1;
+            auto stmt = parser.statement_block();
+            if (parser.curr != func.end)
+                rift::error::report(parser.line, "materialize", "Function body did not end at its closing brace", parser.peek(), ParserException("Function body did not end at its closing brace"));
+
+            func.blk.reset(dynamic_cast<Block<void>*>(stmt.release()));
+            func.src = nullptr;
+            return true;
+        }
+
         ////////////////////////////////////////////////////////////////////////
         #pragma mark - Expressions Parsing
         ////////////////////////////////////////////////////////////////////////
@@ -71,20 +87,16 @@ namespace rift
                 return primary();
         }
 
-        Call<Token>::Exprs Parser::args(Tokens params)
+        Call<Token>::Exprs Parser::args()
         {
             Call<Token>::Exprs exprs = {};
-            int idx = 0;
-            while(peek().type != TokenType::RIGHT_PAREN) {
+            if (peek().type == TokenType::RIGHT_PAREN) return exprs;
+            do {
                 auto exp = expression();
-                if (idx >= params.size()) 
-                    rift::error::report(line, "args", "Too many arguments", peek(), ParserException("Too many arguments"));
                 if (exp == nullptr) 
                     rift::error::report(line, "args", "Expected expression", peek(), ParserException("Expected expression"));
-                
-                exprs.insert({params[idx].lexeme, std::move(exp)});
-                idx++;
-            }
+                exprs.push_back(std::move(exp));
+            } while (consume(Token(TokenType::COMMA, ",", "", line)));
             return exprs;
         }
 
@@ -96,16 +108,11 @@ namespace rift
             // since that's the only way to verify between func test() {} and test(); 
             // note the "test()""
             if (peekPrev().type == TokenType::IDENTIFIER && peek() == Token(TokenType::LEFT_PAREN)) {
-                // get function from token, and grab its paramaters so I can plug them in with args
+                // arguments are positional, their count is checked against the callee once it is resolved
                 auto idt = peekPrev();
-                auto func = curr_env->getEnv<Token>(idt.lexeme);
-                Tokens params;
-                // std::cout << idt.lexeme << ":" << func.lexeme << std::endl;
-
-                params = std::any_cast<Tokens>(func.literal);
                 consume(Token(TokenType::LEFT_PAREN));
-                auto arg = args(params);
-                consume(Token(TokenType::RIGHT_PAREN));
+                auto arg = args();
+                consume(Token(TokenType::RIGHT_PAREN), std::unique_ptr<ParserException>(new ParserException("Expected ')' after arguments")));
                 // another dillema, how do i handle return 3;
                 // do I handle it here or in the return stmt, I choose later
                 // consume(Token(TokenType::SEMICOLON));
@@ -281,7 +288,7 @@ namespace rift
             if (peek() == Token(TokenType::LEFT_BRACE, "{", "", line)) {
                 consume(Token(TokenType::LEFT_BRACE, "{", "", line), std::unique_ptr<ParserException>(new ParserException("Expected '{' after if block")));
                 auto blk = statement_block();
-                if_stmt->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.get()));
+                if_stmt->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.release()));
                 if (!if_stmt->blk)
                     rift::error::report(line, "statement_if", "Expected block", peek(), ParserException("Expected block"));
             } else {
@@ -295,13 +302,15 @@ namespace rift
                 std::vector<StmtIf<void>::Stmt*> elif_stmts = {};
 
                 while (consume(Token(TokenType::ELIF, "elif", "elif", line))) {
+                    consume(Token(TokenType::LEFT_PAREN, "(", "", line), std::unique_ptr<ParserException>(new ParserException("Expected '(' after elif")));
                     auto expr = expression();
+                    consume(Token(TokenType::RIGHT_PAREN, ")", "", line), std::unique_ptr<ParserException>(new ParserException("Expected ')' after elif")));
                     StmtIf<void>::Stmt* curr = new StmtIf<void>::Stmt(std::move(expr));
                      // block vs stmt
                     if (peek() == Token(TokenType::LEFT_BRACE, "{", "", line)) {
                         consume(Token(TokenType::LEFT_BRACE, "{", "", line), std::unique_ptr<ParserException>(new ParserException("Expected '{' after elif block")));
                         auto blk = statement_block();
-                        curr->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.get()));
+                        curr->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.release()));
                         if (!curr->blk)
                             rift::error::report(line, "statement_if", "Expected block", peek(), ParserException("Expected block"));
                     } else {
@@ -322,7 +331,7 @@ namespace rift
                 if (peek() == Token(TokenType::LEFT_BRACE, "{", "", line)) {
                     consume(Token(TokenType::LEFT_BRACE, "{", "", line), std::unique_ptr<ParserException>(new ParserException("Expected '{' after else block")));
                     auto blk = statement_block();
-                    else_stmt->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.get()));
+                    else_stmt->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.release()));
                     if (!else_stmt->blk)
                         rift::error::report(line, "statement_if", "Expected block", peek(), ParserException("Expected block"));
                 } else {
@@ -340,12 +349,14 @@ namespace rift
         {
             std::vector<std::unique_ptr<Decl<Token>>> decls = {};
 
-            curr_env->addChild();
+            curr_env->pushScope();
+            depth++;
             while (!atEnd() && !peek(Token(TokenType::RIGHT_BRACE, "}", "", line))) {
                 std::vector<std::unique_ptr<Decl<Token>>> inner = ret_decl();
                 decls.insert(decls.end(), std::make_move_iterator(inner.begin()), std::make_move_iterator(inner.end()));
             }
-            curr_env->removeChild();
+            depth--;
+            curr_env->popScope();
 
             if (!match({Token(TokenType::RIGHT_BRACE, "}", "", line)})) 
                 rift::error::report(line, "statement_block", "Expected '}' after block", peek(), ParserException("Expected '}' after block"));
@@ -388,7 +399,7 @@ namespace rift
 
             if (match({Token(TokenType::LEFT_BRACE, "{", "", line)})) {
                 auto blk = statement_block();
-                _for->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.get()));
+                _for->blk = std::unique_ptr<Block<void>>(dynamic_cast<Block<void>*>(blk.release()));
                 if (!_for->blk)
                     rift::error::report(line, "statement_for", "Expected block", peek(), ParserException("Expected block"));
             } else {
@@ -437,8 +448,7 @@ namespace rift
                 // was the assignment a function? mut y = test();
                 auto func = dynamic_cast<Call<Token>*>(val);
                 if (func != NULL) {
-                    auto val = curr_env->getEnv<Token>(func->name.lexeme); // value of "test" identifier
-                    std::cout << "TEST[" << idt.lexeme << "," << val << "]" << std::endl;
+                    const auto& val = curr_env->getEnv<Token>(func->name.lexeme); // value of "test" identifier
                     curr_env->setEnv(idt.lexeme, val, false);
                 } else {
                     // more checks and setEnv's...
@@ -468,7 +478,7 @@ namespace rift
         {
             std::unique_ptr<DeclFunc<Token>> _func = std::make_unique<DeclFunc<Token>>();
             _func->func = function();
-            if (_func->func->blk == nullptr) {
+            if (!_func->func->defined()) {
                 consume(Token(TokenType::SEMICOLON, ";", "", line), std::unique_ptr<ParserException>(new ParserException("Expected ';' after function declaration")));
             }
             // return std::make_unique<Decl<Token>>(_func.get());
@@ -541,7 +551,6 @@ namespace rift
             std::unique_ptr<DeclFunc<Token>::Func> ret = std::make_unique<DeclFunc<Token>::Func>();
             auto idt = consume_va({Token(TokenType::IDENTIFIER), Token(TokenType::C_IDENTIFIER)}, std::unique_ptr<ParserException>(new ParserException("Expected function name")));
             ret->name = idt;
-            ret->closure = new Environment(Environment::getInstance(true)); // might be useless since alloc done at runtime too
 
             consume(Token(TokenType::LEFT_PAREN, "(", "", line), std::unique_ptr<ParserException>(new ParserException("Expected '(' after function name")));
             ret->params = params();
@@ -549,7 +558,20 @@ namespace rift
             // give the params (usefull for the call operator)
             curr_env->setEnv<Token>(idt.lexeme, Token(TokenType::FUN, idt.lexeme, ret->params, idt.line), false);
 
-            if(match({Token(TokenType::LEFT_BRACE, "{", "", line)})) {
+            if (lazy && depth == 0 && match({Token(TokenType::LEFT_BRACE, "{", "", line)})) {
+                // pre-parse: skip to the matching brace, the body is parsed on first call
+                ret->src = tokens;
+                ret->begin = curr;
+                unsigned open = 1;
+                while (!atEnd() && open > 0) {
+                    auto tok = advance();
+                    if (tok.type == TokenType::LEFT_BRACE) open++;
+                    else if (tok.type == TokenType::RIGHT_BRACE) open--;
+                }
+                if (open > 0)
+                    rift::error::report(line, "function", "Expected '}' after block", peek(), ParserException("Expected '}' after block"));
+                ret->end = curr;
+            } else if(match({Token(TokenType::LEFT_BRACE, "{", "", line)})) {
                 auto stmt = statement_block();
                 Block<void>* blk = dynamic_cast<Block<void>*>(stmt.release());
                 if (!blk)
@@ -563,7 +585,6 @@ namespace rift
                 consume(Token(TokenType::SEMICOLON, ";", "", line), std::unique_ptr<ParserException>(new ParserException("Expected ';' after function declaration")));
             }
 
-            std::cout << "AMAN OUT\n";
             return ret;
         }
 
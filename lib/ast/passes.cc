@@ -0,0 +1,351 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <iostream>
+#include <ast/passes.hh>
+#include <ast/inline.hh>
+#include <ast/fold.hh>
+#include <ast/prune.hh>
+#include <ast/infer.hh>
+#include <ast/hoist.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        unsigned Verifier::count(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            nodes = 0;
+            broken = "";
+            frame = -1;
+            captures = 0;
+            prgm->accept(*this);
+            return nodes;
+        }
+
+        string Verifier::verify(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            count(prgm);
+            return broken;
+        }
+
+        template <typename Node>
+        void Verifier::visit(const std::unique_ptr<Node>& node, const string& what) const
+        {
+            check(node != nullptr, "missing " + what);
+            if (node != nullptr) node->accept(*this);
+        }
+
+        void Verifier::slot(Storage storage, int depth, int slot, const Token& name) const
+        {
+            if (storage == Storage::Global) return;
+            check(slot >= 0, "'" + name.lexeme + "' (line " + std::to_string(name.line) + ") has no slot");
+            if (storage == Storage::Boxed)
+                check(depth >= 0, "'" + name.lexeme + "' (line " + std::to_string(name.line) + ") has no scope depth");
+            else if (storage == Storage::Upvalue)
+                check(slot < captures, "'" + name.lexeme + "' (line " + std::to_string(name.line) + ") is not captured");
+            else if (frame >= 0)
+                check(slot < frame, "'" + name.lexeme + "' (line " + std::to_string(name.line) + ") is outside its frame");
+        }
+
+        void Verifier::function(const DeclFunc<Token>::Func& func) const
+        {
+            // lazy bodies are checked once parsed & resolved
+            if (func.blk == nullptr) return;
+            check(func.storage.size() == func.params.size(), "'" + func.name.lexeme + "' has unresolved parameters");
+
+            auto enclosing = frame;
+            auto captured = captures;
+            frame = func.frame;
+            captures = func.captures.size();
+            func.blk->accept(*this);
+            frame = enclosing;
+            captures = captured;
+        }
+
+        void Verifier::check(bool ok, const string& what) const
+        {
+            if (!ok && broken.empty()) broken = what;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Verifier::visit_assign(const Assign<Token>& expr) const
+        {
+            nodes++;
+            slot(expr.storage, expr.depth, expr.slot, expr.name);
+            visit(expr.value, "assigned value");
+            return Token();
+        }
+
+        Token Verifier::visit_binary(const Binary<Token>& expr) const
+        {
+            nodes++;
+            visit(expr.left, "left operand of '" + expr.op.lexeme + "'");
+            visit(expr.right, "right operand of '" + expr.op.lexeme + "'");
+            return Token();
+        }
+
+        Token Verifier::visit_grouping(const Grouping<Token>& expr) const
+        {
+            nodes++;
+            visit(expr.expr, "grouped expression");
+            return Token();
+        }
+
+        Token Verifier::visit_literal(const Literal<Token>& expr) const
+        {
+            nodes++;
+            return Token();
+        }
+
+        Token Verifier::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            nodes++;
+            slot(expr.storage, expr.depth, expr.slot, expr.value);
+            return Token();
+        }
+
+        Token Verifier::visit_unary(const Unary<Token>& expr) const
+        {
+            nodes++;
+            visit(expr.expr, "operand of '" + expr.op.lexeme + "'");
+            return Token();
+        }
+
+        Token Verifier::visit_ternary(const Ternary<Token>& expr) const
+        {
+            nodes++;
+            visit(expr.condition, "ternary condition");
+            visit(expr.left, "ternary branch");
+            visit(expr.right, "ternary branch");
+            return Token();
+        }
+
+        Token Verifier::visit_call(const Call<Token>& expr) const
+        {
+            nodes++;
+            slot(expr.storage, expr.depth, expr.slot, expr.name);
+            for (const auto& arg : expr.args)
+                visit(arg, "argument of '" + expr.name.lexeme + "'");
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Verifier::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            nodes++;
+            visit(stmt.expr, "expression statement");
+        }
+
+        void Verifier::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            nodes++;
+            visit(stmt.expr, "printed expression");
+        }
+
+        void Verifier::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            nodes++;
+            auto arm = [this](const StmtIf<void>::Stmt* arm, bool conditional) {
+                if (conditional) visit(arm->expr, "if condition");
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            check(stmt.if_stmt != nullptr, "missing if arm");
+            if (stmt.if_stmt != nullptr) arm(stmt.if_stmt, true);
+            for (const auto& elif : stmt.elif_stmts) {
+                check(elif != nullptr, "missing elif arm");
+                if (elif != nullptr) arm(elif, true);
+            }
+            if (stmt.else_stmt != nullptr) arm(stmt.else_stmt, false);
+        }
+
+        void Verifier::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            nodes++;
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
+        }
+
+        void Verifier::visit_block_stmt(const Block<void>& block) const
+        {
+            nodes++;
+            for (const auto& decl : block.decls)
+                visit(decl, "declaration");
+        }
+
+        void Verifier::visit_for_stmt(const For<void>& stmt) const
+        {
+            nodes++;
+            for (const auto& inv : stmt.invariants) {
+                check(inv->storage == Storage::Frame, "loop invariant is not a frame store");
+                visit(inv, "loop invariant");
+            }
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
+            if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+            if (stmt.blk != nullptr) stmt.blk->accept(*this);
+            if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Verifier::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            nodes++;
+            visit(decl.stmt, "statement");
+            return Token();
+        }
+
+        Token Verifier::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            nodes++;
+            slot(decl.storage, 0, decl.slot, decl.identifier);
+            if (decl.expr != nullptr) decl.expr->accept(*this);
+            return Token();
+        }
+
+        Token Verifier::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            nodes++;
+            check(decl.func != nullptr, "missing function");
+            if (decl.func == nullptr) return Token();
+            slot(decl.storage, 0, decl.slot, decl.func->name);
+            function(*decl.func);
+            return Token();
+        }
+
+        Token Verifier::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            nodes++;
+            for (const auto& method : decl.Methods)
+                function(method.second);
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Verifier::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls)
+                visit(decl, "declaration");
+            return Tokens();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PASS MANAGER
+        ////////////////////////////////////////////////////////////////////////
+
+        PassManager PassManager::pipeline(unsigned level, bool interactive, unsigned inlineSize, bool profile, unsigned ctfeSteps)
+        {
+            PassManager manager(profile);
+
+            // a prompt may rebind any function later on
+            if (level >= 2 && !interactive && inlineSize > 0) {
+                manager.add("inline", [inlineSize](const std::unique_ptr<Program<Tokens>>& prgm) {
+                    Inline pass(inlineSize);
+                    pass.run(prgm);
+                    return std::to_string(pass.inlined()) + " calls inlined";
+                });
+            }
+            if (level >= 1) {
+                // a prompt may rebind the functions called too
+                unsigned steps = level >= 2 && !interactive ? ctfeSteps : 0;
+                manager.add("fold", [steps](const std::unique_ptr<Program<Tokens>>& prgm) {
+                    Fold pass(steps);
+                    pass.run(prgm);
+                    return std::to_string(pass.eliminated()) + " nodes eliminated, " + std::to_string(pass.propagated()) + " constants propagated, " +
+                           std::to_string(pass.evaluated()) + " calls evaluated";
+                });
+                manager.add("prune", [interactive](const std::unique_ptr<Program<Tokens>>& prgm) {
+                    Prune pass;
+                    pass.run(prgm, !interactive);
+                    return std::to_string(pass.statements()) + " statements, " + std::to_string(pass.functions()) + " functions removed";
+                });
+            }
+            if (level >= 2) {
+                manager.add("infer", [](const std::unique_ptr<Program<Tokens>>& prgm) {
+                    Infer pass;
+                    pass.run(prgm);
+                    return std::to_string(pass.specialized()) + " operations specialized";
+                });
+                // needs the types infer found
+                manager.add("hoist", [](const std::unique_ptr<Program<Tokens>>& prgm) {
+                    Hoist pass;
+                    pass.run(prgm);
+                    return std::to_string(pass.hoisted()) + " loop invariants hoisted";
+                });
+            }
+            return manager;
+        }
+
+        void PassManager::add(const string& name, Run run)
+        {
+            sequence.push_back({name, std::move(run)});
+        }
+
+        std::vector<string> PassManager::passes() const
+        {
+            std::vector<string> names = {};
+            for (const auto& pass : sequence)
+                names.push_back(pass.first);
+            return names;
+        }
+
+        void PassManager::run(const std::unique_ptr<Program<Tokens>>& prgm)
+        {
+            if (prgm == nullptr) return;
+            verify(prgm, "resolve");
+
+            Verifier counter;
+            unsigned nodes = profile ? counter.count(prgm) : 0;
+            for (const auto& [name, pass] : sequence) {
+                Stats stats = {name, "", 0, nodes, nodes};
+
+                auto start = std::chrono::steady_clock::now();
+                stats.report = pass(prgm);
+                stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                verify(prgm, name);
+                if (profile) nodes = stats.after = counter.count(prgm);
+                ran.push_back(stats);
+            }
+        }
+
+        void PassManager::verify(const std::unique_ptr<Program<Tokens>>& prgm, const string& after)
+        {
+#ifndef NDEBUG
+            auto broken = Verifier().verify(prgm);
+            if (!broken.empty()) {
+                std::cerr << "🛑 Internal Error: malformed tree after " << after << ": " << broken << std::endl;
+                std::abort();
+            }
+#endif
+        }
+    }
+}
@@ -0,0 +1,341 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/prune.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        /// @brief the expression is a literal (folded), so its truthiness is known
+        static bool known(const std::unique_ptr<Expr<Token>>& expr)
+        {
+            return dynamic_cast<const Literal<Token>*>(expr.get()) != nullptr;
+        }
+
+        static bool holds(const std::unique_ptr<Expr<Token>>& expr)
+        {
+            return truthy(dynamic_cast<const Literal<Token>*>(expr.get())->value);
+        }
+
+        /// @brief stands in for a body the evaluator still expects
+        static std::unique_ptr<Block<void>> empty()
+        {
+            return std::make_unique<Block<void>>(Block<void>::vec_prog{});
+        }
+
+        void Prune::run(const std::unique_ptr<Program<Tokens>>& prgm, bool functions) const
+        {
+            prune(prgm->decls);
+            if (!functions) return;
+
+            // the entry program is everything but the top level functions
+            std::unordered_map<string, const DeclFunc<Token>*> decls = {};
+            for (const auto& decl : prgm->decls) {
+                auto func = dynamic_cast<const DeclFunc<Token>*>(decl.get());
+                if (func != nullptr && func->func != nullptr) decls[func->func->name.lexeme] = func;
+                else if (decl != nullptr) decl->accept(*this);
+            }
+
+            // functions reachable from it (found grows while scanning)
+            for (size_t i = 0; i < found.size(); i++) {
+                auto it = decls.find(found[i]);
+                if (it != decls.end()) scan(*it->second->func);
+            }
+
+            auto& all = prgm->decls;
+            auto dead = std::remove_if(all.begin(), all.end(), [this](const std::unique_ptr<Decl<Token>>& decl) {
+                auto func = dynamic_cast<const DeclFunc<Token>*>(decl.get());
+                return func != nullptr && func->func != nullptr && !refs.contains(func->func->name.lexeme);
+            });
+            funcs += std::distance(dead, all.end());
+            all.erase(dead, all.end());
+        }
+
+        void Prune::prune(std::vector<std::unique_ptr<Decl<Token>>>& decls) const
+        {
+            std::vector<std::unique_ptr<Decl<Token>>> kept = {};
+            bool reachable = true;
+
+            for (auto& decl : decls) {
+                if (!reachable) {
+                    stmts++;
+                    continue;
+                }
+
+                if (auto stmt = dynamic_cast<DeclStmt<Token>*>(decl.get())) {
+                    bool ret = dynamic_cast<const StmtReturn<void>*>(stmt->stmt.get()) != nullptr;
+                    stmt->stmt = simplify(std::move(stmt->stmt));
+                    // the arms that went are already counted
+                    if (stmt->stmt == nullptr) continue;
+                    reachable = !ret;
+                } else if (auto func = dynamic_cast<DeclFunc<Token>*>(decl.get())) {
+                    if (func->func != nullptr && func->func->blk != nullptr)
+                        prune(func->func->blk->decls);
+                }
+                kept.push_back(std::move(decl));
+            }
+            decls = std::move(kept);
+        }
+
+        std::unique_ptr<Stmt<void>> Prune::simplify(std::unique_ptr<Stmt<void>> stmt) const
+        {
+            if (auto blk = dynamic_cast<Block<void>*>(stmt.get())) {
+                prune(blk->decls);
+            } else if (auto ifs = dynamic_cast<StmtIf<void>*>(stmt.get())) {
+                return branch(std::move(stmt), ifs);
+            } else if (auto loop = dynamic_cast<For<void>*>(stmt.get())) {
+                // a loop whose condition never holds only runs its initializer
+                if (known(loop->expr) && !holds(loop->expr)) {
+                    if (loop->blk != nullptr || loop->stmt_o != nullptr) stmts++;
+                    loop->blk = nullptr;
+                    loop->stmt_o = nullptr;
+                    loop->stmt_r = nullptr;
+                } else if (loop->blk != nullptr) {
+                    prune(loop->blk->decls);
+                } else if (loop->stmt_o != nullptr) {
+                    loop->stmt_o = simplify(std::move(loop->stmt_o));
+                    if (loop->stmt_o == nullptr) loop->blk = empty();
+                }
+            }
+            return stmt;
+        }
+
+        std::unique_ptr<Stmt<void>> Prune::branch(std::unique_ptr<Stmt<void>> stmt, StmtIf<void>* ifs) const
+        {
+            std::vector<StmtIf<void>::Stmt*> arms = {ifs->if_stmt};
+            arms.insert(arms.end(), ifs->elif_stmts.begin(), ifs->elif_stmts.end());
+
+            // arms that never run go, the first that always runs becomes the else
+            std::vector<StmtIf<void>::Stmt*> kept = {};
+            StmtIf<void>::Stmt* fallback = ifs->else_stmt;
+            bool always = false;
+            for (auto arm : arms) {
+                if (always || (known(arm->expr) && !holds(arm->expr))) {
+                    delete arm;
+                    stmts++;
+                } else if (known(arm->expr)) {
+                    always = true;
+                    if (fallback != nullptr) {
+                        delete fallback;
+                        stmts++;
+                    }
+                    fallback = arm;
+                    fallback->expr = nullptr;
+                } else {
+                    kept.push_back(arm);
+                }
+            }
+
+            for (auto arm : kept)
+                body(arm);
+            if (fallback != nullptr)
+                body(fallback);
+
+            ifs->if_stmt = nullptr;
+            ifs->elif_stmts.clear();
+            ifs->else_stmt = nullptr;
+
+            // no condition left to test, only the fallback's body remains
+            if (kept.empty()) {
+                if (fallback == nullptr) return nullptr;
+                std::unique_ptr<Stmt<void>> ret = fallback->blk != nullptr ? std::move(fallback->blk) : std::move(fallback->stmt);
+                delete fallback;
+                return ret;
+            }
+
+            ifs->if_stmt = kept.front();
+            ifs->elif_stmts.assign(kept.begin() + 1, kept.end());
+            ifs->else_stmt = fallback;
+            return stmt;
+        }
+
+        void Prune::body(StmtIf<void>::Stmt* arm) const
+        {
+            if (arm->blk != nullptr) {
+                prune(arm->blk->decls);
+            } else {
+                arm->stmt = simplify(std::move(arm->stmt));
+                if (arm->stmt == nullptr) arm->blk = empty();
+            }
+        }
+
+        void Prune::ref(const string& name) const
+        {
+            if (refs.insert(name).second)
+                found.push_back(name);
+        }
+
+        void Prune::scan(const DeclFunc<Token>::Func& func) const
+        {
+            if (func.blk != nullptr) {
+                func.blk->accept(*this);
+            } else if (func.src != nullptr) {
+                // not parsed yet, any identifier in the body may name a function
+                for (unsigned i = func.begin; i < func.end; i++)
+                    if (func.src->at(i).type == TokenType::IDENTIFIER)
+                        ref(func.src->at(i).lexeme);
+            }
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Prune::visit_assign(const Assign<Token>& expr) const
+        {
+            expr.value->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_binary(const Binary<Token>& expr) const
+        {
+            expr.left->accept(*this);
+            expr.right->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_grouping(const Grouping<Token>& expr) const
+        {
+            expr.expr->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_literal(const Literal<Token>& expr) const
+        {
+            return Token();
+        }
+
+        Token Prune::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            if (expr.storage == Storage::Global) ref(expr.value.lexeme);
+            return Token();
+        }
+
+        Token Prune::visit_unary(const Unary<Token>& expr) const
+        {
+            expr.expr->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_ternary(const Ternary<Token>& expr) const
+        {
+            expr.condition->accept(*this);
+            expr.left->accept(*this);
+            expr.right->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_call(const Call<Token>& expr) const
+        {
+            if (expr.storage == Storage::Global) ref(expr.name.lexeme);
+            for (const auto& arg : expr.args)
+                arg->accept(*this);
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void Prune::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
+        }
+
+        void Prune::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            stmt.expr->accept(*this);
+        }
+
+        void Prune::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            auto arm = [this](const StmtIf<void>::Stmt* arm) {
+                if (arm == nullptr) return;
+                if (arm->expr != nullptr) arm->expr->accept(*this);
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            arm(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
+        }
+
+        void Prune::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
+        }
+
+        void Prune::visit_block_stmt(const Block<void>& block) const
+        {
+            for (const auto& decl : block.decls)
+                if (decl != nullptr) decl->accept(*this);
+        }
+
+        void Prune::visit_for_stmt(const For<void>& stmt) const
+        {
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
+            if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+            if (stmt.blk != nullptr) stmt.blk->accept(*this);
+            if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token Prune::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            if (decl.expr != nullptr) decl.expr->accept(*this);
+            return Token();
+        }
+
+        Token Prune::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            // nested functions are part of the enclosing body
+            if (decl.func != nullptr) scan(*decl.func);
+            return Token();
+        }
+
+        Token Prune::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            for (const auto& method : decl.Methods)
+                scan(method.second);
+            return Token();
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens Prune::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls)
+                if (decl != nullptr) decl->accept(*this);
+            return Tokens();
+        }
+    }
+}
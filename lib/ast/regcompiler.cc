@@ -0,0 +1,549 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#include <ast/regvm.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @brief temporaries are numbered from here until relocate moves them behind the frame
+        static constexpr int TEMP = 0x8000;
+
+        /// @brief which of an instruction's operands are registers (bits: a, b, c)
+        static unsigned registers(RegOp op)
+        {
+            switch (op) {
+                case RegOp::Move: case RegOp::Negate: case RegOp::Not:
+                case RegOp::AddK: case RegOp::SubK: case RegOp::MulK: case RegOp::DivK:
+                case RegOp::LessK: case RegOp::LessEqualK: case RegOp::GreaterK: case RegOp::GreaterEqualK:
+                case RegOp::EqualK: case RegOp::NotEqualK:
+                    return 0b011;
+                case RegOp::Add: case RegOp::Sub: case RegOp::Mul: case RegOp::Div:
+                case RegOp::Less: case RegOp::LessEqual: case RegOp::Greater: case RegOp::GreaterEqual:
+                case RegOp::Equal: case RegOp::NotEqual:
+                    return 0b111;
+                case RegOp::JumpIfFalse: case RegOp::JumpIfTrue: case RegOp::JumpIfNotNil:
+                    return 0b010;
+                case RegOp::Call:
+                    return 0b101;
+                case RegOp::Jump: case RegOp::PushScope: case RegOp::PopScope:
+                case RegOp::ReturnNil: case RegOp::Halt:
+                    return 0;
+                default:
+                    return 0b001;
+            }
+        }
+
+        /// @brief the register form of a binary operator, with a constant right operand or not
+        static bool arithmetic(TokenType type, bool constant, RegOp& op)
+        {
+            switch (type) {
+                case TokenType::PLUS: op = constant ? RegOp::AddK : RegOp::Add; return true;
+                case TokenType::MINUS: op = constant ? RegOp::SubK : RegOp::Sub; return true;
+                case TokenType::STAR: op = constant ? RegOp::MulK : RegOp::Mul; return true;
+                case TokenType::SLASH: op = constant ? RegOp::DivK : RegOp::Div; return true;
+                case TokenType::LESS: op = constant ? RegOp::LessK : RegOp::Less; return true;
+                case TokenType::LESS_EQUAL: op = constant ? RegOp::LessEqualK : RegOp::LessEqual; return true;
+                case TokenType::GREATER: op = constant ? RegOp::GreaterK : RegOp::Greater; return true;
+                case TokenType::GREATER_EQUAL: op = constant ? RegOp::GreaterEqualK : RegOp::GreaterEqual; return true;
+                case TokenType::EQUAL_EQUAL: op = constant ? RegOp::EqualK : RegOp::Equal; return true;
+                case TokenType::BANG_EQUAL: op = constant ? RegOp::NotEqualK : RegOp::NotEqual; return true;
+                default: return false;
+            }
+        }
+
+        /// @brief expressions writing their register only once their operands are read,
+        ///        so they may target the variable they are assigned to
+        static bool direct(const Expr<Token>& expr)
+        {
+            const auto& type = typeid(expr);
+            if (type == typeid(Binary<Token>)) {
+                auto op = static_cast<const Binary<Token>&>(expr).op.type;
+                return op != TokenType::NULLISH_COAL && op != TokenType::LOG_AND && op != TokenType::LOG_OR;
+            }
+            return type == typeid(Unary<Token>) || type == typeid(Literal<Token>) ||
+                   type == typeid(VarExpr<Token>) || type == typeid(Call<Token>);
+        }
+
+        #pragma mark - Helpers
+
+        std::shared_ptr<Proto> RegisterCompiler::compile(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            auto script = std::make_shared<Proto>();
+            proto = script.get();
+            supported = true;
+            top = temps = 0;
+            prgm->accept(*this);
+            emit(RegOp::Halt);
+            relocate(*script);
+            proto = nullptr;
+            return supported ? script : nullptr;
+        }
+
+        bool RegisterCompiler::compile(const DeclFunc<Token>::Func& func, Proto& target) const
+        {
+            auto outer = std::exchange(proto, &target);
+            auto outer_top = std::exchange(top, 0), outer_temps = std::exchange(temps, 0);
+            auto outer_dst = dst;
+            auto toplevel = std::exchange(result, false);
+
+            target.name = func.name;
+            target.frame = func.frame;
+            target.boxes = func.boxes;
+            target.params = func.storage;
+            target.captures = func.captures;
+
+            if (func.blk != nullptr) {
+                target.instrs.clear();
+                target.lines.clear();
+                func.blk->accept(*this);
+                emit(RegOp::ReturnNil);
+                relocate(target);
+                target.lazy = nullptr;
+            }
+
+            proto = outer;
+            top = outer_top;
+            temps = outer_temps;
+            dst = outer_dst;
+            result = toplevel;
+            return supported;
+        }
+
+        size_t RegisterCompiler::emit(RegOp op, size_t a, size_t b, size_t c, int line) const
+        {
+            // operands are 16 bits, anything larger is left to Eval
+            if (a > UINT16_MAX || b > UINT16_MAX || c > UINT16_MAX) supported = false;
+            proto->instrs.push_back({op, static_cast<uint16_t>(a), static_cast<uint16_t>(b), static_cast<uint16_t>(c)});
+            proto->lines.push_back(line);
+            return proto->instrs.size() - 1;
+        }
+
+        void RegisterCompiler::patch(size_t at) const
+        {
+            if (proto->instrs.size() > UINT16_MAX) supported = false;
+            proto->instrs[at].a = static_cast<uint16_t>(proto->instrs.size());
+        }
+
+        size_t RegisterCompiler::constant(Value value) const
+        {
+            proto->constants.push_back(std::move(value));
+            return proto->constants.size() - 1;
+        }
+
+        int RegisterCompiler::temp() const
+        {
+            temps = std::max(temps, top + 1);
+            return TEMP + top++;
+        }
+
+        void RegisterCompiler::relocate(Proto& target) const
+        {
+            if (target.frame >= TEMP || target.frame + temps > UINT16_MAX) {
+                supported = false;
+                return;
+            }
+            target.registers = target.frame + temps;
+            for (auto& instr : target.instrs) {
+                unsigned regs = registers(instr.op);
+                if ((regs & 0b001) && instr.a >= TEMP) instr.a = instr.a - TEMP + target.frame;
+                if ((regs & 0b010) && instr.b >= TEMP) instr.b = instr.b - TEMP + target.frame;
+                if ((regs & 0b100) && instr.c >= TEMP) instr.c = instr.c - TEMP + target.frame;
+            }
+        }
+
+        void RegisterCompiler::into(const Expr<Token>& expr, int reg) const
+        {
+            auto outer = std::exchange(dst, reg);
+            expr.accept(*this);
+            dst = outer;
+        }
+
+        int RegisterCompiler::operand(const Expr<Token>& expr) const
+        {
+            // frame locals are read in place
+            if (typeid(expr) == typeid(VarExpr<Token>)) {
+                const auto& var = static_cast<const VarExpr<Token>&>(expr);
+                if (var.storage == Storage::Frame) {
+                    proto->frame = std::max(proto->frame, var.slot + 1);
+                    return var.slot;
+                }
+            }
+            int reg = temp();
+            into(expr, reg);
+            return reg;
+        }
+
+        void RegisterCompiler::store(Storage storage, int depth, int slot, const str_t& name, int src) const
+        {
+            switch (storage) {
+                case Storage::Frame:
+                    proto->frame = std::max(proto->frame, slot + 1);
+                    if (slot != src) emit(RegOp::Move, slot, src);
+                    break;
+                case Storage::Boxed: emit(RegOp::SetBoxed, src, depth, slot); break;
+                case Storage::Upvalue: emit(RegOp::SetUpvalue, src, slot); break;
+                case Storage::Global: emit(RegOp::SetGlobal, src, Globals::getInstance().index(name)); break;
+            }
+        }
+
+        void RegisterCompiler::assign(const Assign<Token>& expr) const
+        {
+            if (expr.storage == Storage::Frame && direct(*expr.value)) {
+                proto->frame = std::max(proto->frame, expr.slot + 1);
+                into(*expr.value, expr.slot);
+                return;
+            }
+            int saved = top;
+            store(expr.storage, expr.depth, expr.slot, expr.name.lexeme, operand(*expr.value));
+            top = saved;
+        }
+
+        void RegisterCompiler::branch(const Stmt<void>* stmt, const Block<void>* blk) const
+        {
+            if (blk != nullptr) statement(*blk);
+            else if (stmt != nullptr) statement(*stmt);
+        }
+
+        void RegisterCompiler::statement(const Stmt<void>& stmt) const
+        {
+            int saved = top;
+            stmt.accept(*this);
+            top = saved;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token RegisterCompiler::visit_assign(const Assign<Token>& expr) const
+        {
+            // the assignment's value is the variable's
+            int out = dst;
+            if (expr.storage == Storage::Frame) {
+                assign(expr);
+                if (out != expr.slot) emit(RegOp::Move, out, expr.slot);
+            } else {
+                into(*expr.value, out);
+                store(expr.storage, expr.depth, expr.slot, expr.name.lexeme, out);
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_binary(const Binary<Token>& expr) const
+        {
+            int out = dst;
+            // the short circuiting ones only evaluate what they need (as Eval does)
+            switch (expr.op.type) {
+                case TokenType::NULLISH_COAL: {
+                    into(*expr.left, out);
+                    auto done = emit(RegOp::JumpIfNotNil, 0, out);
+                    into(*expr.right, out);
+                    patch(done);
+                    return {};
+                }
+                case TokenType::LOG_AND:
+                case TokenType::LOG_OR: {
+                    auto jump = expr.op.type == TokenType::LOG_AND ? RegOp::JumpIfFalse : RegOp::JumpIfTrue;
+                    auto left = emit(jump, 0, operand(*expr.left));
+                    auto right = emit(jump, 0, operand(*expr.right));
+                    emit(RegOp::LoadBool, out, expr.op.type == TokenType::LOG_AND);
+                    auto done = emit(RegOp::Jump);
+                    patch(left);
+                    patch(right);
+                    emit(RegOp::LoadBool, out, expr.op.type != TokenType::LOG_AND);
+                    patch(done);
+                    return {};
+                }
+                default:
+                    break;
+            }
+
+            const auto& r_type = typeid(*expr.right);
+            bool constant = r_type == typeid(Literal<Token>);
+            RegOp op;
+            if (!arithmetic(expr.op.type, constant, op)) {
+                supported = false;
+                return {};
+            }
+
+            // the left operand is read in place only if evaluating the right one cannot write it
+            bool inert = constant || r_type == typeid(VarExpr<Token>);
+            int left = inert ? operand(*expr.left) : temp();
+            if (!inert) into(*expr.left, left);
+
+            if (constant) {
+                auto value = Value::from(Eval::literal(static_cast<const Literal<Token>&>(*expr.right)));
+                emit(op, out, left, this->constant(std::move(value)), expr.op.line);
+            } else {
+                emit(op, out, left, operand(*expr.right), expr.op.line);
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_grouping(const Grouping<Token>& expr) const
+        {
+            return expr.expr->accept(*this);
+        }
+
+        Token RegisterCompiler::visit_literal(const Literal<Token>& expr) const
+        {
+            auto value = Value::from(Eval::literal(expr));
+            switch (value.type) {
+                case Value::Type::Nil: emit(RegOp::LoadNil, dst); break;
+                case Value::Type::Bool: emit(RegOp::LoadBool, dst, value.b); break;
+                default: emit(RegOp::LoadK, dst, constant(std::move(value))); break;
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            switch (expr.storage) {
+                case Storage::Frame:
+                    proto->frame = std::max(proto->frame, expr.slot + 1);
+                    if (dst != expr.slot) emit(RegOp::Move, dst, expr.slot);
+                    break;
+                case Storage::Boxed: emit(RegOp::GetBoxed, dst, expr.depth, expr.slot); break;
+                case Storage::Upvalue: emit(RegOp::GetUpvalue, dst, expr.slot); break;
+                case Storage::Global: emit(RegOp::GetGlobal, dst, Globals::getInstance().index(expr.value.lexeme)); break;
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_unary(const Unary<Token>& expr) const
+        {
+            int out = dst;
+            if (expr.op.type == TokenType::MINUS) emit(RegOp::Negate, out, operand(*expr.expr), 0, expr.op.line);
+            else if (expr.op.type == TokenType::BANG) emit(RegOp::Not, out, operand(*expr.expr), 0, expr.op.line);
+            else supported = false;
+            return {};
+        }
+
+        Token RegisterCompiler::visit_ternary(const Ternary<Token>& expr) const
+        {
+            int out = dst;
+            auto other = emit(RegOp::JumpIfFalse, 0, operand(*expr.condition));
+            into(*expr.left, out);
+            auto done = emit(RegOp::Jump);
+            patch(other);
+            into(*expr.right, out);
+            patch(done);
+            return {};
+        }
+
+        Token RegisterCompiler::visit_call(const Call<Token>& expr) const
+        {
+            int out = dst;
+            Site site;
+            site.name = expr.name;
+            site.storage = expr.storage;
+            site.depth = expr.depth;
+            site.slot = expr.storage == Storage::Global ? Globals::getInstance().index(expr.name.lexeme) : expr.slot;
+            if (expr.storage == Storage::Frame)
+                proto->frame = std::max(proto->frame, expr.slot + 1);
+
+            // arguments go to consecutive registers, the callee's params take them in order
+            int first = top + TEMP;
+            for (size_t i = 0; i < expr.args.size(); i++) temp();
+            int reg = first;
+            for (const auto& arg : expr.args)
+                into(*arg, reg++);
+            site.args = expr.args.size();
+            proto->sites.push_back(std::move(site));
+            emit(RegOp::Call, out, proto->sites.size() - 1, first);
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void RegisterCompiler::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            if (typeid(*stmt.expr) == typeid(Assign<Token>))
+                assign(static_cast<const Assign<Token>&>(*stmt.expr));
+            else
+                into(*stmt.expr, temp());
+        }
+
+        void RegisterCompiler::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            emit(RegOp::Print, operand(*stmt.expr));
+        }
+
+        void RegisterCompiler::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            std::vector<size_t> done = {};
+
+            // if, then each elif, the first one holding runs
+            auto next = emit(RegOp::JumpIfFalse, 0, operand(*stmt.if_stmt->expr));
+            branch(stmt.if_stmt->stmt.get(), stmt.if_stmt->blk.get());
+            for (const auto& elif_stmt : stmt.elif_stmts) {
+                done.push_back(emit(RegOp::Jump));
+                patch(next);
+                next = emit(RegOp::JumpIfFalse, 0, operand(*elif_stmt->expr));
+                branch(elif_stmt->stmt.get(), elif_stmt->blk.get());
+            }
+
+            if (stmt.else_stmt != nullptr) {
+                done.push_back(emit(RegOp::Jump));
+                patch(next);
+                branch(stmt.else_stmt->stmt.get(), stmt.else_stmt->blk.get());
+            } else {
+                patch(next);
+            }
+            for (auto at : done)
+                patch(at);
+        }
+
+        void RegisterCompiler::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            if (stmt.expr == nullptr)
+                emit(RegOp::ReturnNil);
+            else
+                emit(RegOp::Return, operand(*stmt.expr));
+        }
+
+        void RegisterCompiler::visit_block_stmt(const Block<void>& block) const
+        {
+            proto->frame = std::max(proto->frame, block.frame);
+            if (block.scoped())
+                emit(RegOp::PushScope, block.slots);
+            for (const auto& decl : block.decls) {
+                int saved = top;
+                decl->accept(*this);
+                top = saved;
+            }
+            if (block.scoped())
+                emit(RegOp::PopScope);
+        }
+
+        void RegisterCompiler::visit_for_stmt(const For<void>& decl) const
+        {
+            int saved = top;
+            if (decl.decl != nullptr) decl.decl->accept(*this);
+            else if (decl.stmt_l != nullptr) decl.stmt_l->accept(*this);
+            top = saved;
+
+            decl.preheader([this](int frame) { proto->frame = std::max(proto->frame, frame); },
+                           [this, saved](const Assign<Token>& inv) { assign(inv); top = saved; });
+
+            auto loop = proto->instrs.size();
+            auto exit = emit(RegOp::JumpIfFalse, 0, operand(*decl.expr));
+            top = saved;
+            if (decl.stmt_o != nullptr) statement(*decl.stmt_o);
+            else if (decl.blk != nullptr) statement(*decl.blk);
+            if (decl.stmt_r != nullptr) statement(*decl.stmt_r);
+            emit(RegOp::Jump, loop);
+            patch(exit);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token RegisterCompiler::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            bool toplevel = std::exchange(result, false);
+            // a top level expression results in its value (as in Eval)
+            if (toplevel && typeid(*decl.stmt) == typeid(StmtExpr<void>)) {
+                emit(RegOp::Result, operand(*static_cast<const StmtExpr<void>&>(*decl.stmt).expr));
+                return {};
+            }
+            statement(*decl.stmt);
+            if (toplevel) {
+                int reg = temp();
+                emit(RegOp::LoadNil, reg);
+                emit(RegOp::Result, reg);
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            bool toplevel = std::exchange(result, false);
+            if (decl.expr != nullptr) {
+                if (!toplevel && typeid(*decl.expr) == typeid(Assign<Token>))
+                    assign(static_cast<const Assign<Token>&>(*decl.expr));
+                else if (!toplevel)
+                    into(*decl.expr, temp());
+                else
+                    emit(RegOp::Result, operand(*decl.expr));
+                return {};
+            }
+
+            int reg = decl.storage == Storage::Frame ? decl.slot : temp();
+            emit(RegOp::LoadNil, reg);
+            store(decl.storage, 0, decl.slot, decl.identifier.lexeme, reg);
+            if (toplevel) {
+                reg = temp();
+                emit(RegOp::LoadNil, reg);
+                emit(RegOp::Result, reg);
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            bool toplevel = std::exchange(result, false);
+            const auto& func = *decl.func;
+
+            // a declaration without a body binds nil (as in Eval)
+            int reg = temp();
+            if (func.defined()) {
+                auto target = std::make_shared<Proto>();
+                target->lazy = func.blk == nullptr ? decl.func.get() : nullptr;
+                if (!compile(func, *target)) return {};
+                proto->protos.push_back(std::move(target));
+                emit(RegOp::Closure, reg, proto->protos.size() - 1);
+            } else {
+                emit(RegOp::LoadNil, reg);
+            }
+
+            if (decl.storage == Storage::Global)
+                emit(RegOp::DefineFunc, reg, Globals::getInstance().index(func.name.lexeme), constant(Value::boxed(func.name)));
+            else
+                store(decl.storage, 0, decl.slot, func.name.lexeme, reg);
+
+            if (toplevel) {
+                emit(RegOp::LoadK, reg, constant(Value::boxed(func.name)));
+                emit(RegOp::Result, reg);
+            }
+            return {};
+        }
+
+        Token RegisterCompiler::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            // classes only exist in the tree walker for now
+            supported = false;
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens RegisterCompiler::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls) {
+                result = true;
+                decl->accept(*this);
+                top = 0;
+            }
+            result = false;
+            return {};
+        }
+    }
+}
@@ -0,0 +1,319 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#include <ast/regvm.hh>
+#include <ast/parser.hh>
+#include <ast/resolver.hh>
+#include <error/error.hh>
+#include <iostream>
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(RIFT_SWITCH_DISPATCH)
+    #define RIFT_THREADED_DISPATCH 1
+#endif
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        /// @brief int arithmetic wraps (as the 32 bit ints of the tree walker do)
+        static inline int32_t wrap(int64_t value)
+        {
+            return static_cast<int32_t>(static_cast<uint32_t>(value));
+        }
+
+        /// @brief a binary operator on anything but two ints, as Eval evaluates it
+        static Value generic(TokenType type, const Value& left, const Value& right, int line)
+        {
+            Token op(type, "", "", line);
+            return Value::from(Eval::binary(op, left.to(line), right.to(line)));
+        }
+
+        bool RegisterMachine::native(const Proto& proto, size_t pc)
+        {
+            if (proto.native == nullptr) {
+                if (proto.cold || ++proto.heat < Jit::HOT) return false;
+                proto.native = jit.compile(proto);
+                if (proto.native == nullptr) {
+                    proto.cold = true;
+                    return false;
+                }
+            }
+            return proto.native->entries[pc];
+        }
+
+        void RegisterMachine::deopt(const Proto& proto)
+        {
+            if (++proto.native->deopts > Jit::DEOPTS) {
+                proto.native = nullptr;
+                proto.cold = true;
+            }
+        }
+
+        std::vector<string> RegisterMachine::evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive)
+        {
+            auto script = RegisterCompiler().compile(prgm);
+            if (script == nullptr)
+                return Eval().evaluate(prgm, interactive);
+            return run(script, interactive);
+        }
+
+        #pragma mark - Dispatch
+
+        std::vector<string> RegisterMachine::run(const std::shared_ptr<Proto>& script, bool interactive)
+        {
+            std::vector<Value> results = {};
+            auto& globals = Globals::getInstance().values;
+
+            const Proto* proto = script.get();
+            const Instr* code = proto->instrs.data();
+            const Instr* ip = code;
+            const Instr* in = nullptr;
+            size_t base = 0;
+            std::shared_ptr<Scope> scope = nullptr;
+            std::shared_ptr<Closure> closure = nullptr;
+
+            frames.clear();
+            registers.assign(proto->registers, Value());
+            Value* regs = registers.data();
+
+            #define R(x) regs[x]
+            #define K(x) proto->constants[x]
+            #define LINE() proto->lines[in - code]
+
+            #ifdef RIFT_THREADED_DISPATCH
+                // one indirect jump per handler, in the order of RegOp
+                static const void* labels[] = {
+                    &&op_Move, &&op_LoadK, &&op_LoadNil, &&op_LoadBool,
+                    &&op_GetBoxed, &&op_SetBoxed, &&op_GetUpvalue, &&op_SetUpvalue,
+                    &&op_GetGlobal, &&op_SetGlobal, &&op_DefineFunc,
+                    &&op_Add, &&op_Sub, &&op_Mul, &&op_Div,
+                    &&op_Less, &&op_LessEqual, &&op_Greater, &&op_GreaterEqual,
+                    &&op_Equal, &&op_NotEqual,
+                    &&op_AddK, &&op_SubK, &&op_MulK, &&op_DivK,
+                    &&op_LessK, &&op_LessEqualK, &&op_GreaterK, &&op_GreaterEqualK,
+                    &&op_EqualK, &&op_NotEqualK,
+                    &&op_Negate, &&op_Not,
+                    &&op_Jump, &&op_JumpIfFalse, &&op_JumpIfTrue, &&op_JumpIfNotNil,
+                    &&op_PushScope, &&op_PopScope, &&op_Closure, &&op_Call, &&op_Return, &&op_ReturnNil,
+                    &&op_Print, &&op_Result, &&op_Halt
+                };
+                static_assert(sizeof(labels) / sizeof(*labels) == static_cast<size_t>(RegOp::Halt) + 1, "a handler per opcode");
+                #define CASE(name) op_##name:
+                #define NEXT() goto *labels[static_cast<size_t>((in = ip++)->op)]
+            #else
+                #define CASE(name) case RegOp::name:
+                #define NEXT() break
+            #endif
+
+            // the ints take the inline path, every other pair of values the evaluator's
+            #define BINARY(name, kind, right, fast) \
+                CASE(name) { \
+                    const Value& l = R(in->b); const Value& r = right; \
+                    if (l.type == Value::Type::Int && r.type == Value::Type::Int) R(in->a) = fast; \
+                    else R(in->a) = generic(kind, l, r, LINE()); \
+                    NEXT(); \
+                }
+            #define ARITHMETIC(name, kind, fast) \
+                BINARY(name, kind, R(in->c), fast) \
+                BINARY(name##K, kind, K(in->c), fast)
+
+            // hot code runs native until it meets what it doesn't translate, the
+            // interpreter goes on from there
+            #define ENTER(pc) \
+                if (jitting && native(*proto, pc)) { \
+                    uint32_t resume = proto->native->run(regs, pc); \
+                    if (resume & Native::DEOPT) deopt(*proto); \
+                    ip = code + (resume & ~Native::DEOPT); \
+                }
+
+            try {
+                #ifdef RIFT_THREADED_DISPATCH
+                    NEXT();
+                #else
+                    for (;;) {
+                        switch ((in = ip++)->op) {
+                #endif
+
+                CASE(Move) R(in->a) = R(in->b); NEXT();
+                CASE(LoadK) R(in->a) = K(in->b); NEXT();
+                CASE(LoadNil) R(in->a) = Value(); NEXT();
+                CASE(LoadBool) R(in->a) = Value::boolean(in->b != 0); NEXT();
+
+                CASE(GetBoxed) R(in->a) = scope->at(in->b, in->c); NEXT();
+                CASE(SetBoxed) scope->at(in->b, in->c) = R(in->a); NEXT();
+                CASE(GetUpvalue) R(in->a) = closure->cells[in->b].get(); NEXT();
+                CASE(SetUpvalue) closure->cells[in->b].get() = R(in->a); NEXT();
+                CASE(GetGlobal) R(in->a) = globals[in->b]; NEXT();
+                CASE(SetGlobal) globals[in->b] = R(in->a); NEXT();
+                CASE(DefineFunc) {
+                    auto& global = globals[in->b];
+                    if (!interactive && !global.nil())
+                        rift::error::runTimeError("Function '" + K(in->c).token().lexeme + "' already defined");
+                    global = R(in->a);
+                    NEXT();
+                }
+
+                ARITHMETIC(Add, TokenType::PLUS, Value::integer(wrap(int64_t(l.i) + r.i)))
+                ARITHMETIC(Sub, TokenType::MINUS, Value::integer(wrap(int64_t(l.i) - r.i)))
+                ARITHMETIC(Mul, TokenType::STAR, Value::integer(wrap(int64_t(l.i) * r.i)))
+                ARITHMETIC(Div, TokenType::SLASH, (r.i == 0 ? (rift::error::runTimeError("Division by zero"), Value()) : Value::integer(wrap(int64_t(l.i) / r.i))))
+                ARITHMETIC(Less, TokenType::LESS, Value::boolean(l.i < r.i))
+                ARITHMETIC(LessEqual, TokenType::LESS_EQUAL, Value::boolean(l.i <= r.i))
+                ARITHMETIC(Greater, TokenType::GREATER, Value::boolean(l.i > r.i))
+                ARITHMETIC(GreaterEqual, TokenType::GREATER_EQUAL, Value::boolean(l.i >= r.i))
+                ARITHMETIC(Equal, TokenType::EQUAL_EQUAL, Value::boolean(l.i == r.i))
+                ARITHMETIC(NotEqual, TokenType::BANG_EQUAL, Value::boolean(l.i != r.i))
+                CASE(Negate) {
+                    const Value& val = R(in->b);
+                    if (val.type == Value::Type::Int) R(in->a) = Value::integer(wrap(-int64_t(val.i)));
+                    else R(in->a) = Value::from(Eval::unary(Token(TokenType::MINUS, "-", "", LINE()), val.to(LINE())));
+                    NEXT();
+                }
+                CASE(Not) R(in->a) = Value::from(Eval::unary(Token(TokenType::BANG, "!", "", LINE()), R(in->b).to(LINE()))); NEXT();
+
+                CASE(Jump) {
+                    ip = code + in->a;
+                    if (ip <= in) ENTER(in->a);
+                    NEXT();
+                }
+                CASE(JumpIfFalse) if (!R(in->b).truthy()) ip = code + in->a; NEXT();
+                CASE(JumpIfTrue) if (R(in->b).truthy()) ip = code + in->a; NEXT();
+                CASE(JumpIfNotNil) if (!R(in->b).nil()) ip = code + in->a; NEXT();
+
+                CASE(PushScope) scope = std::make_shared<Scope>(std::move(scope), in->a); NEXT();
+                CASE(PopScope) scope = scope->enclosing; NEXT();
+                CASE(Closure) {
+                    const auto& target = proto->protos[in->b];
+                    auto fn = std::make_shared<Closure>();
+                    fn->proto = target;
+                    // capture only what the body uses, one shared cell per variable
+                    fn->cells.reserve(target->captures.size());
+                    for (const auto& capture : target->captures) {
+                        if (!capture.local) {
+                            fn->cells.push_back(closure->cells[capture.slot]);
+                            continue;
+                        }
+                        auto env = scope;
+                        for (int depth = capture.depth; depth > 0; depth--)
+                            env = env->enclosing;
+                        fn->cells.push_back({env, capture.slot});
+                    }
+                    R(in->a) = Value::func(std::move(fn));
+                    NEXT();
+                }
+                CASE(Call) {
+                    const Site& site = proto->sites[in->b];
+                    const Value* callee = nullptr;
+                    switch (site.storage) {
+                        case Storage::Global: callee = &globals[site.slot]; break;
+                        case Storage::Frame: callee = &R(site.slot); break;
+                        case Storage::Boxed: callee = &scope->at(site.depth, site.slot); break;
+                        case Storage::Upvalue: callee = &closure->cells[site.slot].get(); break;
+                    }
+                    if (callee->type != Value::Type::Func)
+                        rift::error::runTimeError("Undefined function '" + site.name.lexeme + "'");
+                    auto fn = std::static_pointer_cast<Closure>(callee->ref);
+                    Proto& target = *fn->proto;
+
+                    // lazily parsed functions get their body (its resolution & code) on the first call
+                    if (target.lazy != nullptr) {
+                        auto& func = *target.lazy;
+                        if (Parser::materialize(func))
+                            Resolver().resolve(func);
+                        if (!RegisterCompiler().compile(func, target))
+                            rift::error::runTimeError("Function '" + func.name.lexeme + "' uses what only the tree walker runs");
+                    }
+
+                    // the callee's window starts right after the caller's, captured params go
+                    // to the function's first heap scope
+                    size_t args = base + in->c;
+                    size_t window = base + proto->registers;
+                    registers.resize(window + target.registers);
+                    auto boxes = target.boxes > 0 ? std::make_shared<Scope>(nullptr, target.boxes) : nullptr;
+                    for (size_t i = 0, f = 0, b = 0; i < target.params.size(); i++) {
+                        Value val = i < site.args ? std::move(registers[args + i]) : Value();
+                        if (target.params[i] == Storage::Boxed)
+                            boxes->slots[b++] = std::move(val);
+                        else
+                            registers[window + f++] = std::move(val);
+                    }
+
+                    frames.push_back({proto, ip, base, std::move(scope), std::move(closure)});
+                    proto = &target;
+                    code = ip = target.instrs.data();
+                    base = window;
+                    regs = registers.data() + base;
+                    scope = std::move(boxes);
+                    closure = std::move(fn);
+                    ENTER(0);
+                    NEXT();
+                }
+                CASE(Return)
+                CASE(ReturnNil) {
+                    Value result = in->op == RegOp::Return ? std::move(R(in->a)) : Value();
+                    // a return outside any function ends the script
+                    if (frames.empty()) goto halt;
+
+                    auto& caller = frames.back();
+                    registers.resize(base);
+                    proto = caller.proto;
+                    code = proto->instrs.data();
+                    ip = caller.ip;
+                    base = caller.base;
+                    regs = registers.data() + base;
+                    scope = std::move(caller.scope);
+                    closure = std::move(caller.closure);
+                    frames.pop_back();
+                    // the caller's Call names the register of the result
+                    R(ip[-1].a) = std::move(result);
+                    NEXT();
+                }
+
+                CASE(Print) {
+                    const auto& val = R(in->a);
+                    if (val.type == Value::Type::Int) std::cout << val.i << '\n';
+                    else if (val.type == Value::Type::Bool) std::cout << (val.b ? "true" : "false") << '\n';
+                    else std::cout << Eval::text(val.to(0)) << '\n';
+                    NEXT();
+                }
+                CASE(Result) results.push_back(R(in->a)); NEXT();
+                CASE(Halt) goto halt;
+
+                #ifndef RIFT_THREADED_DISPATCH
+                        }
+                    }
+                #endif
+            } catch (const std::runtime_error& e) {
+                error::runTimeError(e.what());
+            }
+            halt:
+            std::cout << std::flush;
+
+            #undef R
+            #undef K
+            #undef LINE
+            #undef CASE
+            #undef NEXT
+            #undef BINARY
+            #undef ARITHMETIC
+            #undef ENTER
+
+            std::vector<string> res;
+            for (const auto& val : results)
+                res.push_back(Eval::show(val.to(0)));
+            return res;
+        }
+    }
+}
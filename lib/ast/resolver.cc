@@ -24,45 +24,235 @@ namespace rift
 
         namespace Resolve
         {
-            static Eval *eval = new Eval();
-            static vector<unordered_map<string, bool>> scopes = {};
-
-            void beginScope()
+            /// @brief a local declared in a scope
+            struct Local
+            {
+                bool defined;
+                /// @note written by the escape pass, read by the slot pass
+                Storage* storage;
+                int slot;
+                /// @note function nesting level it was declared at
+                int fn;
+                /// @note the function a func declaration binds it to (nullptr otherwise)
+                const DeclFunc<Token>::Func* func;
+            };
+
+            struct Scope
+            {
+                unordered_map<string, Local> locals;
+                /// @note holds captured locals (allocated as a heap scope at runtime)
+                bool boxed;
+                int boxes;
+                /// @note first frame slot of the scope, reused once it ends
+                int base;
+                /// @note function nesting level of the scope
+                int fn;
+            };
+
+            /// @brief frame slots of a function (or the top level)
+            struct Frame
+            {
+                int next;
+                int size;
+            };
+
+            static vector<Scope> scopes = {};
+            static vector<Frame> frames = {{0, 0}};
+            /// @brief functions being resolved, by nesting level (nullptr: top level)
+            static vector<DeclFunc<Token>::Func*> funcs = {nullptr};
+            /// @brief loops of the current function enclosing what is resolved
+            static vector<const For<void>*> loops = {};
+            /// @brief escape pass: only find the locals captured by inner functions
+            static bool escape = false;
+            /// @brief top level functions by name, for the arity check of their calls
+            static unordered_map<string, const DeclFunc<Token>::Func*> globals = {};
+            /// @brief functions whose name is bound to something else somewhere (found by the escape pass)
+            static std::unordered_set<const DeclFunc<Token>::Func*> rebound = {};
+            /// @brief some top level body is not parsed yet, it may rebind any global
+            static bool unparsed = false;
+
+            void beginScope(bool boxed)
             {
-                scopes.push_back(unordered_map<string, bool>());
+                scopes.push_back({unordered_map<string, Local>(), boxed, 0, frames.back().next, (int)frames.size() - 1});
             }
 
-            void endScope()
+            /// @return the number of boxed slots the scope needs
+            int endScope()
             {
+                int boxes = 0;
+                if (escape) {
+                    for (const auto& [name, local] : scopes.back().locals)
+                        if (*local.storage == Storage::Boxed) boxes++;
+                } else {
+                    boxes = scopes.back().boxes;
+                    frames.back().next = scopes.back().base;
+                }
                 scopes.pop_back();
+                return boxes;
             }
 
-            void declare(Token name) 
+            /// @return the frame or box slot of the local (-1 if global)
+            int declare(Token name, Storage* storage) 
             {
-                if (scopes.empty()) return;
-                unordered_map<string, bool>& scope = scopes.back();
-                if (scope.find(name.lexeme) != scope.end()) {
+                if (scopes.empty()) {
+                    *storage = Storage::Global;
+                    return -1;
+                }
+
+                Scope& scope = scopes.back();
+                if (scope.locals.find(name.lexeme) != scope.locals.end()) {
                     error::report(name.line, "at declaration", "Variable with this name already declared in this scope.", name, ResolverException("Variable with this name already declared in this scope."));
                 }
-                scope[name.lexeme] = false;
+
+                int slot = -1;
+                if (escape) {
+                    *storage = Storage::Frame;
+                } else if (*storage == Storage::Boxed) {
+                    slot = scope.boxes++;
+                } else {
+                    slot = frames.back().next++;
+                    frames.back().size = std::max(frames.back().size, frames.back().next);
+                }
+                scope.locals[name.lexeme] = {false, storage, slot, (int)frames.size() - 1, nullptr};
+                return slot;
             }
 
             void define(Token name)
             {
                 if (scopes.empty()) return;
-                unordered_map<string, bool>& scope = scopes.back();
-                scope[name.lexeme] = true;
+                scopes.back().locals[name.lexeme].defined = true;
+            }
+
+            /// @brief upvalue of function fn for the boxed local slot of scopes[index]
+            /// @note functions in between capture it too, to hand it down
+            int capture(int fn, int index, int slot)
+            {
+                DeclFunc<Token>::Func::Capture capture = {true, 0, slot};
+                if (scopes[index].fn == fn - 1) {
+                    // boxed scopes between the one declaring it & the declaration of fn
+                    int site = index;
+                    while (site + 1 < (int)scopes.size() && scopes[site + 1].fn < fn) site++;
+                    for (int i = site; i > index; i--)
+                        if (scopes[i].boxed) capture.depth++;
+                } else {
+                    capture = {false, -1, Resolve::capture(fn - 1, index, slot)};
+                }
+
+                auto& captures = funcs[fn]->captures;
+                auto it = std::find(captures.begin(), captures.end(), capture);
+                if (it != captures.end()) return it - captures.begin();
+                captures.push_back(capture);
+                return captures.size() - 1;
             }
 
-            void resolveLocal(Expr<rift::scanner::Token>* expr, Token name)
+            /// @brief finds the innermost scope declaring name (unresolved: global)
+            /// @note reaching a local of an enclosing function captures it
+            void resolveLocal(Storage& storage, int& depth, int& slot, Token name)
             {
+                int boxed = 0;
                 for (int i = scopes.size() - 1; i >= 0; i--) {
-                    if (scopes[i].find(name.lexeme) != scopes[i].end()) {
-                        eval->resolve(expr, scopes.size() - 1 - i);
+                    auto it = scopes[i].locals.find(name.lexeme);
+                    if (it != scopes[i].locals.end()) {
+                        const Local& local = it->second;
+                        if (escape) {
+                            if (local.fn < (int)frames.size() - 1) *local.storage = Storage::Boxed;
+                            return;
+                        }
+                        storage = *local.storage;
+                        depth = storage == Storage::Boxed ? boxed : -1;
+                        slot = local.slot;
+                        // declared by an enclosing function: through the closure
+                        if (local.fn < (int)frames.size() - 1) {
+                            storage = Storage::Upvalue;
+                            depth = -1;
+                            slot = capture(frames.size() - 1, i, local.slot);
+                        }
                         return;
                     }
+                    if (scopes[i].boxed) boxed++;
+                }
+                storage = Storage::Global;
+                depth = slot = -1;
+            }
+
+            /// @brief the function name is bound to at a call (nullptr: unknown or rebound)
+            const DeclFunc<Token>::Func* callee(Token name)
+            {
+                const DeclFunc<Token>::Func* func = nullptr;
+                int i = scopes.size() - 1;
+                for (; i >= 0; i--) {
+                    auto it = scopes[i].locals.find(name.lexeme);
+                    if (it != scopes[i].locals.end()) {
+                        func = it->second.func;
+                        break;
+                    }
+                }
+                if (i < 0) {
+                    if (unparsed) return nullptr;
+                    auto it = globals.find(name.lexeme);
+                    if (it != globals.end()) func = it->second;
+                }
+                return rebound.count(func) ? nullptr : func;
+            }
+
+            /// @brief (escape pass) name is bound to something else than the function declared with it
+            /// @note a declaration only rebinds its own scope, it shadows the outer ones
+            void rebind(Token name, bool declaration)
+            {
+                if (!escape) return;
+                int end = declaration && !scopes.empty() ? scopes.size() - 1 : 0;
+                for (int i = scopes.size() - 1; i >= end; i--) {
+                    auto it = scopes[i].locals.find(name.lexeme);
+                    if (it != scopes[i].locals.end()) {
+                        if (it->second.func != nullptr) rebound.insert(it->second.func);
+                        return;
+                    }
+                }
+                if (declaration && !scopes.empty()) return;
+                // nullptr: not a function (yet), one declared later is rebound too
+                auto& func = globals[name.lexeme];
+                if (func != nullptr) rebound.insert(func);
+            }
+
+            /// @brief adds a write to the enclosing loops' write sets
+            void write(Storage storage, int slot, const string& name)
+            {
+                if (escape) return;
+                for (auto loop : loops) {
+                    if (storage == Storage::Frame) loop->writes.frame.insert(slot);
+                    else if (storage == Storage::Global) loop->writes.globals.insert(name);
+                    else loop->writes.boxed = true;
                 }
             }
+
+            /// @brief params get the first scope of a function, the body block the next
+            void function(const Resolver& resolver, DeclFunc<Token>::Func& func)
+            {
+                if (func.storage.size() != func.params.size())
+                    func.storage.assign(func.params.size(), Storage::Frame);
+
+                // the body only writes anything once it is called
+                auto outer = std::move(loops);
+                loops = {};
+                if (!escape) func.captures.clear();
+                frames.push_back({0, 0});
+                funcs.push_back(&func);
+                beginScope(!escape && func.boxes > 0);
+                for (size_t i = 0; i < func.params.size(); i++) {
+                    declare(func.params[i], &func.storage[i]);
+                    define(func.params[i]);
+                }
+
+                // lazily parsed bodies are resolved once they are parsed
+                if (func.blk != nullptr)
+                    resolver.resolve(*func.blk);
+
+                func.boxes = endScope();
+                if (!escape) func.frame = frames.back().size;
+                frames.pop_back();
+                funcs.pop_back();
+                loops = std::move(outer);
+            }
         }
 
         ////////////////////////////////////////////////////////////////////////
@@ -95,36 +285,49 @@ namespace rift
 
         Token Resolver::visit_ternary(const Ternary<Token>& expr) const
         {
-            if(truthy(expr.condition->accept(*this))) {
-                expr.left->accept(*this);
-            } else {
-                expr.right->accept(*this);
-            }
-
+            expr.condition->accept(*this);
+            expr.left->accept(*this);
+            expr.right->accept(*this);
             return Token();
         }
 
         Token Resolver::visit_assign(const Assign<Token>& expr) const
         {
-            Assign<Token>* assign = const_cast<Assign<Token>*>(&expr);
-            Resolve::resolveLocal(assign, expr.name);
+            expr.value->accept(*this);
+            Resolve::rebind(expr.name, false);
+            Resolve::resolveLocal(expr.storage, expr.depth, expr.slot, expr.name);
+            Resolve::write(expr.storage, expr.slot, expr.name.lexeme);
             return  Token();
         }
 
         Token Resolver::visit_call(const Call<Token>& expr) const
         {
-            // expr.accept(*this);
+            for (const auto& arg : expr.args)
+                arg->accept(*this);
+            Resolve::resolveLocal(expr.storage, expr.depth, expr.slot, expr.name);
+
+            // arguments bind to parameters by position, so their count has to match
+            if (!Resolve::escape) {
+                auto func = Resolve::callee(expr.name);
+                if (func != nullptr && func->params.size() != expr.args.size()) {
+                    string msg = "Expected " + std::to_string(func->params.size()) + " arguments but got " + std::to_string(expr.args.size()) + ".";
+                    error::report(expr.name.line, "at call", msg, expr.name, ResolverException(msg));
+                }
+            }
+            if (!Resolve::escape)
+                for (auto loop : Resolve::loops)
+                    loop->writes.calls = true;
             return Token();
         }
 
         Token Resolver::visit_var_expr(const VarExpr<Token>& expr) const
         {
             if (!Resolve::scopes.empty() && 
-                Resolve::scopes.back().find(expr.value.lexeme)!=Resolve::scopes.back().end() &&
-                Resolve::scopes.back().find(expr.value.lexeme)->second == false) {
+                Resolve::scopes.back().locals.find(expr.value.lexeme)!=Resolve::scopes.back().locals.end() &&
+                Resolve::scopes.back().locals.find(expr.value.lexeme)->second.defined == false) {
                 error::report(expr.value.line, "resolve_var_expr", "Cannot read local variable in its own initializer.", expr.value, ResolverException("Cannot read local variable in its own initializer."));
             }
-            Resolve::resolveLocal(const_cast<VarExpr<Token>*>(&expr), expr.value);
+            Resolve::resolveLocal(expr.storage, expr.depth, expr.slot, expr.value);
             return Token();
         }
 
@@ -134,7 +337,7 @@ namespace rift
 
         void Resolver::visit_expr_stmt(const StmtExpr<void>& stmt) const
         {
-            stmt.expr->accept(*this);
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
         }
 
         void Resolver::visit_print_stmt(const StmtPrint<void>& stmt) const
@@ -144,31 +347,47 @@ namespace rift
 
         void Resolver::visit_return_stmt(const StmtReturn<void>& stmt) const
         {
-            stmt.expr->accept(*this);
-            // visit_return_stmt(stmt);
-            // maybe set return token to NIL
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
         }
 
-        // FIX Compound Statements
-
         void Resolver::visit_if_stmt(const StmtIf<void>& stmt) const
         {
-            // stmt.if_stmt->stmt->accept(*this);
-            // stmt.else_stmt->stmt->accept(*this);
+            auto arm = [this](const StmtIf<void>::Stmt* arm) {
+                if (arm == nullptr) return;
+                if (arm->expr != nullptr) arm->expr->accept(*this);
+                if (arm->blk != nullptr) arm->blk->accept(*this);
+                else if (arm->stmt != nullptr) arm->stmt->accept(*this);
+            };
+
+            arm(stmt.if_stmt);
+            for (const auto& elif : stmt.elif_stmts)
+                arm(elif);
+            arm(stmt.else_stmt);
         }
 
         void Resolver::visit_block_stmt(const Block<void>& block) const
         {
-            Resolve::beginScope();
-            //
-            Resolve::endScope();
+            Resolve::beginScope(!Resolve::escape && block.scoped());
+            for (const auto& decl : block.decls)
+                if (decl != nullptr) decl->accept(*this);
+            if (!Resolve::escape) block.frame = Resolve::frames.back().size;
+            block.slots = Resolve::endScope();
         }
 
         void Resolver::visit_for_stmt(const For<void>& stmt) const
         {
-            // visit_for_stmt(stmt.stmt);
-            // resolve(stmt.condition);
-            // resolve(stmt.body);
+            // the loop variable lives in the enclosing scope
+            if (stmt.decl != nullptr) stmt.decl->accept(*this);
+            else if (stmt.stmt_l != nullptr) stmt.stmt_l->accept(*this);
+
+            stmt.writes = {};
+            Resolve::loops.push_back(&stmt);
+            if (stmt.expr != nullptr) stmt.expr->accept(*this);
+            if (stmt.stmt_r != nullptr) stmt.stmt_r->accept(*this);
+
+            if (stmt.blk != nullptr) stmt.blk->accept(*this);
+            else if (stmt.stmt_o != nullptr) stmt.stmt_o->accept(*this);
+            Resolve::loops.pop_back();
         }
 
         ////////////////////////////////////////////////////////////////////////
@@ -183,78 +402,42 @@ namespace rift
 
         Token Resolver::visit_decl_var(const DeclVar<Token>& decl) const
         {
-            Resolve::declare(decl.identifier);
+            Resolve::rebind(decl.identifier, true);
+            decl.slot = Resolve::declare(decl.identifier, &decl.storage);
             if (decl.expr != nullptr) {
                 decl.expr->accept(*this);
             }
             Resolve::define(decl.identifier);
+            // declared inside a loop: (re)initialized every iteration
+            Resolve::write(decl.storage, decl.slot, decl.identifier.lexeme);
             return Token();
         }
 
         Token Resolver::visit_decl_class(const DeclClass<Token>& decl) const
         {
-            Resolve::declare(decl.identifier);
+            Storage storage = Storage::Frame;
+            Resolve::rebind(decl.identifier, true);
+            Resolve::declare(decl.identifier, &storage);
             Resolve::define(decl.identifier);
             return Token();
         }
 
         Token Resolver::visit_decl_func(const DeclFunc<Token>& decl) const
         {
-            Resolve::declare(decl.func->name);
+            // declared & defined up front so the function can recurse
+            decl.slot = Resolve::declare(decl.func->name, &decl.storage);
             Resolve::define(decl.func->name);
-
-            // resolve params
-            Resolve::beginScope();   
-
-            for (auto param: decl.func->params) {
-                Resolve::declare(param);
-                Resolve::define(param);
-            }
-
-            // resolve block (cant initate abstract class ResolverBlock)
-            if (decl.func->blk != nullptr) {
-                // TODO: Fix
-                // Resolve::beginScope();
-                // auto blk = *decl.func->blk;
-
-                // // Create a new vector to hold the copied declarations
-                // Block<Token>::vec_prog copied_decls;
-
-                // // Reserve space in the new vector to avoid reallocations
-                // copied_decls.reserve(blk.decls.size());
-
-                // // Copy each declaration
-                // for (const auto &decl : blk.decls)
-                // {
-                //     if (auto var_decl = dynamic_cast<const DeclVar<Token> *>(decl.get()))
-                //     {
-                //         copied_decls.push_back(std::make_unique<DeclVar<Token>>(
-                //             var_decl->identifier,
-                //             var_decl->expr ? std::make_unique<Expr<Token>>(*var_decl->expr) : nullptr));
-                //     }
-                //     else if (auto func_decl = dynamic_cast<const DeclFunc<Token> *>(decl.get()))
-                //     {
-                //         auto new_func = std::make_unique<DeclFunc<Token>::Func>();
-                //         new_func->name = func_decl->func->name;
-                //         new_func->params = func_decl->func->params;
-                //         new_func->closure = func_decl->func->closure;
-                //         new_func->blk = func_decl->func->blk ? std::make_unique<Block<void>>(*func_decl->func->blk) : nullptr;
-                //         copied_decls.push_back(std::make_unique<DeclFunc<Token>>(std::move(new_func)));
-                //     }
-                //     else if (auto stmt_decl = dynamic_cast<const DeclStmt<Token> *>(decl.get()))
-                //     {
-                //         copied_decls.push_back(std::make_unique<DeclStmt<Token>>(
-                //             stmt_decl->stmt ? std::make_unique<Stmt<void>>(*stmt_decl->stmt) : nullptr));
-                //     }
-                // }
-
-                // Block<Token> new_blk = Block<Token>(std::move(copied_decls));
-                // visit_block_stmt(new_blk);
-                // Resolve::endScope();
+            if (!Resolve::scopes.empty()) {
+                Resolve::scopes.back().locals[decl.func->name.lexeme].func = decl.func.get();
+            } else if (Resolve::escape) {
+                auto it = Resolve::globals.find(decl.func->name.lexeme);
+                if (it != Resolve::globals.end()) Resolve::rebound.insert(decl.func.get());
+                Resolve::globals[decl.func->name.lexeme] = decl.func.get();
+                if (decl.func->blk == nullptr) Resolve::unparsed = true;
             }
+            Resolve::write(decl.storage, decl.slot, decl.func->name.lexeme);
 
-            Resolve::endScope();
-
+            Resolve::function(*this, *decl.func);
             return Token();
         }
 
@@ -262,12 +445,42 @@ namespace rift
         #pragma mark - PROGRAM
         ////////////////////////////////////////////////////////////////////////
 
+        void Resolver::resolve(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            // escape analysis first, slots are handed out knowing what is captured
+            Resolve::globals.clear();
+            Resolve::rebound.clear();
+            Resolve::unparsed = false;
+            Resolve::escape = true;
+            visit_program(*prgm);
+            Resolve::escape = false;
+            visit_program(*prgm);
+        }
+
+        void Resolver::resolve(DeclFunc<Token>::Func& func) const
+        {
+            // only top level functions are parsed lazily, so globals enclose them
+            auto outer = std::move(Resolve::scopes);
+            Resolve::scopes = {};
+
+            Resolve::escape = true;
+            Resolve::function(*this, func);
+            Resolve::escape = false;
+            Resolve::function(*this, func);
+
+            Resolve::scopes = std::move(outer);
+        }
+
+        void Resolver::resolve(const Block<void>& block) const
+        {
+            visit_block_stmt(block);
+        }
+
         Tokens Resolver::visit_program(const Program<Tokens>& prgm) const
         {
-            // for (auto decl: prgm.decls) {
-            //     visit_decl_stmt(*decl);
-            // }
+            for (const auto& decl : prgm.decls)
+                if (decl != nullptr) decl->accept(*this);
             return Tokens();
         }
     }
-}
\ No newline at end of file
+}
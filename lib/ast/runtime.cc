@@ -0,0 +1,249 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/emitc.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        /// @note written next to the emitted C (rift_rt.h & rift_rt.c)
+        const char* const CEmitter::header = R"rift(/* the runtime of rift programs compiled to C (rift --emit-c) */
+#ifndef RIFT_RT_H
+#define RIFT_RT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { RT_NIL, RT_BOOL, RT_INT, RT_STR, RT_FUNC } rt_type;
+
+typedef struct rt_str { size_t len; char chars[]; } rt_str;
+typedef struct rt_closure rt_closure;
+
+typedef struct rt_value {
+    rt_type type;
+    union { int b; int32_t i; rt_str* s; rt_closure* f; } as;
+} rt_value;
+
+/* the captured locals of a block or of a function's params */
+typedef struct rt_scope { struct rt_scope* enclosing; rt_value slots[]; } rt_scope;
+
+/* arguments are passed by name (symbol ids), each param picks its own */
+typedef rt_value (*rt_fn)(rt_closure* self, int argc, const rt_value* args);
+
+struct rt_closure { rt_fn fn; const char* name; rt_value* cells[]; };
+
+void rt_error(const char* msg, const char* what, const char* after);
+rt_value rt_str_new(const char* chars, size_t len);
+rt_scope* rt_enter(rt_scope* enclosing, int slots);
+rt_value rt_closure_new(rt_fn fn, const char* name, int cells);
+void rt_print(rt_value val);
+
+/* everything but two ints (strings, mixed types & errors) */
+rt_value rt_add_slow(rt_value l, rt_value r);
+rt_value rt_arith_slow(const char* op, rt_value l, rt_value r);
+rt_value rt_compare_slow(const char* op, rt_value l, rt_value r);
+rt_value rt_neg_slow(rt_value r);
+rt_value rt_not(rt_value r);
+
+static inline rt_value rt_nil(void) { rt_value v; v.type = RT_NIL; v.as.i = 0; return v; }
+static inline rt_value rt_bool(int b) { rt_value v; v.type = RT_BOOL; v.as.b = b; return v; }
+static inline rt_value rt_int(int32_t i) { rt_value v; v.type = RT_INT; v.as.i = i; return v; }
+
+/* int arithmetic wraps (as the 32 bit ints of the interpreter do) */
+static inline int32_t rt_wrap(int64_t v) { return (int32_t)(uint32_t)v; }
+static inline int rt_ints(rt_value l, rt_value r) { return l.type == RT_INT && r.type == RT_INT; }
+static inline int rt_truthy(rt_value v) { return v.type == RT_BOOL ? v.as.b : 1; }
+static inline int rt_isnil(rt_value v) { return v.type == RT_NIL; }
+
+static inline int32_t rt_idiv(int32_t l, int32_t r)
+{
+    if (r == 0) rt_error("Division by zero", "", "");
+    return rt_wrap((int64_t)l / r);
+}
+
+static inline rt_value rt_add(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_int(rt_wrap((int64_t)l.as.i + r.as.i)) : rt_add_slow(l, r); }
+static inline rt_value rt_sub(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_int(rt_wrap((int64_t)l.as.i - r.as.i)) : rt_arith_slow("-", l, r); }
+static inline rt_value rt_mul(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_int(rt_wrap((int64_t)l.as.i * r.as.i)) : rt_arith_slow("*", l, r); }
+static inline rt_value rt_div(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_int(rt_idiv(l.as.i, r.as.i)) : rt_arith_slow("/", l, r); }
+static inline rt_value rt_lt(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_bool(l.as.i < r.as.i) : rt_compare_slow("<", l, r); }
+static inline rt_value rt_le(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_bool(l.as.i <= r.as.i) : rt_compare_slow("<=", l, r); }
+static inline rt_value rt_gt(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_bool(l.as.i > r.as.i) : rt_compare_slow(">", l, r); }
+static inline rt_value rt_ge(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_bool(l.as.i >= r.as.i) : rt_compare_slow(">=", l, r); }
+static inline rt_value rt_eq(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_bool(l.as.i == r.as.i) : rt_compare_slow("==", l, r); }
+static inline rt_value rt_ne(rt_value l, rt_value r) { return rt_ints(l, r) ? rt_bool(l.as.i != r.as.i) : rt_compare_slow("!=", l, r); }
+static inline rt_value rt_neg(rt_value r) { return r.type == RT_INT ? rt_int(rt_wrap(-(int64_t)r.as.i)) : rt_neg_slow(r); }
+
+static inline rt_value* rt_at(rt_scope* scope, int depth, int slot)
+{
+    while (depth-- > 0) scope = scope->enclosing;
+    return &scope->slots[slot];
+}
+
+static inline rt_value rt_arg(int argc, const rt_value* args, int i)
+{
+    return i < argc ? args[i] : rt_nil();
+}
+
+static inline rt_value rt_call(rt_value callee, const char* name, int argc, const rt_value* args)
+{
+    if (callee.type != RT_FUNC) rt_error("Undefined function '", name, "'");
+    return callee.as.f->fn(callee.as.f, argc, args);
+}
+
+#endif
+)rift";
+
+        const char* const CEmitter::source = R"rift(/* the runtime of rift programs compiled to C (rift --emit-c) */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rift_rt.h"
+
+/* strings, scopes & closures live until the program exits */
+static void* rt_alloc(size_t size)
+{
+    void* mem = calloc(1, size);
+    if (mem == NULL) rt_error("Out of memory", "", "");
+    return mem;
+}
+
+void rt_error(const char* msg, const char* what, const char* after)
+{
+    printf("\xE2\x9B\x94\xEF\xB8\x8F Runtime Error: %s%s%s\n", msg, what, after);
+    exit(1);
+}
+
+rt_value rt_str_new(const char* chars, size_t len)
+{
+    rt_str* s = rt_alloc(sizeof(rt_str) + len + 1);
+    s->len = len;
+    memcpy(s->chars, chars, len);
+    rt_value v;
+    v.type = RT_STR;
+    v.as.s = s;
+    return v;
+}
+
+rt_scope* rt_enter(rt_scope* enclosing, int slots)
+{
+    rt_scope* scope = rt_alloc(sizeof(rt_scope) + slots * sizeof(rt_value));
+    scope->enclosing = enclosing;
+    return scope;
+}
+
+rt_value rt_closure_new(rt_fn fn, const char* name, int cells)
+{
+    rt_closure* f = rt_alloc(sizeof(rt_closure) + cells * sizeof(rt_value*));
+    f->fn = fn;
+    f->name = name;
+    rt_value v;
+    v.type = RT_FUNC;
+    v.as.f = f;
+    return v;
+}
+
+/* string literals keep their quotes until printed or joined to another string */
+static int rt_quoted(const rt_str* s)
+{
+    return s->len >= 2 && s->chars[0] == '"' && s->chars[s->len - 1] == '"';
+}
+
+static rt_value rt_join(const char* l, size_t llen, const char* r, size_t rlen)
+{
+    rt_value v;
+    v.type = RT_STR;
+    v.as.s = rt_alloc(sizeof(rt_str) + llen + rlen + 1);
+    v.as.s->len = llen + rlen;
+    memcpy(v.as.s->chars, l, llen);
+    memcpy(v.as.s->chars + llen, r, rlen);
+    return v;
+}
+
+void rt_print(rt_value val)
+{
+    switch (val.type) {
+        case RT_NIL: puts("nil"); break;
+        case RT_BOOL: puts(val.as.b ? "true" : "false"); break;
+        case RT_INT: printf("%d\n", val.as.i); break;
+        case RT_FUNC: puts(val.as.f->name); break;
+        case RT_STR:
+            if (rt_quoted(val.as.s)) printf("%.*s\n", (int)val.as.s->len - 2, val.as.s->chars + 1);
+            else printf("%.*s\n", (int)val.as.s->len, val.as.s->chars);
+            break;
+    }
+}
+
+rt_value rt_add_slow(rt_value l, rt_value r)
+{
+    char num[16];
+    if (l.type == RT_STR && r.type == RT_STR) {
+        int lq = rt_quoted(l.as.s), rq = rt_quoted(r.as.s);
+        return rt_join(l.as.s->chars + lq, l.as.s->len - 2 * lq, r.as.s->chars + rq, r.as.s->len - 2 * rq);
+    }
+    if (l.type == RT_STR && r.type == RT_INT) {
+        int n = snprintf(num, sizeof(num), "%d", r.as.i);
+        return rt_join(l.as.s->chars, l.as.s->len, num, n);
+    }
+    if (l.type == RT_INT && r.type == RT_STR) {
+        int n = snprintf(num, sizeof(num), "%d", l.as.i);
+        return rt_join(num, n, r.as.s->chars, r.as.s->len);
+    }
+    rt_error("Expected a number or string for '+' operator", "", "");
+    return rt_nil();
+}
+
+rt_value rt_arith_slow(const char* op, rt_value l, rt_value r)
+{
+    (void)l;
+    (void)r;
+    rt_error("Expected a number for '", op, "' operator");
+    return rt_nil();
+}
+
+rt_value rt_compare_slow(const char* op, rt_value l, rt_value r)
+{
+    if (l.type != RT_STR || r.type != RT_STR)
+        rt_error("Expected a number or string for '", op, "' operator");
+
+    int cmp = strcmp(l.as.s->chars, r.as.s->chars);
+    switch (op[0]) {
+        case '<': return rt_bool(op[1] == '=' ? cmp <= 0 : cmp < 0);
+        case '>': return rt_bool(op[1] == '=' ? cmp >= 0 : cmp > 0);
+        case '=': return rt_bool(cmp == 0);
+        default: return rt_bool(cmp != 0);
+    }
+}
+
+rt_value rt_neg_slow(rt_value r)
+{
+    (void)r;
+    rt_error("Expected a number after '-' operator", "", "");
+    return rt_nil();
+}
+
+rt_value rt_not(rt_value r)
+{
+    switch (r.type) {
+        case RT_BOOL: return rt_bool(!r.as.b);
+        case RT_INT: return rt_bool(r.as.i == 0);
+        case RT_STR: return rt_bool(r.as.s->len == 0);
+        default:
+            rt_error("Expected a number or string after '!' operator", "", "");
+            return rt_nil();
+    }
+}
+)rift";
+    }
+}
@@ -0,0 +1,1207 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <ast/ssa.hh>
+#include <ast/fold.hh>
+#include <ast/parser.hh>
+#include <ast/resolver.hh>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        static Token nil(int line = 0)
+        {
+            return Token(TokenType::NIL, "nil", nullptr, line);
+        }
+
+        static Token boolean(bool val, int line = 0)
+        {
+            return val ? Token(TokenType::TRUE, "true", true, line) : Token(TokenType::FALSE, "false", false, line);
+        }
+
+        namespace ssa
+        {
+            /// @brief the same constant (anything else folds conservatively)
+            static bool same(const Token& left, const Token& right)
+            {
+                return left.type == right.type && left.getLiteral().type() == right.getLiteral().type() && left.lexeme == right.lexeme;
+            }
+
+            static void drop(std::vector<Inst*>& users, Inst* user)
+            {
+                auto it = std::find(users.begin(), users.end(), user);
+                if (it != users.end()) users.erase(it);
+            }
+
+            static string literal(const Token& tok)
+            {
+                if (tok.type == TokenType::NIL) return "nil";
+                if (isString(tok)) return "\"" + Eval::text(tok) + "\"";
+                return Eval::show(tok);
+            }
+
+            static string symbol(const Token& op)
+            {
+                switch (op.type) {
+                    case TokenType::PLUS: return "+";
+                    case TokenType::MINUS: return "-";
+                    case TokenType::STAR: return "*";
+                    case TokenType::SLASH: return "/";
+                    case TokenType::LESS: return "<";
+                    case TokenType::LESS_EQUAL: return "<=";
+                    case TokenType::GREATER: return ">";
+                    case TokenType::GREATER_EQUAL: return ">=";
+                    case TokenType::EQUAL_EQUAL: return "==";
+                    case TokenType::BANG_EQUAL: return "!=";
+                    case TokenType::BANG: return "!";
+                    default: return op.lexeme;
+                }
+            }
+
+            bool Inst::pure() const
+            {
+                switch (op) {
+                    case Opcode::Const:
+                    case Opcode::Phi:
+                    case Opcode::Copy:
+                    case Opcode::IsNil:
+                    case Opcode::Closure:
+                        return true;
+                    case Opcode::Binary:
+                        // typed operands can't fail, a division can still be by zero
+                        return operands != Kind::Unknown && value.type != TokenType::SLASH;
+                    default:
+                        return false;
+                }
+            }
+
+            ////////////////////////////////////////////////////////////////////////
+            #pragma mark - FUNCTION
+            ////////////////////////////////////////////////////////////////////////
+
+            Block* Function::block()
+            {
+                blocks.push_back(std::make_unique<Block>());
+                blocks.back()->id = blockId++;
+                return blocks.back().get();
+            }
+
+            Inst* Function::append(Block* blk, Opcode op, std::vector<Inst*> args)
+            {
+                auto inst = std::make_unique<Inst>(op);
+                inst->block = blk;
+                for (auto arg : args)
+                    use(inst.get(), arg);
+
+                auto at = blk->insts.end();
+                if (op == Opcode::Phi)
+                    at = std::find_if(blk->insts.begin(), blk->insts.end(), [](const auto& i) { return i->op != Opcode::Phi; });
+                else if (blk->terminator() != nullptr)
+                    at = std::prev(at);
+                return blk->insts.insert(at, std::move(inst))->get();
+            }
+
+            void Function::use(Inst* inst, Inst* arg)
+            {
+                inst->args.push_back(arg);
+                arg->users.push_back(inst);
+            }
+
+            void Function::replace(Inst* old, Inst* val)
+            {
+                if (old == val) return;
+                auto users = std::move(old->users);
+                old->users.clear();
+                std::sort(users.begin(), users.end());
+                users.erase(std::unique(users.begin(), users.end()), users.end());
+                for (auto user : users) {
+                    for (auto& arg : user->args) {
+                        if (arg != old) continue;
+                        arg = val;
+                        val->users.push_back(user);
+                    }
+                }
+            }
+
+            void Function::erase(Inst* inst)
+            {
+                for (auto arg : inst->args)
+                    drop(arg->users, inst);
+                inst->args.clear();
+
+                auto& insts = inst->block->insts;
+                auto it = std::find_if(insts.begin(), insts.end(), [&](const auto& i) { return i.get() == inst; });
+                inst->block = nullptr;
+                erased.push_back(std::move(*it));
+                insts.erase(it);
+            }
+
+            void Function::link(Block* from, Block* to)
+            {
+                from->succs.push_back(to);
+                to->preds.push_back(from);
+            }
+
+            void Function::unlink(Block* from, Block* to)
+            {
+                auto succ = std::find(from->succs.begin(), from->succs.end(), to);
+                if (succ != from->succs.end()) from->succs.erase(succ);
+
+                auto pred = std::find(to->preds.begin(), to->preds.end(), from);
+                if (pred == to->preds.end()) return;
+                size_t at = pred - to->preds.begin();
+                to->preds.erase(pred);
+                for (const auto& inst : to->insts) {
+                    if (inst->op != Opcode::Phi) break;
+                    if (at >= inst->args.size()) continue;
+                    drop(inst->args[at]->users, inst.get());
+                    inst->args.erase(inst->args.begin() + at);
+                }
+            }
+
+            std::vector<Block*> Function::order() const
+            {
+                std::vector<Block*> post = {};
+                if (blocks.empty()) return post;
+
+                std::unordered_set<Block*> seen = {blocks[0].get()};
+                std::vector<std::pair<Block*, size_t>> stack = {{blocks[0].get(), 0}};
+                while (!stack.empty()) {
+                    auto& [blk, next] = stack.back();
+                    if (next < blk->succs.size()) {
+                        auto succ = blk->succs[next++];
+                        if (seen.insert(succ).second) stack.push_back({succ, 0});
+                        continue;
+                    }
+                    post.push_back(blk);
+                    stack.pop_back();
+                }
+                std::reverse(post.begin(), post.end());
+                return post;
+            }
+
+            unsigned Function::prune()
+            {
+                auto rpo = order();
+                std::unordered_set<Block*> reached(rpo.begin(), rpo.end());
+
+                unsigned removed = 0;
+                for (const auto& blk : blocks) {
+                    if (reached.count(blk.get())) continue;
+                    for (auto succ : std::vector<Block*>(blk->succs))
+                        unlink(blk.get(), succ);
+                    std::vector<Inst*> insts = {};
+                    for (const auto& inst : blk->insts) insts.push_back(inst.get());
+                    for (auto inst : insts) erase(inst);
+                    removed++;
+                }
+                blocks.erase(std::remove_if(blocks.begin(), blocks.end(), [&](const auto& blk) { return !reached.count(blk.get()); }), blocks.end());
+                return removed;
+            }
+
+            string Function::dump() const
+            {
+                std::unordered_map<const Block*, unsigned> labels = {};
+                std::unordered_map<const Inst*, unsigned> ids = {};
+                for (const auto& blk : blocks) {
+                    labels[blk.get()] = labels.size();
+                    for (const auto& inst : blk->insts)
+                        ids[inst.get()] = ids.size();
+                }
+                auto val = [&](const Inst* inst) { return "%" + std::to_string(ids[inst]); };
+                auto lbl = [&](const Block* blk) { return "b" + std::to_string(labels[blk]); };
+                auto where = [](const Inst& inst) {
+                    switch (inst.storage) {
+                        case Storage::Boxed: return "boxed " + std::to_string(inst.depth) + "." + std::to_string(inst.slot) + " " + inst.value.lexeme;
+                        case Storage::Upvalue: return "upvalue " + std::to_string(inst.slot) + " " + inst.value.lexeme;
+                        default: return "global " + inst.value.lexeme;
+                    }
+                };
+
+                std::ostringstream out;
+                out << "func " << name.lexeme << "(";
+                for (size_t i = 0; i < params.size(); i++)
+                    out << (i ? ", " : "") << params[i].lexeme;
+                out << ") {" << std::endl;
+
+                for (const auto& blk : blocks) {
+                    out << lbl(blk.get()) << ":";
+                    for (size_t i = 0; i < blk->preds.size(); i++)
+                        out << (i ? ", " : "  ; preds ") << lbl(blk->preds[i]);
+                    out << std::endl;
+
+                    for (const auto& inst : blk->insts) {
+                        const auto& args = inst->args;
+                        out << "    ";
+                        if (!inst->terminator() && inst->op != Opcode::Store && inst->op != Opcode::Enter && inst->op != Opcode::Leave && inst->op != Opcode::Print)
+                            out << val(inst.get()) << " = ";
+
+                        switch (inst->op) {
+                            case Opcode::Const: out << "const " << literal(inst->value); break;
+                            case Opcode::Param: out << "param " << inst->value.lexeme; break;
+                            case Opcode::Phi:
+                                out << "phi";
+                                for (size_t i = 0; i < args.size(); i++)
+                                    out << (i ? ", [" : " [") << val(args[i]) << ", " << (i < blk->preds.size() ? lbl(blk->preds[i]) : "?") << "]";
+                                break;
+                            case Opcode::Copy: out << "copy " << val(args[0]); break;
+                            case Opcode::Binary: out << val(args[0]) << " " << symbol(inst->value) << " " << val(args[1]); break;
+                            case Opcode::Unary: out << symbol(inst->value) << val(args[0]); break;
+                            case Opcode::IsNil: out << "isnil " << val(args[0]); break;
+                            case Opcode::Load: out << "load " << where(*inst); break;
+                            case Opcode::Store: out << "store " << where(*inst) << ", " << val(args[0]); break;
+                            case Opcode::Closure: out << "closure " << inst->value.lexeme; break;
+                            case Opcode::Call:
+                                out << "call " << val(args[0]) << "(";
+                                for (size_t i = 1; i < args.size(); i++)
+                                    out << (i > 1 ? ", " : "") << val(args[i]);
+                                out << ")";
+                                break;
+                            case Opcode::Enter: out << "enter " << inst->slot; break;
+                            case Opcode::Leave: out << "leave"; break;
+                            case Opcode::Print: out << "print " << val(args[0]); break;
+                            case Opcode::Jump: out << "jump " << lbl(blk->succs[0]); break;
+                            case Opcode::Branch: out << "branch " << val(args[0]) << ", " << lbl(blk->succs[0]) << ", " << lbl(blk->succs[1]); break;
+                            case Opcode::Return: out << "return " << val(args[0]); break;
+                        }
+                        out << std::endl;
+                    }
+                }
+                out << "}" << std::endl;
+                return out.str();
+            }
+
+            string Function::verify() const
+            {
+                std::unordered_set<const Block*> owned = {};
+                for (const auto& blk : blocks) owned.insert(blk.get());
+
+                for (const auto& blk : blocks) {
+                    string at = name.lexeme + ": b" + std::to_string(blk->id) + ": ";
+                    auto term = blk->terminator();
+                    if (term == nullptr) return at + "no terminator";
+                    size_t succs = term->op == Opcode::Jump ? 1 : term->op == Opcode::Branch ? 2 : 0;
+                    if (blk->succs.size() != succs) return at + "successors don't match the terminator";
+
+                    for (auto succ : blk->succs) {
+                        if (!owned.count(succ)) return at + "successor outside the function";
+                        if (std::count(blk->succs.begin(), blk->succs.end(), succ) != std::count(succ->preds.begin(), succ->preds.end(), blk.get()))
+                            return at + "edge missing from a predecessor list";
+                    }
+                    for (auto pred : blk->preds) {
+                        if (!owned.count(pred)) return at + "predecessor outside the function";
+                        if (std::count(pred->succs.begin(), pred->succs.end(), blk.get()) == 0)
+                            return at + "edge missing from a successor list";
+                    }
+
+                    bool phis = true;
+                    for (const auto& inst : blk->insts) {
+                        if (inst->block != blk.get()) return at + "instruction in the wrong block";
+                        if (inst->terminator() && inst.get() != term) return at + "terminator in the middle of the block";
+                        if (inst->op == Opcode::Phi) {
+                            if (!phis) return at + "phi after other instructions";
+                            if (inst->args.size() != blk->preds.size()) return at + "phi operands don't match the predecessors";
+                        } else {
+                            phis = false;
+                        }
+                        for (auto arg : inst->args) {
+                            if (arg->block == nullptr || !owned.count(arg->block)) return at + "operand erased";
+                            if (std::count(inst->args.begin(), inst->args.end(), arg) != std::count(arg->users.begin(), arg->users.end(), inst.get()))
+                                return at + "use missing from a def-use chain";
+                        }
+                        for (auto user : inst->users) {
+                            if (std::find(user->args.begin(), user->args.end(), inst.get()) == user->args.end())
+                                return at + "user not using the value";
+                        }
+                    }
+                }
+                return "";
+            }
+
+            ////////////////////////////////////////////////////////////////////////
+            #pragma mark - OPTIMIZER
+            ////////////////////////////////////////////////////////////////////////
+
+            /// @brief lattice of sparse conditional constant propagation
+            struct Cell
+            {
+                enum State : uint8_t { Top, Const, Bottom } state = Top;
+                Token value = {};
+            };
+
+            static Cell meet(const Cell& left, const Cell& right)
+            {
+                if (left.state == Cell::Top) return right;
+                if (right.state == Cell::Top) return left;
+                if (left.state == Cell::Const && right.state == Cell::Const && same(left.value, right.value)) return left;
+                return {Cell::Bottom};
+            }
+
+            unsigned Optimizer::sccp(Function& fn, unsigned& branches) const
+            {
+                std::unordered_map<Inst*, Cell> cells = {};
+                std::unordered_set<Block*> reached = {};
+                std::set<std::pair<Block*, Block*>> edges = {};
+                std::vector<std::pair<Block*, Block*>> flow = {{nullptr, fn.blocks[0].get()}};
+                std::vector<Inst*> uses = {};
+
+                auto cell = [&](Inst* inst) {
+                    auto it = cells.find(inst);
+                    return it == cells.end() ? Cell{} : it->second;
+                };
+                // values only move down the lattice
+                auto lower = [&](Inst* inst, Cell val) {
+                    auto& old = cells[inst];
+                    val = meet(old, val);
+                    if (val.state == old.state && (val.state != Cell::Const || same(val.value, old.value))) return;
+                    old = val;
+                    uses.insert(uses.end(), inst->users.begin(), inst->users.end());
+                };
+
+                auto visit = [&](Inst* inst) {
+                    const auto& args = inst->args;
+                    switch (inst->op) {
+                        case Opcode::Const:
+                            lower(inst, {Cell::Const, inst->value});
+                            break;
+                        case Opcode::Phi: {
+                            Cell val = {};
+                            for (size_t i = 0; i < args.size(); i++) {
+                                if (edges.count({inst->block->preds[i], inst->block}))
+                                    val = meet(val, cell(args[i]));
+                            }
+                            if (val.state != Cell::Top) lower(inst, val);
+                            break;
+                        }
+                        case Opcode::Copy: {
+                            auto val = cell(args[0]);
+                            if (val.state != Cell::Top) lower(inst, val);
+                            break;
+                        }
+                        case Opcode::Binary: {
+                            auto left = cell(args[0]), right = cell(args[1]);
+                            if (left.state == Cell::Bottom || right.state == Cell::Bottom)
+                                lower(inst, {Cell::Bottom});
+                            else if (left.state == Cell::Const && right.state == Cell::Const)
+                                lower(inst, Fold::foldable(inst->value, left.value, right.value) ? Cell{Cell::Const, Eval::binary(inst->value, left.value, right.value)} : Cell{Cell::Bottom});
+                            break;
+                        }
+                        case Opcode::Unary: {
+                            auto right = cell(args[0]);
+                            if (right.state == Cell::Bottom)
+                                lower(inst, {Cell::Bottom});
+                            else if (right.state == Cell::Const)
+                                lower(inst, Fold::foldable(inst->value, right.value) ? Cell{Cell::Const, Eval::unary(inst->value, right.value)} : Cell{Cell::Bottom});
+                            break;
+                        }
+                        case Opcode::IsNil: {
+                            auto val = cell(args[0]);
+                            if (val.state == Cell::Bottom) lower(inst, {Cell::Bottom});
+                            else if (val.state == Cell::Const) lower(inst, {Cell::Const, boolean(val.value.type == TokenType::NIL)});
+                            break;
+                        }
+                        case Opcode::Jump:
+                            flow.push_back({inst->block, inst->block->succs[0]});
+                            break;
+                        case Opcode::Branch: {
+                            auto cond = cell(args[0]);
+                            if (cond.state == Cell::Const) {
+                                flow.push_back({inst->block, inst->block->succs[truthy(cond.value) ? 0 : 1]});
+                            } else if (cond.state == Cell::Bottom) {
+                                flow.push_back({inst->block, inst->block->succs[0]});
+                                flow.push_back({inst->block, inst->block->succs[1]});
+                            }
+                            break;
+                        }
+                        default:
+                            // params, memory & calls: only known at runtime
+                            lower(inst, {Cell::Bottom});
+                            break;
+                    }
+                };
+
+                while (!flow.empty() || !uses.empty()) {
+                    if (!flow.empty()) {
+                        auto edge = flow.back();
+                        flow.pop_back();
+                        if (!edges.insert(edge).second) continue;
+                        // a block's first edge runs all of it, later ones only its phis
+                        bool first = reached.insert(edge.second).second;
+                        for (const auto& inst : edge.second->insts) {
+                            if (!first && inst->op != Opcode::Phi) break;
+                            visit(inst.get());
+                        }
+                        continue;
+                    }
+                    auto inst = uses.back();
+                    uses.pop_back();
+                    if (inst->block != nullptr && reached.count(inst->block)) visit(inst);
+                }
+
+                // constants replace what computes them, constant branches become jumps
+                unsigned folded = 0;
+                Block* entry = fn.blocks[0].get();
+                for (const auto& blk : fn.blocks) {
+                    if (!reached.count(blk.get())) continue;
+
+                    std::vector<Inst*> insts = {};
+                    for (const auto& inst : blk->insts) insts.push_back(inst.get());
+                    for (auto inst : insts) {
+                        auto val = cell(inst);
+                        if (val.state != Cell::Const || inst->op == Opcode::Const || (!inst->pure() && inst->op != Opcode::Binary && inst->op != Opcode::Unary))
+                            continue;
+                        if (inst->op == Opcode::Phi) {
+                            // phis stay first in their block, the constant goes where it dominates every use
+                            auto k = fn.append(entry, Opcode::Const);
+                            k->value = val.value;
+                            fn.replace(inst, k);
+                            fn.erase(inst);
+                        } else {
+                            for (auto arg : inst->args) drop(arg->users, inst);
+                            inst->args.clear();
+                            inst->op = Opcode::Const;
+                            inst->value = val.value;
+                        }
+                        folded++;
+                    }
+
+                    auto term = blk->terminator();
+                    if (term == nullptr || term->op != Opcode::Branch || cell(term->args[0]).state != Cell::Const) continue;
+                    bool taken = truthy(cell(term->args[0]).value);
+                    Block* other = blk->succs[taken ? 1 : 0];
+                    drop(term->args[0]->users, term);
+                    term->args.clear();
+                    term->op = Opcode::Jump;
+                    fn.unlink(blk.get(), other);
+                    branches++;
+                }
+                fn.prune();
+                return folded;
+            }
+
+            unsigned Optimizer::copies(Function& fn) const
+            {
+                unsigned forwarded = 0;
+                for (bool changed = true; changed; ) {
+                    changed = false;
+                    for (const auto& blk : fn.blocks) {
+                        std::vector<Inst*> insts = {};
+                        for (const auto& inst : blk->insts) insts.push_back(inst.get());
+                        for (auto inst : insts) {
+                            Inst* val = nullptr;
+                            if (inst->op == Opcode::Copy) {
+                                val = inst->args[0];
+                            } else if (inst->op == Opcode::Phi) {
+                                // a phi of a single value (besides itself)
+                                for (auto arg : inst->args) {
+                                    if (arg == inst || arg == val) continue;
+                                    if (val != nullptr) {
+                                        val = nullptr;
+                                        break;
+                                    }
+                                    val = arg;
+                                }
+                            }
+                            if (val == nullptr) continue;
+                            fn.replace(inst, val);
+                            fn.erase(inst);
+                            forwarded++;
+                            changed = true;
+                        }
+                    }
+                }
+                return forwarded;
+            }
+
+            unsigned Optimizer::gvn(Function& fn) const
+            {
+                auto rpo = fn.order();
+                std::unordered_map<Block*, size_t> index = {};
+                for (size_t i = 0; i < rpo.size(); i++) index[rpo[i]] = i;
+
+                // dominators (Cooper, Harvey & Kennedy)
+                std::unordered_map<Block*, Block*> idom = {{rpo[0], rpo[0]}};
+                auto intersect = [&](Block* left, Block* right) {
+                    while (left != right) {
+                        while (index[left] > index[right]) left = idom[left];
+                        while (index[right] > index[left]) right = idom[right];
+                    }
+                    return left;
+                };
+                for (bool changed = true; changed; ) {
+                    changed = false;
+                    for (size_t i = 1; i < rpo.size(); i++) {
+                        Block* dom = nullptr;
+                        for (auto pred : rpo[i]->preds) {
+                            if (!idom.count(pred)) continue;
+                            dom = dom == nullptr ? pred : intersect(pred, dom);
+                        }
+                        if (dom != nullptr && idom[rpo[i]] != dom) {
+                            idom[rpo[i]] = dom;
+                            changed = true;
+                        }
+                    }
+                }
+                std::unordered_map<Block*, std::vector<Block*>> children = {};
+                for (size_t i = 1; i < rpo.size(); i++)
+                    children[idom[rpo[i]]].push_back(rpo[i]);
+
+                auto key = [](const Inst& inst) -> string {
+                    std::ostringstream out;
+                    switch (inst.op) {
+                        case Opcode::Const:
+                            out << "k" << static_cast<int>(inst.value.type) << inst.value.getLiteral().type().name() << ":" << inst.value.lexeme;
+                            return out.str();
+                        case Opcode::Phi: out << "p" << inst.block; break;
+                        case Opcode::Copy: out << "c"; break;
+                        case Opcode::Binary: out << "b" << static_cast<int>(inst.value.type); break;
+                        case Opcode::Unary: out << "u" << static_cast<int>(inst.value.type); break;
+                        case Opcode::IsNil: out << "n"; break;
+                        default: return "";
+                    }
+                    for (auto arg : inst.args) out << ":" << arg;
+                    return out.str();
+                };
+
+                // an instruction is redundant if an equivalent one dominates it
+                unsigned numbered = 0;
+                std::unordered_map<string, Inst*> table = {};
+                std::function<void(Block*)> walk = [&](Block* blk) {
+                    std::vector<string> scope = {};
+                    std::vector<Inst*> insts = {};
+                    for (const auto& inst : blk->insts) insts.push_back(inst.get());
+                    for (auto inst : insts) {
+                        auto k = key(*inst);
+                        if (k.empty()) continue;
+                        auto it = table.find(k);
+                        if (it != table.end()) {
+                            fn.replace(inst, it->second);
+                            fn.erase(inst);
+                            numbered++;
+                            continue;
+                        }
+                        table[k] = inst;
+                        scope.push_back(k);
+                    }
+                    for (auto child : children[blk]) walk(child);
+                    for (const auto& k : scope) table.erase(k);
+                };
+                walk(rpo[0]);
+                return numbered;
+            }
+
+            unsigned Optimizer::dce(Function& fn) const
+            {
+                std::unordered_set<Inst*> live = {};
+                std::vector<Inst*> work = {};
+                for (const auto& blk : fn.blocks) {
+                    for (const auto& inst : blk->insts) {
+                        if (inst->pure()) continue;
+                        live.insert(inst.get());
+                        work.push_back(inst.get());
+                    }
+                }
+                while (!work.empty()) {
+                    auto inst = work.back();
+                    work.pop_back();
+                    for (auto arg : inst->args)
+                        if (live.insert(arg).second) work.push_back(arg);
+                }
+
+                unsigned removed = 0;
+                for (const auto& blk : fn.blocks) {
+                    std::vector<Inst*> insts = {};
+                    for (const auto& inst : blk->insts)
+                        if (!live.count(inst.get())) insts.push_back(inst.get());
+                    for (auto inst : insts) {
+                        fn.erase(inst);
+                        removed++;
+                    }
+                }
+                return removed;
+            }
+
+            unsigned Optimizer::merge(Function& fn) const
+            {
+                unsigned merged = 0;
+                for (bool changed = true; changed; ) {
+                    changed = false;
+                    for (size_t i = 1; i < fn.blocks.size(); i++) {
+                        Block* blk = fn.blocks[i].get();
+                        if (blk->preds.size() != 1) continue;
+                        Block* pred = blk->preds[0];
+                        if (pred == blk || pred->succs.size() != 1) continue;
+
+                        // phis of a single predecessor are their operand
+                        while (!blk->insts.empty() && blk->insts.front()->op == Opcode::Phi) {
+                            auto phi = blk->insts.front().get();
+                            fn.replace(phi, phi->args[0]);
+                            fn.erase(phi);
+                        }
+                        fn.erase(pred->terminator());
+                        for (auto& inst : blk->insts) {
+                            inst->block = pred;
+                            pred->insts.push_back(std::move(inst));
+                        }
+                        pred->succs = blk->succs;
+                        for (auto succ : blk->succs)
+                            std::replace(succ->preds.begin(), succ->preds.end(), blk, pred);
+
+                        fn.blocks.erase(fn.blocks.begin() + i--);
+                        merged++;
+                        changed = true;
+                    }
+                }
+                return merged;
+            }
+
+            Optimizer::Report Optimizer::run(Function& fn) const
+            {
+                Report report = {};
+                for (unsigned round = 0; round < 8; round++) {
+                    unsigned branches = 0;
+                    unsigned folded = sccp(fn, branches);
+                    unsigned copied = copies(fn);
+                    unsigned numbered = gvn(fn);
+                    unsigned dead = dce(fn);
+                    unsigned merged = merge(fn);
+                    fn.sweep();
+
+                    report.folded += folded;
+                    report.branches += branches;
+                    report.copies += copied;
+                    report.numbered += numbered;
+                    report.dead += dead;
+                    report.merged += merged;
+                    if (folded + branches + copied + numbered + dead + merged == 0) break;
+                }
+                return report;
+            }
+        }
+
+        using ssa::Function;
+        using ssa::Inst;
+        using ssa::Opcode;
+
+        #pragma mark - Helpers
+
+        std::vector<std::unique_ptr<Function>> SSABuilder::build(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            built.clear();
+            auto outer = std::exchange(state, State{});
+            state.fn = std::make_unique<Function>(Token(TokenType::IDENTIFIER, "script", 0, 0));
+            state.cur = state.fn->block();
+            state.sealed.insert(state.cur);
+
+            prgm->accept(*this);
+            if (state.cur->terminator() == nullptr)
+                emit(Opcode::Return, {constant(nil())});
+            state.fn->prune();
+
+            auto script = state.supported ? std::move(state.fn) : nullptr;
+            state = std::move(outer);
+
+            std::vector<std::unique_ptr<Function>> fns = {};
+            if (script != nullptr) fns.push_back(std::move(script));
+            for (auto& fn : built)
+                if (fn != nullptr) fns.push_back(std::move(fn));
+            built.clear();
+            return fns;
+        }
+
+        std::unique_ptr<Function> SSABuilder::build(const DeclFunc<Token>::Func& func) const
+        {
+            // the engines parse a lazy body on its first call, here it is needed now
+            auto& body = const_cast<DeclFunc<Token>::Func&>(func);
+            if (Parser::materialize(body))
+                Resolver().resolve(body);
+            if (func.blk == nullptr) return nullptr;
+
+            auto outer = std::exchange(state, State{});
+            state.fn = std::make_unique<Function>(func.name);
+            state.fn->params = func.params;
+            state.fn->func = &func;
+            state.cur = state.fn->block();
+            state.sealed.insert(state.cur);
+
+            // frame params take the first slots, captured ones live in the call's heap scope
+            for (size_t i = 0, f = 0; i < func.params.size() && i < func.storage.size(); i++) {
+                if (func.storage[i] != Storage::Frame) continue;
+                auto param = emit(Opcode::Param);
+                param->value = func.params[i];
+                param->slot = i;
+                write(f++, state.cur, param);
+            }
+
+            func.blk->accept(*this);
+            if (state.cur->terminator() == nullptr)
+                emit(Opcode::Return, {constant(nil())});
+            state.fn->prune();
+
+            auto fn = state.supported ? std::move(state.fn) : nullptr;
+            state = std::move(outer);
+            return fn;
+        }
+
+        Inst* SSABuilder::lower(const Expr<Token>& expr) const
+        {
+            expr.accept(*this);
+            return value;
+        }
+
+        Inst* SSABuilder::emit(Opcode op, std::vector<Inst*> args) const
+        {
+            return state.fn->append(state.cur, op, std::move(args));
+        }
+
+        Inst* SSABuilder::constant(const Token& tok) const
+        {
+            auto k = emit(Opcode::Const);
+            k->value = tok;
+            return k;
+        }
+
+        /// @note code after a return goes to a block nothing reaches, it doesn't branch anywhere
+        ///       (prune drops it at the end)
+        void SSABuilder::jump(ssa::Block* to) const
+        {
+            if (state.cur->preds.empty() && state.cur != state.fn->blocks[0].get()) return;
+            emit(Opcode::Jump);
+            state.fn->link(state.cur, to);
+        }
+
+        void SSABuilder::branch(Inst* cond, ssa::Block* yes, ssa::Block* no) const
+        {
+            if (state.cur->preds.empty() && state.cur != state.fn->blocks[0].get()) return;
+            emit(Opcode::Branch, {cond});
+            state.fn->link(state.cur, yes);
+            state.fn->link(state.cur, no);
+        }
+
+        Inst* SSABuilder::merge(const std::vector<std::pair<ssa::Block*, Inst*>>& values) const
+        {
+            auto phi = emit(Opcode::Phi);
+            for (auto pred : state.cur->preds) {
+                for (const auto& [blk, val] : values) {
+                    if (blk != pred) continue;
+                    state.fn->use(phi, val);
+                    break;
+                }
+            }
+            return phi;
+        }
+
+        void SSABuilder::write(int slot, ssa::Block* blk, Inst* val) const
+        {
+            state.defs[blk][slot] = val;
+        }
+
+        Inst* SSABuilder::read(int slot, ssa::Block* blk) const
+        {
+            const auto& defs = state.defs[blk];
+            if (auto it = defs.find(slot); it != defs.end()) return it->second;
+
+            Inst* val = nullptr;
+            if (!state.sealed.count(blk)) {
+                // completed once every predecessor is known
+                val = state.fn->append(blk, Opcode::Phi);
+                val->slot = slot;
+                state.incomplete[blk][slot] = val;
+            } else if (blk->preds.size() == 1) {
+                val = read(slot, blk->preds[0]);
+            } else if (blk->preds.empty()) {
+                // read before any write: frame slots start out nil
+                val = state.fn->append(blk, Opcode::Const);
+                val->value = nil();
+            } else {
+                // the phi is the slot's value while its operands are read (breaks cycles)
+                val = state.fn->append(blk, Opcode::Phi);
+                val->slot = slot;
+                write(slot, blk, val);
+                val = operands(slot, val);
+            }
+            write(slot, blk, val);
+            return val;
+        }
+
+        Inst* SSABuilder::operands(int slot, Inst* phi) const
+        {
+            state.pending.insert(phi);
+            for (auto pred : std::vector<ssa::Block*>(phi->block->preds))
+                state.fn->use(phi, read(slot, pred));
+            state.pending.erase(phi);
+            return trivial(phi);
+        }
+
+        Inst* SSABuilder::trivial(Inst* phi) const
+        {
+            Inst* same = nullptr;
+            for (auto arg : phi->args) {
+                if (arg == same || arg == phi) continue;
+                if (same != nullptr) return phi;
+                same = arg;
+            }
+            if (same == nullptr) {
+                // only reachable through itself
+                auto entry = state.fn->blocks[0].get();
+                same = state.fn->append(entry, Opcode::Const);
+                same->value = nil();
+            }
+
+            std::vector<Inst*> users = {};
+            for (auto user : phi->users)
+                if (user != phi) users.push_back(user);
+            state.fn->replace(phi, same);
+            for (auto& [blk, defs] : state.defs)
+                for (auto& [slot, val] : defs)
+                    if (val == phi) val = same;
+            state.fn->erase(phi);
+
+            // phis using this one may have become trivial too
+            for (auto user : users)
+                if (user->op == Opcode::Phi && user->block != nullptr && !state.pending.count(user)) trivial(user);
+            return same;
+        }
+
+        void SSABuilder::seal(ssa::Block* blk) const
+        {
+            auto phis = std::move(state.incomplete[blk]);
+            state.incomplete.erase(blk);
+            state.sealed.insert(blk);
+            for (const auto& [slot, phi] : phis)
+                operands(slot, phi);
+        }
+
+        void SSABuilder::assign(Storage storage, int depth, int slot, const Token& name, Inst* val) const
+        {
+            if (storage == Storage::Frame) {
+                write(slot, state.cur, val);
+                return;
+            }
+            auto store = emit(Opcode::Store, {val});
+            store->storage = storage;
+            store->depth = depth;
+            store->slot = slot;
+            store->value = name;
+        }
+
+        void SSABuilder::branch(const Stmt<void>* stmt, const Block<void>* blk) const
+        {
+            if (blk != nullptr) blk->accept(*this);
+            else if (stmt != nullptr) stmt->accept(*this);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token SSABuilder::visit_assign(const Assign<Token>& expr) const
+        {
+            auto val = lower(*expr.value);
+            if (expr.storage == Storage::Frame) {
+                val = emit(Opcode::Copy, {val});
+                val->value = expr.name;
+            }
+            assign(expr.storage, expr.depth, expr.slot, expr.name, val);
+            value = val;
+            return {};
+        }
+
+        Token SSABuilder::visit_binary(const Binary<Token>& expr) const
+        {
+            auto fn = state.fn.get();
+            switch (expr.op.type) {
+                case TokenType::NULLISH_COAL: {
+                    auto left = lower(*expr.left);
+                    auto from = state.cur;
+                    auto rhs = fn->block(), join = fn->block();
+                    branch(emit(Opcode::IsNil, {left}), rhs, join);
+                    seal(rhs);
+                    state.cur = rhs;
+                    auto right = lower(*expr.right);
+                    auto back = state.cur;
+                    jump(join);
+                    seal(join);
+                    state.cur = join;
+                    value = merge({{from, left}, {back, right}});
+                    return {};
+                }
+                case TokenType::LOG_AND:
+                case TokenType::LOG_OR: {
+                    bool conj = expr.op.type == TokenType::LOG_AND;
+                    auto rhs = fn->block(), yes = fn->block(), no = fn->block(), join = fn->block();
+                    auto left = lower(*expr.left);
+                    branch(left, conj ? rhs : yes, conj ? no : rhs);
+                    seal(rhs);
+                    state.cur = rhs;
+                    branch(lower(*expr.right), yes, no);
+                    seal(yes);
+                    seal(no);
+
+                    state.cur = yes;
+                    auto t = constant(boolean(true, expr.op.line));
+                    jump(join);
+                    state.cur = no;
+                    auto f = constant(boolean(false, expr.op.line));
+                    jump(join);
+                    seal(join);
+                    state.cur = join;
+                    value = merge({{yes, t}, {no, f}});
+                    return {};
+                }
+                default:
+                    break;
+            }
+
+            auto left = lower(*expr.left);
+            auto right = lower(*expr.right);
+            value = emit(Opcode::Binary, {left, right});
+            value->value = expr.op;
+            value->operands = expr.operands;
+            return {};
+        }
+
+        Token SSABuilder::visit_grouping(const Grouping<Token>& expr) const
+        {
+            lower(*expr.expr);
+            return {};
+        }
+
+        Token SSABuilder::visit_literal(const Literal<Token>& expr) const
+        {
+            value = constant(Eval::literal(expr));
+            return {};
+        }
+
+        Token SSABuilder::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            if (expr.storage == Storage::Frame) {
+                value = read(expr.slot, state.cur);
+                return {};
+            }
+            value = emit(Opcode::Load);
+            value->storage = expr.storage;
+            value->depth = expr.depth;
+            value->slot = expr.slot;
+            value->value = expr.value;
+            return {};
+        }
+
+        Token SSABuilder::visit_unary(const Unary<Token>& expr) const
+        {
+            auto right = lower(*expr.expr);
+            if (expr.op.type != TokenType::MINUS && expr.op.type != TokenType::BANG) state.supported = false;
+            value = emit(Opcode::Unary, {right});
+            value->value = expr.op;
+            return {};
+        }
+
+        Token SSABuilder::visit_ternary(const Ternary<Token>& expr) const
+        {
+            auto fn = state.fn.get();
+            auto yes = fn->block(), no = fn->block(), join = fn->block();
+            branch(lower(*expr.condition), yes, no);
+            seal(yes);
+            seal(no);
+
+            state.cur = yes;
+            auto left = lower(*expr.left);
+            auto from = state.cur;
+            jump(join);
+            state.cur = no;
+            auto right = lower(*expr.right);
+            auto back = state.cur;
+            jump(join);
+            seal(join);
+            state.cur = join;
+            value = merge({{from, left}, {back, right}});
+            return {};
+        }
+
+        Token SSABuilder::visit_call(const Call<Token>& expr) const
+        {
+            // arguments first, then the callee (as the vms do)
+            std::vector<Inst*> args = {nullptr};
+            for (const auto& arg : expr.args)
+                args.push_back(lower(*arg));
+            if (expr.storage == Storage::Frame) {
+                args[0] = read(expr.slot, state.cur);
+            } else {
+                args[0] = emit(Opcode::Load);
+                args[0]->storage = expr.storage;
+                args[0]->depth = expr.depth;
+                args[0]->slot = expr.slot;
+                args[0]->value = expr.name;
+            }
+
+            value = emit(Opcode::Call, std::move(args));
+            value->value = expr.name;
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void SSABuilder::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            lower(*stmt.expr);
+        }
+
+        void SSABuilder::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            emit(Opcode::Print, {lower(*stmt.expr)});
+        }
+
+        void SSABuilder::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            auto fn = state.fn.get();
+            auto join = fn->block();
+
+            // if, then each elif, the first one holding runs
+            std::vector<const StmtIf<void>::Stmt*> clauses = {stmt.if_stmt};
+            clauses.insert(clauses.end(), stmt.elif_stmts.begin(), stmt.elif_stmts.end());
+            for (auto clause : clauses) {
+                auto cond = lower(*clause->expr);
+                auto then = fn->block(), next = fn->block();
+                branch(cond, then, next);
+                seal(then);
+                seal(next);
+                state.cur = then;
+                branch(clause->stmt.get(), clause->blk.get());
+                jump(join);
+                state.cur = next;
+            }
+
+            if (stmt.else_stmt != nullptr)
+                branch(stmt.else_stmt->stmt.get(), stmt.else_stmt->blk.get());
+            jump(join);
+            seal(join);
+            state.cur = join;
+        }
+
+        void SSABuilder::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            auto val = stmt.expr != nullptr ? lower(*stmt.expr) : constant(nil());
+            emit(Opcode::Return, {val});
+
+            // whatever follows is unreachable
+            state.cur = state.fn->block();
+            state.sealed.insert(state.cur);
+        }
+
+        void SSABuilder::visit_block_stmt(const Block<void>& block) const
+        {
+            if (block.scoped())
+                emit(Opcode::Enter)->slot = block.slots;
+            for (const auto& decl : block.decls)
+                decl->accept(*this);
+            if (block.scoped())
+                emit(Opcode::Leave);
+        }
+
+        void SSABuilder::visit_for_stmt(const For<void>& decl) const
+        {
+            if (decl.decl != nullptr) decl.decl->accept(*this);
+            else if (decl.stmt_l != nullptr) decl.stmt_l->accept(*this);
+
+            // the frame slots are values here, nothing to make room for
+            decl.preheader([](int) {}, [this](const Assign<Token>& inv) { lower(inv); });
+
+            // the header isn't sealed until the back edge is there
+            auto fn = state.fn.get();
+            auto header = fn->block(), body = fn->block(), exit = fn->block();
+            jump(header);
+            state.cur = header;
+            branch(lower(*decl.expr), body, exit);
+            seal(body);
+
+            state.cur = body;
+            if (decl.stmt_o != nullptr) decl.stmt_o->accept(*this);
+            else if (decl.blk != nullptr) decl.blk->accept(*this);
+            if (decl.stmt_r != nullptr) decl.stmt_r->accept(*this);
+            jump(header);
+            seal(header);
+            seal(exit);
+            state.cur = exit;
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token SSABuilder::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            decl.stmt->accept(*this);
+            return {};
+        }
+
+        Token SSABuilder::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            // an initializer is an assignment (resolver)
+            if (decl.expr != nullptr)
+                lower(*decl.expr);
+            else
+                assign(decl.storage, 0, decl.slot, decl.identifier, constant(nil(decl.identifier.line)));
+            return {};
+        }
+
+        Token SSABuilder::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            const auto& func = *decl.func;
+
+            // a declaration without a body binds nil (as in Eval)
+            Inst* val = nullptr;
+            if (func.defined()) {
+                val = emit(Opcode::Closure);
+                val->value = func.name;
+                val->func = &func;
+                // nested functions follow the one declaring them
+                size_t at = built.size();
+                built.push_back(nullptr);
+                auto fn = build(func);
+                built[at] = std::move(fn);
+            } else {
+                val = constant(nil(func.name.line));
+            }
+            assign(decl.storage, 0, decl.slot, func.name, val);
+            return {};
+        }
+
+        Token SSABuilder::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            // classes only exist in the tree walker for now
+            state.supported = false;
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens SSABuilder::visit_program(const Program<Tokens>& prgm) const
+        {
+            for (const auto& decl : prgm.decls)
+                decl->accept(*this);
+            return {};
+        }
+    }
+}
@@ -0,0 +1,726 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <ast/thunk.hh>
+#include <ast/parser.hh>
+#include <ast/resolver.hh>
+#include <error/error.hh>
+#include <iostream>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        /// @brief int arithmetic wraps (as the 32 bit ints of the tree walker do)
+        static inline int32_t wrap(int64_t value)
+        {
+            return static_cast<int32_t>(static_cast<uint32_t>(value));
+        }
+
+        /// @brief a binary operator, ints inline & every other pair of values as Eval evaluates it
+        template <TokenType T>
+        static inline Value apply(const Value& l, const Value& r, const Token& op)
+        {
+            if (l.type == Value::Type::Int && r.type == Value::Type::Int) {
+                if constexpr (T == TokenType::PLUS) return Value::integer(wrap(int64_t(l.i) + r.i));
+                else if constexpr (T == TokenType::MINUS) return Value::integer(wrap(int64_t(l.i) - r.i));
+                else if constexpr (T == TokenType::STAR) return Value::integer(wrap(int64_t(l.i) * r.i));
+                else if constexpr (T == TokenType::SLASH) {
+                    if (r.i == 0) rift::error::runTimeError("Division by zero");
+                    return Value::integer(wrap(int64_t(l.i) / r.i));
+                }
+                else if constexpr (T == TokenType::LESS) return Value::boolean(l.i < r.i);
+                else if constexpr (T == TokenType::LESS_EQUAL) return Value::boolean(l.i <= r.i);
+                else if constexpr (T == TokenType::GREATER) return Value::boolean(l.i > r.i);
+                else if constexpr (T == TokenType::GREATER_EQUAL) return Value::boolean(l.i >= r.i);
+                else if constexpr (T == TokenType::EQUAL_EQUAL) return Value::boolean(l.i == r.i);
+                else return Value::boolean(l.i != r.i);
+            }
+            return Value::from(Eval::binary(op, l.to(op.line), r.to(op.line)));
+        }
+
+        /// @brief where a binary operator's operands come from: a frame slot (a: left, b: right),
+        ///        the constant or the thunks (first: left, last: right)
+        struct Local
+        {
+            static inline const Value& left(const Thunk& t, Activation& act) { return act.slots[t.a]; }
+            static inline const Value& right(const Thunk& t, Activation& act) { return act.slots[t.b]; }
+        };
+        struct Const
+        {
+            static inline const Value& right(const Thunk& t, Activation& act) { return t.k; }
+        };
+        struct Any
+        {
+            static inline Value left(const Thunk& t, Activation& act) { return t.kids.front()(act); }
+            static inline Value right(const Thunk& t, Activation& act) { return t.kids.back()(act); }
+        };
+
+        template <TokenType T, class L, class R>
+        static Value binary(const Thunk& t, Activation& act)
+        {
+            decltype(auto) l = L::left(t, act);
+            decltype(auto) r = R::right(t, act);
+            return apply<T>(l, r, t.op);
+        }
+
+        /// @brief the operands of a Binary, as the thunk reads them
+        enum class Operand : uint8_t { Local, Const, Any };
+
+        template <TokenType T>
+        static Thunk::Fn specialize(Operand left, Operand right)
+        {
+            if (left == Operand::Local && right == Operand::Local) return binary<T, Local, Local>;
+            if (left == Operand::Local && right == Operand::Const) return binary<T, Local, Const>;
+            if (right == Operand::Local) return binary<T, Any, Local>;
+            if (right == Operand::Const) return binary<T, Any, Const>;
+            return binary<T, Any, Any>;
+        }
+
+        static Thunk::Fn specialize(TokenType type, Operand left, Operand right)
+        {
+            switch (type) {
+                case TokenType::PLUS: return specialize<TokenType::PLUS>(left, right);
+                case TokenType::MINUS: return specialize<TokenType::MINUS>(left, right);
+                case TokenType::STAR: return specialize<TokenType::STAR>(left, right);
+                case TokenType::SLASH: return specialize<TokenType::SLASH>(left, right);
+                case TokenType::LESS: return specialize<TokenType::LESS>(left, right);
+                case TokenType::LESS_EQUAL: return specialize<TokenType::LESS_EQUAL>(left, right);
+                case TokenType::GREATER: return specialize<TokenType::GREATER>(left, right);
+                case TokenType::GREATER_EQUAL: return specialize<TokenType::GREATER_EQUAL>(left, right);
+                case TokenType::EQUAL_EQUAL: return specialize<TokenType::EQUAL_EQUAL>(left, right);
+                case TokenType::BANG_EQUAL: return specialize<TokenType::BANG_EQUAL>(left, right);
+                default: return nullptr;
+            }
+        }
+
+        #pragma mark - Thunks
+
+        static Value constant(const Thunk& t, Activation& act) { return t.k; }
+        static Value local(const Thunk& t, Activation& act) { return act.slots[t.a]; }
+        static Value boxed(const Thunk& t, Activation& act) { return act.scope->at(t.b, t.a); }
+        static Value upvalue(const Thunk& t, Activation& act) { return act.closure->cells[t.a].get(); }
+        static Value global(const Thunk& t, Activation& act) { return Globals::getInstance().values[t.a]; }
+
+        static Value set_local(const Thunk& t, Activation& act) { return act.slots[t.a] = t.kids[0](act); }
+        static Value set_boxed(const Thunk& t, Activation& act)
+        {
+            Value val = t.kids[0](act);
+            return act.scope->at(t.b, t.a) = std::move(val);
+        }
+        static Value set_upvalue(const Thunk& t, Activation& act)
+        {
+            Value val = t.kids[0](act);
+            return act.closure->cells[t.a].get() = std::move(val);
+        }
+        static Value set_global(const Thunk& t, Activation& act)
+        {
+            Value val = t.kids[0](act);
+            return Globals::getInstance().values[t.a] = std::move(val);
+        }
+        static Value define(const Thunk& t, Activation& act)
+        {
+            Value val = t.kids[0](act);
+            auto& global = Globals::getInstance().values[t.a];
+            if (!act.interactive && !global.nil())
+                rift::error::runTimeError("Function '" + t.op.lexeme + "' already defined");
+            return global = std::move(val);
+        }
+
+        // the short circuiting ones only evaluate what they need (as Eval does)
+        static Value both(const Thunk& t, Activation& act)
+        {
+            return Value::boolean(t.kids[0](act).truthy() && t.kids[1](act).truthy());
+        }
+        static Value either(const Thunk& t, Activation& act)
+        {
+            return Value::boolean(t.kids[0](act).truthy() || t.kids[1](act).truthy());
+        }
+        static Value nullish(const Thunk& t, Activation& act)
+        {
+            Value left = t.kids[0](act);
+            return left.nil() ? t.kids[1](act) : left;
+        }
+
+        static Value negate(const Thunk& t, Activation& act)
+        {
+            Value val = t.kids[0](act);
+            if (val.type == Value::Type::Int) return Value::integer(wrap(-int64_t(val.i)));
+            return Value::from(Eval::unary(t.op, val.to(t.op.line)));
+        }
+        static Value negation(const Thunk& t, Activation& act)
+        {
+            return Value::from(Eval::unary(t.op, t.kids[0](act).to(t.op.line)));
+        }
+        static Value ternary(const Thunk& t, Activation& act)
+        {
+            return t.kids[0](act).truthy() ? t.kids[1](act) : t.kids[2](act);
+        }
+
+        static Value closure(const Thunk& t, Activation& act)
+        {
+            const auto& target = t.proto;
+            auto fn = std::make_shared<Closure>();
+            fn->proto = target;
+            // capture only what the body uses, one shared cell per variable
+            fn->cells.reserve(target->captures.size());
+            for (const auto& capture : target->captures) {
+                if (!capture.local) {
+                    fn->cells.push_back(act.closure->cells[capture.slot]);
+                    continue;
+                }
+                auto env = act.scope;
+                for (int depth = capture.depth; depth > 0; depth--)
+                    env = env->enclosing;
+                fn->cells.push_back({env, capture.slot});
+            }
+            return Value::func(std::move(fn));
+        }
+
+        static Value call(const Thunk& t, Activation& act)
+        {
+            const Site& site = *t.site;
+            const Value* callee = nullptr;
+            switch (site.storage) {
+                case Storage::Global: callee = &Globals::getInstance().values[site.slot]; break;
+                case Storage::Frame: callee = &act.slots[site.slot]; break;
+                case Storage::Boxed: callee = &act.scope->at(site.depth, site.slot); break;
+                case Storage::Upvalue: callee = &act.closure->cells[site.slot].get(); break;
+            }
+            if (callee->type != Value::Type::Func)
+                rift::error::runTimeError("Undefined function '" + site.name.lexeme + "'");
+            auto fn = std::static_pointer_cast<Closure>(callee->ref);
+            Proto& target = *fn->proto;
+
+            // lazily parsed functions get their body (its resolution & thunks) on the first call
+            if (target.lazy != nullptr) {
+                auto& func = *target.lazy;
+                if (Parser::materialize(func))
+                    Resolver().resolve(func);
+                if (!ThunkCompiler().compile(func, target))
+                    rift::error::runTimeError("Function '" + func.name.lexeme + "' uses what only the tree walker runs");
+            }
+
+            Value frame[8];
+            std::vector<Value> heap;
+            Activation callee_act;
+            callee_act.slots = target.frame <= 8 ? frame : (heap.resize(target.frame), heap.data());
+            callee_act.scope = target.boxes > 0 ? std::make_shared<Scope>(nullptr, target.boxes) : nullptr;
+            callee_act.closure = fn.get();
+            callee_act.interactive = act.interactive;
+
+            // arguments are evaluated in the caller straight into the callee's param slots,
+            // captured params go to the function's first heap scope (extras are dropped)
+            for (size_t i = 0, f = 0, b = 0; i < t.kids.size(); i++) {
+                Value val = t.kids[i](act);
+                if (i >= target.params.size()) continue;
+                if (target.params[i] == Storage::Boxed)
+                    callee_act.scope->slots[b++] = std::move(val);
+                else
+                    callee_act.slots[f++] = std::move(val);
+            }
+
+            (*target.body)(callee_act);
+            return callee_act.returning ? std::move(callee_act.ret) : Value();
+        }
+
+        static Value print(const Thunk& t, Activation& act)
+        {
+            Value val = t.kids[0](act);
+            if (val.type == Value::Type::Int) std::cout << val.i << '\n';
+            else if (val.type == Value::Type::Bool) std::cout << (val.b ? "true" : "false") << '\n';
+            else std::cout << Eval::text(val.to(0)) << '\n';
+            return {};
+        }
+
+        static Value conditional(const Thunk& t, Activation& act)
+        {
+            // if, then each elif, the first one holding runs (an odd one out is the else)
+            size_t i = 0;
+            for (; i + 1 < t.kids.size(); i += 2) {
+                if (t.kids[i](act).truthy())
+                    return t.kids[i + 1](act);
+            }
+            if (i < t.kids.size()) t.kids[i](act);
+            return {};
+        }
+
+        static Value ret(const Thunk& t, Activation& act)
+        {
+            act.ret = t.kids.empty() ? Value() : t.kids[0](act);
+            act.returning = true;
+            return {};
+        }
+
+        static Value sequence(const Thunk& t, Activation& act)
+        {
+            for (const auto& kid : t.kids) {
+                kid(act);
+                if (act.returning) break;
+            }
+            return {};
+        }
+
+        /// @brief a block declaring captured locals, in a heap scope of its own
+        static Value scoped(const Thunk& t, Activation& act)
+        {
+            act.scope = std::make_shared<Scope>(std::move(act.scope), t.a);
+            sequence(t, act);
+            act.scope = act.scope->enclosing;
+            return {};
+        }
+
+        /// @note kids: the condition, the body & the increment (if any)
+        static Value loop(const Thunk& t, Activation& act)
+        {
+            const auto& cond = t.kids[0];
+            const auto& body = t.kids[1];
+            while (cond(act).truthy()) {
+                body(act);
+                if (act.returning) break;
+                if (t.a) t.kids[2](act);
+            }
+            return {};
+        }
+
+        static Value nothing(const Thunk& t, Activation& act) { return {}; }
+
+        static Value record(const Thunk& t, Activation& act)
+        {
+            act.results->push_back(t.kids[0](act));
+            return {};
+        }
+
+        static inline Thunk make(Thunk::Fn fn, std::vector<Thunk> kids = {})
+        {
+            Thunk t;
+            t.fn = fn;
+            t.kids = std::move(kids);
+            return t;
+        }
+
+        static inline Thunk make(Value k)
+        {
+            Thunk t;
+            t.fn = constant;
+            t.k = std::move(k);
+            return t;
+        }
+
+        std::shared_ptr<Proto> ThunkCompiler::compile(const std::unique_ptr<Program<Tokens>>& prgm) const
+        {
+            auto script = std::make_shared<Proto>();
+            proto = script.get();
+            supported = true;
+            prgm->accept(*this);
+            script->body = std::make_shared<Thunk>(std::move(out));
+            proto = nullptr;
+            return supported ? script : nullptr;
+        }
+
+        bool ThunkCompiler::compile(const DeclFunc<Token>::Func& func, Proto& target) const
+        {
+            auto outer = std::exchange(proto, &target);
+            auto toplevel = std::exchange(result, false);
+
+            target.name = func.name;
+            target.frame = func.frame;
+            target.boxes = func.boxes;
+            target.params = func.storage;
+            target.captures = func.captures;
+
+            if (func.blk != nullptr) {
+                target.body = std::make_shared<Thunk>(lower(*func.blk));
+                target.lazy = nullptr;
+            }
+
+            proto = outer;
+            result = toplevel;
+            return supported;
+        }
+
+        Thunk ThunkCompiler::lower(const Expr<Token>& expr) const
+        {
+            expr.accept(*this);
+            return std::move(out);
+        }
+
+        Thunk ThunkCompiler::lower(const Stmt<void>& stmt) const
+        {
+            stmt.accept(*this);
+            return std::move(out);
+        }
+
+        Thunk ThunkCompiler::lower(const Decl<Token>& decl) const
+        {
+            decl.accept(*this);
+            return std::move(out);
+        }
+
+        Thunk ThunkCompiler::branch(const Stmt<void>* stmt, const Block<void>* blk) const
+        {
+            if (blk != nullptr) return lower(*blk);
+            if (stmt != nullptr) return lower(*stmt);
+            return make(nothing);
+        }
+
+        Thunk ThunkCompiler::store(Storage storage, int depth, int slot, const str_t& name, Thunk src) const
+        {
+            Thunk t;
+            t.kids.push_back(std::move(src));
+            switch (storage) {
+                case Storage::Frame: reserve(slot); t.fn = set_local; t.a = slot; break;
+                case Storage::Boxed: t.fn = set_boxed; t.a = slot; t.b = depth; break;
+                case Storage::Upvalue: t.fn = set_upvalue; t.a = slot; break;
+                case Storage::Global: t.fn = set_global; t.a = Globals::getInstance().index(name); break;
+            }
+            return t;
+        }
+
+        void ThunkCompiler::reserve(int slot) const
+        {
+            proto->frame = std::max(proto->frame, slot + 1);
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - EXPRESSIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token ThunkCompiler::visit_assign(const Assign<Token>& expr) const
+        {
+            out = store(expr.storage, expr.depth, expr.slot, expr.name.lexeme, lower(*expr.value));
+            return {};
+        }
+
+        Token ThunkCompiler::visit_binary(const Binary<Token>& expr) const
+        {
+            Thunk t;
+            t.op = expr.op;
+            switch (expr.op.type) {
+                case TokenType::NULLISH_COAL: t.fn = nullish; break;
+                case TokenType::LOG_AND: t.fn = both; break;
+                case TokenType::LOG_OR: t.fn = either; break;
+                default: {
+                    // a frame local is read in place, the left one only if evaluating the
+                    // right one cannot write it
+                    auto operand = [](const Expr<Token>& side) {
+                        if (typeid(side) == typeid(Literal<Token>)) return Operand::Const;
+                        if (typeid(side) == typeid(VarExpr<Token>) && static_cast<const VarExpr<Token>&>(side).storage == Storage::Frame)
+                            return Operand::Local;
+                        return Operand::Any;
+                    };
+                    Operand right = operand(*expr.right);
+                    Operand left = right != Operand::Any && operand(*expr.left) == Operand::Local ? Operand::Local : Operand::Any;
+
+                    t.fn = specialize(expr.op.type, left, right);
+                    if (t.fn == nullptr) {
+                        supported = false;
+                        t.fn = nothing;
+                    }
+                    if (left == Operand::Local) {
+                        t.a = static_cast<const VarExpr<Token>&>(*expr.left).slot;
+                        reserve(t.a);
+                    } else {
+                        t.kids.push_back(lower(*expr.left));
+                    }
+                    if (right == Operand::Local) {
+                        t.b = static_cast<const VarExpr<Token>&>(*expr.right).slot;
+                        reserve(t.b);
+                    } else if (right == Operand::Const) {
+                        t.k = Value::from(Eval::literal(static_cast<const Literal<Token>&>(*expr.right)));
+                    } else {
+                        t.kids.push_back(lower(*expr.right));
+                    }
+                    out = std::move(t);
+                    return {};
+                }
+            }
+            t.kids.push_back(lower(*expr.left));
+            t.kids.push_back(lower(*expr.right));
+            out = std::move(t);
+            return {};
+        }
+
+        Token ThunkCompiler::visit_grouping(const Grouping<Token>& expr) const
+        {
+            out = lower(*expr.expr);
+            return {};
+        }
+
+        Token ThunkCompiler::visit_literal(const Literal<Token>& expr) const
+        {
+            out = make(Value::from(Eval::literal(expr)));
+            return {};
+        }
+
+        Token ThunkCompiler::visit_var_expr(const VarExpr<Token>& expr) const
+        {
+            Thunk t;
+            switch (expr.storage) {
+                case Storage::Frame: reserve(expr.slot); t.fn = local; t.a = expr.slot; break;
+                case Storage::Boxed: t.fn = boxed; t.a = expr.slot; t.b = expr.depth; break;
+                case Storage::Upvalue: t.fn = upvalue; t.a = expr.slot; break;
+                case Storage::Global: t.fn = global; t.a = Globals::getInstance().index(expr.value.lexeme); break;
+            }
+            out = std::move(t);
+            return {};
+        }
+
+        Token ThunkCompiler::visit_unary(const Unary<Token>& expr) const
+        {
+            Thunk t;
+            if (expr.op.type == TokenType::MINUS) t.fn = negate;
+            else if (expr.op.type == TokenType::BANG) t.fn = negation;
+            else {
+                supported = false;
+                t.fn = nothing;
+            }
+            t.op = expr.op;
+            t.kids.push_back(lower(*expr.expr));
+            out = std::move(t);
+            return {};
+        }
+
+        Token ThunkCompiler::visit_ternary(const Ternary<Token>& expr) const
+        {
+            std::vector<Thunk> kids;
+            kids.push_back(lower(*expr.condition));
+            kids.push_back(lower(*expr.left));
+            kids.push_back(lower(*expr.right));
+            out = make(ternary, std::move(kids));
+            return {};
+        }
+
+        Token ThunkCompiler::visit_call(const Call<Token>& expr) const
+        {
+            auto site = std::make_shared<Site>();
+            site->name = expr.name;
+            site->storage = expr.storage;
+            site->depth = expr.depth;
+            site->slot = expr.storage == Storage::Global ? Globals::getInstance().index(expr.name.lexeme) : expr.slot;
+            if (expr.storage == Storage::Frame)
+                reserve(expr.slot);
+
+            // the callee's params take their arguments in order
+            std::vector<Thunk> kids;
+            for (const auto& arg : expr.args)
+                kids.push_back(lower(*arg));
+            site->args = expr.args.size();
+            out = make(call, std::move(kids));
+            out.site = std::move(site);
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - STATEMENTS
+        ////////////////////////////////////////////////////////////////////////
+
+        void ThunkCompiler::visit_expr_stmt(const StmtExpr<void>& stmt) const
+        {
+            out = lower(*stmt.expr);
+        }
+
+        void ThunkCompiler::visit_print_stmt(const StmtPrint<void>& stmt) const
+        {
+            std::vector<Thunk> kids;
+            kids.push_back(lower(*stmt.expr));
+            out = make(print, std::move(kids));
+        }
+
+        void ThunkCompiler::visit_if_stmt(const StmtIf<void>& stmt) const
+        {
+            std::vector<Thunk> kids;
+            kids.push_back(lower(*stmt.if_stmt->expr));
+            kids.push_back(branch(stmt.if_stmt->stmt.get(), stmt.if_stmt->blk.get()));
+            for (const auto& elif_stmt : stmt.elif_stmts) {
+                kids.push_back(lower(*elif_stmt->expr));
+                kids.push_back(branch(elif_stmt->stmt.get(), elif_stmt->blk.get()));
+            }
+            if (stmt.else_stmt != nullptr)
+                kids.push_back(branch(stmt.else_stmt->stmt.get(), stmt.else_stmt->blk.get()));
+            out = make(conditional, std::move(kids));
+        }
+
+        void ThunkCompiler::visit_return_stmt(const StmtReturn<void>& stmt) const
+        {
+            std::vector<Thunk> kids;
+            if (stmt.expr != nullptr)
+                kids.push_back(lower(*stmt.expr));
+            out = make(ret, std::move(kids));
+        }
+
+        void ThunkCompiler::visit_block_stmt(const Block<void>& block) const
+        {
+            reserve(block.frame - 1);
+            std::vector<Thunk> kids;
+            for (const auto& decl : block.decls)
+                kids.push_back(lower(*decl));
+            out = make(block.scoped() ? scoped : sequence, std::move(kids));
+            out.a = block.slots;
+        }
+
+        void ThunkCompiler::visit_for_stmt(const For<void>& decl) const
+        {
+            // the initializer & the pre-header, then the loop
+            std::vector<Thunk> pre;
+            if (decl.decl != nullptr) pre.push_back(lower(*decl.decl));
+            else if (decl.stmt_l != nullptr) pre.push_back(lower(*decl.stmt_l));
+            decl.preheader([this](int frame) { reserve(frame - 1); },
+                           [this, &pre](const Assign<Token>& inv) { pre.push_back(lower(inv)); });
+
+            std::vector<Thunk> kids;
+            kids.push_back(lower(*decl.expr));
+            kids.push_back(branch(decl.stmt_o.get(), decl.blk.get()));
+            if (decl.stmt_r != nullptr) kids.push_back(lower(*decl.stmt_r));
+            auto body = make(loop, std::move(kids));
+            body.a = decl.stmt_r != nullptr;
+
+            pre.push_back(std::move(body));
+            out = make(sequence, std::move(pre));
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - DECLARATIONS
+        ////////////////////////////////////////////////////////////////////////
+
+        Token ThunkCompiler::visit_decl_stmt(const DeclStmt<Token>& decl) const
+        {
+            bool toplevel = std::exchange(result, false);
+            // a top level expression results in its value (as in Eval)
+            if (toplevel && typeid(*decl.stmt) == typeid(StmtExpr<void>)) {
+                out = make(record, {lower(*static_cast<const StmtExpr<void>&>(*decl.stmt).expr)});
+                return {};
+            }
+            out = lower(*decl.stmt);
+            if (toplevel) {
+                std::vector<Thunk> kids;
+                kids.push_back(std::move(out));
+                kids.push_back(make(record, {make(Value())}));
+                out = make(sequence, std::move(kids));
+            }
+            return {};
+        }
+
+        Token ThunkCompiler::visit_decl_var(const DeclVar<Token>& decl) const
+        {
+            bool toplevel = std::exchange(result, false);
+            if (decl.expr != nullptr) {
+                out = lower(*decl.expr);
+                if (toplevel) out = make(record, {std::move(out)});
+                return {};
+            }
+
+            out = store(decl.storage, 0, decl.slot, decl.identifier.lexeme, make(Value()));
+            if (toplevel) {
+                std::vector<Thunk> kids;
+                kids.push_back(std::move(out));
+                kids.push_back(make(record, {make(Value())}));
+                out = make(sequence, std::move(kids));
+            }
+            return {};
+        }
+
+        Token ThunkCompiler::visit_decl_func(const DeclFunc<Token>& decl) const
+        {
+            bool toplevel = std::exchange(result, false);
+            const auto& func = *decl.func;
+
+            // a declaration without a body binds nil (as in Eval)
+            Thunk fn = make(Value());
+            if (func.defined()) {
+                auto target = std::make_shared<Proto>();
+                target->lazy = func.blk == nullptr ? decl.func.get() : nullptr;
+                if (!compile(func, *target)) return {};
+                fn = make(closure);
+                fn.proto = std::move(target);
+            }
+
+            if (decl.storage == Storage::Global) {
+                out = make(define, {});
+                out.kids.push_back(std::move(fn));
+                out.a = Globals::getInstance().index(func.name.lexeme);
+                out.op = func.name;
+            } else {
+                out = store(decl.storage, 0, decl.slot, func.name.lexeme, std::move(fn));
+            }
+
+            if (toplevel) {
+                std::vector<Thunk> kids;
+                kids.push_back(std::move(out));
+                kids.push_back(make(record, {make(Value::boxed(func.name))}));
+                out = make(sequence, std::move(kids));
+            }
+            return {};
+        }
+
+        Token ThunkCompiler::visit_decl_class(const DeclClass<Token>& decl) const
+        {
+            // classes only exist in the tree walker for now
+            supported = false;
+            out = make(nothing);
+            return {};
+        }
+
+        ////////////////////////////////////////////////////////////////////////
+        #pragma mark - PROGRAM
+        ////////////////////////////////////////////////////////////////////////
+
+        Tokens ThunkCompiler::visit_program(const Program<Tokens>& prgm) const
+        {
+            std::vector<Thunk> kids;
+            for (const auto& decl : prgm.decls) {
+                result = true;
+                kids.push_back(lower(*decl));
+            }
+            result = false;
+            out = make(sequence, std::move(kids));
+            return {};
+        }
+
+        #pragma mark - Machine
+
+        std::vector<string> ThunkMachine::evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive)
+        {
+            auto script = ThunkCompiler().compile(prgm);
+            if (script == nullptr)
+                return Eval().evaluate(prgm, interactive);
+            return run(script, interactive);
+        }
+
+        std::vector<string> ThunkMachine::run(const std::shared_ptr<Proto>& script, bool interactive)
+        {
+            std::vector<Value> results = {};
+            std::vector<Value> frame(script->frame);
+
+            // a return outside any function ends the script
+            Activation act;
+            act.slots = frame.data();
+            act.interactive = interactive;
+            act.results = &results;
+            try {
+                (*script->body)(act);
+            } catch (const std::runtime_error& e) {
+                error::runTimeError(e.what());
+            }
+            std::cout << std::flush;
+
+            std::vector<string> res;
+            for (const auto& val : results)
+                res.push_back(Eval::show(val.to(0)));
+            return res;
+        }
+    }
+}
@@ -0,0 +1,283 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+#include <ast/vm.hh>
+#include <ast/parser.hh>
+#include <ast/resolver.hh>
+#include <error/error.hh>
+#include <iostream>
+
+namespace rift
+{
+    namespace ast
+    {
+        #pragma mark - Helpers
+
+        /// @brief int arithmetic wraps (as the 32 bit ints of the tree walker do)
+        static inline int32_t wrap(int64_t value)
+        {
+            return static_cast<int32_t>(static_cast<uint32_t>(value));
+        }
+
+        void Machine::reset()
+        {
+            Globals::getInstance().clear();
+        }
+
+        std::vector<string> Machine::evaluate(std::unique_ptr<Program<Tokens>>& prgm, bool interactive)
+        {
+            auto script = Compiler().compile(prgm);
+            if (script == nullptr)
+                return Eval().evaluate(prgm, interactive);
+            return run(script, interactive);
+        }
+
+        #pragma mark - Dispatch
+
+        std::vector<string> Machine::run(const std::shared_ptr<Proto>& script, bool interactive)
+        {
+            std::vector<Value> results = {};
+            auto& globals = Globals::getInstance().values;
+
+            const Proto* proto = script.get();
+            const uint8_t* code = proto->code.data();
+            const uint8_t* ip = code;
+            size_t base = 0;
+            std::shared_ptr<Scope> scope = nullptr;
+            std::shared_ptr<Closure> closure = nullptr;
+
+            stack.clear();
+            frames.clear();
+            locals.assign(proto->frame, Value());
+
+            #define READ() (ip += 2, static_cast<uint16_t>(ip[-2] | (ip[-1] << 8)))
+            #define TARGET() (ip += 4, static_cast<uint32_t>(ip[-4] | (ip[-3] << 8) | (ip[-2] << 16) | (ip[-1] << 24)))
+            #define TOP() stack.back()
+            #define PEEK(n) stack[stack.size() - 1 - (n)]
+
+            // the ints take the inline path, every other pair of values the evaluator's
+            #define BINARY(fast) { \
+                const Token& op = proto->ops[READ()]; \
+                Value& l = PEEK(1); const Value& r = PEEK(0); \
+                if (l.type == Value::Type::Int && r.type == Value::Type::Int) { fast; } \
+                else l = Value::from(Eval::binary(op, l.to(op.line), r.to(op.line))); \
+                stack.pop_back(); \
+                break; \
+            }
+
+            try {
+                for (;;) {
+                    switch (static_cast<Op>(*ip++)) {
+                        case Op::Const: stack.push_back(proto->constants[READ()]); break;
+                        case Op::Nil: stack.emplace_back(); break;
+                        case Op::True: stack.push_back(Value::boolean(true)); break;
+                        case Op::False: stack.push_back(Value::boolean(false)); break;
+                        case Op::Pop: stack.pop_back(); break;
+                        case Op::Dup: stack.push_back(TOP()); break;
+
+                        case Op::GetLocal: stack.push_back(locals[base + READ()]); break;
+                        case Op::SetLocal: locals[base + READ()] = std::move(TOP()); stack.pop_back(); break;
+                        case Op::GetBoxed: {
+                            int depth = READ();
+                            stack.push_back(scope->at(depth, READ()));
+                            break;
+                        }
+                        case Op::SetBoxed: {
+                            int depth = READ();
+                            scope->at(depth, READ()) = std::move(TOP());
+                            stack.pop_back();
+                            break;
+                        }
+                        case Op::GetUpvalue: stack.push_back(closure->cells[READ()].get()); break;
+                        case Op::SetUpvalue: closure->cells[READ()].get() = std::move(TOP()); stack.pop_back(); break;
+                        case Op::GetGlobal: stack.push_back(globals[READ()]); break;
+                        case Op::SetGlobal: globals[READ()] = std::move(TOP()); stack.pop_back(); break;
+                        case Op::DefineFunc: {
+                            auto& global = globals[READ()];
+                            const auto& name = proto->ops[READ()];
+                            if (!interactive && !global.nil())
+                                rift::error::runTimeError("Function '" + name.lexeme + "' already defined");
+                            global = std::move(TOP());
+                            stack.pop_back();
+                            break;
+                        }
+
+                        case Op::Add: BINARY(l.i = wrap(int64_t(l.i) + r.i))
+                        case Op::Sub: BINARY(l.i = wrap(int64_t(l.i) - r.i))
+                        case Op::Mul: BINARY(l.i = wrap(int64_t(l.i) * r.i))
+                        case Op::Div: BINARY(
+                            if (r.i == 0) rift::error::runTimeError("Division by zero");
+                            l.i = wrap(int64_t(l.i) / r.i))
+                        case Op::Less: BINARY(l = Value::boolean(l.i < r.i))
+                        case Op::LessEqual: BINARY(l = Value::boolean(l.i <= r.i))
+                        case Op::Greater: BINARY(l = Value::boolean(l.i > r.i))
+                        case Op::GreaterEqual: BINARY(l = Value::boolean(l.i >= r.i))
+                        case Op::Equal: BINARY(l = Value::boolean(l.i == r.i))
+                        case Op::NotEqual: BINARY(l = Value::boolean(l.i != r.i))
+                        case Op::Negate: {
+                            const Token& op = proto->ops[READ()];
+                            if (TOP().type == Value::Type::Int) TOP().i = wrap(-int64_t(TOP().i));
+                            else TOP() = Value::from(Eval::unary(op, TOP().to(op.line)));
+                            break;
+                        }
+                        case Op::Not: {
+                            const Token& op = proto->ops[READ()];
+                            TOP() = Value::from(Eval::unary(op, TOP().to(op.line)));
+                            break;
+                        }
+
+                        case Op::Jump: {
+                            auto target = TARGET();
+                            ip = code + target;
+                            break;
+                        }
+                        case Op::JumpIfFalse: {
+                            auto target = TARGET();
+                            if (!TOP().truthy()) ip = code + target;
+                            stack.pop_back();
+                            break;
+                        }
+                        case Op::JumpIfTrue: {
+                            auto target = TARGET();
+                            if (TOP().truthy()) ip = code + target;
+                            stack.pop_back();
+                            break;
+                        }
+                        case Op::JumpIfNotNil: {
+                            auto target = TARGET();
+                            if (!TOP().nil()) ip = code + target;
+                            else stack.pop_back();
+                            break;
+                        }
+
+                        case Op::PushScope: scope = std::make_shared<Scope>(std::move(scope), READ()); break;
+                        case Op::PopScope: scope = scope->enclosing; break;
+                        case Op::Closure: {
+                            const auto& target = proto->protos[READ()];
+                            auto fn = std::make_shared<Closure>();
+                            fn->proto = target;
+                            // capture only what the body uses, one shared cell per variable
+                            fn->cells.reserve(target->captures.size());
+                            for (const auto& capture : target->captures) {
+                                if (!capture.local) {
+                                    fn->cells.push_back(closure->cells[capture.slot]);
+                                    continue;
+                                }
+                                auto env = scope;
+                                for (int depth = capture.depth; depth > 0; depth--)
+                                    env = env->enclosing;
+                                fn->cells.push_back({env, capture.slot});
+                            }
+                            stack.push_back(Value::func(std::move(fn)));
+                            break;
+                        }
+                        case Op::Call: {
+                            const Site& site = proto->sites[READ()];
+                            const Value* callee = nullptr;
+                            switch (site.storage) {
+                                case Storage::Global: callee = &globals[site.slot]; break;
+                                case Storage::Frame: callee = &locals[base + site.slot]; break;
+                                case Storage::Boxed: callee = &scope->at(site.depth, site.slot); break;
+                                case Storage::Upvalue: callee = &closure->cells[site.slot].get(); break;
+                            }
+                            if (callee->type != Value::Type::Func)
+                                rift::error::runTimeError("Undefined function '" + site.name.lexeme + "'");
+                            auto fn = std::static_pointer_cast<Closure>(callee->ref);
+                            Proto& target = *fn->proto;
+
+                            // lazily parsed functions get their body (its resolution & code) on the first call
+                            if (target.lazy != nullptr) {
+                                auto& func = *target.lazy;
+                                if (Parser::materialize(func))
+                                    Resolver().resolve(func);
+                                if (!Compiler().compile(func, target))
+                                    rift::error::runTimeError("Function '" + func.name.lexeme + "' uses what only the tree walker runs");
+                            }
+
+                            // push a frame, captured params go to the function's first heap scope
+                            size_t args = stack.size() - site.args;
+                            size_t frame = locals.size();
+                            locals.resize(frame + target.frame);
+                            auto boxes = target.boxes > 0 ? std::make_shared<Scope>(nullptr, target.boxes) : nullptr;
+                            for (size_t i = 0, f = 0, b = 0; i < target.params.size(); i++) {
+                                Value val = i < site.args ? std::move(stack[args + i]) : Value();
+                                if (target.params[i] == Storage::Boxed)
+                                    boxes->slots[b++] = std::move(val);
+                                else
+                                    locals[frame + f++] = std::move(val);
+                            }
+                            stack.resize(args);
+
+                            frames.push_back({proto, ip, base, std::move(scope), std::move(closure)});
+                            proto = &target;
+                            code = ip = target.code.data();
+                            base = frame;
+                            scope = std::move(boxes);
+                            closure = std::move(fn);
+                            break;
+                        }
+                        case Op::Return:
+                        case Op::ReturnNil: {
+                            Value result = static_cast<Op>(ip[-1]) == Op::Return ? std::move(TOP()) : Value();
+                            if (static_cast<Op>(ip[-1]) == Op::Return) stack.pop_back();
+                            // a return outside any function ends the script
+                            if (frames.empty()) goto halt;
+
+                            locals.resize(base);
+                            auto& caller = frames.back();
+                            proto = caller.proto;
+                            code = proto->code.data();
+                            ip = caller.ip;
+                            base = caller.base;
+                            scope = std::move(caller.scope);
+                            closure = std::move(caller.closure);
+                            frames.pop_back();
+                            stack.push_back(std::move(result));
+                            break;
+                        }
+
+                        case Op::Print: {
+                            const auto& val = TOP();
+                            if (val.type == Value::Type::Int) std::cout << val.i << '\n';
+                            else if (val.type == Value::Type::Bool) std::cout << (val.b ? "true" : "false") << '\n';
+                            else std::cout << Eval::text(val.to(0)) << '\n';
+                            stack.pop_back();
+                            break;
+                        }
+                        case Op::Result:
+                            results.push_back(std::move(TOP()));
+                            stack.pop_back();
+                            break;
+                        case Op::Halt:
+                            goto halt;
+                    }
+                }
+            } catch (const std::runtime_error& e) {
+                error::runTimeError(e.what());
+            }
+            halt:
+            std::cout << std::flush;
+
+            #undef READ
+            #undef TARGET
+            #undef TOP
+            #undef PEEK
+            #undef BINARY
+
+            std::vector<string> res;
+            for (const auto& val : results)
+                res.push_back(Eval::show(val.to(0)));
+            return res;
+        }
+    }
+}
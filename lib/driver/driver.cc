@@ -17,6 +17,9 @@
 #include <fstream> // file stream
 #include <sstream> // string stream
 #include <vector>
+#include <iomanip>
+#include <algorithm>
+#include <cctype>
 #include <driver/driver.hh>
 #include <error/error.hh>
 
@@ -25,6 +28,14 @@
 #include <ast/parser.hh>
 #include <scanner/scanner.hh>
 #include <ast/eval.hh>
+#include <ast/resolver.hh>
+#include <ast/cache.hh>
+#include <ast/passes.hh>
+#include <ast/vm.hh>
+#include <ast/regvm.hh>
+#include <ast/thunk.hh>
+#include <ast/ssa.hh>
+#include <ast/emitc.hh>
 #include <string>
 
 using namespace rift::error;
@@ -37,22 +48,80 @@ namespace rift
     {
         # pragma mark - Driver Tools
 
-        void run(std::string lines, bool interactive)
+        void Driver::run(std::string lines, bool interactive)
         {
-            std::istringstream scanner(lines);
-            std::shared_ptr<std::vector<char>> source = std::make_shared<std::vector<char>>(std::istreambuf_iterator<char>(scanner), std::istreambuf_iterator<char>()); 
-            
-            Scanner riftScanner(source);
-            riftScanner.scan_source();
-
-            std::shared_ptr<std::vector<Token>> tokensPtr = std::make_shared<std::vector<Token>>(riftScanner.tokens);
-            Parser riftParser(tokensPtr);
-            std::unique_ptr<Program<Tokens>> statements = riftParser.parse(); 
-
-            Eval riftEvaluator;
-            riftEvaluator.evaluate(statements, interactive);
-            rift::ast::Environment::getInstance(true).printState();
-            rift::ast::Environment::getInstance(false).printState();
+            std::unique_ptr<Program<Tokens>> statements = nullptr;
+            size_t copied = Token::copies;
+            // the cached tree is optimized, so the pipeline is part of its key
+            Cache astCache(cache && !interactive ? Cache::defaultDir() : "", Cache::pipeline(RIFT_VERSION, level, inlineSize, ctfeSteps, lazy));
+
+            // unchanged scripts skip the scanner, parser & resolver entirely
+            statements = astCache.load(lines);
+            if (statements == nullptr) {
+                std::istringstream scanner(lines);
+                std::shared_ptr<std::vector<char>> source = std::make_shared<std::vector<char>>(std::istreambuf_iterator<char>(scanner), std::istreambuf_iterator<char>()); 
+                
+                Scanner riftScanner(source);
+                riftScanner.scan_source();
+
+                std::shared_ptr<std::vector<Token>> tokensPtr = std::make_shared<std::vector<Token>>(riftScanner.tokens);
+                Parser riftParser(tokensPtr, lazy);
+                statements = riftParser.parse(); 
+                if (statements == nullptr) return;
+
+                Resolver riftResolver;
+                riftResolver.resolve(statements);
+
+                PassManager riftPasses = PassManager::pipeline(level, interactive, inlineSize, stats, ctfeSteps);
+                riftPasses.run(statements);
+                if (stats) {
+                    for (const auto& pass : riftPasses.stats())
+                        std::cerr << pass.name << ": " << pass.report << " (" << std::fixed << std::setprecision(3) << pass.ms << " ms, "
+                                  << pass.before << " -> " << pass.after << " nodes)" << std::endl;
+                }
+
+                astCache.store(lines, statements);
+            }
+
+            if (dumpSSA) {
+                for (const auto& fn : SSABuilder().build(statements)) {
+                    ssa::Optimizer().run(*fn);
+                    std::cerr << fn->dump();
+                }
+            }
+
+            if (!emitC.empty() && !interactive) {
+                // out.c builds out, anything else builds <name>.out
+                std::string exe = emitC.ends_with(".c") ? emitC.substr(0, emitC.size() - 2) : emitC + ".out";
+                CEmitter emitter;
+                if (!emitter.build(statements, emitC, exe)) {
+                    std::cerr << "emit-c: " << emitter.error() << std::endl;
+                    errorOccured = true;
+                }
+                return;
+            }
+
+            if (engine == Engine::VM) {
+                Machine riftMachine;
+                riftMachine.evaluate(statements, interactive);
+            } else if (engine == Engine::Register) {
+                RegisterMachine riftMachine(jit);
+                riftMachine.evaluate(statements, interactive);
+                if (jitStats) {
+                    for (const auto& fn : riftMachine.jitted())
+                        std::cerr << "jit: " << fn.name << ": " << fn.bytes << " bytes from " << fn.translated << "/" << fn.instrs
+                                  << " instrs (" << std::fixed << std::setprecision(3) << fn.ms << " ms)" << std::endl;
+                }
+            } else if (engine == Engine::Thunk) {
+                ThunkMachine riftMachine;
+                riftMachine.evaluate(statements, interactive);
+            } else {
+                Eval riftEvaluator;
+                riftEvaluator.evaluate(statements, interactive);
+            }
+
+            if (copyStats)
+                std::cerr << "tokens: " << Token::copies - copied << " copies" << std::endl;
         }
 
         void Driver::runFile(std::string path)
@@ -63,7 +132,7 @@ namespace rift
                 file.seekg(0, std::ios::beg);
                 std::vector<char> buffer(size);
                 if (file.read(buffer.data(), size)) {
-                    run(buffer.data(), false);
+                    run(std::string(buffer.begin(), buffer.end()), false);
                     if (errorOccured) exit(42);
                     if (runtimeErrorOccured) exit(69);
                 }
@@ -88,7 +157,7 @@ namespace rift
 
         void Driver::version()
         {
-            std::cout << "Rift version 0.0.1" << std::endl;
+            std::cout << "Rift version " RIFT_VERSION << std::endl;
             std::cout << "(c) Rift-Team 2024" << std::endl;
             exit(1);
         }
@@ -102,17 +171,41 @@ namespace rift
             std::cout << "  -h, --help        Display this information" << std::endl;
             std::cout << "  -v, --version     Display the version of the program" << std::endl;
             std::cout << "  -i, --interactive Run the interpreter" << std::endl;
+            std::cout << "  --no-cache        Don't read or write the ast cache" << std::endl;
+            std::cout << "  --lazy            Parse function bodies on their first call" << std::endl;
+            std::cout << "  -O0, -O1, -O2     Optimization level (default: -O2)" << std::endl;
+            std::cout << "  --opt-stats       Report each optimization pass, its time & node counts" << std::endl;
+            std::cout << "  --inline-size=N   Inline functions of at most N nodes (0: off)" << std::endl;
+            std::cout << "  --ctfe-steps=N    Evaluate calls to pure functions on constants while compiling," << std::endl;
+            std::cout << "                    in at most N steps each (0: off, default: 10000)" << std::endl;
+            std::cout << "  --copy-stats      Report how many tokens each run copied" << std::endl;
+            std::cout << "  --engine=NAME     Run on eval (tree walker, default), vm (stack bytecode)" << std::endl;
+            std::cout << "                    reg (register bytecode) or thunk (pre-bound closures)" << std::endl;
+            std::cout << "  --jit             Compile hot code to x86-64 (runs on the register vm)" << std::endl;
+            std::cout << "  --jit-stats       Report each compiled function, its size & compile time" << std::endl;
+            std::cout << "  --dump-ssa        Print the optimized ssa form of every function" << std::endl;
+            std::cout << "  --emit-c=FILE     Compile to C in FILE & build it with cc (FILE minus .c)" << std::endl;
             exit(1);
         }
 
+        unsigned Driver::number(const std::string& option, const char* arg)
+        {
+            std::string value = arg != nullptr ? arg : "";
+            bool digits = !value.empty() && value.size() <= 9 && std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); });
+            if (!digits) {
+                std::cout << "Invalid value '" << value << "' for " << option << ", expected a number" << std::endl;
+                help();
+            }
+            return std::stoul(value);
+        }
+
         # pragma mark - Driver
 
         int Driver::parse(int argc, char **argv) 
         {
-            bool passed = false;
+            bool interactive = false;
             int opt = 0, idx = 0;
-            while ((opt = getopt_long(argc, argv, "", opts, &idx)) != -1) {
-                passed = true;
+            while ((opt = getopt_long(argc, argv, "O:", opts, &idx)) != -1) {
                 switch (opt) {
                     case 'h':
                         help();
@@ -120,7 +213,49 @@ namespace rift
                     case 'v':
                         version();
                     case 'i':
-                        runPrompt();
+                        interactive = true;
+                        break;
+                    case 'n':
+                        cache = false;
+                        break;
+                    case 'l':
+                        lazy = true;
+                        break;
+                    case 's':
+                        stats = true;
+                        break;
+                    case 'O':
+                        level = std::min(number("-O", optarg), 2u);
+                        break;
+                    case 'c':
+                        copyStats = true;
+                        break;
+                    case 'I':
+                        inlineSize = number("--inline-size", optarg);
+                        break;
+                    case 'E':
+                        ctfeSteps = number("--ctfe-steps", optarg);
+                        break;
+                    case 'e':
+                        if (std::string(optarg) == "vm") engine = Engine::VM;
+                        else if (std::string(optarg) == "reg") engine = Engine::Register;
+                        else if (std::string(optarg) == "thunk") engine = Engine::Thunk;
+                        else if (std::string(optarg) == "eval") engine = Engine::Eval;
+                        else std::cout << "Invalid engine '" << optarg << "'" << std::endl;
+                        break;
+                    case 'J':
+                        jitStats = true;
+                        [[fallthrough]];
+                    case 'j':
+                        jit = true;
+                        engine = Engine::Register;
+                        break;
+                    case 'D':
+                        dumpSSA = true;
+                        break;
+                    case 'C':
+                        emitC = optarg;
+                        break;
                     default:
                         std::cout << "Invalid option" << std::endl;
                         break;
@@ -128,12 +263,12 @@ namespace rift
                 }
             }
 
-            if (!passed) {
-                if (optind < argc) {
-                    runFile(argv[optind]);
-                } else {
-                    help();
-                }
+            if (interactive) {
+                runPrompt();
+            } else if (optind < argc) {
+                runFile(argv[optind]);
+            } else {
+                help();
             }
 
             return 0;
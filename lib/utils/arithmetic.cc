@@ -48,4 +48,9 @@ namespace rift
         }
         return any();
     }
+
+    any any_arithmetic(const Token& left, const Token& right, const Token& op)
+    {
+        return any_arithmetic(left.getLiteral(), right.getLiteral(), op);
+    }
 }
\ No newline at end of file
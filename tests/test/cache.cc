@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <filesystem>
+#include <unistd.h>
+
+#include "fixture.hh"
+#include <ast/cache.hh>
+
+#pragma mark - Rift Cache (Fixtures)
+
+class RiftCache : public RiftTest {
+
+    protected:
+        RiftCache() {}
+        ~RiftCache() override {}
+};
+
+#pragma mark - Rift Cache (Tests)
+
+TEST_F(RiftCache, roundTrip)
+{
+    auto prgm = parse("mut a = 4; a = a * 10 + 2; print(a); print(\"ri\" + \"ft\");");
+    auto bytes = Serializer().serialize(prgm, 42);
+
+    auto loaded = Deserializer(bytes.data(), bytes.size()).deserialize(42);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(Serializer().serialize(loaded, 42), bytes);
+    EXPECT_EQ(run(loaded), "42\nrift\n");
+}
+
+TEST_F(RiftCache, rejectsStaleEntries)
+{
+    auto prgm = parse("print(1 + 2);");
+    auto bytes = Serializer().serialize(prgm, 7);
+
+    EXPECT_THROW(Deserializer(bytes.data(), bytes.size()).deserialize(8), CacheException);
+    EXPECT_THROW(Deserializer(bytes.data(), bytes.size() - 1).deserialize(7), CacheException);
+}
+
+TEST_F(RiftCache, lazyTreesAreKeyedApart)
+{
+    string src = "func f(x) { return x * 2; } print(f(21));";
+    auto dir = (std::filesystem::temp_directory_path() / ("rift-cache-test-" + std::to_string(getpid()))).string();
+    Cache lazy(dir, Cache::pipeline("test", 2, 16, 10000, true));
+    Cache eager(dir, Cache::pipeline("test", 2, 16, 10000, false));
+
+    auto prgm = parse(src, true);
+    lazy.store(src, prgm);
+
+    // an eager run never maps the tree whose bodies were left unparsed
+    EXPECT_NE(lazy.load(src), nullptr);
+    EXPECT_EQ(eager.load(src), nullptr);
+    prgm = parse(src);
+    eager.store(src, prgm);
+    auto loaded = eager.load(src);
+    ASSERT_NE(loaded, nullptr);
+    EXPECT_EQ(run(loaded), "42\n");
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_F(RiftCache, rejectsCorruptEntries)
+{
+    auto prgm = parse("mut n = 3; { mut a = 1; func add(x) { a = a + x; return a; } for (mut i = 0; i < n; i = i + 1) { print(add(i * n)); } }");
+    auto bytes = Serializer().serialize(prgm, 7);
+
+    // every flipped bit is caught before a node is built
+    for (size_t i = 0; i < bytes.size(); i++) {
+        for (int bit : {0, 3, 7}) {
+            auto flipped = bytes;
+            flipped[i] ^= (char)(1 << bit);
+            EXPECT_THROW(Deserializer(flipped.data(), flipped.size()).deserialize(7), CacheException) << "byte " << i << " bit " << bit;
+        }
+    }
+}
+
+TEST_F(RiftCache, rejectsSlotsOutOfRange)
+{
+    // well formed entries still have their slots checked against where they run: { print(a); }
+    auto entry = [](Storage storage, int slot, int frame) {
+        auto var = std::make_unique<VarExpr<Token>>(Token(TokenType::IDENTIFIER, "a", "a", 1));
+        var->storage = storage;
+        var->depth = 0;
+        var->slot = slot;
+        std::unique_ptr<Expr<Token>> val = std::move(var);
+        Block<void>::vec_prog body;
+        body.push_back(std::make_unique<DeclStmt<Token>>(std::make_unique<StmtPrint<void>>(val)));
+        auto block = std::make_unique<Block<void>>(std::move(body));
+        block->frame = frame;
+        Program<Tokens>::vec_t decls;
+        decls.push_back(std::make_unique<DeclStmt<Token>>(std::move(block)));
+        return Serializer().serialize(std::make_unique<Program<Tokens>>(std::move(decls)), 7);
+    };
+
+    auto bytes = entry(Storage::Frame, 0, 1);
+    EXPECT_NE(Deserializer(bytes.data(), bytes.size()).deserialize(7), nullptr);
+    for (auto bad : {entry(Storage::Frame, 1, 1), entry(Storage::Frame, -1, 1), entry(Storage::Boxed, 0, 1), entry(Storage::Upvalue, 0, 1)})
+        EXPECT_THROW(Deserializer(bad.data(), bad.size()).deserialize(7), CacheException);
+}
@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/fold.hh>
+
+#pragma mark - Rift CTFE (Fixtures)
+
+class RiftCtfe : public RiftTest {
+
+    protected:
+        RiftCtfe() {}
+        ~RiftCtfe() override {}
+
+        /// @return the calls folding with a budget of steps evaluated, the output is checked
+        unsigned evaluated(const string& src, unsigned steps, const string& output) {
+            auto prgm = parse(src);
+            Fold fold(steps);
+            fold.run(prgm);
+            EXPECT_EQ(run(prgm), output);
+            clear();
+            return fold.evaluated();
+        }
+};
+
+#pragma mark - Rift CTFE (Tests)
+
+TEST_F(RiftCtfe, evaluatesPureCallsOnConstants)
+{
+    const string src = "func nextPow2(n) { mut p = 1; for (mut i = 0; n > p; i = i + 1) { p = p * 2; } return p; }\n"
+                       "func slots(n) { return nextPow2(n) - 1; }\n"
+                       "mut! SIZE = nextPow2(1000);\n"
+                       "print(SIZE);\n"
+                       "print(slots(SIZE + 1));";
+    EXPECT_EQ(evaluated(src, 100000, "1024\n2047\n"), 2u);
+    // no budget, nothing runs at compile time
+    EXPECT_EQ(evaluated(src, 0, "1024\n2047\n"), 0u);
+}
+
+TEST_F(RiftCtfe, leavesImpureCallsToTheRuntime)
+{
+    EXPECT_EQ(evaluated("mut count = 0;\n"
+                        "func loud(n) { print(n); return n; }\n"
+                        "func bump(n) { count = count + n; return count; }\n"
+                        "func twice(n) { return loud(n) * 2; }\n"
+                        "print(twice(3)); print(bump(2));", 100000, "3\n6\n2\n"), 0u);
+
+    // a variable isn't a constant
+    EXPECT_EQ(evaluated("func sq(n) { return n * n; }\n"
+                        "mut x = 4; print(sq(x)); print(sq(5));", 100000, "16\n25\n"), 1u);
+}
+
+TEST_F(RiftCtfe, staysWithinItsStepBudget)
+{
+    const string src = "func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                       "print(fib(15));";
+    EXPECT_EQ(evaluated(src, 1000, "610\n"), 0u);
+    EXPECT_EQ(evaluated(src, 100000, "610\n"), 1u);
+}
@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <unistd.h>
+
+#include "fixture.hh"
+#include <ast/emitc.hh>
+
+#pragma mark - Rift C (Fixtures)
+
+class RiftEmitC : public RiftEngine {
+
+    protected:
+        RiftEmitC() {}
+        ~RiftEmitC() override {}
+        void SetUp() override {
+            dir = std::filesystem::temp_directory_path() / ("rift-emitc-" + std::to_string(::getpid()));
+            std::filesystem::create_directories(dir);
+        }
+        void TearDown() override {
+            RiftEngine::TearDown();
+            std::filesystem::remove_all(dir);
+        }
+
+        static bool compiler() { return std::system("cc --version > /dev/null 2>&1") == 0; }
+
+        /// @brief what the program prints built to a native executable
+        string engine(std::unique_ptr<Program<Tokens>>& prgm) override {
+            string path = (dir / "out.c").string(), exe = (dir / "out").string();
+            CEmitter emitter;
+            EXPECT_TRUE(emitter.build(prgm, path, exe)) << emitter.error();
+
+            string actual = "";
+            FILE* out = popen(("'" + exe + "'").c_str(), "r");
+            if (out == nullptr) return actual;
+            char buf[256];
+            for (size_t n; (n = fread(buf, 1, sizeof(buf), out)) > 0; )
+                actual.append(buf, n);
+            pclose(out);
+            return actual;
+        }
+
+        std::filesystem::path dir;
+};
+
+#pragma mark - Rift C (Tests)
+
+TEST_F(RiftEmitC, emitsAFunctionPerDeclaration)
+{
+    auto prgm = parse("func sq(n) { return n * n; }\nfunc two() { return sq(2); }\nprint(two());", 0);
+    CEmitter emitter;
+    string code = emitter.emit(prgm);
+    ASSERT_NE(code, "") << emitter.error();
+    EXPECT_NE(code.find("#include \"rift_rt.h\""), string::npos);
+    EXPECT_NE(code.find("int main(void)"), string::npos);
+    EXPECT_NE(code.find("/* sq */"), string::npos);
+    EXPECT_NE(code.find("/* two */"), string::npos);
+    EXPECT_NE(code.find("rt_call("), string::npos);
+}
+
+TEST_F(RiftEmitC, runsWhatEvalRuns)
+{
+    if (!compiler()) GTEST_SKIP() << "no C compiler";
+
+    for (unsigned level = 0; level <= 2; level += 2) {
+        EXPECT_EQ(run("mut s = 0;\n"
+                      "for (mut i = 0; i < 300; i = i + 1) { s = s + i * 2 - 1; }\n"
+                      "print(s);", level), "89400\n");
+        EXPECT_EQ(run("func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                      "{ mut a = 2; mut b = a + fib(10); print(b); }", level), "57\n");
+        EXPECT_EQ(run("mut n = nil;\n"
+                      "{ mut x = 3; mut y = n ?? x; x = y ?? x; print(x + y); print(x > 2 && y < 2); print(x > 2 && y > 2); }\n"
+                      "func outer(p) { func inner(q) { return p + q; } return inner(3); }\n"
+                      "print(outer(4)); print(\"a\" + \"b\"); print(\"n\" + 1); print(-outer(1));", level),
+                  "6\nfalse\ntrue\n7\nab\n\"n\"1\n-4\n");
+    }
+}
+
+TEST_F(RiftEmitC, compilesLazilyParsedBodies)
+{
+    if (!compiler()) GTEST_SKIP() << "no C compiler";
+
+    EXPECT_EQ(run("func outer(p) { func inner(q) { return p + q; } return inner(3); }\n"
+                  "func sum(n) { mut s = 0; for (mut i = 0; i < n; i = i + 1) { s = s + i; } return s; }\n"
+                  "print(outer(4)); print(sum(10));", 2, true), "7\n45\n");
+}
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include <ast/env.hh>
+
+using namespace rift::ast;
+using string = std::string;
+using TokenType = rift::scanner::TokenType;
+
+#pragma mark - Rift Environment (Fixtures)
+
+class RiftEnvironment : public ::testing::Test {
+
+    protected:
+        RiftEnvironment() {}
+        ~RiftEnvironment() override {}
+        void SetUp() override { }
+        void TearDown() override { env.clear(true); }
+
+        Token num(int n) { return Token(TokenType::NUMERICLITERAL, std::to_string(n), n, 1); }
+        string get(const string& name) { return env.getEnv<Token>(name).lexeme; }
+
+        Environment& env = Environment::getInstance(true);
+};
+
+#pragma mark - Rift Environment (Tests)
+
+TEST_F(RiftEnvironment, scopesShadowAndClose)
+{
+    env.setEnv<Token>("a", num(1), false);
+    env.pushScope();
+    env.setEnv<Token>("b", num(2), false);
+    env.pushScope();
+    env.setEnv<Token>("c", num(3), false);
+    EXPECT_EQ(get("a") + get("b") + get("c"), "123");
+
+    // writes go to the scope declaring the name
+    env.setEnv<Token>("b", num(4), false);
+    env.popScope();
+    EXPECT_EQ(get("b"), "4");
+    EXPECT_EQ(env.getEnv<Token>("c").type, TokenType::NIL);
+    env.popScope();
+    EXPECT_EQ(env.getEnv<Token>("b").type, TokenType::NIL);
+    EXPECT_EQ(get("a"), "1");
+}
+
+TEST_F(RiftEnvironment, reopenedScopesStartEmpty)
+{
+    for (int i = 0; i < 100; i++) {
+        env.pushScope();
+        EXPECT_EQ(env.getEnv<Token>("x").type, TokenType::NIL);
+        env.setEnv<Token>("x", num(i), false);
+        EXPECT_EQ(get("x"), std::to_string(i));
+        env.popScope();
+    }
+    EXPECT_EQ(env.getEnv<Token>("x").type, TokenType::NIL);
+}
+
+TEST_F(RiftEnvironment, snapshotsShareUntilWritten)
+{
+    auto& globals = Environment::getInstance(false);
+    globals.setEnv<Token>("a", num(1), false);
+    globals.setEnv<Token>("b", num(2), false);
+    auto idx = globals.index("a");
+
+    auto snapshot = globals.snapshot();
+    globals.setEnv<Token>("a", num(10), false);
+    globals.setEnv<Token>("c", num(3), false);
+    EXPECT_EQ(snapshot.getEnv<Token>("a").lexeme, "1");
+    EXPECT_EQ(snapshot.getEnv<Token>("c").type, TokenType::NIL);
+
+    // sites caching an index look it up again after a restore
+    auto version = globals.version;
+    globals.restore(snapshot);
+    EXPECT_GT(globals.version, version);
+    EXPECT_EQ(globals.get(idx).lexeme, "1");
+    EXPECT_EQ(globals.getEnv<Token>("b").lexeme, "2");
+    EXPECT_EQ(globals.getEnv<Token>("c").type, TokenType::NIL);
+    globals.clear(false);
+}
+
+TEST_F(RiftEnvironment, readsAndMovesDoNotCopy)
+{
+    env.setEnv<Token>("a", num(1), false);
+    env.pushScope();
+    env.setEnv<Token>("b", num(2), false);
+
+    auto copies = Token::copies;
+    EXPECT_EQ(&env.getEnv<Token>("a"), &env.getEnv<Token>("a"));
+    EXPECT_EQ(env.getEnv<Token>("b").lexeme, "2");
+    EXPECT_EQ(env.getEnv<Token>("missing").type, TokenType::NIL);
+
+    Token moved = num(3);
+    Token target = std::move(moved);
+    target = num(4);
+    env.setEnv<Token>("c", std::move(target), false);
+    EXPECT_EQ(Token::copies, copies);
+
+    Token copy = env.getEnv<Token>("c");
+    EXPECT_EQ(Token::copies, copies + 1);
+    env.popScope();
+}
@@ -1,27 +1,30 @@
-#include <string>
 
-#include <gtest/gtest.h>
-#include <ast/expr.hh>
-#include <ast/parser.hh>
-#include <ast/eval.hh>
 
-using namespace rift::ast;
-using string = std::string;
+#include "fixture.hh"
+#include <ast/expr.hh>
 
 #pragma mark - Rift Evaluator (Fixtures)
 
 #define TOK_NUM(n) Token(TokenType::NUMERICLITERAL, #n, n, 1)
 
 /// @note used mostly for sharing allocations
-class RiftEvaluator : public ::testing::Test {
+class RiftEvaluator : public RiftTest {
 
     protected:
         RiftEvaluator() {}
         ~RiftEvaluator() override {}
-        void SetUp() override { /*this->eval = new Eval(); */ }
-        void TearDown() override { /* delete this->eval; */ }
+        void SetUp() override { this->eval = new Eval(); }
+        void TearDown() override {
+            delete this->eval;
+            RiftTest::TearDown();
+        }
+
+        /// @brief what the program prints
+        string run(const string& src) {
+            auto prgm = parse(src);
+            return output([&] { eval->evaluate(prgm, false); });
+        }
 
-        Parser *parser;
         Eval *eval;
 };
 
@@ -49,4 +52,24 @@ TEST_F(RiftEvaluator, simpleEvalExpr) {
     auto program = std::make_unique<Program<Tokens>>(std::move(program_statements));
     auto x = eval->evaluate(program, true);
     EXPECT_EQ(x.at(0), "2");
-}
\ No newline at end of file
+}
+
+TEST_F(RiftEvaluator, returnsUnwindToTheirCall) {
+    // out of a loop (its condition & increment don't run again), through nested calls
+    EXPECT_EQ(run("mut n = 0;\n"
+                  "func tick() { n = n + 1; return n < 100; }\n"
+                  "func find(k) { for (mut i = 0; tick(); i = i + 1) { if (i == k) { return i; } } return -1; }\n"
+                  "func twice(k) { return find(k) + find(k); }\n"
+                  "print(twice(3)); print(n);\n"
+                  "func none() { return; }\n"
+                  "func fall() { mut x = 1; }\n"
+                  "print(none() ?? \"nil\"); print(fall() ?? \"nil\");\n"
+                  "return;\n"
+                  "print(\"unreachable\");"), "6\n8\nnil\nnil\n");
+}
+
+TEST_F(RiftEvaluator, divisionByZeroIsReported) {
+    // on the generic path & on a node quickened to ints (a runtime error, not a trap)
+    EXPECT_EXIT(run("mut b = 0;\nprint(7 / b);"), ::testing::ExitedWithCode(1), "");
+    EXPECT_EXIT(run("func d(a, b) { return a / b; }\nfor (mut i = 0; i < 4; i = i + 1) { print(d(10, 2 - i)); }"), ::testing::ExitedWithCode(1), "");
+}
@@ -0,0 +1,108 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <functional>
+
+#include <gtest/gtest.h>
+#include <scanner/scanner.hh>
+#include <ast/parser.hh>
+#include <ast/resolver.hh>
+#include <ast/passes.hh>
+#include <ast/eval.hh>
+#include <ast/vm.hh>
+
+using namespace rift::ast;
+using string = std::string;
+
+#pragma mark - Rift (Fixtures)
+
+/// @brief what the tests of every stage share: source to a resolved program & a program to its output
+class RiftTest : public ::testing::Test {
+
+    protected:
+        RiftTest() {}
+        ~RiftTest() override {}
+        void SetUp() override { }
+        void TearDown() override { clear(); }
+
+        /// @brief forget the globals of the evaluator & the parser
+        virtual void clear() {
+            Environment::getInstance(false).clear(false);
+            Environment::getInstance(true).clear(true);
+        }
+
+        /// @brief scanned, parsed & resolved
+        static std::unique_ptr<Program<Tokens>> parse(const string& src, bool lazy = false) {
+            auto source = std::make_shared<std::vector<char>>(src.begin(), src.end());
+            Scanner scanner(source);
+            scanner.scan_source();
+            auto tokens = std::make_shared<std::vector<Token>>(scanner.tokens);
+            Parser parser(tokens, lazy);
+            auto prgm = parser.parse();
+            Resolver().resolve(prgm);
+            return prgm;
+        }
+
+        /// @brief what running prints
+        static string output(const std::function<void()>& running) {
+            testing::internal::CaptureStdout();
+            running();
+            return testing::internal::GetCapturedStdout();
+        }
+
+        /// @brief what the program prints on the tree walker
+        static string run(std::unique_ptr<Program<Tokens>>& prgm) {
+            return output([&prgm] { Eval().evaluate(prgm, false); });
+        }
+};
+
+/// @brief the tests of an engine: programs optimized as the driver would, each run checked
+///        against the tree walker's output
+class RiftEngine : public RiftTest {
+
+    protected:
+        RiftEngine() {}
+        ~RiftEngine() override {}
+
+        void clear() override {
+            RiftTest::clear();
+            Machine::reset();
+        }
+
+        /// @brief what the program prints on the engine under test
+        virtual string engine(std::unique_ptr<Program<Tokens>>& prgm) = 0;
+
+        /// @brief parsed, resolved & optimized at level
+        /// @note the engine runs the calls, none are evaluated while compiling
+        static std::unique_ptr<Program<Tokens>> parse(const string& src, unsigned level = 2, bool lazy = false) {
+            auto prgm = RiftTest::parse(src, lazy);
+            PassManager::pipeline(level, false, 16, false, 0).run(prgm);
+            return prgm;
+        }
+
+        /// @brief output of the program on the engine, checked against the tree walker's
+        string run(const string& src, unsigned level = 2, bool lazy = false) {
+            auto prgm = parse(src, level, lazy);
+            string expected = RiftTest::run(prgm);
+            clear();
+
+            prgm = parse(src, level, lazy);
+            string actual = engine(prgm);
+            EXPECT_EQ(actual, expected);
+            return actual;
+        }
+};
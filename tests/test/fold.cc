@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/fold.hh>
+
+#pragma mark - Rift Fold (Fixtures)
+
+class RiftFold : public RiftTest {
+
+    protected:
+        RiftFold() {}
+        ~RiftFold() override {}
+};
+
+#pragma mark - Rift Fold (Tests)
+
+TEST_F(RiftFold, foldsAndPropagatesConstants)
+{
+    auto prgm = parse("mut! secs = 60 * 60 * 24;\nprint(secs);");
+    Fold fold;
+    // two binaries collapse into one literal (4 nodes), secs is propagated into print
+    EXPECT_EQ(fold.run(prgm), 4u);
+    EXPECT_EQ(fold.propagated(), 1u);
+    EXPECT_EQ(run(prgm), "86400\n");
+}
+
+TEST_F(RiftFold, foldsNumericComparisons)
+{
+    // > folds like the other relational operators
+    auto prgm = parse("print(1 > 0);\nprint(3 > 7);\nprint(2 >= 2);");
+    Fold fold;
+    EXPECT_EQ(fold.run(prgm), 6u);
+    EXPECT_EQ(run(prgm), "true\nfalse\ntrue\n");
+}
+
+TEST_F(RiftFold, simplifiesShortCircuits)
+{
+    auto prgm = parse("mut v = 1;\n"
+                      "print(nil ?? v);\n"
+                      "print(false && v);\n"
+                      "print(true ? v + 1 : v);\n"
+                      "func lookup(k) { mut! base = 10; return k > \"a\" ? base : base * 2; }\n"
+                      "print(lookup(\"b\"));");
+    Fold fold;
+    EXPECT_GT(fold.run(prgm), 0u);
+    EXPECT_EQ(run(prgm), "1\nfalse\n2\n10\n");
+}
+
+TEST_F(RiftFold, reassignedConstantsAreNotPropagated)
+{
+    // accepted at every level, each use sees the value the evaluator gives it
+    auto prgm = parse("mut! k = 3;\nprint(k);\nk = 4;\nprint(k);\n"
+                      "func f() { mut! c = 1; for (mut i = 0; i < 2; i = i + 1) { print(c); c = c + 1; } }\nf();");
+    Fold fold;
+    fold.run(prgm);
+    EXPECT_EQ(fold.propagated(), 0u);
+    EXPECT_EQ(run(prgm), "3\n4\n1\n2\n");
+}
@@ -0,0 +1,84 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include <gtest/gtest.h>
+#include <ast/hamt.hh>
+
+using namespace rift::ast;
+using string = std::string;
+
+#pragma mark - Rift Hamt (Fixtures)
+
+/// @brief every key in one of 4 buckets, to force full collisions
+struct Clash {
+    size_t operator()(int key) const { return key % 4; }
+};
+
+#pragma mark - Rift Hamt (Tests)
+
+TEST(RiftHamt, findsWhatWasSet)
+{
+    Hamt<string, int> map;
+    EXPECT_EQ(map.find("a"), nullptr);
+    for (int i = 0; i < 5000; i++)
+        EXPECT_TRUE(map.set("k" + std::to_string(i), i));
+    EXPECT_FALSE(map.set("k42", -42));
+    EXPECT_EQ(map.size(), 5000u);
+
+    EXPECT_EQ(*map.find("k0"), 0);
+    EXPECT_EQ(*map.find("k42"), -42);
+    EXPECT_EQ(*map.find("k4999"), 4999);
+    EXPECT_FALSE(map.contains("k5000"));
+
+    long sum = 0;
+    map.each([&sum](const string&, int value) { sum += value; });
+    EXPECT_EQ(sum, 4999L * 5000 / 2 - 42 - 42);
+}
+
+TEST(RiftHamt, copiesAreIndependent)
+{
+    Hamt<int, int> map;
+    for (int i = 0; i < 1000; i++)
+        map.set(i, i);
+
+    auto snapshot = map;
+    for (int i = 0; i < 1000; i += 2)
+        map.set(i, -i);
+    map.set(1000, 1000);
+
+    EXPECT_EQ(snapshot.size(), 1000u);
+    EXPECT_EQ(map.size(), 1001u);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(*snapshot.find(i), i);
+        EXPECT_EQ(*map.find(i), i % 2 ? i : -i);
+    }
+    EXPECT_FALSE(snapshot.contains(1000));
+}
+
+TEST(RiftHamt, collisionsShareALeaf)
+{
+    Hamt<int, string, Clash> map;
+    for (int i = 0; i < 40; i++)
+        map.set(i, std::to_string(i));
+    auto snapshot = map;
+    map.set(8, "eight");
+
+    EXPECT_EQ(map.size(), 40u);
+    for (int i = 0; i < 40; i++)
+        EXPECT_EQ(*snapshot.find(i), std::to_string(i));
+    EXPECT_EQ(*map.find(8), "eight");
+    EXPECT_EQ(map.find(40), nullptr);
+}
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/infer.hh>
+#include <ast/hoist.hh>
+
+#pragma mark - Rift Hoist (Fixtures)
+
+class RiftHoist : public RiftTest {
+
+    protected:
+        RiftHoist() {}
+        ~RiftHoist() override {}
+
+        std::unique_ptr<Program<Tokens>> parse(const string& src) {
+            auto prgm = RiftTest::parse(src);
+            Infer().run(prgm);
+            return prgm;
+        }
+
+        /// @brief output of src without moving anything
+        string plain(const string& src) {
+            auto prgm = parse(src);
+            auto out = run(prgm);
+            clear();
+            return out;
+        }
+};
+
+#pragma mark - Rift Hoist (Tests)
+
+TEST_F(RiftHoist, hoistsToTheOutermostInvariantLoop)
+{
+    auto src = "func grid(n) {\n"
+               "    mut m = 3;\n"
+               "    mut sum = 0;\n"
+               "    for (mut i = 0; i < n; i = i + 1) {\n"
+               "        for (mut j = 0; j < n * 2; j = j + 1) { sum = sum + m * m - m + i * m; }\n"
+               "    }\n"
+               "    return sum;\n"
+               "}\n"
+               "print(grid(2));\n"
+               "mut rows = 5;\n"
+               "mut total = 0;\n"
+               "for (mut r = 0; r < 3; r = r + 1) { total = total + rows * rows; }\n"
+               "print(total);";
+    auto expected = plain(src);
+    auto prgm = parse(src);
+    Hoist hoist;
+    // m * m to the outer loop, n * 2 (tested anyway) & i * m to the inner one, rows * rows
+    EXPECT_EQ(hoist.run(prgm), 4u);
+    EXPECT_EQ(run(prgm), expected);
+    EXPECT_EQ(expected, "60\n75\n");
+}
+
+TEST_F(RiftHoist, keepsWhatTheLoopMayChange)
+{
+    auto src = "mut g = 2;\n"
+               "func bump() { g = g + 1; return 0; }\n"
+               "mut acc = 0;\n"
+               "for (mut i = 0; i < 3; i = i + 1) { acc = acc + g * 10; bump(); }\n"
+               "print(acc);\n"
+               "mut d = 0;\n"
+               "for (mut i = 0; i < 3; i = i + 1) { mut step = i * 2; d = d + step * 3; }\n"
+               "print(d);\n"
+               "mut z = 0;\n"
+               "for (mut i = 0; z > 0; i = i + 1) { print(10 / z); }\n"
+               "print(z);";
+    auto expected = plain(src);
+    auto prgm = parse(src);
+    Hoist hoist;
+    // only z > 0: g is written by the call, step in the body, 10 / z may fail
+    EXPECT_EQ(hoist.run(prgm), 1u);
+    EXPECT_EQ(run(prgm), expected);
+    EXPECT_EQ(expected, "90\n18\n0\n");
+}
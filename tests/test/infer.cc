@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/fold.hh>
+#include <ast/infer.hh>
+
+#pragma mark - Rift Infer (Fixtures)
+
+class RiftInfer : public RiftTest {
+
+    protected:
+        RiftInfer() {}
+        ~RiftInfer() override {}
+
+        /// @brief output of src on the generic path
+        string generic(const string& src) {
+            auto prgm = parse(src);
+            auto out = run(prgm);
+            clear();
+            return out;
+        }
+};
+
+#pragma mark - Rift Infer (Tests)
+
+TEST_F(RiftInfer, specializesLoopArithmetic)
+{
+    auto src = "mut s = 0;\n"
+               "for (mut i = 0; i < 10; i = i + 1) { s = s + i; }\n"
+               "print(s);\n"
+               "print(s > 40);\n"
+               "mut d = s / 2;\n"
+               "print(d * 2 - 1);\n"
+               "print(\"ab\" + \"cd\");";
+    auto expected = generic(src);
+    auto prgm = parse(src);
+    Infer infer;
+    // i < 10, i + 1, s + i, s > 40, s / 2, d * 2, ... - 1, "ab" + "cd"
+    EXPECT_EQ(infer.run(prgm), 8u);
+    EXPECT_EQ(run(prgm), expected);
+    EXPECT_EQ(expected, "45\ntrue\n43\nabcd\n");
+}
+
+TEST_F(RiftInfer, fallsBackWhereTypesAreUnknown)
+{
+    auto src = "mut v = 1;\n"
+               "mut flag = true;\n"
+               "if (flag) { v = \"a\"; }\n"
+               "print(v + v);\n"
+               "mut g = 1;\n"
+               "func setg() { g = \"x\"; return 0; }\n"
+               "setg();\n"
+               "print(g + g);\n"
+               "func twice(n) { return n + n; }\n"
+               "print(twice(4));";
+    auto expected = generic(src);
+    auto prgm = parse(src);
+    Infer infer;
+    EXPECT_EQ(infer.run(prgm), 0u);
+    EXPECT_EQ(run(prgm), expected);
+    EXPECT_EQ(expected, "aa\nxx\n8\n");
+}
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/inline.hh>
+
+#pragma mark - Rift Inline (Fixtures)
+
+class RiftInline : public RiftTest {
+
+    protected:
+        RiftInline() {}
+        ~RiftInline() override {}
+
+        /// @brief output of src with every call made
+        string plain(const string& src) {
+            auto prgm = parse(src);
+            auto out = run(prgm);
+            clear();
+            return out;
+        }
+};
+
+#pragma mark - Rift Inline (Tests)
+
+TEST_F(RiftInline, inlinesSmallFunctions)
+{
+    auto src = "func sq(x) { return x * x; }\n"
+               "func quad(x) { return sq(x) * sq(x); }\n"
+               "mut a = 2;\n"
+               "print(quad(3));\n"
+               "print(sq(a));\n"
+               "print(sq(a + 1));";
+    auto expected = plain(src);
+    auto prgm = parse(src);
+    Inline inliner;
+    // both calls in quad, then quad(3) itself & sq(a), a + 1 would be computed twice
+    EXPECT_EQ(inliner.run(prgm), 4u);
+    EXPECT_EQ(run(prgm), expected);
+    EXPECT_EQ(expected, "81\n4\n9\n");
+}
+
+TEST_F(RiftInline, leavesWhatItCannotInline)
+{
+    auto src = "mut g = 1;\n"
+               "func fact(n) { return n < 2 ? 1 : n * fact(n - 1); }\n"
+               "func inc(x) { mut y = x + 1; return y; }\n"
+               "func bump(x) { g = g + x; return g; }\n"
+               "func twice(x) { return x + x; }\n"
+               "print(fact(5));\n"
+               "print(inc(1));\n"
+               "print(twice(bump(1)));\n"
+               "print(g);";
+    auto expected = plain(src);
+    auto prgm = parse(src);
+    // recursive, two statements, an assignment & an argument with side effects
+    EXPECT_EQ(Inline().run(prgm), 0u);
+    EXPECT_EQ(run(prgm), expected);
+    EXPECT_EQ(expected, "120\n2\n4\n2\n");
+}
+
+TEST_F(RiftInline, respectsTheSizeLimit)
+{
+    auto src = "func sq(x) { return x * x; }\n"
+               "print(sq(7));";
+    auto prgm = parse(src);
+    EXPECT_EQ(Inline(2).run(prgm), 0u);
+    EXPECT_EQ(Inline(3).run(prgm), 1u);
+    EXPECT_EQ(run(prgm), "49\n");
+}
+
+TEST_F(RiftInline, keepsCallsAheadOfTheDeclaration)
+{
+    // the first call finds no function bound yet, inlining must not make it succeed
+    auto prgm = parse("print(inc(1));\nfunc inc(x) { return x + 1; }\nprint(inc(2));");
+    EXPECT_EQ(Inline().run(prgm), 1u);
+    EXPECT_EXIT(run(prgm), ::testing::ExitedWithCode(1), "");
+}
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/regvm.hh>
+
+#pragma mark - Rift JIT (Fixtures)
+
+class RiftJit : public RiftEngine {
+
+    protected:
+        RiftJit() {}
+        ~RiftJit() override {}
+
+        /// @brief what the program prints with the jit, the compiled functions kept in stats
+        string engine(std::unique_ptr<Program<Tokens>>& prgm) override {
+            RegisterMachine machine(true);
+            auto out = output([&] { machine.evaluate(prgm, false); });
+            stats = machine.jitted();
+            return out;
+        }
+
+        /// @brief output of the program with the jit, checked against the tree walker's
+        string run(const string& src, std::vector<Jit::Stats>* jitted = nullptr) {
+            auto out = RiftEngine::run(src);
+            if (jitted != nullptr) *jitted = stats;
+            return out;
+        }
+
+        std::vector<Jit::Stats> stats;
+};
+
+#pragma mark - Rift JIT (Tests)
+
+TEST_F(RiftJit, assemblesX64)
+{
+    Assembler as;
+    auto done = as.label();
+    as.mov(Assembler::rax, 42);
+    as.jmp(done);
+    as.ret();
+    as.bind(done);
+    as.ret();
+    std::vector<uint8_t> expected = {0xB8, 0x2A, 0x00, 0x00, 0x00, 0xE9, 0x01, 0x00, 0x00, 0x00, 0xC3, 0xC3};
+    EXPECT_EQ(as.finish(), expected);
+
+    Assembler mem;
+    mem.cmp8(Assembler::Mem{Assembler::rdi, 24}, 2);
+    mem.add(Assembler::rax, Assembler::Mem{Assembler::rdi, 4});
+    expected = {0x80, 0xBF, 0x18, 0x00, 0x00, 0x00, 0x02, 0x03, 0x87, 0x04, 0x00, 0x00, 0x00};
+    EXPECT_EQ(mem.finish(), expected);
+}
+
+TEST_F(RiftJit, compilesHotLoops)
+{
+    std::vector<Jit::Stats> jitted;
+    EXPECT_EQ(run("func sum(n) { mut s = 0; for (mut i = 0; i < n; i = i + 1) { s = s + i * 3 - i / 2; } return s; }\n"
+                  "print(sum(1000)); print(sum(7));", &jitted), "1249000\n54\n");
+#ifdef RIFT_JIT
+    ASSERT_EQ(jitted.size(), 1u);
+    EXPECT_EQ(jitted[0].name, "sum");
+    EXPECT_GT(jitted[0].bytes, 0u);
+    // everything but the two returns
+    EXPECT_EQ(jitted[0].translated, jitted[0].instrs - 2);
+#endif
+}
+
+TEST_F(RiftJit, leavesWhatItCannotRunToTheInterpreter)
+{
+    // hot with ints, then a string & a nil: the guards fail, the interpreter finishes the work
+    EXPECT_EQ(run("func twice(x) { mut y = x + x; return y; }\n"
+                  "mut s = 0;\n"
+                  "for (mut i = 0; i < 300; i = i + 1) { s = s + twice(i); }\n"
+                  "print(s); print(twice(\"ab\")); print(twice(-2));"), "89700\nabab\n-4\n");
+    clear();
+    EXPECT_EQ(run("func div(x) { mut q = 0; for (mut i = 1; i < 200; i = i + 1) { q = q + x / i; } return q; }\n"
+                  "print(div(1000)); print(div(-7));"), "5781\n-16\n");
+}
@@ -1,10 +1,8 @@
-#include <scanner/scanner.hh>
+#include "fixture.hh"
 #include <ast/expr.hh>
 #include <ast/printer.hh>
-#include <gtest/gtest.h>
 
 using namespace rift::scanner;
-using string = std::string;
 
 #pragma mark - Rift Parser (Printer Fixtures)
 
@@ -60,4 +58,28 @@ TEST_F(RiftPrinter, simpleParseExprGroup) {
         std::make_unique<rift::ast::Literal<Token>>(std::move(expr2))
     );
     // EXPECT_EQ(rift::ast::printer->print(&expr3), "(+ [ (* 1 2)] 3)");
+}
+
+#pragma mark - Rift Parser (Fixtures)
+
+class RiftParser : public RiftTest {
+
+    protected:
+        RiftParser() {}
+        ~RiftParser() override {}
+
+        string run(const string& src, bool lazy) {
+            auto prgm = parse(src, lazy);
+            return RiftTest::run(prgm);
+        }
+};
+
+#pragma mark - Rift Parser (Tests)
+
+TEST_F(RiftParser, lazyFunctionBodies) {
+    // the body of unused() is only brace-matched, so it is never parsed
+    string src = "func twice(x) { return x * 2; }\n"
+                 "func unused() { print( ; { } }\n"
+                 "print(twice(21));";
+    EXPECT_EQ(run(src, true), "42\n");
 }
\ No newline at end of file
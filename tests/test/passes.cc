@@ -0,0 +1,75 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+
+#pragma mark - Rift Passes (Fixtures)
+
+class RiftPasses : public RiftTest {
+
+    protected:
+        RiftPasses() {}
+        ~RiftPasses() override {}
+};
+
+#pragma mark - Rift Passes (Tests)
+
+TEST_F(RiftPasses, levelsSelectTheirPasses)
+{
+    using Names = std::vector<string>;
+    EXPECT_EQ(PassManager::pipeline(0, false).passes(), Names());
+    EXPECT_EQ(PassManager::pipeline(1, false).passes(), Names({"fold", "prune"}));
+    EXPECT_EQ(PassManager::pipeline(2, false).passes(), Names({"inline", "fold", "prune", "infer", "hoist"}));
+    // no inlining at the prompt or with a size of 0
+    EXPECT_EQ(PassManager::pipeline(2, true).passes(), Names({"fold", "prune", "infer", "hoist"}));
+    EXPECT_EQ(PassManager::pipeline(2, false, 0).passes(), Names({"fold", "prune", "infer", "hoist"}));
+}
+
+TEST_F(RiftPasses, reportsEachPass)
+{
+    auto src = "func sq(x) { return x * x; }\n"
+               "mut a = 2 + 3;\n"
+               "if (false) { print(a); }\n"
+               "print(sq(a));";
+    auto expected = "25\n";
+    auto prgm = parse(src);
+
+    auto passes = PassManager::pipeline(2, false, 16, true);
+    passes.run(prgm);
+    const auto& stats = passes.stats();
+    ASSERT_EQ(stats.size(), 5u);
+
+    EXPECT_EQ(stats[0].report, "1 calls inlined");
+    for (size_t i = 1; i < stats.size(); i++)
+        EXPECT_EQ(stats[i].before, stats[i - 1].after);
+    // 2 + 3 & the dead branch
+    EXPECT_LT(stats[1].after, stats[1].before);
+    EXPECT_LT(stats[2].after, stats[2].before);
+    EXPECT_EQ(stats.back().after, Verifier().count(prgm));
+    EXPECT_EQ(run(prgm), expected);
+}
+
+TEST_F(RiftPasses, verifierFindsMalformedTrees)
+{
+    auto prgm = parse("mut a = 1;\nfunc f(x) { return x + a; }\nprint(f(a));");
+    EXPECT_EQ(Verifier().verify(prgm), "");
+
+    Program<Tokens>::vec_t decls;
+    auto sum = std::make_unique<Binary<Token>>(std::make_unique<Literal<Token>>(Token(TokenType::NUMERICLITERAL, "1", 1, 1)),
+                                               Token(TokenType::PLUS, "+", "", 1), nullptr);
+    decls.push_back(std::make_unique<DeclStmt<Token>>(std::make_unique<StmtExpr<void>>(std::move(sum))));
+    auto broken = std::make_unique<Program<Tokens>>(std::move(decls));
+    EXPECT_EQ(Verifier().verify(broken), "missing right operand of '+'");
+    EXPECT_EQ(Verifier().count(broken), 4u);
+}
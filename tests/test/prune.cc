@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/fold.hh>
+#include <ast/prune.hh>
+
+#pragma mark - Rift Prune (Fixtures)
+
+class RiftPrune : public RiftTest {
+
+    protected:
+        RiftPrune() {}
+        ~RiftPrune() override {}
+
+        std::unique_ptr<Program<Tokens>> parse(const string& src) {
+            auto prgm = RiftTest::parse(src);
+            Fold().run(prgm);
+            return prgm;
+        }
+};
+
+#pragma mark - Rift Prune (Tests)
+
+TEST_F(RiftPrune, onlyTheFirstArmThatHoldsRuns)
+{
+    auto prgm = parse("mut v = 1;\n"
+                      "if (v == 1) { print(\"if\"); } elif (v == 1) { print(\"elif\"); } else { print(\"else\"); }\n"
+                      "if (v == 2) { print(\"if\"); } elif (v == 1) { print(\"elif\"); } elif (v == 1) { print(\"again\"); } else { print(\"else\"); }");
+    EXPECT_EQ(run(prgm), "if\nelif\n");
+}
+
+TEST_F(RiftPrune, removesConstantBranches)
+{
+    auto prgm = parse("mut! debug = false;\n"
+                      "mut v = 1;\n"
+                      "if (debug) { print(\"debug\"); } elif (v == 1) { print(\"one\"); } else { print(\"other\"); }\n"
+                      "if (true) { print(\"always\"); } else { print(\"never\"); }\n"
+                      "if (debug) print(\"gone\");\n"
+                      "for (mut i = 0; false; i = i + 1) { print(i); }");
+    Prune prune;
+    prune.run(prgm, true);
+    // the debug arm, the else after true, the whole third if and the loop body
+    EXPECT_EQ(prune.statements(), 4u);
+    EXPECT_EQ(run(prgm), "one\nalways\n");
+}
+
+TEST_F(RiftPrune, dropsUnreachableCodeAndFunctions)
+{
+    auto prgm = parse("func unused() { return 0; }\n"
+                      "func leaf(n) { return n * 2; }\n"
+                      "func twice(n) { return leaf(n); print(\"after\"); }\n"
+                      "print(twice(3));");
+    Prune prune;
+    prune.run(prgm, true);
+    EXPECT_EQ(prune.statements(), 1u);
+    EXPECT_EQ(prune.functions(), 1u);
+    EXPECT_EQ(run(prgm), "6\n");
+}
@@ -0,0 +1,91 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+
+#pragma mark - Rift Quicken (Fixtures)
+
+class RiftQuicken : public RiftTest {
+
+    protected:
+        RiftQuicken() {}
+        ~RiftQuicken() override {}
+
+        /// @brief the global v, as the evaluator reads it
+        void set(Token value) {
+            auto& env = Environment::getInstance(false);
+            env.assign(env.index("v"), std::move(value), false);
+        }
+
+        /// @brief v + 1
+        std::unique_ptr<Binary<Token>> increment() {
+            return std::make_unique<Binary<Token>>(
+                std::make_unique<VarExpr<Token>>(Token(TokenType::IDENTIFIER, "v", "v", 1)),
+                Token(TokenType::PLUS, "+", "", 1),
+                std::make_unique<Literal<Token>>(Token(TokenType::NUMERICLITERAL, "1", 1, 1)));
+        }
+
+        string run(const string& src) {
+            auto prgm = parse(src);
+            return RiftTest::run(prgm);
+        }
+};
+
+#pragma mark - Rift Quicken (Tests)
+
+TEST_F(RiftQuicken, specializesToTheTypesItSees)
+{
+    auto expr = increment();
+    set(Token(TokenType::NUMERICLITERAL, "41", 41, 1));
+
+    // a few runs of ints, then the node runs the int specialization
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(Eval().visit_binary(*expr).lexeme, "42");
+        EXPECT_EQ(expr->quick, Quick::Unseen);
+    }
+    EXPECT_EQ(Eval().visit_binary(*expr).lexeme, "42");
+    EXPECT_EQ(expr->quick, Quick::Int);
+    EXPECT_EQ(Eval().visit_binary(*expr).lexeme, "42");
+
+    // a string fails the guard, the node is generic from then on
+    set(Token(TokenType::STRINGLITERAL, "a", 0, 1));
+    EXPECT_EQ(Eval().visit_binary(*expr).lexeme, "a1");
+    EXPECT_EQ(expr->quick, Quick::Generic);
+    set(Token(TokenType::NUMERICLITERAL, "1", 1, 1));
+    EXPECT_EQ(Eval().visit_binary(*expr).lexeme, "2");
+    EXPECT_EQ(expr->quick, Quick::Generic);
+}
+
+TEST_F(RiftQuicken, mixedTypesStayGeneric)
+{
+    auto expr = increment();
+    set(Token(TokenType::NUMERICLITERAL, "1", 1, 1));
+    Eval().visit_binary(*expr);
+    set(Token(TokenType::STRINGLITERAL, "a", 0, 1));
+    Eval().visit_binary(*expr);
+    EXPECT_EQ(expr->quick, Quick::Generic);
+}
+
+TEST_F(RiftQuicken, deoptimizedRunsMatchTheGenericPath)
+{
+    EXPECT_EQ(run("func twice(n) { return n + n; }\n"
+                  "mut s = 0;\n"
+                  "for (mut i = 0; i < 10; i = i + 1) { s = s + twice(i); }\n"
+                  "print(s);\n"
+                  "print(twice(\"ab\"));\n"
+                  "func join(a) { return a + \"!\"; }\n"
+                  "for (mut j = 0; j < 6; j = j + 1) { join(\"x\"); }\n"
+                  "print(join(\"y\"));\n"
+                  "print(twice(3));"), "90\nabab\ny!\n6\n");
+}
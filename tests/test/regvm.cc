@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/regvm.hh>
+
+#pragma mark - Rift Register VM (Fixtures)
+
+class RiftRegisterVM : public RiftEngine {
+
+    protected:
+        RiftRegisterVM() {}
+        ~RiftRegisterVM() override {}
+
+        /// @brief what the program prints on the register vm
+        string engine(std::unique_ptr<Program<Tokens>>& prgm) override {
+            return output([&prgm] { RegisterMachine().evaluate(prgm, false); });
+        }
+};
+
+#pragma mark - Rift Register VM (Tests)
+
+TEST_F(RiftRegisterVM, runsWhatEvalRuns)
+{
+    for (unsigned level = 0; level <= 2; level++) {
+        EXPECT_EQ(run("mut s = 0;\n"
+                      "for (mut i = 0; i < 300; i = i + 1) { s = s + i * 2 - 1; }\n"
+                      "print(s);", level), "89400\n");
+        EXPECT_EQ(run("func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                      "{ mut a = 2; mut b = a + fib(10); print(b); }", level), "57\n");
+        EXPECT_EQ(run("mut n = nil;\n"
+                      "{ mut x = 3; mut y = n ?? x; x = y ?? x; print(x + y); print(x > 2 && y < 2); print(x > 2 && y > 2); }\n"
+                      "func outer(p) { func inner(q) { return p + q; } return inner(3); }\n"
+                      "print(outer(4)); print(\"a\" + \"b\"); print(-outer(1));", level),
+                  "6\nfalse\ntrue\n7\nab\n-4\n");
+    }
+}
+
+TEST_F(RiftRegisterVM, localsAreRegisters)
+{
+    auto prgm = parse("{ mut x = 1; x = x + 1; mut y = x * x; print(y); }", 0);
+    auto script = RegisterCompiler().compile(prgm);
+    ASSERT_NE(script, nullptr);
+
+    // x = x + 1 reads & writes x's register in one instruction, no global loads or stores
+    size_t adds = 0;
+    for (const auto& instr : script->instrs) {
+        EXPECT_NE(instr.op, RegOp::GetGlobal);
+        EXPECT_NE(instr.op, RegOp::SetGlobal);
+        if (instr.op == RegOp::AddK) {
+            EXPECT_EQ(instr.a, instr.b);
+            adds++;
+        }
+    }
+    EXPECT_EQ(adds, 1u);
+    EXPECT_GE(script->registers, script->frame);
+    EXPECT_EQ(script->lines.size(), script->instrs.size());
+
+    EXPECT_EQ(output([&script] { RegisterMachine().run(script, false); }), "4\n");
+}
@@ -0,0 +1,143 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+
+#pragma mark - Rift Resolver (Fixtures)
+
+class RiftResolver : public RiftTest {
+
+    protected:
+        RiftResolver() {}
+        ~RiftResolver() override {}
+};
+
+#pragma mark - Rift Resolver (Tests)
+
+TEST_F(RiftResolver, recursionAndBlockLocals)
+{
+    // the function resolves to itself from its own body, locals to their block slot
+    auto prgm = parse("func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                      "{ mut a = 2; mut b = a + fib(10); print(b); }");
+    EXPECT_EQ(run(prgm), "57\n");
+}
+
+TEST_F(RiftResolver, shadowingAndClosures)
+{
+    auto prgm = parse("mut x = 1;\n"
+                      "{ mut x = 2; { mut y = x + 10; print(y); x = 5; } print(x); }\n"
+                      "print(x);\n"
+                      "func outer(p) { func inner(q) { return p + q; } return inner(3); }\n"
+                      "print(outer(4));");
+    EXPECT_EQ(run(prgm), "12\n5\n1\n7\n");
+}
+
+TEST_F(RiftResolver, globalSitesFollowRedefinition)
+{
+    // the loop's call site caches its callee, redefining it in the REPL must invalidate that
+    auto first = parse("func pick() { return 1; }\n"
+                       "func sum() { mut t = 0; for (mut k = 0; k < 3; k = k + 1) { t = t + pick(); } return t; }\n"
+                       "print(sum());");
+    EXPECT_EQ(run(first), "3\n");
+
+    Eval eval;
+    auto second = parse("func pick() { return 2; }\nprint(sum());");
+    EXPECT_EQ(output([&] { eval.evaluate(second, true); }), "6\n");
+}
+
+TEST_F(RiftResolver, functionsOutliveTheirLine)
+{
+    // the REPL frees each line once it ran, the functions it declared are still called
+    auto first = parse("mut n = 2;\n"
+                       "func scale(x) { return x * n; }\n"
+                       "func twice(x) { return scale(scale(x)); }");
+    EXPECT_EQ(run(first), "");
+    first.reset();
+
+    Eval eval;
+    auto second = parse("print(twice(3));\nprint(scale(5));");
+    EXPECT_EQ(output([&] { eval.evaluate(second, true); }), "12\n10\n");
+}
+
+TEST_F(RiftResolver, capturedLocalsAreBoxed)
+{
+    // a, t & later escape into closures (t's block is boxed after get() is declared),
+    // unused & z stay in the frame
+    auto prgm = parse("func mk(a) {\n"
+                      "  mut unused = 5;\n"
+                      "  { mut t = 1; func get() { return a + t; }\n"
+                      "    mut later = 100; func other() { return later; }\n"
+                      "    { mut z = 3; return get() + other() + z; } }\n"
+                      "}\n"
+                      "func rec(n) { func down(k) { if (k < 1) { return 0; } return n + down(k - 1); } return down(n); }\n"
+                      "print(mk(10));\n"
+                      "print(rec(4));");
+    EXPECT_EQ(run(prgm), "114\n16\n");
+}
+
+TEST_F(RiftResolver, closuresShareCapturedCells)
+{
+    // mid hands a & b down to inner without using them, b is read after it changes,
+    // inc writes the cell its function reads back
+    auto prgm = parse("func outer(a) {\n"
+                      "  mut b = 2;\n"
+                      "  func mid(c) { func inner(d) { return a + b + d; } return inner(c); }\n"
+                      "  b = 20;\n"
+                      "  return mid(1);\n"
+                      "}\n"
+                      "func counter(n) { mut c = n; func inc(k) { c = c + k; return c; } inc(1); inc(2); return c; }\n"
+                      "{ mut base = 7; func add(v) { return base + v; } print(add(1)); }\n"
+                      "print(outer(100));\n"
+                      "print(counter(10));");
+    EXPECT_EQ(run(prgm), "8\n121\n13\n");
+}
+
+TEST_F(RiftResolver, argumentsArePositional)
+{
+    // each argument goes to the param at its position, whatever the names, and a body
+    // may call a function declared after it
+    auto prgm = parse("func sub(a, b) { return a - b; }\n"
+                      "func twice(f, g) { return sub(g, f) + later(f, g, 1); }\n"
+                      "func later(x, y, z) { return x * 100 + y * 10 + z; }\n"
+                      "mut b = 3;\n"
+                      "print(sub(10, b));\n"
+                      "print(twice(1, 4));");
+    EXPECT_EQ(run(prgm), "7\n144\n");
+}
+
+TEST_F(RiftResolver, arityIsCheckedAtResolve)
+{
+    EXPECT_EXIT(parse("func add(a, b) { return a + b; }\nprint(add(1));"), ::testing::ExitedWithCode(1), "");
+    EXPECT_EXIT(parse("func f() { func g(x) { return x; } return g(1, 2); }"), ::testing::ExitedWithCode(1), "");
+    // a local shadowing the function is not checked against it
+    auto prgm = parse("func one(a) { return a; }\nfunc two(one) { return one; }\nprint(one(5) + two(6));");
+    EXPECT_EQ(run(prgm), "11\n");
+}
+
+TEST_F(RiftResolver, eachClosureKeepsItsOwnCells)
+{
+    // two closures of one declaration, each bound to the variables of its own run
+    auto prgm = parse("func adder(k) { func add(v) { return v + k; } return add; }\n"
+                      "mut add5 = adder(5);\n"
+                      "mut add7 = adder(7);\n"
+                      "print(add5(1));\n"
+                      "print(add7(1));\n"
+                      "func counter() { mut c = 0; func inc() { c = c + 1; return c; } return inc; }\n"
+                      "mut a = counter();\n"
+                      "mut b = counter();\n"
+                      "a(); a();\n"
+                      "print(a());\n"
+                      "print(b());");
+    EXPECT_EQ(run(prgm), "6\n8\n3\n1\n");
+}
@@ -0,0 +1,131 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/ssa.hh>
+
+#pragma mark - Rift SSA (Fixtures)
+
+class RiftSSA : public RiftTest {
+
+    protected:
+        RiftSSA() {}
+        ~RiftSSA() override {}
+
+        /// @brief every function of the source in ssa form, checked before & after optimizing
+        std::vector<std::unique_ptr<ssa::Function>> build(const string& src, unsigned level = 0, bool lazy = false) {
+            auto prgm = parse(src, lazy);
+            PassManager::pipeline(level, false).run(prgm);
+
+            auto fns = SSABuilder().build(prgm);
+            for (const auto& fn : fns) {
+                EXPECT_EQ(fn->verify(), "") << fn->dump();
+                ssa::Optimizer().run(*fn);
+                EXPECT_EQ(fn->verify(), "") << fn->dump();
+            }
+            return fns;
+        }
+
+        static unsigned count(const ssa::Function& fn, ssa::Opcode op) {
+            unsigned n = 0;
+            for (const auto& blk : fn.blocks)
+                for (const auto& inst : blk->insts)
+                    n += inst->op == op;
+            return n;
+        }
+};
+
+#pragma mark - Rift SSA (Tests)
+
+TEST_F(RiftSSA, placesPhisAtLoopHeaders)
+{
+    auto fns = build("func sum(n) { mut s = 0; for (mut i = 0; i < n; i = i + 1) { s = s + i; } return s; }");
+    ASSERT_EQ(fns.size(), 2u);
+    EXPECT_EQ(fns[0]->name.lexeme, "script");
+    const auto& sum = *fns[1];
+    EXPECT_EQ(sum.name.lexeme, "sum");
+
+    // s & i merge at the header, the copies of the assignments are forwarded
+    EXPECT_EQ(count(sum, ssa::Opcode::Phi), 2u);
+    EXPECT_EQ(count(sum, ssa::Opcode::Copy), 0u);
+    EXPECT_EQ(count(sum, ssa::Opcode::Param), 1u);
+    for (const auto& blk : sum.blocks) {
+        for (const auto& inst : blk->insts) {
+            if (inst->op != ssa::Opcode::Phi) continue;
+            EXPECT_EQ(inst->args.size(), 2u);
+            EXPECT_EQ(blk->preds.size(), 2u);
+        }
+    }
+}
+
+TEST_F(RiftSSA, propagatesConstantsThroughBranches)
+{
+    auto fns = build("func f(x) { mut a = 2; mut b = a * 3; if (5 < b) { return x + b; } return 0; }");
+    const auto& f = *fns[1];
+
+    // b is 6, the condition holds & the other return is gone
+    EXPECT_EQ(count(f, ssa::Opcode::Branch), 0u);
+    EXPECT_EQ(count(f, ssa::Opcode::Return), 1u);
+    string dump = f.dump();
+    EXPECT_NE(dump.find("const 6"), string::npos) << dump;
+    EXPECT_EQ(dump.find("const 0"), string::npos) << dump;
+}
+
+TEST_F(RiftSSA, numbersRedundantValues)
+{
+    auto fns = build("func g(x) { mut a = x * x; mut b = x * x; print(a); return a + b; }");
+    const auto& g = *fns[1];
+
+    unsigned products = 0;
+    for (const auto& blk : g.blocks)
+        for (const auto& inst : blk->insts)
+            products += inst->op == ssa::Opcode::Binary && inst->value.type == TokenType::STAR;
+    EXPECT_EQ(products, 1u) << g.dump();
+}
+
+TEST_F(RiftSSA, eliminatesDeadCode)
+{
+    auto fns = build("func h(x) { mut t = 1 + 2; mut u = t; mut n = nil; mut v = n ?? t; return x; }");
+    const auto& h = *fns[1];
+
+    // only the param & the return are left, in a single block
+    ASSERT_EQ(h.blocks.size(), 1u) << h.dump();
+    EXPECT_EQ(h.blocks[0]->insts.size(), 2u) << h.dump();
+}
+
+TEST_F(RiftSSA, loadsWhatLivesOutsideTheFrame)
+{
+    auto fns = build("mut g = 1;\n"
+                     "func outer(p) { func inner(q) { g = g + q; return p + q; } return inner(3); }\n"
+                     "print(outer(4));");
+    ASSERT_EQ(fns.size(), 3u);
+    EXPECT_EQ(fns[1]->name.lexeme, "outer");
+    EXPECT_EQ(fns[2]->name.lexeme, "inner");
+
+    string dump = fns[2]->dump();
+    EXPECT_NE(dump.find("load upvalue"), string::npos) << dump;
+    EXPECT_NE(dump.find("load global g"), string::npos) << dump;
+    EXPECT_NE(dump.find("store global g"), string::npos) << dump;
+    EXPECT_EQ(count(*fns[1], ssa::Opcode::Closure), 1u);
+    EXPECT_EQ(count(*fns[1], ssa::Opcode::Call), 1u);
+}
+
+TEST_F(RiftSSA, buildsLazilyParsedBodies)
+{
+    // --lazy leaves bodies as tokens, the dump still has every function
+    auto fns = build("func sum(n) { mut s = 0; for (mut i = 0; i < n; i = i + 1) { s = s + i; } return s; }\nprint(sum(4));", 0, true);
+    ASSERT_EQ(fns.size(), 2u);
+    EXPECT_EQ(fns[1]->name.lexeme, "sum");
+    EXPECT_EQ(count(*fns[1], ssa::Opcode::Phi), 2u);
+}
@@ -0,0 +1,72 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+#include <ast/thunk.hh>
+
+#pragma mark - Rift Thunks (Fixtures)
+
+class RiftThunk : public RiftEngine {
+
+    protected:
+        RiftThunk() {}
+        ~RiftThunk() override {}
+
+        /// @brief what the program prints run as thunks
+        string engine(std::unique_ptr<Program<Tokens>>& prgm) override {
+            return output([&prgm] { ThunkMachine().evaluate(prgm, false); });
+        }
+};
+
+#pragma mark - Rift Thunks (Tests)
+
+TEST_F(RiftThunk, runsWhatEvalRuns)
+{
+    for (unsigned level = 0; level <= 2; level++) {
+        EXPECT_EQ(run("mut s = 0;\n"
+                      "for (mut i = 0; i < 300; i = i + 1) { s = s + i * 2 - 1; }\n"
+                      "print(s);", level), "89400\n");
+        EXPECT_EQ(run("func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                      "{ mut a = 2; mut b = a + fib(10); print(b); }", level), "57\n");
+        EXPECT_EQ(run("mut n = nil;\n"
+                      "{ mut x = 3; mut y = n ?? x; x = y ?? x; print(x + y); print(x > 2 && y < 2); print(x > 2 && y > 2); }\n"
+                      "func outer(p) { func inner(q) { return p + q; } return inner(3); }\n"
+                      "print(outer(4)); print(\"a\" + \"b\"); print(-outer(1));", level, level == 1),
+                  "6\nfalse\ntrue\n7\nab\n-4\n");
+    }
+}
+
+TEST_F(RiftThunk, specializesLocalOperands)
+{
+    auto prgm = parse("{ mut x = 2; mut y = 3; mut z = x * y; print(z + 1); }", 0);
+    auto script = ThunkCompiler().compile(prgm);
+    ASSERT_NE(script, nullptr);
+
+    // the block's decls: x, y, then z = x * y, one thunk reading both slots in place
+    const auto& block = script->body->kids[0].kids[0];
+    ASSERT_EQ(block.kids.size(), 4u);
+    const auto& assign = block.kids[2];
+    ASSERT_EQ(assign.kids.size(), 1u);
+    const auto& product = assign.kids[0];
+    EXPECT_TRUE(product.kids.empty());
+    EXPECT_NE(product.a, product.b);
+
+    // z + 1 has its constant bound in
+    const auto& sum = block.kids[3].kids[0];
+    ASSERT_EQ(sum.kids.size(), 0u);
+    EXPECT_EQ(sum.k.type, Value::Type::Int);
+    EXPECT_EQ(sum.k.i, 1);
+
+    EXPECT_EQ(output([&script] { ThunkMachine().run(script, false); }), "7\n");
+}
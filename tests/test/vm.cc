@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////
+///                                                       ///
+///     ██████╗ ██╗███████╗████████╗                      ///
+///     ██╔══██╗██║██╔════╝╚══██╔══╝                      ///
+///     ██████╔╝██║█████╗     ██║                         ///
+///     ██╔══██╗██║██╔══╝     ██║                         ///
+///     ██║  ██║██║██║        ██║                         ///
+///     ╚═╝  ╚═╝╚═╝╚═╝        ╚═╝                         ///
+///     * RIFT CORE - The official compiler for Rift.     ///
+///     * Copyright (c) 2024, Rift-Org                    ///
+///     * License terms may be found in the LICENSE file. ///
+///                                                       ///
+/////////////////////////////////////////////////////////////
+
+#include "fixture.hh"
+
+#pragma mark - Rift VM (Fixtures)
+
+class RiftVM : public RiftEngine {
+
+    protected:
+        RiftVM() {}
+        ~RiftVM() override {}
+
+        /// @brief what the program prints on the vm
+        string engine(std::unique_ptr<Program<Tokens>>& prgm) override {
+            return output([&prgm] { Machine().evaluate(prgm, false); });
+        }
+};
+
+#pragma mark - Rift VM (Tests)
+
+TEST_F(RiftVM, runsWhatEvalRuns)
+{
+    for (unsigned level = 0; level <= 2; level++) {
+        EXPECT_EQ(run("mut s = 0;\n"
+                      "for (mut i = 0; i < 300; i = i + 1) { s = s + i * 2 - 1; }\n"
+                      "print(s);", level), "89400\n");
+        EXPECT_EQ(run("func fib(n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }\n"
+                      "print(fib(15));", level), "610\n");
+        EXPECT_EQ(run("mut! name = \"ri\" + \"ft\";\n"
+                      "print(name); print(name + 1); print(name < \"z\");\n"
+                      "mut n = nil; print(n ?? 7); print(3 ?? n);\n"
+                      "print(true ? 1 + 1 : 99); print(false && n); print(-5 + 1); print(!0);", level),
+                  "rift\nrift1\nfalse\n7\n3\n2\nfalse\n-4\ntrue\n");
+        EXPECT_EQ(run("mut x = 1;\n"
+                      "if (x > 1) { print(1); } elif (x == 1) { print(2); } else { print(3); }\n"
+                      "mut big = 2147483647; print(big + 1);", level), "2\n-2147483648\n");
+    }
+}
+
+TEST_F(RiftVM, closuresShareCells)
+{
+    EXPECT_EQ(run("func makeCounter(start) {\n"
+                  "  mut i = start;\n"
+                  "  func count() { i = i + start; return i; }\n"
+                  "  return count;\n"
+                  "}\n"
+                  "mut counter = makeCounter(5);\n"
+                  "print(counter()); print(counter());\n"
+                  "func rec(n) {\n"
+                  "  func down(k) { if (k < 1) { return 0; } return n + down(k - 1); }\n"
+                  "  return down(n);\n"
+                  "}\n"
+                  "print(rec(4));"), "10\n15\n16\n");
+}
+
+TEST_F(RiftVM, compilesToBytecode)
+{
+    auto prgm = parse("mut s = 0;\n"
+                      "func twice(n) { return n * 2; }\n"
+                      "{ mut t = 40; s = twice(t) + 2; }\n"
+                      "print(s);", 0);
+    auto script = Compiler().compile(prgm);
+    ASSERT_NE(script, nullptr);
+    // the block's local gets a frame slot, literals & the function go to the pools
+    EXPECT_GE(script->frame, 1);
+    EXPECT_EQ(script->protos.size(), 1u);
+    EXPECT_EQ(script->sites.size(), 1u);
+    EXPECT_EQ(script->protos[0]->params.size(), 1u);
+    EXPECT_FALSE(script->constants.empty());
+    EXPECT_EQ(static_cast<Op>(script->code.back()), Op::Halt);
+
+    std::vector<string> res;
+    EXPECT_EQ(output([&] { res = Machine().run(script, false); }), "82\n");
+    EXPECT_EQ(res, std::vector<string>({"0", "twice", "null", "null"}));
+}
+
+TEST_F(RiftVM, fallsBackToEval)
+{
+    // classes only run on the tree walker, the whole program goes there
+    Program<Tokens>::vec_t decls;
+    decls.push_back(std::make_unique<DeclClass<Token>>(Token(TokenType::IDENTIFIER, "A", "A", 1),
+                                                       std::unordered_map<Token, DeclFunc<Token>::Func>()));
+    auto prgm = std::make_unique<Program<Tokens>>(std::move(decls));
+    EXPECT_EQ(Compiler().compile(prgm), nullptr);
+    EXPECT_EQ(Machine().evaluate(prgm, false), std::vector<string>({"null"}));
+}